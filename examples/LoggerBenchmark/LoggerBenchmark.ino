@@ -0,0 +1,15 @@
+#include "logger_bench.hpp"
+
+// Times the logger hot paths on the target, and prints the results over Serial.
+// Teensy boards use the cycle counter. Other boards use micros().
+
+void setup() {
+  Serial.begin(115200);
+  while(!Serial && millis() < 3000) {
+  }
+
+  run_logger_benchmarks();
+}
+
+void loop() {
+}
@@ -0,0 +1,299 @@
+#ifndef LOGGER_BENCH_HPP_
+#define LOGGER_BENCH_HPP_
+
+/** Benchmarks for the logger hot paths
+ *
+ * Shared by the LoggerBenchmark sketch and the host `arduino_logger_bench` target. Each case
+ * runs a fixed number of iterations, then reports the time per operation and the throughput
+ * through printf().
+ *
+ * Clocks:
+ * - Teensy 3.x/4.x: the ARM_DWT_CYCCNT cycle counter
+ * - AVR (and other Arduino boards): micros(), so use enough iterations to hide its 4 us step
+ * - Host: std::chrono::steady_clock
+ */
+
+#include <CircularBufferLogger.h>
+#include <internal/log_sink.hpp>
+#include <internal/sd_file_writer.hpp>
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+#ifndef LOG_BENCH_ITERATIONS
+#if defined(__AVR__)
+#define LOG_BENCH_ITERATIONS 200
+#else
+#define LOG_BENCH_ITERATIONS 10000
+#endif
+#endif
+
+// Buffer sizes. The defaults on AVR fit a board with 4 KiB of RAM or more (e.g., Mega 2560).
+#if defined(__AVR__)
+#define LOG_BENCH_SMALL_BUFFER_SIZE 64
+#define LOG_BENCH_MEDIUM_BUFFER_SIZE 128
+#define LOG_BENCH_LARGE_BUFFER_SIZE 256
+#else
+#define LOG_BENCH_SMALL_BUFFER_SIZE 256
+#define LOG_BENCH_MEDIUM_BUFFER_SIZE 1024
+#define LOG_BENCH_LARGE_BUFFER_SIZE (8 * 1024)
+#endif
+
+/// A size which is not a power of two, to compare the modulo-based buffer
+#define LOG_BENCH_ODD_BUFFER_SIZE (LOG_BENCH_MEDIUM_BUFFER_SIZE - 24)
+
+/// Reads the benchmark clock, and converts clock ticks to nanoseconds
+struct bench_clock
+{
+#if defined(TEENSYDUINO) && defined(ARM_DWT_CYCCNT)
+	static void begin()
+	{
+		ARM_DEMCR |= ARM_DEMCR_TRCENA;
+		ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+	}
+
+	static uint32_t now()
+	{
+		return ARM_DWT_CYCCNT;
+	}
+
+	static uint64_t to_ns(uint64_t ticks)
+	{
+		return ticks * 1000 / (F_CPU / 1000000);
+	}
+#elif defined(ARDUINO)
+	static void begin() {}
+
+	static uint32_t now()
+	{
+		return micros();
+	}
+
+	static uint64_t to_ns(uint64_t ticks)
+	{
+		return ticks * 1000;
+	}
+#else
+	static void begin() {}
+
+	static uint32_t now()
+	{
+		return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+										 std::chrono::steady_clock::now().time_since_epoch())
+										 .count());
+	}
+
+	static uint64_t to_ns(uint64_t ticks)
+	{
+		return ticks;
+	}
+#endif
+};
+
+/// Sink (see internal/log_sink.hpp) which discards data, so flushes measure the logger only
+struct bench_null_sink
+{
+	size_t write(const char* data, size_t size)
+	{
+		// Read the data, so the write cannot be optimized away
+		for(size_t i = 0; i < size; i++)
+		{
+			checksum += static_cast<unsigned char>(data[i]);
+		}
+
+		return size;
+	}
+
+	volatile uint32_t checksum = 0;
+};
+
+/// Counts the calls and bytes an SD logger flush makes, in place of SdFat's FsFile
+struct bench_sd_file
+{
+	size_t write(const void* data, size_t size)
+	{
+		writes++;
+		bytes += size;
+		last = static_cast<const char*>(data)[size - 1];
+		return size;
+	}
+
+	uint32_t writes = 0;
+	uint64_t bytes = 0;
+	volatile char last = 0;
+};
+
+/// Data used to fill the buffers
+inline const char* bench_fill()
+{
+	static char fill[LOG_BENCH_LARGE_BUFFER_SIZE];
+	memset(fill, 'x', sizeof(fill));
+	return fill;
+}
+
+/** Time a benchmark case, and print the result
+ *
+ * @param name The case name.
+ * @param iterations The number of times f is called.
+ * @param bytes The number of bytes each call handles, for the throughput. 0 omits it.
+ * @param f The operation.
+ */
+template<class TFunction>
+void bench_run(const char* name, uint32_t iterations, size_t bytes, TFunction&& f)
+{
+	// Warm up the caches and branch predictors
+	f();
+
+	uint32_t start = bench_clock::now();
+
+	for(uint32_t i = 0; i < iterations; i++)
+	{
+		f();
+	}
+
+	uint64_t ns = bench_clock::to_ns(static_cast<uint32_t>(bench_clock::now() - start));
+	uint32_t ns_per_op = static_cast<uint32_t>(ns / iterations);
+
+	if(bytes > 0 && ns > 0)
+	{
+		uint32_t kib_per_s =
+			static_cast<uint32_t>(uint64_t(bytes) * iterations * 1000000000 / ns / 1024);
+		printf("%-40s %8lu ns/op %10lu KiB/s\n", name, static_cast<unsigned long>(ns_per_op),
+			   static_cast<unsigned long>(kib_per_s));
+	}
+	else
+	{
+		printf("%-40s %8lu ns/op\n", name, static_cast<unsigned long>(ns_per_op));
+	}
+}
+
+/// log() with 0, 1, and 4 arguments and with float arguments (the last two also with a
+/// LOG_FMT() format), and print() without the level prefix
+template<size_t TBufferSize>
+void bench_log_paths(const char* label)
+{
+	static CircularLogBufferLogger<TBufferSize> logger;
+	char name[48];
+
+	snprintf(name, sizeof(name), "%s info(), 0 args", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, 0, [] { logger.info("Hello world\n"); });
+
+	snprintf(name, sizeof(name), "%s info(), 1 arg", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, 0, [] { logger.info("Value %d\n", 42); });
+
+	snprintf(name, sizeof(name), "%s info(), 4 args", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, 0,
+			  [] { logger.info("%d %u %s %x\n", -42, 42u, "str", 0x42u); });
+
+	snprintf(name, sizeof(name), "%s info(LOG_FMT()), 4 args", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, 0,
+			  [] { logger.info(LOG_FMT("%d %u %s %x\n"), -42, 42u, "str", 0x42u); });
+
+	snprintf(name, sizeof(name), "%s info(), 3 floats", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, 0,
+			  [] { logger.info("%.3f %.3f %.3f\n", 0.012, -9.806, 1.5); });
+
+	snprintf(name, sizeof(name), "%s info(LOG_FMT()), 3 floats", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, 0,
+			  [] { logger.info(LOG_FMT("%.3f %.3f %.3f\n"), 0.012, -9.806, 1.5); });
+
+	snprintf(name, sizeof(name), "%s print(), 0 args (no prefix)", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, 0, [] { logger.print("Hello world\n"); });
+}
+
+/// Bytes/s into the log buffer, by character and by block
+template<size_t TBufferSize>
+void bench_buffer_throughput(const char* label)
+{
+	static CircularLogBufferLogger<TBufferSize> logger;
+	static const char block[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcd\n";
+	char name[48];
+
+	snprintf(name, sizeof(name), "%s write(), 64 B block", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, sizeof(block) - 1,
+			  [] { logger.write(block, sizeof(block) - 1); });
+
+	snprintf(name, sizeof(name), "%s print(\"%%s\"), 64 B", label);
+	bench_run(name, LOG_BENCH_ITERATIONS, sizeof(block) - 1, [] { logger.print("%s", block); });
+}
+
+/// The cost of flushing a full buffer to a sink which accepts all data
+template<size_t TBufferSize>
+void bench_flush(const char* label)
+{
+	static CircularLogBufferLogger<TBufferSize> logger;
+	static bench_null_sink sink;
+	static const char* fill = bench_fill();
+	char name[48];
+
+	snprintf(name, sizeof(name), "%s fill + flush_to()", label);
+	bench_run(name, LOG_BENCH_ITERATIONS / 10 + 1, TBufferSize, [] {
+		logger.write(fill, TBufferSize);
+		logger.flush_to(sink);
+	});
+}
+
+/// The SD logger flush path: sector-aligned writes from the log buffer to the file
+template<size_t TBufferSize>
+void bench_sd_flush(const char* label)
+{
+	static CircularBuffer<char, TBufferSize> buffer;
+	static bench_sd_file file;
+	static const char* fill = bench_fill();
+	static uint64_t position;
+	char name[48];
+
+	file.writes = 0;
+	file.bytes = 0;
+	position = 0;
+
+	// Leave a partial sector behind, as a real flush does
+	static constexpr size_t fill_size = TBufferSize - TBufferSize / 8;
+
+	snprintf(name, sizeof(name), "%s SD flush, sector-aligned", label);
+	bench_run(name, LOG_BENCH_ITERATIONS / 10 + 1, fill_size, [] {
+		buffer.put(fill, fill_size);
+		size_t count = sector_aligned_size(position, buffer.size());
+		count = write_buffer_to_file(file, buffer, count);
+		buffer.consume(count);
+		position += count;
+	});
+
+	printf("%-40s %8lu writes %10lu bytes\n", "  file calls",
+		   static_cast<unsigned long>(file.writes), static_cast<unsigned long>(file.bytes));
+}
+
+/// Run all benchmark cases
+inline void run_logger_benchmarks()
+{
+	bench_clock::begin();
+	printf("ArduinoLogger benchmarks (%u iterations)\n",
+		   static_cast<unsigned>(LOG_BENCH_ITERATIONS));
+	printf("Buffer sizes: small %u, odd %u, medium %u, large %u\n",
+		   static_cast<unsigned>(LOG_BENCH_SMALL_BUFFER_SIZE),
+		   static_cast<unsigned>(LOG_BENCH_ODD_BUFFER_SIZE),
+		   static_cast<unsigned>(LOG_BENCH_MEDIUM_BUFFER_SIZE),
+		   static_cast<unsigned>(LOG_BENCH_LARGE_BUFFER_SIZE));
+
+	bench_log_paths<LOG_BENCH_MEDIUM_BUFFER_SIZE>("[medium]");
+
+	bench_buffer_throughput<LOG_BENCH_SMALL_BUFFER_SIZE>("[small]");
+	bench_buffer_throughput<LOG_BENCH_ODD_BUFFER_SIZE>("[odd]");
+	bench_buffer_throughput<LOG_BENCH_MEDIUM_BUFFER_SIZE>("[medium]");
+	bench_buffer_throughput<LOG_BENCH_LARGE_BUFFER_SIZE>("[large]");
+
+	bench_flush<LOG_BENCH_SMALL_BUFFER_SIZE>("[small]");
+	bench_flush<LOG_BENCH_LARGE_BUFFER_SIZE>("[large]");
+
+#if !defined(__AVR__)
+	// The AVR buffers are smaller than two sectors, so they would never write a whole sector
+	bench_sd_flush<LOG_BENCH_MEDIUM_BUFFER_SIZE>("[medium]");
+	bench_sd_flush<LOG_BENCH_LARGE_BUFFER_SIZE>("[large]");
+#endif
+}
+
+#endif // LOGGER_BENCH_HPP_
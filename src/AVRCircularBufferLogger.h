@@ -8,8 +8,9 @@
 #endif
 
 #include "ArduinoLogger.h"
+#include "internal/avr_reset_reason.hpp"
 #include "internal/circular_buffer.hpp"
-#include <avr/wdt.h>
+#include "internal/log_sink.hpp"
 
 /** Circular log buffer
  *
@@ -20,7 +21,7 @@
  *
  * @tparam TBufferSize Defines the size of the circular log buffer.
  * Set to 0 to disable logging completely (for memory constrained systems).
- * @note Size requirement: power-of-2 for optimized queue logic.
+ * @note Power-of-2 sizes select the optimized (mask-based) queue logic.
  *
  *	@code
  *	using PlatformLogger =
@@ -30,11 +31,13 @@
  * @ingroup LoggingSubsystem
  */
 template<size_t TBufferSize = (1 * 1024)>
-class AVRCircularLogBufferLogger final : public LoggerBase
+class AVRCircularLogBufferLogger final : public LoggerBaseT<AVRCircularLogBufferLogger<TBufferSize>>
 {
+	friend class LoggerBaseT<AVRCircularLogBufferLogger>;
+
   public:
 	/// Default constructor
-	AVRCircularLogBufferLogger() : LoggerBase() {}
+	AVRCircularLogBufferLogger() : LoggerBaseT<AVRCircularLogBufferLogger>() {}
 
 	/** Initialize the circular log buffer with options
 	 *
@@ -47,36 +50,17 @@ class AVRCircularLogBufferLogger final : public LoggerBase
 	 */
 	explicit AVRCircularLogBufferLogger(bool enable, log_level_e l = LOG_LEVEL_LIMIT(),
 										bool echo = LOG_ECHO_EN_DEFAULT) noexcept
-		: LoggerBase(enable, l, echo)
+		: LoggerBaseT<AVRCircularLogBufferLogger>(enable, l, echo)
 	{
 	}
 
 	/// Default destructor
 	~AVRCircularLogBufferLogger() noexcept = default;
 
+	/// Logs the reset reason recorded in MCUSR
 	void resetCause()
 	{
-		auto reg = MCUSR;
-
-		if(reg & (1 << WDRF))
-		{
-			info("Watchdog reset\n");
-		}
-
-		if(reg & (1 << BORF))
-		{
-			info("Brown-out reset\n");
-		}
-
-		if(reg & (1 << EXTRF))
-		{
-			info("External reset\n");
-		}
-
-		if(reg & (1 << PORF))
-		{
-			info("Power-on reset\n");
-		}
+		report_avr_reset_reason([this](const char* reason) { this->info("%s", reason); });
 	}
 
 	size_t size() const noexcept final
@@ -89,18 +73,67 @@ class AVRCircularLogBufferLogger final : public LoggerBase
 		return log_buffer_.capacity();
 	}
 
+	/** Write the log buffer to a sink, straight from the buffer storage
+	 *
+	 * The sink receives at most two write() calls (see internal/log_sink.hpp), so UART DMA,
+	 * USB bulk, or network sinks can send the data without an intermediate copy.
+	 *
+	 *	@code
+	 *	logger.flush_to(Serial);
+	 *	@endcode
+	 *
+	 * @param sink The destination.
+	 * @returns The number of bytes written. Data which the sink did not accept stays in the
+	 *	buffer.
+	 */
+	template<class TSink>
+	size_t flush_to(TSink& sink) noexcept
+	{
+		return drain_to_sink(sink, log_buffer_);
+	}
+
+	/** Select the output written by flush()
+	 *
+	 * By default, flush() writes the whole buffer with _putchar(), which blocks until the data
+	 * is sent (about 700 ms for 8 KiB at 115200 baud). With a non-blocking output, flush()
+	 * writes only what the output accepts and returns. The rest stays in the buffer, and the
+	 * next flush() or poll() continues from there.
+	 *
+	 *	@code
+	 *	logger.output(log_sink_ref::nonblocking(Serial));
+	 *	@endcode
+	 *
+	 * @param sink The output. An empty log_sink_ref selects _putchar().
+	 */
+	void output(log_sink_ref sink) noexcept
+	{
+		output_ = sink;
+	}
+
   protected:
 	void log_putc(char c) noexcept final
 	{
 		log_buffer_.put(c);
 	}
 
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
 	void flush_() noexcept final
 	{
-		while(!log_buffer_.empty())
+		if(output_.valid())
+		{
+			drain_to_sink(output_, log_buffer_);
+		}
+		else
 		{
-			_putchar(log_buffer_.get());
+			putchar_log_sink sink;
+			drain_to_sink(sink, log_buffer_);
 		}
+
+		this->flush_pending(!log_buffer_.empty());
 	}
 
 	void clear_() noexcept final
@@ -110,6 +143,7 @@ class AVRCircularLogBufferLogger final : public LoggerBase
 
   private:
 	CircularBuffer<char, TBufferSize> log_buffer_;
+	log_sink_ref output_;
 };
 
 #endif // AVR_CIRCULAR_BUFFER_LOGGER_H_
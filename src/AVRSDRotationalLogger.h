@@ -4,9 +4,11 @@
 #include "Arduino.h"
 #include "ArduinoLogger.h"
 #include "SdFat.h"
+#include "internal/avr_reset_reason.hpp"
 #include "internal/circular_buffer.hpp"
-#include <EEPROM.h>
-#include <avr/wdt.h>
+#include "internal/external_buffer.hpp"
+#include "internal/sdfat_storage.hpp"
+#include "internal/timestamp_clock.hpp"
 
 /** AVR SD File Buffer
  *
@@ -19,64 +21,179 @@
  *		PlatformLogger_t<AVRSDRotationalLogger>;
  *  @endcode
  *
+ * On boards with little RAM, select a smaller staging buffer:
+ *
+ *	@code
+ *	using PlatformLogger =
+ *		PlatformLogger_t<AVRSDRotationalLogger_t<CircularBuffer<char, 128>>>;
+ *  @endcode
+ *
+ * A buffer smaller than a sector writes all of its data on each flush, including to a
+ * pre-allocated file.
+ *
+ * @tparam TBuffer The type of the internal RAM staging buffer. Any type with the
+ *	CircularBuffer interface can be used.
+ *
  * @ingroup LoggingSubsystem
  */
-class AVRSDRotationalLogger final : public LoggerBase
+template<class TBuffer = CircularBuffer<char, 512>>
+class AVRSDRotationalLogger_t final : public LoggerBaseT<AVRSDRotationalLogger_t<TBuffer>>
 {
-  private:
-	static constexpr size_t BUFFER_SIZE = 512;
-	static constexpr size_t FILENAME_SIZE = 32;
-	static constexpr unsigned EEPROM_LOG_STORAGE_ADDR = 4095;
+	friend class LoggerBaseT<AVRSDRotationalLogger_t>;
 
   public:
 	/// Default constructor
-	AVRSDRotationalLogger() : LoggerBase() {}
+	AVRSDRotationalLogger_t() : LoggerBaseT<AVRSDRotationalLogger_t>() {}
 
 	/// Default destructor
-	~AVRSDRotationalLogger() noexcept = default;
+	~AVRSDRotationalLogger_t() noexcept = default;
 
 	size_t size() const noexcept final
 	{
-		return file_.size();
+		return storage_.size();
 	}
 
 	size_t capacity() const noexcept final
 	{
-		// size in blocks * bytes per block (512 Bytes = 2^9)
-		return fs_ ? fs_->card()->sectorCount() << 9 : 0;
+		return storage_.capacity();
 	}
 
-	void log_customprefix() noexcept final
+	size_t format_customprefix(char* dst) noexcept final
 	{
-		print("[%u ms] ", millis());
+		return this->format_timestamp_prefix(dst, log_timestamp_now(this->timestamp_source()));
 	}
 
-	void begin(SdFs& sd_inst)
+	/** Open the log file on the SD card
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size If non-zero, a contiguous file of this many bytes is allocated,
+	 *	and the file is kept open. Data is then written in whole sectors, which avoids
+	 *	read-modify-write cycles and cluster allocation during logging. The file is truncated
+	 *	to the length of the data by close(), or when a new file is started.
+	 */
+	void begin(SdFs& sd_inst, uint64_t preallocate_size = 0)
 	{
-		fs_ = &sd_inst;
+		storage_.attach(sd_inst, preallocate_size);
 
-		set_filename();
+		open_next_file();
 
-		if(!file_.open(filename_, O_WRITE | O_CREAT))
+		log_reset_reason();
+
+		// Manually flush, since the file is open
+		this->flush();
+
+		if(storage_.keep_open())
 		{
-			errorHalt("Failed to open file");
+			sync();
 		}
+		else
+		{
+			storage_.release();
+		}
+	}
 
-		// Clear current file contents
-		file_.truncate(0);
+	/** Attach the SD card, and start a new log file at the first flush
+	 *
+	 * begin() starts a new log file, logs the reset reason, and flushes before it returns,
+	 * which can take hundreds of milliseconds on a slow card. This version only attaches the
+	 * card and logs the reset reason. Statements are kept in the RAM buffer, and the new file
+	 * is started by the first flush: the next poll() or flush(), or an auto-flush when the
+	 * buffer fills.
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size @see begin()
+	 */
+	void begin_deferred(SdFs& sd_inst, uint64_t preallocate_size = 0)
+	{
+		storage_.attach(sd_inst, preallocate_size);
+		storage_.defer_open();
 
 		log_reset_reason();
 
-		// Manually flush, since the file is open
-		flush();
+		// The first poll() starts the file, even if no flush is due
+		this->flush_pending(true);
+	}
+
+	/** Keep the log file open between flushes
+	 *
+	 * By default, the log file is opened and closed on every flush. When the file is kept
+	 * open, flush() only writes the data, and the file is synced according to the sync
+	 * budget (see sync_budget()). Data which has not been synced is lost if power is removed.
+	 *
+	 * @param enable If true, keep the file open. If false, the file is closed.
+	 */
+	void keep_file_open(bool enable)
+	{
+		storage_.keep_open(enable, log_buffer_, millis());
+	}
+
+	/** Set the sync budget used when the log file is kept open
+	 *
+	 * @param bytes Sync once this many bytes have been written since the last sync.
+	 * @param ms Sync during flush() if this many milliseconds have passed since the last sync.
+	 */
+	void sync_budget(size_t bytes, uint32_t ms) noexcept
+	{
+		storage_.sync_policy().budget(bytes, ms);
+	}
 
-		file_.close();
+	/// Commit the data written to the log file to the SD card.
+	/// For a pre-allocated file, this includes the partial sector held in the buffer.
+	void sync()
+	{
+		storage_.sync(log_buffer_, millis());
+	}
+
+	/** Write the buffered data and close the log file
+	 *
+	 * A pre-allocated file is truncated to the length of the data. Logging can continue
+	 * after close(): the file is reopened (in append mode) by the next flush.
+	 */
+	void close()
+	{
+		this->flush();
+		storage_.close(log_buffer_, millis());
+	}
+
+	/** Access the rotation policy
+	 *
+	 * By default, a new file is only started by begin(). The policy can also start a new file
+	 * once the current one reaches a size, or has been in use for an interval. With a
+	 * retention budget, the oldest log files are deleted when a new file is started:
+	 *
+	 *	@code
+	 *	logger.rotation_policy().max_size(16 * 1024 * 1024);
+	 *	logger.rotation_policy().interval(24 * 60 * 60 * 1000UL);
+	 *	logger.rotation_policy().retention(1024 * 1024 * 1024ULL);
+	 *	@endcode
+	 */
+	LogRotationPolicy& rotation_policy() noexcept
+	{
+		return storage_.rotation_policy();
 	}
 
-	// Resets the log file counter back to 1
+	/// The index of the current log file, log_<index>.txt
+	uint32_t file_index() const noexcept
+	{
+		return storage_.file_index();
+	}
+
+	/// Write the buffered data to the current file, and start the next file
+	void rotate()
+	{
+		if(storage_.attached())
+		{
+			this->flush();
+			open_next_file();
+
+			storage_.release();
+		}
+	}
+
+	/// Resets the log file counter back to 1. The SD card must be initialized.
 	void resetFileCounter()
 	{
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, 1);
+		sd_store_log_index<FsFile>(1);
 	}
 
   protected:
@@ -85,6 +202,11 @@ class AVRSDRotationalLogger final : public LoggerBase
 		log_buffer_.put(c);
 	}
 
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
 	void flush_() noexcept final
 	{
 		writeBufferToSDFile();
@@ -106,118 +228,48 @@ class AVRSDRotationalLogger final : public LoggerBase
 	}
 
   private:
-	void errorHalt(const char* msg)
+	void writeBufferToSDFile()
 	{
-		printf("Error: %s\n", msg);
-		if(fs_->sdErrorCode())
+		if(storage_.take_deferred_open())
 		{
-			if(fs_->sdErrorCode() == SD_CARD_ERROR_ACMD41)
-			{
-				printf("Try power cycling the SD card.\n");
-			}
-			printSdErrorSymbol(&Serial, fs_->sdErrorCode());
-			printf(", ErrorData: 0x%x\n", fs_->sdErrorData());
+			// See begin_deferred()
+			open_next_file();
+			this->flush_pending(false);
 		}
-		while(true)
-		{
-		}
-	}
 
-	/// Checks the AVR SoC's reset reason registers and logs them
-	/// This should only be called during begin().
-	void log_reset_reason()
-	{
-		auto reg = MCUSR;
-
-		if(reg & (1 << WDRF))
-		{
-			info("Watchdog reset\n");
-		}
+		uint32_t start = this->stats_clock();
+		size_t count = storage_.write(log_buffer_);
+		this->stats_stored(start);
 
-		if(reg & (1 << BORF))
+		// log() never starts the next file: that waits for an explicit flush() or poll()
+		if(storage_.rotation_due(count, millis()) && !this->flushing_from_log())
 		{
-			info("Brown-out reset\n");
+			open_next_file();
 		}
 
-		if(reg & (1 << EXTRF))
-		{
-			info("External reset\n");
-		}
-
-		if(reg & (1 << PORF))
-		{
-			info("Power-on reset\n");
-		}
+		storage_.finish(count, log_buffer_, millis());
 	}
 
-	void set_filename()
+	/// Close the current file, and start the next one. This is called by begin(), and by the
+	/// flush path when the rotation policy requires a new file.
+	void open_next_file()
 	{
-		uint8_t value = EEPROM.read(EEPROM_LOG_STORAGE_ADDR);
-
-		// 0xFF indicates a byte that's been reset, or value 255. Either way, reset to 0.
-		if(value == 0xFF)
-		{
-			value = 1;
-		}
-
-		snprintf(filename_, FILENAME_SIZE, "log_%d.txt", value);
-
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, static_cast<uint8_t>(value + 1));
+		storage_.open_next(".txt", log_buffer_, millis());
 	}
 
-	void writeBufferToSDFile()
+	/// Logs the reset reason. This should only be called during begin() or begin_deferred().
+	void log_reset_reason()
 	{
-		if(!file_.open(filename_, O_WRITE | O_APPEND))
-		{
-			errorHalt("Failed to open file");
-		}
-
-		int bytes_written = 0;
-
-		// We need to get the front, the rear, and potentially write the files in two steps
-		// to prevent ordering problems
-		size_t head = log_buffer_.head();
-		size_t tail = log_buffer_.tail();
-		const char* buffer = log_buffer_.storage();
-
-		/** Note on const_cast
-		 *
-		 * The circular buffer returns a const char* for the underlying storage,
-		 * but the AVR EEPROM library requires that a char* is passed to write().
-		 * We're not modifying the buffer, so I'm const casting here.
-		 */
-
-		if((head < tail) || ((tail > 0) && (log_buffer_.size() == log_buffer_.capacity())))
-		{
-			// we have a wraparound case
-			// We will write from buffer[tail] to buffer[size] in one go
-			// Then we'll reset head to 0 so that we can write 0 to tail next
-			bytes_written =
-				file_.write(const_cast<char*>(&buffer[tail]), log_buffer_.capacity() - tail);
-			bytes_written += file_.write(const_cast<char*>(buffer), head);
-		}
-		else
-		{
-			// Write from tail position and send the specified number of bytes
-			bytes_written = file_.write(const_cast<char*>(&buffer[tail]), log_buffer_.size());
-		}
-
-		if(static_cast<size_t>(bytes_written) != log_buffer_.size())
-		{
-			errorHalt("Failed to write to log file");
-		}
-
-		log_buffer_.reset();
-
-		file_.close();
+		report_avr_reset_reason([this](const char* reason) { this->info("%s", reason); });
 	}
 
   private:
-	SdFs* fs_;
-	char filename_[FILENAME_SIZE];
-	FsFile file_;
+	SDRotatingStorage storage_;
 
-	CircularBuffer<char, BUFFER_SIZE> log_buffer_;
+	TBuffer log_buffer_;
 };
 
+/// The default AVRSDRotationalLogger configuration
+using AVRSDRotationalLogger = AVRSDRotationalLogger_t<>;
+
 #endif // AVR_SD_FILE_LOGGER_H_
@@ -2,3 +2,4 @@
 
 constexpr const char* logNames::level_short_names[LOG_LEVEL_COUNT];
 constexpr const char* logNames::level_string_names[LOG_LEVEL_COUNT];
+constexpr size_t logNames::level_short_name_lengths[LOG_LEVEL_COUNT];
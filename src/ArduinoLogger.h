@@ -1,7 +1,14 @@
 #ifndef ARDUINO_LOGGER_H_
 #define ARDUINO_LOGGER_H_
 
+#include "internal/flush_policy.hpp"
+#include "internal/log_format.hpp"
+#include "internal/log_kv.hpp"
+#include "internal/log_record_builder.hpp"
+#include "internal/record_circular_buffer.hpp"
+#include "internal/timestamp_prefix.hpp"
 #include <LibPrintf.h>
+#include <string.h>
 #if !defined(__AVR__)
 #include <utility>
 #endif
@@ -40,6 +47,23 @@
 #define LOG_LEVEL LOG_LEVEL_DEBUG
 #endif
 
+#ifndef LOG_MODULE_LEVEL
+/** Default maximum log level for a module.
+ *
+ * This is the maximum log level that will be compiled in for log statements which supply the
+ * module ID as a template argument (e.g., `logger.debug<MODULE_ID>("...")`).
+ * Statements above the module's level compile away entirely, including the format string.
+ * The global LOG_LEVEL still applies. This is also the module's default runtime level, and
+ * the runtime level cannot be raised above it.
+ *
+ * To set custom module levels, define LOG_MODULE_LEVEL before including this header:
+ * @code
+ * #define LOG_MODULE_LEVEL(module_id) ((module_id) == 2 ? LOG_LEVEL_DEBUG : LOG_LEVEL_WARNING)
+ * @endcode
+ */
+#define LOG_MODULE_LEVEL(module_id) (static_cast<void>(module_id), LOG_LEVEL)
+#endif
+
 #ifndef LOG_EN_DEFAULT
 /// Whether the logging module is enabled automatically on boot.
 #define LOG_EN_DEFAULT true
@@ -57,6 +81,134 @@
 #define LOG_ECHO_EN_DEFAULT false
 #endif
 
+#ifndef LOG_ECHO_STAGING_SIZE
+/// With echo enabled, messages are formatted once into a stack buffer of this many characters,
+/// which is copied to the log and the console each time it fills
+#define LOG_ECHO_STAGING_SIZE 64
+#endif
+
+#ifndef LOG_STATS_EN
+/** Whether loggers collect usage statistics (see LoggerBase::stats()).
+ *
+ * If false, no counters are compiled in, and the logging paths are unchanged.
+ * Define the same value in every translation unit, since it changes the layout of the loggers.
+ */
+#define LOG_STATS_EN false
+#endif
+
+#if LOG_STATS_EN
+#include "internal/log_stats.hpp"
+
+#ifndef LOG_STATS_CLOCK
+#if defined(ARDUINO)
+#include <Arduino.h>
+/// Reads the clock used to time flushes and storage writes, in microseconds
+#define LOG_STATS_CLOCK() micros()
+#else
+#include <chrono>
+
+inline uint32_t log_stats_host_clock() noexcept
+{
+	return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+									 std::chrono::steady_clock::now().time_since_epoch())
+									 .count());
+}
+
+/// Reads the clock used to time flushes and storage writes, in microseconds
+#define LOG_STATS_CLOCK() log_stats_host_clock()
+#endif
+#endif
+#endif
+
+#ifndef LOG_CONCURRENT_EN
+/** Whether several threads or tasks may log at the same time.
+ *
+ * If true, each log statement is assembled on the stack of the logging thread (see
+ * LOG_RECORD_MAX_SIZE), and then added to the strategy's buffer in a single call. With a
+ * multi-producer buffer (MPSCCircularBuffer), statements from different threads never
+ * interleave, and no lock is taken. Producers never flush: one consumer thread calls flush()
+ * or poll(), so logging threads do not wait on the output.
+ *
+ * The custom prefix is formatted with format_customprefix(). log_customprefix() overrides are
+ * not used. Statements which do not fit in the buffer are dropped as a whole, and are reported
+ * by has_overrun(). Statistics (LOG_STATS_EN) are approximate with more than one producer.
+ *
+ * Define the same value in every translation unit.
+ */
+#define LOG_CONCURRENT_EN false
+#endif
+
+#ifndef LOG_RECORD_FRAMING_EN
+/** Whether each log statement is added to the log as a single record.
+ *
+ * If true, each log statement is assembled on the stack (see LOG_RECORD_MAX_SIZE), and then
+ * added to the strategy's buffer in a single call, so a full buffer drops whole statements
+ * instead of bytes. A RecordCircularBuffer evicts its oldest statements to make room, and other
+ * buffers reject the new statement. Either way, the output never starts part-way through a
+ * statement, and flush() reports how many statements and bytes were dropped.
+ *
+ * LOG_CONCURRENT_EN implies this behavior. The custom prefix is formatted with
+ * format_customprefix(). Define the same value in every translation unit.
+ */
+#define LOG_RECORD_FRAMING_EN false
+#endif
+
+/// Log statements are assembled before they are added to the log (see LoggerBase::log_record())
+#define LOG_RECORDS_STAGED (LOG_CONCURRENT_EN || LOG_RECORD_FRAMING_EN)
+
+#ifndef LOG_RECORD_MAX_SIZE
+/// The maximum length of a log statement when LOG_CONCURRENT_EN or LOG_RECORD_FRAMING_EN is set,
+/// including the prefixes. Longer statements are truncated. The record is on the stack of the
+/// logging thread.
+#define LOG_RECORD_MAX_SIZE 128
+#endif
+
+#ifndef LOG_RATE_LIMIT_EN
+/** Whether loggers limit the rate of each call site, and collapse repeated statements.
+ *
+ * If true, log() passes each statement to a LogRateLimiter before it is formatted (see
+ * LoggerBase::rate_limiter()). Statements which hit the limit, and repeats of the previous
+ * statement, are counted instead of logged, and the counts are written at the next flush.
+ * log_interrupt() is not limited. Not supported with LOG_CONCURRENT_EN.
+ *
+ * Define the same value in every translation unit, since it changes the layout of the loggers.
+ */
+#define LOG_RATE_LIMIT_EN false
+#endif
+
+#if LOG_RATE_LIMIT_EN
+#include "internal/log_rate_limiter.hpp"
+
+#if LOG_CONCURRENT_EN
+#error "LOG_RATE_LIMIT_EN is not supported with LOG_CONCURRENT_EN"
+#endif
+
+#ifndef LOG_RATE_LIMIT_SITES
+/// The number of call sites which are rate limited independently. Must be a power of two.
+#define LOG_RATE_LIMIT_SITES 8
+#endif
+
+#ifndef LOG_RATE_LIMIT_CLOCK
+#if defined(ARDUINO)
+#include <Arduino.h>
+/// Reads the clock used by the rate limit, in milliseconds
+#define LOG_RATE_LIMIT_CLOCK() millis()
+#else
+#include <chrono>
+
+inline uint32_t log_rate_limit_host_clock() noexcept
+{
+	return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+									 std::chrono::steady_clock::now().time_since_epoch())
+									 .count());
+}
+
+/// Reads the clock used by the rate limit, in milliseconds
+#define LOG_RATE_LIMIT_CLOCK() log_rate_limit_host_clock()
+#endif
+#endif
+#endif
+
 #ifndef LOG_LEVEL_NAMES
 /// Users can override these default names with a compiler definition
 #define LOG_LEVEL_NAMES                                         \
@@ -92,6 +244,20 @@ constexpr cstr past_last_slash(cstr str)
 	return past_last_slash(str, str);
 }
 
+/// Returns the offset of the first character after the last '/' in str
+constexpr size_t past_last_slash_offset(cstr str, size_t i, size_t offset)
+{
+	return str[i] == '\0'	 ? offset
+		   : str[i] == '/' ? past_last_slash_offset(str, i + 1, i + 1)
+						   : past_last_slash_offset(str, i + 1, offset);
+}
+
+/// Returns the length of str. Usable in constant expressions.
+constexpr size_t log_strlen(cstr str)
+{
+	return *str == '\0' ? 0 : 1 + log_strlen(str + 1);
+}
+
 #define __SHORT_FILE__                                  \
 	({                                                  \
 		constexpr cstr sf__{past_last_slash(__FILE__)}; \
@@ -110,6 +276,26 @@ constexpr cstr past_last_slash(cstr str)
 		sf__;                                                                  \
 	})
 
+/** Prefix a format string literal with the short file name and line number
+ *
+ * The file:line location and the format string are concatenated into a single string literal,
+ * so a call site stores one constant string and the location is copied along with the rest of
+ * the format string. Only the file name portion is searched for a path separator, so the
+ * format string may contain '/'.
+ *
+ * @code
+ * loginfo(TRACE_FMT("Sensor %d: %d\n"), id, value); // "<I> main.cpp:42 Sensor 1: 300"
+ * @endcode
+ *
+ * @param fmt The format string. Must be a string literal.
+ */
+#define TRACE_FMT(fmt)                                                             \
+	({                                                                             \
+		constexpr cstr tf__{(__FILE__ ":" TOSTRING(__LINE__) " " fmt) +            \
+							past_last_slash_offset(__FILE__, 0, 0)};                \
+		tf__;                                                                      \
+	})
+
 #define FUNC() __FUNCTION__
 #define PRETTY_FUNC() __PRETTY_FUNCTION__
 
@@ -132,6 +318,12 @@ class logNames
   public:
 	constexpr static const char* level_short_names[LOG_LEVEL_COUNT] = LOG_LEVEL_SHORT_NAMES;
 	constexpr static const char* level_string_names[LOG_LEVEL_COUNT] = LOG_LEVEL_NAMES;
+	/// The length of each short name, so prefixes are copied without a strlen() or printf()
+	constexpr static size_t level_short_name_lengths[LOG_LEVEL_COUNT] = {
+		log_strlen(level_short_names[0]), log_strlen(level_short_names[1]),
+		log_strlen(level_short_names[2]), log_strlen(level_short_names[3]),
+		log_strlen(level_short_names[4]), log_strlen(level_short_names[5]),
+	};
 };
 
 constexpr log_level_e LOG_LEVEL_LIMIT() noexcept
@@ -139,6 +331,15 @@ constexpr log_level_e LOG_LEVEL_LIMIT() noexcept
 	return static_cast<log_level_e>(LOG_LEVEL);
 }
 
+/// Returns the compile-time log level limit for a module: the lower of LOG_LEVEL
+/// and LOG_MODULE_LEVEL(module_id)
+constexpr log_level_e LOG_MODULE_LEVEL_LIMIT(unsigned module_id) noexcept
+{
+	return (LOG_MODULE_LEVEL(module_id) < LOG_LEVEL)
+			   ? static_cast<log_level_e>(LOG_MODULE_LEVEL(module_id))
+			   : LOG_LEVEL_LIMIT();
+}
+
 constexpr const char* LOG_LEVEL_TO_C_STRING(log_level_e level)
 {
 	return logNames::level_string_names[level];
@@ -149,6 +350,41 @@ constexpr const char* LOG_LEVEL_TO_SHORT_C_STRING(log_level_e level)
 	return logNames::level_short_names[level];
 }
 
+constexpr size_t LOG_LEVEL_SHORT_C_STRING_LENGTH(log_level_e level)
+{
+	return logNames::level_short_name_lengths[level];
+}
+
+/// Send the short level prefix directly to _putchar(), without going through printf()
+inline void log_echo_level_prefix(log_level_e level) noexcept
+{
+	const char* prefix = LOG_LEVEL_TO_SHORT_C_STRING(level);
+
+	for(size_t i = 0; i < LOG_LEVEL_SHORT_C_STRING_LENGTH(level); i++)
+	{
+		_putchar(prefix[i]);
+	}
+}
+
+/// Log sink (see internal/log_sink.hpp) which sends data to _putchar()
+struct putchar_log_sink
+{
+	size_t write(const char* data, size_t size) noexcept
+	{
+		for(size_t i = 0; i < size; i++)
+		{
+			_putchar(data[i]);
+		}
+
+		return size;
+	}
+};
+
+/// The maximum length of the prefix formatted by LoggerBase::format_customprefix()
+static constexpr size_t log_customprefix_max_size = 32;
+static_assert(log_customprefix_max_size >= log_timestamp_prefix_max_size,
+			  "The custom prefix must have space for a timestamp prefix");
+
 class LoggerBase
 {
   public:
@@ -278,6 +514,110 @@ class LoggerBase
 		return overrun_occurred_;
 	}
 
+#if LOG_STATS_EN
+	/** Access the usage statistics
+	 *
+	 * Only available when LOG_STATS_EN is set. The counters cover the statements logged at
+	 * each level, the bytes lost to overruns, the largest amount of data held in the internal
+	 * buffer (sampled before each flush), and the duration of flushes and storage writes.
+	 * Unlike has_overrun(), the counters are not cleared by flush().
+	 *
+	 *	@code
+	 *	printf("High water: %u of %u bytes\n", (unsigned)logger.stats().high_water(),
+	 *		   (unsigned)logger.capacity());
+	 *	printf("Flush time: %lu us max\n", (unsigned long)logger.stats().flush_time().max());
+	 *	@endcode
+	 */
+	const LogStats<LOG_LEVEL_COUNT>& stats() const noexcept
+	{
+		return stats_;
+	}
+
+	/// Clear the usage statistics
+	void reset_stats() noexcept
+	{
+		stats_.reset();
+	}
+#endif
+
+#if LOG_RATE_LIMIT_EN
+	/** Access the rate limit and duplicate suppression settings
+	 *
+	 * Only available when LOG_RATE_LIMIT_EN is set. By default, each call site may log
+	 * LOG_RATE_LIMIT_BURST statements at once, and then one per LOG_RATE_LIMIT_INTERVAL
+	 * milliseconds, and repeated statements are collapsed.
+	 *
+	 *	@code
+	 *	logger.rate_limiter().limit(5, 1000); // 5 at once, then one per second
+	 *	logger.rate_limiter().collapse_repeats(false);
+	 *	@endcode
+	 */
+	LogRateLimiter<LOG_RATE_LIMIT_SITES>& rate_limiter() noexcept
+	{
+		return rate_limiter_;
+	}
+#endif
+
+	/// The clock used by strategies which write a timestamp prefix
+	log_timestamp_e timestamp_source() const noexcept
+	{
+		return timestamp_.source();
+	}
+
+	/** Select the clock used by strategies which write a timestamp prefix
+	 *
+	 * @param source The clock. log_timestamp_e::delta writes the microseconds since the
+	 *	previous statement.
+	 */
+	void timestamp_source(log_timestamp_e source) noexcept
+	{
+		timestamp_.source(source);
+	}
+
+	/** Access the flush policy
+	 *
+	 * The policy controls when poll() flushes the log, and whether critical statements are
+	 * written out immediately.
+	 *
+	 *	@code
+	 *	logger.flush_policy().watermark(75);
+	 *	logger.flush_policy().max_age(500);
+	 *	logger.flush_policy().flush_on_critical(true);
+	 *	@endcode
+	 */
+	FlushPolicy& flush_policy() noexcept
+	{
+		return flush_policy_;
+	}
+
+	/** Flush the log if the flush policy requires it
+	 *
+	 * Call this from loop(), so that flushes happen at a time the application chooses rather
+	 * than inside a log statement. Each call performs at most one flush, which writes no more
+	 * than the contents of the RAM buffer. To keep flushes out of log statements entirely,
+	 * disable auto_flush() and choose a watermark that leaves room for the data logged
+	 * between calls.
+	 *
+	 * If the previous flush stopped before the buffer was empty (e.g., with a non-blocking
+	 * output), poll() continues it without waiting for the policy.
+	 *
+	 * @param now The current time, in milliseconds (e.g., millis()).
+	 * @returns true if the log was flushed.
+	 */
+	bool poll(uint32_t now) noexcept
+	{
+		bool resume = flush_pending_ && buffered_size() > 0;
+
+		if(resume || flush_policy_.due(buffered_size(), internal_capacity(), now))
+		{
+			flush();
+			flush_policy_.flushed();
+			return true;
+		}
+
+		return false;
+	}
+
 	template<typename... Args>
 	void critical(const char* fmt, const Args&... args)
 	{
@@ -378,16 +718,198 @@ class LoggerBase
 #endif
 	}
 
+	/** @name LOG_FMT() overloads
+	 *
+	 * These versions check the arguments against the format at compile time, and write simple
+	 * formats without parsing them at run time (see log_format.hpp).
+	 *
+	 *	@code
+	 *	logger.info(LOG_FMT("Reading %d: %ld\n"), index, value);
+	 *	@endcode
+	 */
+	///@{
+	template<class TString, typename... Args>
+	void critical(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log(log_level_e::critical, fmt, args...);
+#else
+		log(log_level_e::critical, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void critical_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log_interrupt(log_level_e::critical, fmt, args...);
+#else
+		log_interrupt(log_level_e::critical, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void error(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log(log_level_e::error, fmt, args...);
+#else
+		log(log_level_e::error, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void error_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log_interrupt(log_level_e::error, fmt, args...);
+#else
+		log_interrupt(log_level_e::error, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void warning(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log(log_level_e::warning, fmt, args...);
+#else
+		log(log_level_e::warning, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void warning_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log_interrupt(log_level_e::warning, fmt, args...);
+#else
+		log_interrupt(log_level_e::warning, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void info(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log(log_level_e::info, fmt, args...);
+#else
+		log(log_level_e::info, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void info_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log_interrupt(log_level_e::info, fmt, args...);
+#else
+		log_interrupt(log_level_e::info, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void debug(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log(log_level_e::debug, fmt, args...);
+#else
+		log(log_level_e::debug, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	void debug_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+#if defined(__AVR__)
+		log_interrupt(log_level_e::debug, fmt, args...);
+#else
+		log_interrupt(log_level_e::debug, fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	/// @see print()
+	template<class TString, typename... Args>
+	void print(const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+#if LOG_RECORDS_STAGED
+		LogRecordBuilder<LOG_RECORD_MAX_SIZE> record;
+		log_format_write(record, fmt, args...);
+		write(record.data(), record.size());
+#else
+		if(echo_)
+		{
+			echo_staging out(*this);
+			log_format_write(out, fmt, args...);
+			stats_wrote(out.finish());
+		}
+		else
+		{
+			format_output out(*this);
+			log_format_write(out, fmt, args...);
+			stats_wrote(out.size());
+		}
+#endif
+	}
+
+	/// @see log_interrupt()
+	template<class TString, typename... Args>
+	void log_interrupt(log_level_e l, const log_format<TString>& fmt,
+					   const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		log_interrupt_statement(l, fmt, args...);
+	}
+
+	/// @see log()
+	template<class TString, typename... Args>
+	void log(log_level_e l, const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		log_statement(l, fmt, args...);
+	}
+	///@}
+
 	/// Prints directly to the log with no extra characters added to the message.
 	template<typename... Args>
 	void print(const Args&... args) noexcept
 	{
-		fctprintf(&LoggerBase::log_add_char_to_buffer_bounce, this, args...);
+#if LOG_RECORDS_STAGED
+		LogRecordBuilder<LOG_RECORD_MAX_SIZE> record;
+		fctprintf(&LogRecordBuilder<LOG_RECORD_MAX_SIZE>::putc_bounce, &record, args...);
+		write(record.data(), record.size());
+#else
+		if(echo_)
+		{
+			// Format once, for both the log and the console
+			echo_staging out(*this);
+			fctprintf(&echo_staging::putc_bounce, &out, args...);
+			stats_wrote(out.finish());
+		}
+		else
+		{
+			int count = fctprintf(putc_, this, args...);
+			stats_wrote(count > 0 ? static_cast<size_t>(count) : 0);
+		}
+#endif
+	}
+
+	/** Write a block of pre-formatted characters directly to the log.
+	 *
+	 * Like print(), no extra characters are added. Unlike print(), the data is not run through
+	 * the printf() formatter, and it is handed to the logging strategy in a single call.
+	 *
+	 * @param str The characters to add to the log. Does not need to be NUL-terminated.
+	 * @param len The number of characters to add.
+	 */
+	void write(const char* str, size_t len) noexcept
+	{
+		log_write(str, len);
+		stats_wrote(len);
 
 		if(echo_)
 		{
-			// cppcheck-suppress wrongPrintfScanfArgNum
-			printf(args...);
+			printf("%.*s", static_cast<int>(len), str);
 		}
 	}
 
@@ -405,23 +927,7 @@ class LoggerBase
 	template<typename... Args>
 	void log_interrupt(log_level_e l, const char* fmt, const Args&... args) noexcept
 	{
-		if(enabled_ && l <= level_)
-		{
-			bool flush_setting = auto_flush(false);
-			bool echo_setting = echo(false);
-
-			// Add our prefix
-			print("%s", LOG_LEVEL_TO_SHORT_C_STRING(l));
-
-			log_customprefix();
-
-			// Send the primary log statement
-			print(fmt, args...);
-
-			// Restore prior settings
-			auto_flush(flush_setting);
-			echo(echo_setting);
-		}
+		log_interrupt_statement(l, fmt, args...);
 	}
 
 	/** Add data to the log buffer
@@ -435,16 +941,26 @@ class LoggerBase
 	template<typename... Args>
 	void log(log_level_e l, const char* fmt, const Args&... args) noexcept
 	{
-		if(enabled_ && l <= level_)
-		{
-			// Add our prefix
-			print("%s", LOG_LEVEL_TO_SHORT_C_STRING(l));
-
-			log_customprefix();
+		log_statement(l, fmt, args...);
+	}
 
-			// Send the primary log statement
-			print(fmt, args...);
-		}
+	/** Add a structured record to the log
+	 *
+	 * The record is written in place of the message, after the level and custom prefixes,
+	 * e.g. `<I> @motor rpm=3000,amps=1.25`. The format is described in internal/log_kv.hpp.
+	 *
+	 * @code
+	 * logger.log_kv(log_level_e::info, "motor", kv("rpm", rpm), kv("amps", amps));
+	 * @endcode
+	 *
+	 * @param l The log level associated with this record.
+	 * @param name The record name. It identifies the call site, like a format string.
+	 * @param fields The fields of the record, created with kv().
+	 */
+	template<typename... Fields>
+	void log_kv(log_level_e l, const char* name, const log_kv_field<Fields>&... fields) noexcept
+	{
+		log_statement(l, log_kv_record{name}, fields...);
 	}
 
 	/// Flush the buffered log contents to the target output stream
@@ -452,15 +968,19 @@ class LoggerBase
 	/// Can be overridden if desired
 	virtual void flush() noexcept
 	{
-		if(internal_size() > 0 || (ready_buffer_exists() && ready_buffer_internal_size() > 0))
+		write_rate_limit_summary(*this);
+
+		if(buffered_size() > 0)
 		{
+			uint32_t start = stats_flush_started();
 			flush_();
 			if(overrun_occurred_)
 			{
-				critical("---Log buffer overrun detected---\n");
+				write_overrun_marker(*this);
 				flush_();
 			}
 			overrun_occurred_ = false;
+			stats_flushed(start);
 		}
 	}
 
@@ -484,14 +1004,42 @@ class LoggerBase
 	/// Can be overridden if desired
 	virtual void clear() noexcept
 	{
+		stats_buffered(internal_size());
 		overrun_occurred_ = false;
+#if LOG_RECORDS_STAGED
+		dropped_records_ = 0;
+		dropped_record_bytes_ = 0;
+#endif
+#if LOG_RATE_LIMIT_EN
+		rate_limiter_.reset();
+#endif
+		flush_pending_ = false;
 		clear_();
 	}
 
   protected:
+	/// The signature of the per-character output function print() passes to fctprintf()
+	using putc_function = void (*)(char c, void* this_ptr);
+
 	/// Default constructor
 	LoggerBase() = default;
 
+	/** Initialize the logger with a per-character output function and options
+	 *
+	 * Used by LoggerBaseT to route print() output to the strategy without virtual calls.
+	 *
+	 * @param putc The function print() passes to fctprintf(). It receives the this pointer
+	 *	of the LoggerBase instance.
+	 * @param enable @see LoggerBase(bool, log_level_e, bool)
+	 * @param l @see LoggerBase(bool, log_level_e, bool)
+	 * @param echo @see LoggerBase(bool, log_level_e, bool)
+	 */
+	explicit LoggerBase(putc_function putc, bool enable = LOG_EN_DEFAULT,
+						log_level_e l = LOG_LEVEL_LIMIT(), bool echo = LOG_ECHO_EN_DEFAULT) noexcept
+		: enabled_(enable), level_(l), echo_(echo), putc_(putc)
+	{
+	}
+
 	/** Initialize the logger with options
 	 *
 	 * @param enable If true, log statements will be output to the log buffer. If false,
@@ -539,9 +1087,35 @@ class LoggerBase
 	 * Recommended use of this field might include generating a timestamp:
 	 *	<!> [0081838ms] Message goes here.
 	 *
-	 * Derived classes must implement this function.
+	 * The default implementation writes the prefix formatted by format_customprefix().
+	 * Overrides are not used when LOG_CONCURRENT_EN or LOG_RECORD_FRAMING_EN is set.
+	 */
+	virtual void log_customprefix()
+	{
+		char prefix[log_customprefix_max_size];
+		size_t len = format_customprefix(prefix);
+
+		if(len > 0)
+		{
+			write(prefix, len);
+		}
+	}
+
+	/** Format a custom prefix for the log statement
+	 *
+	 * An alternative to overriding log_customprefix(), which also works with LOG_CONCURRENT_EN
+	 * and LOG_RECORD_FRAMING_EN. The prefix is formatted into a buffer instead of being written
+	 * to the log, so the logger can add it to a statement which is assembled before it is added
+	 * to the log. For a timestamp, use format_timestamp_prefix().
+	 *
+	 * @param dst The destination. Has space for log_customprefix_max_size characters.
+	 * @returns The length of the prefix. The default implementation returns 0 (no prefix).
 	 */
-	virtual void log_customprefix() {}
+	virtual size_t format_customprefix(char* dst) noexcept
+	{
+		static_cast<void>(dst);
+		return 0;
+	}
 
 	/** Log buffer putc function
 	 *
@@ -556,6 +1130,89 @@ class LoggerBase
 	 */
 	virtual void log_putc(char c) = 0;
 
+	/** Log buffer block write function
+	 *
+	 * This function adds a block of pre-formatted characters to the underlying log buffer.
+	 * It is used for data that does not need to pass through the formatter, such as the
+	 * level prefix and the data supplied to write().
+	 *
+	 * The default implementation forwards each character to log_add_char_to_buffer().
+	 * Derived classes should override this function if their storage supports block
+	 * insertion. log_write_to_buffer() implements the override for CircularBuffer-style
+	 * storage while preserving the auto-flush and overrun behavior.
+	 *
+	 * @param str The characters to insert into the log buffer.
+	 * @param len The number of characters to insert.
+	 */
+	virtual void log_write(const char* str, size_t len)
+	{
+		for(size_t i = 0; i < len; i++)
+		{
+			log_add_char_to_buffer(str[i]);
+		}
+	}
+
+	/** Helper for implementing log_write() with a block-capable buffer.
+	 *
+	 * The data is inserted in chunks that fit the free space of the internal buffer.
+	 * When the buffer fills, we flush or record an overrun just like log_add_char_to_buffer().
+	 * With LOG_CONCURRENT_EN or LOG_RECORD_FRAMING_EN, the data is a whole statement and is
+	 * inserted as a record instead (see buffer_put_record()), so whole statements are dropped.
+	 *
+	 * @tparam TBuffer The buffer type. Must provide a put(const char*, size_t) overload.
+	 * @param buffer The internal storage buffer that backs internal_size()/internal_capacity().
+	 * @param str The characters to insert into the log buffer.
+	 * @param len The number of characters to insert.
+	 */
+	template<class TBuffer>
+	void log_write_to_buffer(TBuffer& buffer, const char* str, size_t len)
+	{
+#if LOG_RECORDS_STAGED
+#if !LOG_CONCURRENT_EN
+		// With LOG_CONCURRENT_EN, producers never flush
+		if(len > internal_capacity() - internal_size() && auto_flush())
+		{
+			flush_from_log();
+		}
+#endif
+
+		record_drop_count dropped = buffer_put_record(buffer, str, len);
+
+		if(dropped.records > 0)
+		{
+			overrun_occurred_ = true;
+			dropped_records_ += dropped.records;
+			dropped_record_bytes_ += dropped.bytes;
+			stats_dropped(dropped.bytes);
+		}
+#else
+		while(len > 0)
+		{
+			size_t space = internal_capacity() - internal_size();
+
+			if(space == 0 && auto_flush())
+			{
+				// A busy output (e.g., log_sink_ref::nonblocking()) may accept nothing
+				flush_from_log();
+				space = internal_capacity() - internal_size();
+			}
+
+			// If no space could be made, the remaining data overwrites the oldest data
+			size_t chunk = (space == 0 || space > len) ? len : space;
+
+			if(space == 0)
+			{
+				overrun_occurred_ = true;
+				stats_dropped(chunk);
+			}
+
+			buffer.put(str, chunk);
+			str += chunk;
+			len -= chunk;
+		}
+#endif
+	}
+
 	/** Helper function for logging to the buffer.
 	 *
 	 * If auto-flushing is enabled, we check whether the RAM buffer storage
@@ -568,21 +1225,325 @@ class LoggerBase
 	 */
 	virtual void log_add_char_to_buffer(char c)
 	{
+		if(internal_size() == internal_capacity() && auto_flush())
+		{
+			flush_from_log();
+		}
+
+		// If the flush made no space, the character overwrites the oldest data
 		if(internal_size() == internal_capacity())
 		{
-			if(auto_flush())
-			{
-				flush();
-			}
-			else
-			{
-				overrun_occurred_ = true;
-			}
+			overrun_occurred_ = true;
+			stats_dropped(1);
 		}
 
 		log_putc(c);
 	}
 
+	/** Record whether the last flush left data in the buffer
+	 *
+	 * Strategies whose flush_() can return before the buffer is empty (e.g., because the
+	 * output is busy) call this, so that poll() resumes the flush on its next call.
+	 */
+	void flush_pending(bool pending) noexcept
+	{
+		flush_pending_ = pending;
+	}
+
+	/** Write a timestamp prefix, such as "[123 ms] ", to the log
+	 *
+	 * This is a fast replacement for print("[%u ms] ", millis()) in log_customprefix().
+	 * The prefix is formatted without printf() and written with a single write() call.
+	 *
+	 * @param now The current reading of the clock selected by timestamp_source()
+	 *	(see log_timestamp_now()).
+	 */
+	void write_timestamp_prefix(uint32_t now) noexcept
+	{
+		char prefix[log_timestamp_prefix_max_size];
+		write(prefix, format_timestamp_prefix(prefix, now));
+	}
+
+	/** Format a timestamp prefix, such as "[123 ms] ", for format_customprefix()
+	 *
+	 * @param dst The destination. Must have space for log_timestamp_prefix_max_size
+	 *	characters.
+	 * @param now The current reading of the clock selected by timestamp_source()
+	 *	(see log_timestamp_now()).
+	 * @returns The length of the prefix.
+	 */
+	size_t format_timestamp_prefix(char* dst, uint32_t now) noexcept
+	{
+		return timestamp_.format(dst, now);
+	}
+
+	/** Write out a completed log statement if the flush policy requires it
+	 *
+	 * Strategies which implement their own log() call this after adding a statement.
+	 * The buffer is written with flush_(), so this is safe to call from within flush().
+	 * An overrun is still reported by the next flush().
+	 *
+	 * @param l The log level of the statement.
+	 */
+	void flush_on_level(log_level_e l) noexcept
+	{
+#if LOG_CONCURRENT_EN
+		// The consumer flushes, so a critical statement is written by its next flush()
+		static_cast<void>(l);
+#else
+		if(l == log_level_e::critical && flush_policy_.flush_on_critical() && buffered_size() > 0)
+		{
+			bool nested = flushing_from_log_;
+			flushing_from_log_ = true;
+			uint32_t start = stats_flush_started();
+			flush_();
+			stats_flushed(start);
+			flushing_from_log_ = nested;
+		}
+#endif
+	}
+
+	/** Returns true while log() flushes the buffer
+	 *
+	 * This is the case during an auto-flush, which makes room for a statement, and during the
+	 * flush of a critical statement (see flush_on_level()). Strategies defer slow work in their
+	 * flush path, such as starting the next log file, to the next explicit flush() or poll().
+	 * log() is then not delayed by it, and a statement is not split across files.
+	 */
+	bool flushing_from_log() const noexcept
+	{
+		return flushing_from_log_;
+	}
+
+	/// Flush the buffer from within log(), to make room for a statement
+	/// @see flushing_from_log()
+	void flush_from_log() noexcept
+	{
+		bool nested = flushing_from_log_;
+		flushing_from_log_ = true;
+		flush();
+		flushing_from_log_ = nested;
+	}
+
+	/** Set or clear the overrun flag.
+	 *
+	 * Strategies which manage their own storage use this to report lost data through
+	 * has_overrun(), or to clear the flag when they override flush().
+	 *
+	 * @param occurred True if data has been lost from the log buffer.
+	 */
+	void overrun_occurred(bool occurred) noexcept
+	{
+		overrun_occurred_ = occurred;
+	}
+
+	/** Check a statement against the rate limit (see LOG_RATE_LIMIT_EN)
+	 *
+	 * Strategies which implement their own log() call this before adding a statement. If the
+	 * statement is logged, the repeats of the previous statement are reported first.
+	 * When LOG_RATE_LIMIT_EN is not set, this returns true, and the call compiles away.
+	 *
+	 * @param logger The strategy, whose log() writes the report.
+	 * @returns true if the statement should be logged.
+	 */
+#if LOG_RATE_LIMIT_EN
+	template<class TLogger, typename... Args>
+	bool rate_limit_admit(TLogger& logger, log_level_e l, const char* fmt,
+						  const Args&... args) noexcept
+	{
+		if(rate_limit_reporting_)
+		{
+			return true;
+		}
+
+		if(!rate_limiter_.admit(fmt, static_cast<uint8_t>(l), log_hash_args(args...),
+								LOG_RATE_LIMIT_CLOCK()))
+		{
+			return false;
+		}
+
+		log_suppressed_site repeated;
+
+		if(rate_limiter_.take_repeats(repeated))
+		{
+			rate_limit_reporting_ = true;
+			write_repeats(logger, repeated);
+			rate_limit_reporting_ = false;
+		}
+
+		return true;
+	}
+#else
+	template<class TLogger, typename... Args>
+	bool rate_limit_admit(TLogger& /*logger*/, log_level_e /*l*/, const char* /*fmt*/,
+						  const Args&... /*args*/) noexcept
+	{
+		return true;
+	}
+#endif
+
+	/** Report the data lost since the last flush, and clear the counts of dropped records
+	 *
+	 * Strategies which override flush() call this after an overrun, before they flush again.
+	 *
+	 * @param logger The strategy, whose log() writes the report.
+	 */
+	template<class TLogger>
+	void write_overrun_marker(TLogger& logger) noexcept
+	{
+#if LOG_RECORDS_STAGED
+		if(dropped_records_ > 0)
+		{
+			unsigned records = static_cast<unsigned>(dropped_records_);
+			unsigned bytes = static_cast<unsigned>(dropped_record_bytes_);
+			dropped_records_ = 0;
+			dropped_record_bytes_ = 0;
+			logger.log(log_level_e::critical,
+					   "---Log buffer overrun: %u records (%u bytes) dropped---\n", records, bytes);
+			return;
+		}
+#endif
+		logger.log(log_level_e::critical, "---Log buffer overrun detected---\n");
+	}
+
+	/** Write the counts of the statements which were not logged because of the rate limit
+	 *
+	 * Strategies which override flush() call this first.
+	 * When LOG_RATE_LIMIT_EN is not set, this does nothing.
+	 *
+	 * @param logger The strategy, whose log() writes the report.
+	 */
+	template<class TLogger>
+	void write_rate_limit_summary(TLogger& logger) noexcept
+	{
+#if LOG_RATE_LIMIT_EN
+		if(rate_limit_reporting_)
+		{
+			return;
+		}
+
+		// Each count is cleared before it is written, so a flush during the report is safe
+		rate_limit_reporting_ = true;
+		log_suppressed_site site;
+
+		while(rate_limiter_.take_repeats(site))
+		{
+			write_repeats(logger, site);
+		}
+
+		while(rate_limiter_.take_suppressed(site))
+		{
+			// Record names (see log_kv()) have no newline
+			size_t len = strlen(site.key);
+			bool newline = (len > 0 && site.key[len - 1] == '\n');
+			logger.log(static_cast<log_level_e>(site.level),
+					   newline ? "---Rate limited %lu statements--- %s"
+							   : "---Rate limited %lu statements--- %s\n",
+					   static_cast<unsigned long>(site.count), site.key);
+		}
+
+		rate_limit_reporting_ = false;
+#else
+		static_cast<void>(logger);
+#endif
+	}
+
+	/** @name Statistics hooks
+	 *
+	 * Strategies call these to update stats(). When LOG_STATS_EN is not set, they are empty,
+	 * and stats_clock() returns 0, so the calls compile away.
+	 */
+	///@{
+
+	/// Read the clock used for stats() durations, in microseconds
+	static uint32_t stats_clock() noexcept
+	{
+#if LOG_STATS_EN
+		return LOG_STATS_CLOCK();
+#else
+		return 0;
+#endif
+	}
+
+	/// The total number of bytes written to the log so far
+	uint64_t stats_bytes() const noexcept
+	{
+#if LOG_STATS_EN
+		return stats_.bytes();
+#else
+		return 0;
+#endif
+	}
+
+	/// Record data written to the log
+	void stats_wrote(size_t bytes) noexcept
+	{
+#if LOG_STATS_EN
+		stats_.wrote(bytes);
+#else
+		static_cast<void>(bytes);
+#endif
+	}
+
+	/// Record a log statement at level l. `start` is stats_bytes() from before the statement.
+	void stats_logged(log_level_e l, uint64_t start) noexcept
+	{
+#if LOG_STATS_EN
+		stats_.logged(static_cast<size_t>(l), start);
+#else
+		static_cast<void>(l);
+		static_cast<void>(start);
+#endif
+	}
+
+	/// Record data which was overwritten or discarded because the buffer was full
+	void stats_dropped(size_t bytes) noexcept
+	{
+#if LOG_STATS_EN
+		stats_.dropped(bytes);
+#else
+		static_cast<void>(bytes);
+#endif
+	}
+
+	/// Record the current size of the internal buffer for the high-water mark
+	void stats_buffered(size_t size) noexcept
+	{
+#if LOG_STATS_EN
+		stats_.buffered(size);
+#else
+		static_cast<void>(size);
+#endif
+	}
+
+	/// Call before a flush. Samples the high-water mark, and returns the start time.
+	uint32_t stats_flush_started() noexcept
+	{
+		stats_buffered(internal_size());
+		return stats_clock();
+	}
+
+	/// Call after a flush which began at `start` (see stats_flush_started())
+	void stats_flushed(uint32_t start) noexcept
+	{
+#if LOG_STATS_EN
+		stats_.flushed(stats_clock() - start);
+#else
+		static_cast<void>(start);
+#endif
+	}
+
+	/// Call after a write to the storage which began at `start` (see stats_clock())
+	void stats_stored(uint32_t start) noexcept
+	{
+#if LOG_STATS_EN
+		stats_.stored(stats_clock() - start);
+#else
+		static_cast<void>(start);
+#endif
+	}
+	///@}
+
 	/** putc bounce function
 	 *
 	 * This is a bounce function which registers with the C printf API. We use the private parameter
@@ -634,6 +1595,269 @@ class LoggerBase
 	}
 
   private:
+	/// The number of bytes held in the internal buffer and the ready buffer
+	size_t buffered_size() const noexcept
+	{
+		return internal_size() + (ready_buffer_exists() ? ready_buffer_internal_size() : 0);
+	}
+
+	/// The body of log(). TFormat is `const char*`, a log_format, or a log_kv_record.
+	template<class TFormat, typename... Args>
+	void log_statement(log_level_e l, const TFormat& fmt, const Args&... args) noexcept
+	{
+		if(enabled_ && l <= level_ && rate_limit_admit(*this, l, fmt, args...))
+		{
+			uint64_t start = stats_bytes();
+
+#if LOG_RECORDS_STAGED
+			log_record(l, true, fmt, args...);
+#else
+			// Add our prefix
+			write_level_prefix(l);
+
+			log_customprefix();
+
+			// Send the primary log statement
+			print_message(fmt, args...);
+#endif
+			stats_logged(l, start);
+
+			flush_on_level(l);
+		}
+	}
+
+	/// The body of log_interrupt(). TFormat is `const char*`, a log_format, or a log_kv_record.
+	template<class TFormat, typename... Args>
+	void log_interrupt_statement(log_level_e l, const TFormat& fmt, const Args&... args) noexcept
+	{
+		if(enabled_ && l <= level_)
+		{
+#if LOG_CONCURRENT_EN
+			// Producers never flush, and the settings are shared, so they are left alone
+			uint64_t start = stats_bytes();
+			log_record(l, false, fmt, args...);
+			stats_logged(l, start);
+#else
+			bool flush_setting = auto_flush(false);
+			bool echo_setting = echo(false);
+			uint64_t start = stats_bytes();
+
+#if LOG_RECORD_FRAMING_EN
+			log_record(l, false, fmt, args...);
+#else
+			// Add our prefix
+			write_level_prefix(l);
+
+			log_customprefix();
+
+			// Send the primary log statement
+			print_message(fmt, args...);
+#endif
+			stats_logged(l, start);
+
+			// Restore prior settings
+			auto_flush(flush_setting);
+			echo(echo_setting);
+#endif
+		}
+	}
+
+	/// Output for log_format_write() which adds to the log like print() does
+	class format_output
+	{
+	  public:
+		explicit format_output(LoggerBase& logger) noexcept : logger_(logger) {}
+
+		void put(char c) noexcept
+		{
+			logger_.putc_(c, &logger_);
+			size_++;
+		}
+
+		void put(const char* str, size_t len) noexcept
+		{
+			logger_.log_write(str, len);
+			size_ += len;
+		}
+
+		size_t size() const noexcept
+		{
+			return size_;
+		}
+
+		static void putc_bounce(char c, void* out) noexcept
+		{
+			static_cast<format_output*>(out)->put(c);
+		}
+
+	  private:
+		LoggerBase& logger_;
+		size_t size_ = 0;
+	};
+
+	/// The message of a log statement. Format strings are written by print().
+	template<class TFormat, typename... Args>
+	void print_message(const TFormat& fmt, const Args&... args) noexcept
+	{
+		print(fmt, args...);
+	}
+
+	template<typename... Fields>
+	void print_message(const log_kv_record& record, const log_kv_field<Fields>&... fields) noexcept
+	{
+		if(echo_)
+		{
+			echo_staging out(*this);
+			log_kv_write(out, record, fields...);
+			stats_wrote(out.finish());
+		}
+		else
+		{
+			format_output out(*this);
+			log_kv_write(out, record, fields...);
+			stats_wrote(out.size());
+		}
+	}
+
+	/** Output for messages which are echoed
+	 *
+	 * The message is formatted once into a stack buffer. Each time the buffer fills, and at
+	 * finish(), its contents are added to the log and printed to the console.
+	 */
+	class echo_staging
+	{
+	  public:
+		explicit echo_staging(LoggerBase& logger) noexcept : logger_(logger) {}
+
+		void put(char c) noexcept
+		{
+			if(size_ == LOG_ECHO_STAGING_SIZE)
+			{
+				drain();
+			}
+
+			buffer_[size_++] = c;
+		}
+
+		void put(const char* str, size_t len) noexcept
+		{
+			if(size_ + len > LOG_ECHO_STAGING_SIZE)
+			{
+				drain();
+
+				// Too long to stage, so it is copied as it is
+				if(len >= LOG_ECHO_STAGING_SIZE)
+				{
+					copy(str, len);
+					return;
+				}
+			}
+
+			memcpy(&buffer_[size_], str, len);
+			size_ += len;
+		}
+
+		static void putc_bounce(char c, void* out) noexcept
+		{
+			static_cast<echo_staging*>(out)->put(c);
+		}
+
+		/// Copy the rest of the message, and return the length of the whole message
+		size_t finish() noexcept
+		{
+			drain();
+			return written_;
+		}
+
+	  private:
+		void drain() noexcept
+		{
+			copy(buffer_, size_);
+			size_ = 0;
+		}
+
+		void copy(const char* str, size_t len) noexcept
+		{
+			if(len > 0)
+			{
+				logger_.log_write(str, len);
+				printf("%.*s", static_cast<int>(len), str);
+				written_ += len;
+			}
+		}
+
+		LoggerBase& logger_;
+		char buffer_[LOG_ECHO_STAGING_SIZE];
+		size_t size_ = 0;
+		size_t written_ = 0;
+	};
+
+	void write_level_prefix(log_level_e l) noexcept
+	{
+		write(LOG_LEVEL_TO_SHORT_C_STRING(l), LOG_LEVEL_SHORT_C_STRING_LENGTH(l));
+	}
+
+#if LOG_RATE_LIMIT_EN
+	template<class TLogger>
+	static void write_repeats(TLogger& logger, const log_suppressed_site& site) noexcept
+	{
+		logger.log(static_cast<log_level_e>(site.level), "---Last message repeated %lu times---\n",
+				   static_cast<unsigned long>(site.count));
+	}
+#endif
+
+#if LOG_RECORDS_STAGED
+	/** Assemble a log statement on the stack, and add it to the log in a single call
+	 *
+	 * @param l The log level of the statement.
+	 * @param echo If false, the statement is not echoed, whatever the echo() setting.
+	 * @param fmt The log format string, or a LOG_FMT() string.
+	 * @param args The arguments that are associated with the format string.
+	 */
+	template<class TFormat, typename... Args>
+	void log_record(log_level_e l, bool echo, const TFormat& fmt, const Args&... args) noexcept
+	{
+		LogRecordBuilder<LOG_RECORD_MAX_SIZE> record;
+		char prefix[log_customprefix_max_size];
+
+		record.put(LOG_LEVEL_TO_SHORT_C_STRING(l), LOG_LEVEL_SHORT_C_STRING_LENGTH(l));
+		record.put(prefix, format_customprefix(prefix));
+		format_record(record, fmt, args...);
+
+		const char* data = record.data();
+		log_write(data, record.size());
+		stats_wrote(record.size());
+
+		if(echo && echo_)
+		{
+			printf("%.*s", static_cast<int>(record.size()), data);
+		}
+	}
+
+	template<typename... Args>
+	static void format_record(LogRecordBuilder<LOG_RECORD_MAX_SIZE>& record, const char* fmt,
+							  const Args&... args) noexcept
+	{
+		// cppcheck-suppress wrongPrintfScanfArgNum
+		fctprintf(&LogRecordBuilder<LOG_RECORD_MAX_SIZE>::putc_bounce, &record, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	static void format_record(LogRecordBuilder<LOG_RECORD_MAX_SIZE>& record,
+							  const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_write(record, fmt, args...);
+	}
+
+	template<typename... Fields>
+	static void format_record(LogRecordBuilder<LOG_RECORD_MAX_SIZE>& record,
+							  const log_kv_record& kv_record,
+							  const log_kv_field<Fields>&... fields) noexcept
+	{
+		log_kv_write(record, kv_record, fields...);
+	}
+#endif
+
 	/// Indicates whether logging is currently enabled
 	bool enabled_ = LOG_EN_DEFAULT;
 
@@ -641,10 +1865,19 @@ class LoggerBase
 	/// is full. If disabled, the user is responsible for coordinating flush() calls.
 	bool auto_flush_ = LOG_AUTOFLUSH_DEFAULT;
 
+	/// Indicates whether log() is flushing the buffer. @see flushing_from_log()
+	bool flushing_from_log_ = false;
+
 	/// Indicates whether an overrun has occurred between flush() calls. If this is `true`,
 	/// then you know data has been lost.
 	bool overrun_occurred_ = false;
 
+#if LOG_RECORDS_STAGED
+	/// The statements, and their bytes, dropped since the last flush() because the buffer was full
+	size_t dropped_records_ = 0;
+	size_t dropped_record_bytes_ = 0;
+#endif
+
 	/// The current log level.
 	/// Levels greater than the current setting will be filtered out.
 	log_level_e level_ = LOG_LEVEL_LIMIT();
@@ -652,6 +1885,128 @@ class LoggerBase
 	/// Console echoing.
 	/// If true, log statements will be printed to the console through printf().
 	bool echo_ = LOG_ECHO_EN_DEFAULT;
+
+	/// Controls when poll() flushes, and whether critical statements flush immediately
+	FlushPolicy flush_policy_;
+
+	/// Set by strategies whose flush can return before the buffer is empty, so that poll()
+	/// resumes the flush on the next call
+	bool flush_pending_ = false;
+
+	/// Formats the timestamp prefix written by write_timestamp_prefix()
+	TimestampPrefix timestamp_;
+
+#if LOG_STATS_EN
+	/// Usage statistics, see stats()
+	LogStats<LOG_LEVEL_COUNT> stats_;
+#endif
+
+#if LOG_RATE_LIMIT_EN
+	/// Rate limit and duplicate suppression, see rate_limiter()
+	LogRateLimiter<LOG_RATE_LIMIT_SITES> rate_limiter_;
+	/// Set while the counts are written, so the reports are not limited themselves
+	bool rate_limit_reporting_ = false;
+#endif
+
+	/// The per-character output function used by print()
+	putc_function putc_ = &LoggerBase::log_add_char_to_buffer_bounce;
+};
+
+/** CRTP base class for logging strategies
+ *
+ * Deriving from LoggerBase routes every character through four virtual calls:
+ * log_add_char_to_buffer(), internal_size(), internal_capacity(), and log_putc().
+ * Deriving from LoggerBaseT<Strategy> instead makes those calls on the strategy type itself.
+ * Because strategies are final, the compiler resolves them statically and can inline the
+ * whole per-character path. The strategy remains a LoggerBase, so code which uses loggers
+ * through a LoggerBase reference is unaffected.
+ *
+ * The strategy must be final, and must declare LoggerBaseT as a friend so that it can reach
+ * the protected overrides:
+ *
+ *	@code
+ *	class MyLogger final : public LoggerBaseT<MyLogger>
+ *	{
+ *		friend class LoggerBaseT<MyLogger>;
+ *		...
+ *	};
+ *	@endcode
+ *
+ * @tparam TDerived The logging strategy type.
+ */
+template<class TDerived>
+class LoggerBaseT : public LoggerBase
+{
+  protected:
+	/// Default constructor
+	LoggerBaseT() noexcept : LoggerBase(&LoggerBaseT::log_add_char_to_buffer_bounce) {}
+
+	/// Initialize the logger with options
+	/// @see LoggerBase(bool, log_level_e, bool)
+	explicit LoggerBaseT(bool enable, log_level_e l = LOG_LEVEL_LIMIT(),
+						 bool echo = LOG_ECHO_EN_DEFAULT) noexcept
+		: LoggerBase(&LoggerBaseT::log_add_char_to_buffer_bounce, enable, l, echo)
+	{
+	}
+
+	/// Default destructor
+	~LoggerBaseT() = default;
+
+	/// @see LoggerBase::log_add_char_to_buffer()
+	/// The strategy functions are called with qualified names. Since the strategy is final,
+	/// these are its final overriders, and the calls need no virtual dispatch.
+	void log_add_char_to_buffer(char c) override
+	{
+		TDerived& self = derived();
+
+		if(self.TDerived::internal_size() == self.TDerived::internal_capacity())
+		{
+			// Not on the fast path, so a virtual call keeps the flush code out of line
+			if(auto_flush())
+			{
+				flush_from_log();
+			}
+
+			// If the flush made no space, the character overwrites the oldest data
+			if(self.TDerived::internal_size() == self.TDerived::internal_capacity())
+			{
+				overrun_occurred(true);
+				stats_dropped(1);
+			}
+		}
+
+		self.TDerived::log_putc(c);
+	}
+
+	/// @see LoggerBase::internal_size()
+	size_t internal_size() const noexcept override
+	{
+		return derived().TDerived::size();
+	}
+
+	/// @see LoggerBase::internal_capacity()
+	size_t internal_capacity() const noexcept override
+	{
+		return derived().TDerived::capacity();
+	}
+
+  private:
+	TDerived& derived() noexcept
+	{
+		return static_cast<TDerived&>(*this);
+	}
+
+	const TDerived& derived() const noexcept
+	{
+		return static_cast<const TDerived&>(*this);
+	}
+
+	/// Forwards a character to the strategy's log_add_char_to_buffer() without a virtual call
+	static void log_add_char_to_buffer_bounce(char c, void* this_ptr)
+	{
+		auto self = static_cast<TDerived*>(static_cast<LoggerBase*>(this_ptr));
+		self->TDerived::log_add_char_to_buffer(c);
+	}
 };
 
 /** Declare a static platform logger instance.
@@ -795,11 +2150,154 @@ class PlatformLogger_t
 #endif
 	}
 
+	/// @see LoggerBase LOG_FMT() overloads
+	/// The arguments are checked here, so the check does not depend on the strategy.
+	///@{
+	template<class TString, typename... Args>
+	inline static void critical(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().critical(fmt, args...);
+#else
+		inst().critical(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void error(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().error(fmt, args...);
+#else
+		inst().error(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void warning(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().warning(fmt, args...);
+#else
+		inst().warning(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void info(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().info(fmt, args...);
+#else
+		inst().info(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void debug(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().debug(fmt, args...);
+#else
+		inst().debug(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void critical_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().critical_interrupt(fmt, args...);
+#else
+		inst().critical_interrupt(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void error_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().error_interrupt(fmt, args...);
+#else
+		inst().error_interrupt(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void warning_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().warning_interrupt(fmt, args...);
+#else
+		inst().warning_interrupt(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void info_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().info_interrupt(fmt, args...);
+#else
+		inst().info_interrupt(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void debug_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().debug_interrupt(fmt, args...);
+#else
+		inst().debug_interrupt(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+
+	template<class TString, typename... Args>
+	inline static void print(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+#if defined(__AVR__)
+		inst().print(fmt, args...);
+#else
+		inst().print(fmt, std::forward<const Args>(args)...);
+#endif
+	}
+	///@}
+
+	/// @see LoggerBase::log_kv()
+	template<typename... Fields>
+	inline static void log_kv(log_level_e l, const char* name,
+							  const log_kv_field<Fields>&... fields)
+	{
+		inst().log_kv(l, name, fields...);
+	}
+
+	inline static void write(const char* str, size_t len)
+	{
+		inst().write(str, len);
+	}
+
 	inline static void flush()
 	{
 		inst().flush();
 	}
 
+	inline static bool poll(uint32_t now)
+	{
+		return inst().poll(now);
+	}
+
 	inline static void clear()
 	{
 		inst().clear();
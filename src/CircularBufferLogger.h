@@ -9,6 +9,9 @@
 
 #include "ArduinoLogger.h"
 #include "internal/circular_buffer.hpp"
+#include "internal/log_query.hpp"
+#include "internal/log_sink.hpp"
+#include "internal/record_circular_buffer.hpp"
 
 /** Circular log buffer
  *
@@ -17,23 +20,34 @@
  * overwrite old data. This enables seemingly "infinite" memory with a fixed capacity, preferring
  * the newest data be kept.
  *
- * @tparam TBufferSize Defines the size of the circular log buffer.
- * Set to 0 to disable logging completely (for memory constrained systems).
- * @note Size requirement: power-of-2 for optimized queue logic.
- *
  *	@code
  *	using PlatformLogger =
  *		PlatformLogger_t<CircularLogBufferLogger<8 * 1024>>;
  *  @endcode
  *
+ * Select a RecordCircularBuffer, and set LOG_RECORD_FRAMING_EN, to drop whole statements on
+ * overrun and to search the buffer with query():
+ *
+ *	@code
+ *	CircularLogBufferLogger_t<RecordCircularBuffer<char, 8 * 1024>> logger;
+ *	@endcode
+ *
+ * @tparam TBuffer The type of the log buffer. Any type with the CircularBuffer interface can
+ *	be used.
+ *
  * @ingroup LoggingSubsystem
  */
-template<size_t TBufferSize = (1 * 1024)>
-class CircularLogBufferLogger final : public LoggerBase
+template<class TBuffer>
+class CircularLogBufferLogger_t final : public LoggerBaseT<CircularLogBufferLogger_t<TBuffer>>
 {
+	friend class LoggerBaseT<CircularLogBufferLogger_t>;
+
   public:
+	/// Function which returns the time for the timestamp prefix
+	using timestamp_fn = uint32_t (*)();
+
 	/// Default constructor
-	CircularLogBufferLogger() : LoggerBase() {}
+	CircularLogBufferLogger_t() : LoggerBaseT<CircularLogBufferLogger_t>() {}
 
 	/** Initialize the circular log buffer with options
 	 *
@@ -44,14 +58,14 @@ class CircularLogBufferLogger final : public LoggerBase
 	 * @param echo If true, log statements will be logged and printed to the console with printf().
 	 * If false, log statements will only be added to the log buffer.
 	 */
-	explicit CircularLogBufferLogger(bool enable, log_level_e l = LOG_LEVEL_LIMIT(),
-									 bool echo = LOG_ECHO_EN_DEFAULT) noexcept
-		: LoggerBase(enable, l, echo)
+	explicit CircularLogBufferLogger_t(bool enable, log_level_e l = LOG_LEVEL_LIMIT(),
+									   bool echo = LOG_ECHO_EN_DEFAULT) noexcept
+		: LoggerBaseT<CircularLogBufferLogger_t>(enable, l, echo)
 	{
 	}
 
 	/// Default destructor
-	~CircularLogBufferLogger() noexcept = default;
+	~CircularLogBufferLogger_t() noexcept = default;
 
 	size_t size() const noexcept final
 	{
@@ -63,18 +77,106 @@ class CircularLogBufferLogger final : public LoggerBase
 		return log_buffer_.capacity();
 	}
 
+	/** Write the log buffer to a sink, straight from the buffer storage
+	 *
+	 * The sink receives at most two write() calls (see internal/log_sink.hpp), so UART DMA,
+	 * USB bulk, or network sinks can send the data without an intermediate copy.
+	 *
+	 *	@code
+	 *	logger.flush_to(Serial);
+	 *	@endcode
+	 *
+	 * @param sink The destination.
+	 * @returns The number of bytes written. Data which the sink did not accept stays in the
+	 *	buffer.
+	 */
+	template<class TSink>
+	size_t flush_to(TSink& sink) noexcept
+	{
+		return drain_to_sink(sink, log_buffer_);
+	}
+
+	/** Select the output written by flush()
+	 *
+	 * By default, flush() writes the whole buffer with _putchar(), which blocks until the data
+	 * is sent (about 700 ms for 8 KiB at 115200 baud). With a non-blocking output, flush()
+	 * writes only what the output accepts and returns. The rest stays in the buffer, and the
+	 * next flush() or poll() continues from there.
+	 *
+	 *	@code
+	 *	logger.output(log_sink_ref::nonblocking(Serial));
+	 *	@endcode
+	 *
+	 * @param sink The output. An empty log_sink_ref selects _putchar().
+	 */
+	void output(log_sink_ref sink) noexcept
+	{
+		output_ = sink;
+	}
+
+	/** Add a timestamp prefix, such as "[123 ms] ", to each statement
+	 *
+	 * The prefix is written in the units of timestamp_source(). query() can then find the
+	 * statements logged after a given time (see LogQuery::find_newer()).
+	 *
+	 *	@code
+	 *	logger.timestamp_clock(millis);
+	 *	@endcode
+	 *
+	 * @param clock Returns the current reading of the clock. nullptr (the default) disables the
+	 *	prefix.
+	 */
+	void timestamp_clock(timestamp_fn clock) noexcept
+	{
+		clock_ = clock;
+	}
+
+	size_t format_customprefix(char* dst) noexcept final
+	{
+		return (clock_ != nullptr) ? this->format_timestamp_prefix(dst, clock_()) : 0;
+	}
+
+	/** Search the log buffer without removing anything from it
+	 *
+	 * Requires a RecordCircularBuffer and LOG_RECORD_FRAMING_EN (see log_query.hpp).
+	 *
+	 *	@code
+	 *	auto query = logger.query();
+	 *	size_t first = query.find_newer(millis() - 1000);
+	 *	@endcode
+	 *
+	 * @returns A query over the statements in the buffer. The query must not be used after
+	 *	a statement is logged, or the buffer is flushed or cleared.
+	 */
+	LogQuery<TBuffer> query() const noexcept
+	{
+		return LogQuery<TBuffer>(log_buffer_, logNames::level_short_names, LOG_LEVEL_COUNT);
+	}
+
   protected:
 	void log_putc(char c) noexcept final
 	{
 		log_buffer_.put(c);
 	}
 
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
 	void flush_() noexcept final
 	{
-		while(!log_buffer_.empty())
+		if(output_.valid())
 		{
-			_putchar(log_buffer_.get());
+			drain_to_sink(output_, log_buffer_);
 		}
+		else
+		{
+			putchar_log_sink sink;
+			drain_to_sink(sink, log_buffer_);
+		}
+
+		this->flush_pending(!log_buffer_.empty());
 	}
 
 	void clear_() noexcept final
@@ -83,7 +185,18 @@ class CircularLogBufferLogger final : public LoggerBase
 	}
 
   private:
-	CircularBuffer<char, TBufferSize> log_buffer_;
+	TBuffer log_buffer_;
+	log_sink_ref output_;
+	timestamp_fn clock_ = nullptr;
 };
 
+/** Circular log buffer with a CircularBuffer of the given size
+ *
+ * @tparam TBufferSize Defines the size of the circular log buffer.
+ * Set to 0 to disable logging completely (for memory constrained systems).
+ * @note Power-of-2 sizes select the optimized (mask-based) queue logic.
+ */
+template<size_t TBufferSize = (1 * 1024)>
+using CircularLogBufferLogger = CircularLogBufferLogger_t<CircularBuffer<char, TBufferSize>>;
+
 #endif // CIRCULAR_BUFFER_LOGGER_H_
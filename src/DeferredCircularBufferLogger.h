@@ -0,0 +1,504 @@
+#ifndef DEFERRED_CIRCULAR_BUFFER_LOGGER_H_
+#define DEFERRED_CIRCULAR_BUFFER_LOGGER_H_
+
+// By default, this logging strategy does not auto-flush
+// You can still override this default setting if desired.
+#ifndef LOG_AUTOFLUSH_DEFAULT
+#define LOG_AUTOFLUSH_DEFAULT false
+#endif
+
+#include "ArduinoLogger.h"
+#include "internal/circular_buffer.hpp"
+#include "internal/deferred_args.hpp"
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+#ifndef LOG_DEFERRED_MAX_ARGS_SIZE
+/// The maximum number of argument bytes in a single deferred log record.
+/// This also sets the size of the stack buffer used to decode records in flush().
+#define LOG_DEFERRED_MAX_ARGS_SIZE 96
+#endif
+
+/** Circular log buffer with deferred formatting
+ *
+ * Log statements are not formatted when they are made. Instead, each statement is stored as a
+ * record containing the level, a timestamp, the format string pointer, and the raw argument
+ * bytes. Formatting happens in flush(), which prints the log buffer contents with _putchar().
+ * This moves the cost of printf() formatting out of time-critical code.
+ *
+ * The logging API is the same as the other strategies. A few rules apply:
+ * - Format strings are stored by pointer, so they must remain valid until flush() is called.
+ *	String literals always satisfy this requirement.
+ * - String arguments are copied into the record, truncated to LOG_DEFERRED_MAX_STRING_LENGTH.
+ * - The arguments to a single statement can use at most LOG_DEFERRED_MAX_ARGS_SIZE bytes.
+ *	This is checked at compile time.
+ * - When the buffer is full, whole records are dropped (oldest first), rather than bytes.
+ * - If echo is enabled, the statement is also formatted immediately with printf().
+ *
+ * On Arduino, records are timestamped with millis() by default, and the formatted output
+ * matches the other strategies' `[%d ms] ` prefix. On other platforms, supply a timestamp
+ * function with timestamp_clock().
+ *
+ * @tparam TBufferSize Defines the size of the circular log buffer, in bytes.
+ * @note Power-of-2 sizes select the optimized (mask-based) queue logic.
+ *
+ *	@code
+ *	using PlatformLogger =
+ *		PlatformLogger_t<DeferredCircularLogBufferLogger<8 * 1024>>;
+ *  @endcode
+ *
+ * @ingroup LoggingSubsystem
+ */
+template<size_t TBufferSize = (1 * 1024)>
+class DeferredCircularLogBufferLogger final
+	: public LoggerBaseT<DeferredCircularLogBufferLogger<TBufferSize>>
+{
+	friend class LoggerBaseT<DeferredCircularLogBufferLogger>;
+
+  public:
+	/// Function which returns the timestamp stored with each record
+	using timestamp_fn = uint32_t (*)();
+
+  private:
+	/// Stored at the start of every record in the buffer
+	struct record_header
+	{
+		/// Formats the record. A nullptr indicates a text record, whose payload is
+		/// copied to the output without formatting.
+		deferred_format_fn format;
+		const char* fmt;
+		uint32_t timestamp;
+		/// Number of payload bytes that follow the header
+		uint16_t length;
+		uint8_t level;
+	};
+
+	static_assert(TBufferSize >= sizeof(record_header) + LOG_DEFERRED_MAX_ARGS_SIZE,
+				  "Buffer must be able to hold the largest possible record");
+
+  public:
+	/// Default constructor
+	DeferredCircularLogBufferLogger() : LoggerBaseT<DeferredCircularLogBufferLogger>() {}
+
+	/** Initialize the deferred log buffer with options
+	 *
+	 * @param enable If true, log statements will be output to the log buffer. If false,
+	 * logging will be disabled and log statements will not be output to the log buffer.
+	 * @param l Runtime log filtering level. Levels greater than the target will not be output
+	 * to the log buffer.
+	 * @param echo If true, log statements will be logged and printed to the console with printf().
+	 * If false, log statements will only be added to the log buffer.
+	 */
+	explicit DeferredCircularLogBufferLogger(bool enable, log_level_e l = LOG_LEVEL_LIMIT(),
+											 bool echo = LOG_ECHO_EN_DEFAULT) noexcept
+		: LoggerBaseT<DeferredCircularLogBufferLogger>(enable, l, echo)
+	{
+	}
+
+	/// Default destructor
+	~DeferredCircularLogBufferLogger() noexcept = default;
+
+	size_t size() const noexcept final
+	{
+		return log_buffer_.size();
+	}
+
+	size_t capacity() const noexcept final
+	{
+		return log_buffer_.capacity();
+	}
+
+	/** Set the function used to timestamp records
+	 *
+	 * Records are stamped when they are logged, and the stamp is written as "[123 ms] " when
+	 * the log is flushed. LoggerBase::timestamp_source() does not apply to this strategy.
+	 *
+	 * @param clock The timestamp function, which returns milliseconds.
+	 *	Pass nullptr to disable timestamps.
+	 */
+	void timestamp_clock(timestamp_fn clock) noexcept
+	{
+		timestamp_ = clock;
+	}
+
+	template<typename... Args>
+	void critical(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::critical, fmt, args...);
+	}
+
+	template<typename... Args>
+	void critical_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::critical, fmt, args...);
+	}
+
+	template<typename... Args>
+	void error(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::error, fmt, args...);
+	}
+
+	template<typename... Args>
+	void error_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::error, fmt, args...);
+	}
+
+	template<typename... Args>
+	void warning(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::warning, fmt, args...);
+	}
+
+	template<typename... Args>
+	void warning_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::warning, fmt, args...);
+	}
+
+	template<typename... Args>
+	void info(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::info, fmt, args...);
+	}
+
+	template<typename... Args>
+	void info_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::info, fmt, args...);
+	}
+
+	template<typename... Args>
+	void debug(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::debug, fmt, args...);
+	}
+
+	template<typename... Args>
+	void debug_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::debug, fmt, args...);
+	}
+
+	/// Adds a record to the log which is formatted with no extra characters added to the message.
+	template<typename... Args>
+	void print(const char* fmt, const Args&... args) noexcept
+	{
+		add_record(log_level_e::off, fmt, args...);
+
+		if(this->echo())
+		{
+			// cppcheck-suppress wrongPrintfScanfArgNum
+			printf(fmt, args...);
+		}
+	}
+
+	/// Add a record to the log buffer from an interrupt context
+	/// @see LoggerBase::log_interrupt()
+	template<typename... Args>
+	void log_interrupt(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		if(this->enabled() && l <= this->level())
+		{
+			bool flush_setting = this->auto_flush(false);
+			uint64_t start = this->stats_bytes();
+			add_record(l, fmt, args...);
+			this->stats_logged(l, start);
+			this->auto_flush(flush_setting);
+		}
+	}
+
+	/// Add a record to the log buffer
+	/// @see LoggerBase::log()
+	template<typename... Args>
+	void log(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		if(this->enabled() && l <= this->level() && this->rate_limit_admit(*this, l, fmt, args...))
+		{
+			uint64_t start = this->stats_bytes();
+			add_record(l, fmt, args...);
+			this->stats_logged(l, start);
+
+			if(this->echo())
+			{
+				log_echo_level_prefix(l);
+				// cppcheck-suppress wrongPrintfScanfArgNum
+				printf(fmt, args...);
+			}
+
+			this->flush_on_level(l);
+		}
+	}
+
+	/** @name LOG_FMT() overloads
+	 *
+	 * @see LoggerBase LOG_FMT() overloads. The arguments are checked against the format at
+	 * compile time. Records store the format string, so the checked format is then stored like
+	 * a plain one, and is formatted when the log is flushed.
+	 */
+	///@{
+	template<class TString, typename... Args>
+	void critical(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void critical_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::debug, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::debug, fmt, args...);
+	}
+
+	/// @see print()
+	template<class TString, typename... Args>
+	void print(const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		print(fmt.c_str(), args...);
+	}
+
+	/// @see log_interrupt()
+	template<class TString, typename... Args>
+	void log_interrupt(log_level_e l, const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		log_interrupt(l, fmt.c_str(), args...);
+	}
+
+	/// @see log()
+	template<class TString, typename... Args>
+	void log(log_level_e l, const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		log(l, fmt.c_str(), args...);
+	}
+	///@}
+
+	/// Format and print the stored records, then report any overrun
+	void flush() noexcept final
+	{
+		this->write_rate_limit_summary(*this);
+
+		if(!log_buffer_.empty())
+		{
+			uint32_t start = this->stats_flush_started();
+			flush_();
+
+			if(this->has_overrun())
+			{
+				this->write_overrun_marker(*this);
+				flush_();
+			}
+
+			this->overrun_occurred(false);
+			this->stats_flushed(start);
+		}
+	}
+
+  protected:
+	void log_putc(char c) noexcept final
+	{
+		log_write(&c, 1);
+	}
+
+	/// Data which bypasses the formatter (e.g., write()) is stored as text records
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		while(len > 0)
+		{
+			size_t chunk = (len < LOG_DEFERRED_MAX_ARGS_SIZE) ? len : LOG_DEFERRED_MAX_ARGS_SIZE;
+			record_header header = {nullptr, nullptr, 0, static_cast<uint16_t>(chunk),
+									static_cast<uint8_t>(log_level_e::off)};
+
+			commit(header, str);
+			str += chunk;
+			len -= chunk;
+		}
+	}
+
+	/// Space is managed per record in commit(), so characters skip the base class checks
+	void log_add_char_to_buffer(char c) noexcept final
+	{
+		log_write(&c, 1);
+	}
+
+	void flush_() noexcept final
+	{
+		char data[LOG_DEFERRED_MAX_ARGS_SIZE];
+
+		while(!log_buffer_.empty())
+		{
+			record_header header;
+			read(&header, sizeof(header));
+			read(data, header.length);
+
+			if(header.format == nullptr)
+			{
+				for(size_t i = 0; i < header.length; i++)
+				{
+					_putchar(data[i]);
+				}
+
+				continue;
+			}
+
+			if(header.level != log_level_e::off)
+			{
+				log_echo_level_prefix(static_cast<log_level_e>(header.level));
+
+				if(timestamp_)
+				{
+					fctprintf(&deferred_putchar, nullptr, "[%u ms] ",
+							  static_cast<unsigned>(header.timestamp));
+				}
+			}
+
+			header.format(&deferred_putchar, nullptr, header.fmt, data);
+		}
+	}
+
+	void clear_() noexcept final
+	{
+		log_buffer_.reset();
+	}
+
+  private:
+#if defined(ARDUINO)
+	static uint32_t millis_timestamp()
+	{
+		return millis();
+	}
+#endif
+
+	static void deferred_putchar(char c, void* /*arg*/)
+	{
+		_putchar(c);
+	}
+
+	template<typename... Args>
+	void add_record(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		static_assert(deferred_args_max_size<Args...>::value <= LOG_DEFERRED_MAX_ARGS_SIZE,
+					  "Log arguments are too large for a deferred record. Increase "
+					  "LOG_DEFERRED_MAX_ARGS_SIZE.");
+
+		// +1 avoids a zero-length array when there are no arguments
+		char data[deferred_args_max_size<Args...>::value + 1];
+		size_t length = deferred_args_size(args...);
+		deferred_args_encode(data, args...);
+
+		record_header header = {&deferred_format<Args...>, fmt, timestamp_ ? timestamp_() : 0,
+								static_cast<uint16_t>(length), static_cast<uint8_t>(l)};
+
+		commit(header, data);
+		this->stats_wrote(sizeof(header) + length);
+	}
+
+	/// Add a record to the buffer, making room if necessary
+	void commit(const record_header& header, const char* data) noexcept
+	{
+		size_t record_size = sizeof(header) + header.length;
+
+		while(capacity() - size() < record_size)
+		{
+			if(this->auto_flush())
+			{
+				this->flush_from_log();
+			}
+			else
+			{
+				drop_oldest_record();
+				this->overrun_occurred(true);
+			}
+		}
+
+		log_buffer_.put(reinterpret_cast<const char*>(&header), sizeof(header));
+		log_buffer_.put(data, header.length);
+	}
+
+	void drop_oldest_record() noexcept
+	{
+		record_header header;
+		peek(&header, sizeof(header));
+		log_buffer_.consume(sizeof(header) + header.length);
+		this->stats_dropped(sizeof(header) + header.length);
+	}
+
+	/// Copy data from the front of the buffer without removing it
+	void peek(void* dst, size_t count) noexcept
+	{
+		buffer_spans<char> spans = log_buffer_.peek_contiguous();
+		size_t first_chunk = (spans.first.size > count) ? count : spans.first.size;
+
+		memcpy(dst, spans.first.data, first_chunk);
+		memcpy(static_cast<char*>(dst) + first_chunk, spans.second.data, count - first_chunk);
+	}
+
+	/// Copy data from the front of the buffer and remove it
+	void read(void* dst, size_t count) noexcept
+	{
+		peek(dst, count);
+		log_buffer_.consume(count);
+	}
+
+  private:
+#if defined(ARDUINO)
+	timestamp_fn timestamp_ = &millis_timestamp;
+#else
+	timestamp_fn timestamp_ = nullptr;
+#endif
+
+	CircularBuffer<char, TBufferSize> log_buffer_;
+};
+
+#endif // DEFERRED_CIRCULAR_BUFFER_LOGGER_H_
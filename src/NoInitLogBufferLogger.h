@@ -0,0 +1,177 @@
+#ifndef NOINIT_LOG_BUFFER_LOGGER_H_
+#define NOINIT_LOG_BUFFER_LOGGER_H_
+
+// By default, this logging strategy does not auto-flush
+// You can still override this default setting if desired.
+#ifndef LOG_AUTOFLUSH_DEFAULT
+#define LOG_AUTOFLUSH_DEFAULT false
+#endif
+
+#include "ArduinoLogger.h"
+#include "internal/log_sink.hpp"
+#include "internal/noinit_log_buffer.hpp"
+
+#ifndef LOG_NOINIT
+#if defined(__IMXRT1062__)
+/// Places a NoInitLogBuffer in memory which is not cleared at startup.
+/// On Teensy 4, DMAMEM is not cleared. It is cached, so the newest data may be lost on reset.
+#define LOG_NOINIT DMAMEM
+#else
+/// Places a NoInitLogBuffer in memory which is not cleared at startup
+#define LOG_NOINIT __attribute__((section(".noinit")))
+#endif
+#endif
+
+/** Circular log buffer which survives a reset
+ *
+ * The log buffer lives in a NoInitLogBuffer, which you declare with LOG_NOINIT so the startup
+ * code does not clear it. Logging works like CircularLogBufferLogger, and costs nothing extra
+ * at run time. After a watchdog or software reset, the constructor finds the log from before
+ * the reset, and begin() writes it to another strategy, such as an SD card or EEPROM logger,
+ * for a post-mortem.
+ *
+ * The recovered data is the data which had not been flushed before the reset. Leave
+ * auto-flush disabled so the buffer holds the most recent log.
+ *
+ * @tparam TBufferSize Defines the size of the circular log buffer.
+ *
+ *	@code
+ *	LOG_NOINIT static NoInitLogBuffer<2048> crash_log;
+ *	NoInitLogBufferLogger<2048> logger(crash_log);
+ *
+ *	void setup()
+ *	{
+ *		sd_logger.begin(sd);
+ *		logger.begin(sd_logger); // Writes the log from before the reset to the SD card
+ *	}
+ *  @endcode
+ *
+ * @ingroup LoggingSubsystem
+ */
+template<size_t TBufferSize = (1 * 1024)>
+class NoInitLogBufferLogger final : public LoggerBaseT<NoInitLogBufferLogger<TBufferSize>>
+{
+	friend class LoggerBaseT<NoInitLogBufferLogger>;
+
+  public:
+	/** Construct the logger
+	 *
+	 * The buffer is validated here, so it is safe to log before begin() is called. A log from
+	 * before the reset is kept until begin() writes it out.
+	 *
+	 * @param buffer The log buffer, which should be declared LOG_NOINIT.
+	 * @param enable If true, log statements will be output to the log buffer.
+	 * @param l Runtime log filtering level. Levels greater than the target will not be output
+	 * to the log buffer.
+	 * @param echo If true, log statements will be logged and printed to the console with printf().
+	 */
+	explicit NoInitLogBufferLogger(NoInitLogBuffer<TBufferSize>& buffer, bool enable = true,
+								   log_level_e l = LOG_LEVEL_LIMIT(),
+								   bool echo = LOG_ECHO_EN_DEFAULT) noexcept
+		: LoggerBaseT<NoInitLogBufferLogger>(enable, l, echo), log_buffer_(buffer),
+		  recovered_(buffer.recover() ? buffer.size() : 0)
+	{
+	}
+
+	/// Default destructor
+	~NoInitLogBufferLogger() noexcept = default;
+
+	/** Write the log from before the reset to another logger
+	 *
+	 * The data is written with sink.write(), so no level prefix is added, and the sink is
+	 * flushed afterwards. Data logged since the logger was constructed stays in the buffer.
+	 *
+	 * @param sink The destination logger, such as an SD card or EEPROM logger.
+	 * @returns true if a log from before the reset was written.
+	 */
+	template<class TSink>
+	bool begin(TSink& sink) noexcept
+	{
+		bool found = recovered_ > 0;
+
+		// The recovered log is at the front of the buffer, and is written in place
+		buffer_spans<char> spans = log_buffer_.peek_contiguous();
+		size_t first_chunk = (spans.first.size > recovered_) ? recovered_ : spans.first.size;
+
+		if(first_chunk > 0)
+		{
+			sink.write(spans.first.data, first_chunk);
+		}
+
+		if(recovered_ > first_chunk)
+		{
+			sink.write(spans.second.data, recovered_ - first_chunk);
+		}
+
+		log_buffer_.consume(recovered_);
+		recovered_ = 0;
+
+		if(found)
+		{
+			sink.flush();
+		}
+
+		return found;
+	}
+
+	/// The number of bytes from before the reset which are still in the buffer
+	size_t recovered() const noexcept
+	{
+		return recovered_;
+	}
+
+	size_t size() const noexcept final
+	{
+		return log_buffer_.size();
+	}
+
+	size_t capacity() const noexcept final
+	{
+		return log_buffer_.capacity();
+	}
+
+  protected:
+	void log_putc(char c) noexcept final
+	{
+		overwrite_recovered(1);
+		log_buffer_.put(c);
+	}
+
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		overwrite_recovered(len);
+		log_buffer_.put(str, len);
+	}
+
+	void flush_() noexcept final
+	{
+		putchar_log_sink sink;
+		drain_to_sink(sink, log_buffer_);
+		recovered_ = 0;
+	}
+
+	void clear_() noexcept final
+	{
+		log_buffer_.reset();
+		recovered_ = 0;
+	}
+
+  private:
+	/// Account for recovered data which is overwritten because the buffer is full
+	void overwrite_recovered(size_t count) noexcept
+	{
+		size_t free_space = log_buffer_.capacity() - log_buffer_.size();
+
+		if(recovered_ > 0 && count > free_space)
+		{
+			size_t lost = count - free_space;
+			recovered_ = (lost < recovered_) ? recovered_ - lost : 0;
+		}
+	}
+
+	NoInitLogBuffer<TBufferSize>& log_buffer_;
+	/// The number of bytes at the front of the buffer which were logged before the reset
+	size_t recovered_;
+};
+
+#endif // NOINIT_LOG_BUFFER_LOGGER_H_
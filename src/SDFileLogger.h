@@ -5,6 +5,10 @@
 #include "ArduinoLogger.h"
 #include "SdFat.h"
 #include "internal/circular_buffer.hpp"
+#include "internal/external_buffer.hpp"
+#include "internal/sdfat_storage.hpp"
+#include "internal/spsc_circular_buffer.hpp"
+#include "internal/timestamp_clock.hpp"
 
 /** SD File Buffer
  *
@@ -17,77 +21,132 @@
  *		PlatformLogger_t<SDFileLogger>;
  *  @endcode
  *
+ * To log from an interrupt while loop() flushes, select the lock-free buffer:
+ *
+ *	@code
+ *	using PlatformLogger =
+ *		PlatformLogger_t<SDFileLogger_t<SPSCCircularBuffer<char, 2048>>>;
+ *  @endcode
+ *
+ * Data is written to the card in blocks of TBlockSize bytes, using two blocks in turn.
+ * prepareBuffer() moves data from the log buffer into the block being filled, while the other
+ * block waits to be written. flush() does not wait for the card: if the card is busy
+ * programming a previous write, flush() returns and the data stays buffered until the next
+ * call. With SdFat's FIFO_SDIO mode on Teensy, a block write returns once the data has been
+ * transferred, and the card programs it in the background. This removes the 5-40 ms stalls
+ * that occur when a write waits for the card. Size the log buffer to hold the data logged while
+ * the card is busy.
+ *
+ * The file is synced once LOG_SD_SYNC_BYTES_DEFAULT bytes have been written, or if
+ * LOG_SD_SYNC_MS_DEFAULT milliseconds have passed since the last sync (see sync_budget()).
+ * begin(), sync(), and close_file() wait until all buffered data is written.
+ *
+ * @tparam TBuffer The type of the internal RAM log buffer. Any type with the
+ *	CircularBuffer interface can be used (e.g., SPSCCircularBuffer, or ExternalBuffer to place
+ *	the buffer in another memory region).
+ * @tparam TBlockSize The size of each block written to the card, in bytes. Must be a multiple
+ *	of the 512-byte sector size. Larger blocks are written as multi-sector transfers.
+ *
  * @ingroup LoggingSubsystem
  */
-class SDFileLogger final : public LoggerBase
+template<class TBuffer = CircularBuffer<char, 2048>, size_t TBlockSize = 512>
+class SDFileLogger_t final : public LoggerBaseT<SDFileLogger_t<TBuffer, TBlockSize>>
 {
-  private:
-	static constexpr size_t BUFFER_SIZE = 2048;
-	static constexpr size_t READY_BUFFER_SIZE = 512;
+	friend class LoggerBaseT<SDFileLogger_t>;
+
+	static_assert(TBlockSize > 0 && TBlockSize % sd_sector_size == 0,
+				  "The block size must be a multiple of the SD sector size");
 
   public:
 	/// Default constructor
-	SDFileLogger() : LoggerBase() {}
+	SDFileLogger_t() : LoggerBaseT<SDFileLogger_t>() {}
 
 	/// Default destructor
-	~SDFileLogger() noexcept = default;
+	~SDFileLogger_t() noexcept = default;
 
 	size_t size() const noexcept final
 	{
-		return file_.size();
+		return storage_.size();
 	}
 
 	size_t capacity() const noexcept final
 	{
-		// size in blocks * bytes per block (512 Bytes = 2^9)
-		return fs_ ? fs_->card()->sectorCount() << 9 : 0;
+		return storage_.capacity();
 	}
 
-	void log_customprefix() noexcept final
+	size_t format_customprefix(char* dst) noexcept final
 	{
-		print("[%d ms] ", millis());
+		return this->format_timestamp_prefix(dst, log_timestamp_now(this->timestamp_source()));
 	}
 
 	void begin(SdFs& sd_inst, const char filename[13] = "log000.txt")
 	{
-		fs_ = &sd_inst;
+		storage_.attach(sd_inst);
+		storage_.open(filename, log_buffer_, millis());
 
-		if(!file_.open(filename, O_WRITE | O_CREAT))
-		{
-			errorHalt("Failed to open file");
-		}
+		// Write the buffer since the file is open
+		write_all();
+		storage_.sync_policy().synced(millis());
+	}
 
-		// Clear current file contents
-		file_.truncate(0);
+	/** Attach the SD card, and open the log file at the first flush
+	 *
+	 * begin() opens the log file and writes the buffered data before it returns, which can
+	 * take hundreds of milliseconds on a slow card. This version only attaches the card.
+	 * Statements are kept in the RAM buffer, and the file is opened by the first flush: the next
+	 * poll() or flush(), or an auto-flush when the buffer fills.
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param filename @see begin()
+	 */
+	void begin_deferred(SdFs& sd_inst, const char filename[13] = "log000.txt")
+	{
+		storage_.attach(sd_inst);
+		storage_.defer_open(filename);
 
-		// Flush the buffer since the file is open
-		flush();
+		// The first poll() opens the file, even if no flush is due
+		this->flush_pending(true);
 	}
 
 	bool rename_file(const char filename[15] = "log000.txt"){
-		return file_.rename(filename);
+		return storage_.file().rename(filename);
 	}
 
 	void close_file(){
-		flush();
-		if(!file_.close()){
-			errorHalt("Failed to close file");
-		}
+		write_all();
+		storage_.close(log_buffer_, millis());
 	}
 
 	bool open_file(const char filename[15] = "log000.txt"){
-		if(!file_.open(filename, O_WRITE | O_CREAT))
+		if(!storage_.file().open(filename, O_WRITE | O_CREAT))
 		{
 			return false;
 		}
 
 		// Clear current file contents
-		file_.truncate(0);
+		storage_.file().truncate(0);
 		return true;
 	}
 
 	FsFile *get_file(){
-		return &file_;
+		return &storage_.file();
+	}
+
+	/** Set the sync budget
+	 *
+	 * @param bytes Sync once this many bytes have been written since the last sync.
+	 * @param ms Sync during a flush if this many milliseconds have passed since the last sync.
+	 */
+	void sync_budget(size_t bytes, uint32_t ms)
+	{
+		storage_.sync_policy().budget(bytes, ms);
+	}
+
+	/// Write all buffered data, waiting for the card if needed, and commit it to the SD card
+	void sync()
+	{
+		write_all();
+		storage_.sync(log_buffer_, millis());
 	}
 
 	size_t internal_size() const noexcept override
@@ -97,12 +156,12 @@ class SDFileLogger final : public LoggerBase
 
 	size_t ready_buffer_internal_size() const noexcept override
 	{
-		return ready_buffer_.size();
+		return blocks_[0].size + blocks_[1].size;
 	}
 
 	size_t ready_buffer_internal_capacity()
 	{
-		return ready_buffer_.capacity();
+		return 2 * TBlockSize;
 	}
 
 	bool ready_buffer_exists() const noexcept override
@@ -116,20 +175,32 @@ class SDFileLogger final : public LoggerBase
 		return log_buffer_.empty();
 	}
 
+	/** Move data from the log buffer into the block being filled
+	 *
+	 * Once the block is full, it is queued for writing and filling continues with the other
+	 * block. This is called by flush(), but it can also be called from loop() to free space
+	 * in the log buffer without accessing the SD card.
+	 */
 	void prepareBuffer()
 	{
-		size_t val_size = sizeof(char);
-		for(size_t i = 0; i < (READY_BUFFER_SIZE/val_size); i++){
-			if(!ready_buffer_.full()){
-				char c = log_buffer_.get();
-				if(c == char()){
-					break;
-				}
-				ready_buffer_.put(c);
-			}
-			else{
-				break;
-			}
+		log_block& block = blocks_[fill_block_];
+		size_t count = TBlockSize - block.size;
+
+		// Snapshot the buffer size. With a lock-free buffer, an interrupt may add data
+		// while we are copying. That data is moved by the next call.
+		if(count > log_buffer_.size())
+		{
+			count = log_buffer_.size();
+		}
+
+		copy_from_buffer(log_buffer_, &block.data[block.size], count);
+		log_buffer_.consume(count);
+		block.size += count;
+
+		if(block.size == TBlockSize && !write_pending_)
+		{
+			queue_fill_block();
+			prepareBuffer();
 		}
 	}
 
@@ -139,6 +210,11 @@ class SDFileLogger final : public LoggerBase
 		log_buffer_.put(c);
 	}
 
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
 	size_t internal_capacity() const noexcept override
 	{
 		return log_buffer_.capacity();
@@ -146,78 +222,94 @@ class SDFileLogger final : public LoggerBase
 
 	void flush_() noexcept final
 	{
-		if(!ready_buffer_.empty()){
-			writeBufferToSDFile(&ready_buffer_);
-		}
-		else{
-			writeBufferToSDFile(&log_buffer_);
+		if(storage_.take_deferred_open())
+		{
+			// See begin_deferred()
+			storage_.open(storage_.filename(), log_buffer_, millis());
+			storage_.sync_policy().synced(millis());
+			this->flush_pending(false);
 		}
-	}
 
-	void clear_() noexcept final
-	{
-		log_buffer_.reset();
-	}
+		prepareBuffer();
 
-  private:
-	void errorHalt(const char* msg)
-	{
-		printf("Error: %s\n", msg);
-		if(fs_->sdErrorCode())
+		while(!storage_.file().isBusy())
 		{
-			if(fs_->sdErrorCode() == SD_CARD_ERROR_ACMD41)
+			// A partial block is written once all buffered data has been moved into it
+			if(!write_pending_ && log_buffer_.empty() && blocks_[fill_block_].size > 0)
 			{
-				printf("Try power cycling the SD card.\n");
+				queue_fill_block();
 			}
-			printSdErrorSymbol(&Serial, fs_->sdErrorCode());
-			printf(", ErrorData: 0x%x\n", fs_->sdErrorData());
+
+			if(!write_pending_)
+			{
+				break;
+			}
+
+			writeBlockToSDFile(blocks_[fill_block_ ^ 1]);
+			write_pending_ = false;
+			prepareBuffer();
 		}
-		while(true)
+
+		// Check the sync budget. A sync is deferred while the card is busy.
+		SDSyncPolicy& sync = storage_.sync_policy();
+
+		if(sync.pending() > 0 && !storage_.file().isBusy() && sync.wrote(0, millis()))
 		{
+			storage_.sync(log_buffer_, millis());
 		}
 	}
+	void clear_() noexcept final
+	{
+		log_buffer_.reset();
+		blocks_[0].size = 0;
+		blocks_[1].size = 0;
+		write_pending_ = false;
+	}
 
-	template<size_t T>
-	void writeBufferToSDFile(CircularBuffer<char, T> *circular_buffer)
+  private:
+	/// A block of log data, written to the SD card as a unit
+	struct log_block
 	{
-		int bytes_written = 0;
+		char data[TBlockSize];
+		size_t size = 0;
+	};
 
-		// We need to get the front, the rear, and potentially write the files in two steps
-		// to prevent ordering problems
-		size_t head = circular_buffer->head();
-		size_t tail = circular_buffer->tail();
-		const char* buffer = circular_buffer->storage();
+	/// Hand the block being filled over for writing, and start filling the other block
+	void queue_fill_block()
+	{
+		write_pending_ = true;
+		fill_block_ ^= 1;
+	}
 
-		if((head < tail) || ((tail > 0) && (circular_buffer->size() == circular_buffer->capacity())))
-		{
-			// we have a wraparound case
-			// We will write from buffer[tail] to buffer[size] in one go
-			// Then we'll reset head to 0 so that we can write 0 to tail next
-			bytes_written = file_.write(&buffer[tail], circular_buffer->capacity() - tail);
-			bytes_written += file_.write(buffer, head);
-		}
-		else
-		{
-			// Write from tail position and send the specified number of bytes
-			bytes_written = file_.write(&buffer[tail], circular_buffer->size());
-		}
+	void writeBlockToSDFile(log_block& block)
+	{
+		uint32_t start = this->stats_clock();
+		storage_.write(block.data, block.size, millis());
+		this->stats_stored(start);
+
+		block.size = 0;
+	}
 
-		if(static_cast<size_t>(bytes_written) != circular_buffer->size())
+	/// Write all buffered data, waiting for the card to finish previous writes
+	void write_all()
+	{
+		while(!log_buffer_.empty() || ready_buffer_internal_size() > 0)
 		{
-			errorHalt("Failed to write to log file");
+			flush_();
 		}
-
-		file_.flush();
-		circular_buffer->reset();
 	}
 
   private:
-	SdFs* fs_;
-	mutable FsFile file_;
+	SDStorage storage_;
 
   protected:
-	CircularBuffer<char, BUFFER_SIZE> log_buffer_;
-	CircularBuffer<char, READY_BUFFER_SIZE> ready_buffer_;
+	TBuffer log_buffer_;
+	log_block blocks_[2];
+	uint8_t fill_block_ = 0;
+	bool write_pending_ = false;
 };
 
+/// The default SDFileLogger configuration
+using SDFileLogger = SDFileLogger_t<>;
+
 #endif // SD_FILE_LOGGER_H_
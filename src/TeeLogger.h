@@ -0,0 +1,525 @@
+#ifndef TEE_LOGGER_H_
+#define TEE_LOGGER_H_
+
+#include "ArduinoLogger.h"
+#include "internal/tee_sink_list.hpp"
+
+#ifndef LOG_TEE_SCRATCH_SIZE
+/// The size of the buffer that a TeeLogger formats each statement into, in bytes.
+/// Longer statements are passed to the sinks in pieces of this size.
+#define LOG_TEE_SCRATCH_SIZE 128
+#endif
+
+/** Send one log stream to several logging strategies
+ *
+ * Each statement is formatted once, into a small scratch buffer, and the result is copied into
+ * the buffer of every sink whose runtime level accepts it. For example, the SD card can receive
+ * info and up, the console warnings and up, and a fallback store only critical statements,
+ * without formatting the statement three times:
+ *
+ *	@code
+ *	using PlatformLogger = PlatformLogger_t<
+ *		TeeLogger<TeensySDLogger, CircularLogBufferLogger<1024>, TeensyRobustModuleLogger<>>>;
+ *
+ *	PlatformLogger::inst().sink<0>().level(log_level_e::info);
+ *	PlatformLogger::inst().sink<1>().level(log_level_e::warning);
+ *	PlatformLogger::inst().sink<2>().level(log_level_e::critical);
+ *	@endcode
+ *
+ * Each sink is a complete logging strategy with its own buffer, level, auto-flush setting, and
+ * flush policy. Sinks are reached with sink<Index>(), in the order they are listed, for setup
+ * such as begin(). Data reaches a sink through its write() function, so a sink's own level
+ * prefix and custom prefix (e.g., the SD timestamp) are not added.
+ *
+ * The level of the TeeLogger itself filters statements before any sink sees them. By default
+ * it is LOG_LEVEL_LIMIT(), so filtering is left to the sinks. Statements that no sink accepts
+ * are not formatted at all.
+ *
+ * print() and write() output is sent to every enabled sink, regardless of level.
+ *
+ * If echo is enabled, the formatted statement is copied to _putchar() rather than being run
+ * through printf() a second time.
+ *
+ * @tparam TSinks The logging strategies which receive the log stream. Each must be default
+ *	constructible.
+ *
+ * @ingroup LoggingSubsystem
+ */
+template<class... TSinks>
+class TeeLogger final : public LoggerBaseT<TeeLogger<TSinks...>>
+{
+	friend class LoggerBaseT<TeeLogger>;
+
+  public:
+	/// Default constructor
+	TeeLogger() : LoggerBaseT<TeeLogger>(LOG_EN_DEFAULT, LOG_LEVEL_LIMIT(), false) {}
+
+	/** Initialize the logger with options
+	 *
+	 * @param enable If true, log statements are passed to the sinks. If false, logging is
+	 *	disabled for every sink.
+	 * @param l Runtime log filtering level, applied before the sink levels.
+	 * @param echo If true, log statements are also sent to the console with _putchar().
+	 */
+	explicit TeeLogger(bool enable, log_level_e l = LOG_LEVEL_LIMIT(),
+					   bool echo = LOG_ECHO_EN_DEFAULT) noexcept
+		: LoggerBaseT<TeeLogger>(enable, l, false), echo_(echo)
+	{
+	}
+
+	/// Default destructor
+	~TeeLogger() noexcept = default;
+
+	/// The number of bytes in the scratch buffer. This is 0 between statements.
+	size_t size() const noexcept final
+	{
+		return scratch_size_;
+	}
+
+	/// The capacity of the scratch buffer
+	size_t capacity() const noexcept final
+	{
+		return LOG_TEE_SCRATCH_SIZE;
+	}
+
+	/// Access the sink at TIndex
+	template<size_t TIndex>
+	typename tee_sink_type<TIndex, TSinks...>::type& sink() noexcept
+	{
+		return sinks_.get(tee_sink_index<TIndex>());
+	}
+
+	/// @see LoggerBase::echo()
+	bool echo() const noexcept
+	{
+		return echo_;
+	}
+
+	/// @see LoggerBase::echo(bool)
+	bool echo(bool en) noexcept
+	{
+		bool setting = echo_;
+		echo_ = en;
+		return setting;
+	}
+
+	/// Flush every sink
+	void flush() noexcept final
+	{
+		this->write_rate_limit_summary(*this);
+		flush_();
+	}
+
+	/** Poll the flush policy of every sink
+	 *
+	 * @see LoggerBase::poll()
+	 * @param now The current time, in milliseconds (e.g., millis()).
+	 * @returns true if any sink was flushed.
+	 */
+	bool poll(uint32_t now) noexcept
+	{
+		dispatch();
+
+		poll_sink poll_fn{now, false};
+		sinks_.for_each(poll_fn);
+
+		return poll_fn.flushed;
+	}
+
+	template<typename... Args>
+	void critical(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::critical, fmt, args...);
+	}
+
+	template<typename... Args>
+	void critical_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::critical, fmt, args...);
+	}
+
+	template<typename... Args>
+	void error(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::error, fmt, args...);
+	}
+
+	template<typename... Args>
+	void error_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::error, fmt, args...);
+	}
+
+	template<typename... Args>
+	void warning(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::warning, fmt, args...);
+	}
+
+	template<typename... Args>
+	void warning_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::warning, fmt, args...);
+	}
+
+	template<typename... Args>
+	void info(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::info, fmt, args...);
+	}
+
+	template<typename... Args>
+	void info_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::info, fmt, args...);
+	}
+
+	template<typename... Args>
+	void debug(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::debug, fmt, args...);
+	}
+
+	template<typename... Args>
+	void debug_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::debug, fmt, args...);
+	}
+
+	/// Format once and send the result to every enabled sink
+	/// @see LoggerBase::print()
+	template<typename... Args>
+	void print(const Args&... args) noexcept
+	{
+		statement_level_ = log_level_e::off;
+		LoggerBase::print(args...);
+		dispatch();
+	}
+
+	/// Send a block of characters to every enabled sink
+	/// @see LoggerBase::write()
+	void write(const char* str, size_t len) noexcept
+	{
+		statement_level_ = log_level_e::off;
+		LoggerBase::write(str, len);
+		dispatch();
+	}
+
+	/// Add a statement to the log buffer of each sink that accepts level l
+	/// @see LoggerBase::log()
+	template<typename... Args>
+	void log(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		tee_statement(l, fmt, args...);
+	}
+
+	/// Add a structured record to the log buffer of each sink that accepts level l
+	/// @see LoggerBase::log_kv()
+	template<typename... Fields>
+	void log_kv(log_level_e l, const char* name, const log_kv_field<Fields>&... fields) noexcept
+	{
+		if(this->enabled() && l <= this->level() && accepted(l))
+		{
+			statement_level_ = l;
+			LoggerBase::log_kv(l, name, fields...);
+			dispatch();
+
+			if(l == log_level_e::critical)
+			{
+				flush_on_critical flush_fn;
+				sinks_.for_each(flush_fn);
+			}
+		}
+	}
+
+	/// Add a statement to the log buffer of each sink from an interrupt context.
+	/// The sinks are not flushed, even if they are full.
+	/// @see LoggerBase::log_interrupt()
+	template<typename... Args>
+	void log_interrupt(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		tee_interrupt_statement(l, fmt, args...);
+	}
+
+	/** @name LOG_FMT() overloads
+	 *
+	 * @see LoggerBase LOG_FMT() overloads. The arguments are checked against the format at
+	 * compile time, and the statement is formatted once for every sink.
+	 */
+	///@{
+	template<class TString, typename... Args>
+	void critical(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void critical_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::debug, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::debug, fmt, args...);
+	}
+
+	/// @see log_interrupt()
+	template<class TString, typename... Args>
+	void log_interrupt(log_level_e l, const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		tee_interrupt_statement(l, fmt, args...);
+	}
+
+	/// @see log()
+	template<class TString, typename... Args>
+	void log(log_level_e l, const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		tee_statement(l, fmt, args...);
+	}
+	///@}
+
+  protected:
+	void log_add_char_to_buffer(char c) noexcept final
+	{
+		if(scratch_size_ == LOG_TEE_SCRATCH_SIZE)
+		{
+			dispatch();
+		}
+
+		log_putc(c);
+	}
+
+	void log_putc(char c) noexcept final
+	{
+		scratch_[scratch_size_++] = c;
+	}
+
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		while(len > 0)
+		{
+			if(scratch_size_ == LOG_TEE_SCRATCH_SIZE)
+			{
+				dispatch();
+			}
+
+			size_t chunk = LOG_TEE_SCRATCH_SIZE - scratch_size_;
+			chunk = (chunk > len) ? len : chunk;
+			memcpy(&scratch_[scratch_size_], str, chunk);
+			scratch_size_ += chunk;
+			str += chunk;
+			len -= chunk;
+		}
+	}
+
+	void flush_() noexcept final
+	{
+		dispatch();
+
+		flush_sink flush_fn;
+		sinks_.for_each(flush_fn);
+	}
+
+	void clear_() noexcept final
+	{
+		scratch_size_ = 0;
+
+		clear_sink clear_fn;
+		sinks_.for_each(clear_fn);
+	}
+
+  private:
+	/// Copies the scratch buffer to each sink which accepts the current statement
+	struct write_sink
+	{
+		const char* data;
+		size_t size;
+		log_level_e level;
+		bool interrupt;
+
+		template<class TSink>
+		void operator()(TSink& sink) noexcept
+		{
+			if(sink.enabled() && level <= sink.level())
+			{
+				bool flush_setting = sink.auto_flush(sink.auto_flush() && !interrupt);
+				sink.write(data, size);
+				sink.auto_flush(flush_setting);
+			}
+		}
+	};
+
+	/// Checks whether any sink accepts a level
+	struct accepts_level
+	{
+		log_level_e level;
+		bool accepted;
+
+		template<class TSink>
+		void operator()(const TSink& sink) noexcept
+		{
+			accepted = accepted || (sink.enabled() && level <= sink.level());
+		}
+	};
+
+	/// Applies each sink's own flush_on_critical() setting
+	struct flush_on_critical
+	{
+		template<class TSink>
+		void operator()(TSink& sink) noexcept
+		{
+			if(sink.enabled() && sink.flush_policy().flush_on_critical())
+			{
+				sink.flush();
+			}
+		}
+	};
+
+	struct flush_sink
+	{
+		template<class TSink>
+		void operator()(TSink& sink) noexcept
+		{
+			sink.flush();
+		}
+	};
+
+	struct clear_sink
+	{
+		template<class TSink>
+		void operator()(TSink& sink) noexcept
+		{
+			sink.clear();
+		}
+	};
+
+	struct poll_sink
+	{
+		uint32_t now;
+		bool flushed;
+
+		template<class TSink>
+		void operator()(TSink& sink) noexcept
+		{
+			flushed = sink.poll(now) || flushed;
+		}
+	};
+
+	/// The body of log(). TFormat is `const char*` or a log_format.
+	template<class TFormat, typename... Args>
+	void tee_statement(log_level_e l, const TFormat& fmt, const Args&... args) noexcept
+	{
+		if(this->enabled() && l <= this->level() && accepted(l))
+		{
+			statement_level_ = l;
+			LoggerBase::log(l, fmt, args...);
+			dispatch();
+
+			if(l == log_level_e::critical)
+			{
+				flush_on_critical flush_fn;
+				sinks_.for_each(flush_fn);
+			}
+		}
+	}
+
+	/// The body of log_interrupt(). TFormat is `const char*` or a log_format.
+	template<class TFormat, typename... Args>
+	void tee_interrupt_statement(log_level_e l, const TFormat& fmt, const Args&... args) noexcept
+	{
+		if(this->enabled() && l <= this->level() && accepted(l))
+		{
+			statement_level_ = l;
+			interrupt_ = true;
+			LoggerBase::log_interrupt(l, fmt, args...);
+			dispatch();
+			interrupt_ = false;
+		}
+	}
+
+	bool accepted(log_level_e l) const noexcept
+	{
+		accepts_level accepts_fn{l, false};
+		sinks_.for_each(accepts_fn);
+		return accepts_fn.accepted;
+	}
+
+	/// Send the contents of the scratch buffer to the sinks and the console
+	void dispatch() noexcept
+	{
+		if(scratch_size_ == 0)
+		{
+			return;
+		}
+
+		write_sink write_fn{scratch_, scratch_size_, statement_level_, interrupt_};
+		sinks_.for_each(write_fn);
+
+		if(echo_)
+		{
+			for(size_t i = 0; i < scratch_size_; i++)
+			{
+				_putchar(scratch_[i]);
+			}
+		}
+
+		scratch_size_ = 0;
+	}
+
+	tee_sink_list<TSinks...> sinks_;
+	char scratch_[LOG_TEE_SCRATCH_SIZE];
+	size_t scratch_size_ = 0;
+	/// The level of the statement in the scratch buffer. print() and write() use off.
+	log_level_e statement_level_ = log_level_e::off;
+	/// True while a statement from log_interrupt() is being added
+	bool interrupt_ = false;
+	bool echo_ = LOG_ECHO_EN_DEFAULT;
+};
+
+#endif // TEE_LOGGER_H_
@@ -1,12 +1,18 @@
-#ifndef SD_FILE_LOGGER_H_
-#define SD_FILE_LOGGER_H_
+#ifndef TEENSY_ROBUST_MODULE_LOGGER_H_
+#define TEENSY_ROBUST_MODULE_LOGGER_H_
 
 #include "Arduino.h"
 #include "ArduinoLogger.h"
 #include "SdFat.h"
+#include "internal/arduino_eeprom.hpp"
 #include "internal/circular_buffer.hpp"
+#include "internal/eeprom_log_store.hpp"
+#include "internal/timestamp_clock.hpp"
+#include "internal/external_buffer.hpp"
+#include "internal/kinetis_reset_reason.hpp"
+#include "internal/sdfat_storage.hpp"
+#include "internal/spsc_circular_buffer.hpp"
 #include <EEPROM.h>
-#include <kinetis.h>
 
 /** Robust Teensy Logging Strategy with per-Module Log Levels
  *
@@ -14,8 +20,9 @@
  *
  * The primary method is to log to a file on the SD card using a rotation strategy.
  *
- * Alternatively, you can initialize the logger with an EEPROM class instead,
- * which can be used for logging if an SD card is not present.
+ * Alternatively, you can initialize the logger with an EEPROM region instead,
+ * which can be used for logging if an SD card is not present. The region is managed by
+ * EEPROMLogStore, which spreads writes across the region and recovers the log on boot.
  *
  * If begin() is called without arguments, a simple circular buffer logger is used.
  *
@@ -33,36 +40,51 @@
  *		PlatformLogger_t<TeensySDRotationalLogger>;
  *  @endcode
  *
+ * To log from an interrupt while loop() flushes, select the lock-free buffer:
+ *
+ *	@code
+ *	TeensyRobustModuleLogger<MODULE_COUNT, SPSCCircularBuffer<char, 512>> Log;
+ *  @endcode
+ *
  * @tparam TModuleCount The maximum number of modules you want to support
  * 	with this logging strategy.
+ * @tparam TBuffer The type of the internal RAM log buffer. Any type with the
+ *	CircularBuffer interface can be used (e.g., SPSCCircularBuffer, or ExternalBuffer to place
+ *	the buffer in another memory region).
  *
  * @ingroup LoggingSubsystem
  */
-template<size_t TModuleCount = 1>
-class TeensyRobustModuleLogger final : public LoggerBase
+template<size_t TModuleCount = 1, class TBuffer = CircularBuffer<char, 512>>
+class TeensyRobustModuleLogger final
+	: public LoggerBaseT<TeensyRobustModuleLogger<TModuleCount, TBuffer>>
 {
+	friend class LoggerBaseT<TeensyRobustModuleLogger>;
+
   private:
-	static constexpr size_t BUFFER_SIZE = 512;
-	static constexpr size_t FILENAME_SIZE = 32;
-	static constexpr unsigned EEPROM_LOG_STORAGE_ADDR = 4095;
 
   public:
 	/// Default constructor
-	TeensyRobustModuleLogger() : LoggerBase() {}
+	/// Module 0 starts at LOG_LEVEL, clamped to LOG_MODULE_LEVEL_LIMIT(0); other modules start off
+	TeensyRobustModuleLogger() : LoggerBaseT<TeensyRobustModuleLogger>()
+	{
+		for(unsigned i = 0; i < TModuleCount; i++)
+		{
+			module_levels_[i] = (i == 0) ? LOG_MODULE_LEVEL_LIMIT(0) : log_level_e::off;
+		}
+	}
 
 	/// Default destructor
 	~TeensyRobustModuleLogger() noexcept = default;
 
 	size_t size() const noexcept final
 	{
-		if(fs_)
+		if(storage_.attached())
 		{
-			return file_.size();
+			return storage_.size();
 		}
 		else if(fallback_to_eeprom_)
 		{
-			// Once we've filled the EEPROM range once, we will always wrap around.
-			return eeprom_full_ ? eeprom_log_size_ : eeprom_write_pos_;
+			return eeprom_.size();
 		}
 		else
 		{
@@ -72,14 +94,13 @@ class TeensyRobustModuleLogger final : public LoggerBase
 
 	size_t capacity() const noexcept final
 	{
-		if(fs_)
+		if(storage_.attached())
 		{
-			// size in blocks * bytes per block (512 Bytes = 2^9)
-			return fs_ ? fs_->card()->sectorCount() << 9 : 0;
+			return storage_.capacity();
 		}
 		else if(fallback_to_eeprom_)
 		{
-			return eeprom_log_size_;
+			return eeprom_.capacity();
 		}
 		else
 		{
@@ -87,9 +108,15 @@ class TeensyRobustModuleLogger final : public LoggerBase
 		}
 	}
 
-	void log_customprefix() noexcept final
+	/// The EEPROM log storage, which can be used to read back the log after a reset
+	const EEPROMLogStore<ArduinoEEPROMDevice>& eeprom_log() const noexcept
 	{
-		print("[%d ms] ", millis());
+		return eeprom_;
+	}
+
+	size_t format_customprefix(char* dst) noexcept final
+	{
+		return this->format_timestamp_prefix(dst, log_timestamp_now(this->timestamp_source()));
 	}
 
 	void begin()
@@ -97,52 +124,156 @@ class TeensyRobustModuleLogger final : public LoggerBase
 		log_reset_reason();
 	}
 
-	// EEPROM logger
+	/** Log to a region of the EEPROM
+	 *
+	 * The existing log in the region is recovered, and new data is appended to it.
+	 *
+	 * With LOG_COMPRESSION_EN, each flush is stored as a compressed block. To read the log
+	 * back, concatenate the records of eeprom_log() from first_block() onwards, and decompress
+	 * them with tools/lzss_decoder.
+	 *
+	 * @param address The start address of the EEPROM log region.
+	 * @param size The size of the region, in bytes. Whole slots of LOG_EEPROM_SLOT_SIZE
+	 *	bytes are used.
+	 */
 	void begin(unsigned address, unsigned size)
 	{
-		eeprom_log_address_ = address;
-		eeprom_log_size_ = size;
+		eeprom_.begin(eeprom_device_, address, size);
 		fallback_to_eeprom_ = true;
 		log_reset_reason();
-
-		if((eeprom_log_address_ < EEPROM_LOG_STORAGE_ADDR) &&
-		   (eeprom_log_address_ + eeprom_log_size_ >= EEPROM_LOG_STORAGE_ADDR))
-		{
-			printf("EEPROM log storage overlaps with the required file counter address. Please "
-				   "adjust.\n");
-			while(1)
-			{
-			}
-		}
 	}
 
-	// SD Card Logger
-	void begin(SdFs& sd_inst)
+	/** Open the log file on the SD card
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size If non-zero, a contiguous file of this many bytes is allocated,
+	 *	and the file is kept open. Data is then written in whole sectors, which avoids
+	 *	read-modify-write cycles and cluster allocation during logging. The file is truncated
+	 *	to the length of the data by close(), or when a new file is started.
+	 */
+	void begin(SdFs& sd_inst, uint64_t preallocate_size = 0)
 	{
-		fs_ = &sd_inst;
+		storage_.attach(sd_inst, preallocate_size);
+
+		open_next_file();
+
+		log_reset_reason();
 
-		set_filename();
+		// Manually flush, since the file is open
+		this->flush();
 
-		if(!file_.open(filename_, O_WRITE | O_CREAT))
+		if(storage_.keep_open())
+		{
+			sync();
+		}
+		else
 		{
-			errorHalt("Failed to open file");
+			storage_.release();
 		}
+	}
 
-		// Clear current file contents
-		file_.truncate(0);
+	/** Attach the SD card, and start a new log file at the first flush
+	 *
+	 * begin() starts a new log file, logs the reset reason, and flushes before it returns,
+	 * which can take hundreds of milliseconds on a slow card. This version only attaches the
+	 * card and logs the reset reason. Statements are kept in the RAM buffer, and the new file
+	 * is started by the first flush: the next poll() or flush(), or an auto-flush when the
+	 * buffer fills.
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size @see begin()
+	 */
+	void begin_deferred(SdFs& sd_inst, uint64_t preallocate_size = 0)
+	{
+		storage_.attach(sd_inst, preallocate_size);
+		storage_.defer_open();
 
 		log_reset_reason();
 
-		// Manually flush, since the file is open
-		flush();
+		// The first poll() starts the file, even if no flush is due
+		this->flush_pending(true);
+	}
+
+	/** Keep the log file open between flushes
+	 *
+	 * By default, the log file is opened and closed on every flush. When the file is kept
+	 * open, flush() only writes the data, and the file is synced according to the sync
+	 * budget (see sync_budget()). Data which has not been synced is lost if power is removed.
+	 *
+	 * @param enable If true, keep the file open. If false, the file is closed.
+	 */
+	void keep_file_open(bool enable)
+	{
+		storage_.keep_open(enable, log_buffer_, millis());
+	}
+
+	/** Set the sync budget used when the log file is kept open
+	 *
+	 * @param bytes Sync once this many bytes have been written since the last sync.
+	 * @param ms Sync during flush() if this many milliseconds have passed since the last sync.
+	 */
+	void sync_budget(size_t bytes, uint32_t ms) noexcept
+	{
+		storage_.sync_policy().budget(bytes, ms);
+	}
+
+	/// Commit the data written to the log file to the SD card.
+	/// For a pre-allocated file, this includes the partial sector held in the buffer.
+	void sync()
+	{
+		storage_.sync(log_buffer_, millis());
+	}
+
+	/** Write the buffered data and close the log file
+	 *
+	 * A pre-allocated file is truncated to the length of the data. Logging can continue
+	 * after close(): the file is reopened (in append mode) by the next flush.
+	 */
+	void close()
+	{
+		this->flush();
+		storage_.close(log_buffer_, millis());
+	}
+
+	/** Access the rotation policy
+	 *
+	 * By default, a new file is only started by begin(). The policy can also start a new file
+	 * once the current one reaches a size, or has been in use for an interval. With a
+	 * retention budget, the oldest log files are deleted when a new file is started:
+	 *
+	 *	@code
+	 *	logger.rotation_policy().max_size(16 * 1024 * 1024);
+	 *	logger.rotation_policy().interval(24 * 60 * 60 * 1000UL);
+	 *	logger.rotation_policy().retention(1024 * 1024 * 1024ULL);
+	 *	@endcode
+	 */
+	LogRotationPolicy& rotation_policy() noexcept
+	{
+		return storage_.rotation_policy();
+	}
 
-		file_.close();
+	/// The index of the current log file, log_<index>.txt
+	uint32_t file_index() const noexcept
+	{
+		return storage_.file_index();
 	}
 
-	// Resets the log file counter back to 1
+	/// Write the buffered data to the current file, and start the next file
+	void rotate()
+	{
+		if(storage_.attached())
+		{
+			this->flush();
+			open_next_file();
+
+			storage_.release();
+		}
+	}
+
+	/// Resets the log file counter back to 1. The SD card must be initialized.
 	void resetFileCounter()
 	{
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, 1);
+		sd_store_log_index<FsFile>(1);
 	}
 
 	/** Get the maximum log level (filtering) for the specified module
@@ -175,11 +306,12 @@ class TeensyRobustModuleLogger final : public LoggerBase
 	 *
 	 * @param module_id The ID for the corresponding module
 	 * @param l The maximum log level. Levels greater than `l` will not be added to the log buffer.
+	 *	Levels greater than LOG_MODULE_LEVEL_LIMIT(module_id) are ignored.
 	 * @returns the current log level maximum.
 	 */
 	log_level_e level(unsigned module_id, log_level_e l) noexcept
 	{
-		if(l <= LOG_LEVEL_LIMIT())
+		if(l <= LOG_MODULE_LEVEL_LIMIT(module_id))
 		{
 			module_levels_[module_id] = l;
 		}
@@ -187,104 +319,357 @@ class TeensyRobustModuleLogger final : public LoggerBase
 		return module_levels_[module_id];
 	}
 
+#if LOG_STATS_EN
+	/** The statements logged by a module
+	 *
+	 * Only available when LOG_STATS_EN is set. Statements filtered out by the module or global
+	 * level are not counted.
+	 *
+	 * @param module_id The ID for the corresponding module
+	 */
+	const log_record_stats& module_stats(unsigned module_id) const noexcept
+	{
+		return module_stats_[module_id];
+	}
+#endif
+
 	/// The following overrides should be used to log with module IDs
 
 	template<typename... Args>
 	void critical(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::critical)
-		{
-			log(log_level_e::critical, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::critical, fmt, args...);
 	}
 
 	template<typename... Args>
 	void critical_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::critical)
-		{
-			log_interrupt(log_level_e::critical, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::critical, fmt, args...);
 	}
 
 	template<typename... Args>
 	void error(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::error)
-		{
-			log(log_level_e::error, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::error, fmt, args...);
 	}
 
 	template<typename... Args>
 	void error_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::error)
-		{
-			log_interrupt(log_level_e::error, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::error, fmt, args...);
 	}
 
 	template<typename... Args>
 	void warning(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::warning)
-		{
-			log(log_level_e::warning, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::warning, fmt, args...);
 	}
 
 	template<typename... Args>
 	void warning_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::warning)
-		{
-			log_interrupt(log_level_e::warning, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::warning, fmt, args...);
 	}
 
 	template<typename... Args>
 	void info(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::info)
-		{
-			log(log_level_e::info, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::info, fmt, args...);
 	}
 
 	template<typename... Args>
 	void info_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::info)
-		{
-			log_interrupt(log_level_e::info, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::info, fmt, args...);
 	}
 
 	template<typename... Args>
 	void debug(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::debug)
-		{
-			log(log_level_e::debug, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::debug, fmt, args...);
 	}
 
 	template<typename... Args>
 	void debug_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::debug)
-		{
-			log_interrupt(log_level_e::debug, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::debug, fmt, args...);
+	}
+
+	/** Compile-time filtered module logging
+	 *
+	 * These overloads take the module ID as a template argument:
+	 * @code
+	 * logger.debug<MODULE_SENSOR>("Reading: %d\n", value);
+	 * @endcode
+	 *
+	 * Statements above LOG_MODULE_LEVEL_LIMIT(TModule) compile away entirely, including the
+	 * format string and argument handling. Statements which are compiled in are still
+	 * filtered by the module's runtime level.
+	 */
+
+	template<unsigned TModule, typename... Args>
+	void critical(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void critical_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void error(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void error_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void warning(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void warning_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void info(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void info_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void debug(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void debug_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
 	}
 
+	/** @name LOG_FMT() overloads
+	 *
+	 * The module versions of the LoggerBase LOG_FMT() overloads. The arguments are checked
+	 * against the format at compile time, even if the statement is compiled out:
+	 *
+	 *	@code
+	 *	logger.info(MODULE_SENSOR, LOG_FMT("Reading: %d\n"), value);
+	 *	logger.debug<MODULE_SENSOR>(LOG_FMT("Reading: %d\n"), value);
+	 *	@endcode
+	 */
+	///@{
+	template<class TString, typename... Args>
+	void critical(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void critical_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::debug, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::debug, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void critical(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void critical_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void error(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void error_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void warning(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void warning_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void info(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void info_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void debug(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void debug_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
+	}
+	///@}
+
   protected:
 	void log_putc(char c) noexcept final
 	{
 		log_buffer_.put(c);
 	}
 
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
 	size_t internal_size() const noexcept override
 	{
 		return log_buffer_.size();
@@ -292,11 +677,11 @@ class TeensyRobustModuleLogger final : public LoggerBase
 
 	size_t internal_capacity() const noexcept override
 	{
-		if(fallback_to_eeprom_)
+		if(fallback_to_eeprom_ && eeprom_.capacity() < log_buffer_.capacity())
 		{
 			// We constrain the EEPROM fallback to the total log storage size
 			// which should trigger auto-flush when the EEPROM buffer would be filled.
-			return eeprom_log_size_;
+			return eeprom_.capacity();
 		}
 		else
 		{
@@ -308,31 +693,38 @@ class TeensyRobustModuleLogger final : public LoggerBase
 	{
 		// First, we need to check to ensure that there is an SD Instance
 		// If not, we determine whether we need to fallback to EEPROM
-		if(fs_)
+		if(storage_.attached())
 		{
 			writeBufferToSDFile();
 		}
 		else if(fallback_to_eeprom_)
 		{
-			// We go byte-by-byte (since that's what the EEPROM interface allows)
-			// and then we reset the log buffer
+#if LOG_COMPRESSION_EN
+			// The SD card is not in use, so its compressor is free
+			typename EEPROMLogStore<ArduinoEEPROMDevice>::block_writer writer(eeprom_);
+			size_t count = log_buffer_.size();
+			storage_.encoder().compress(writer, log_buffer_, count);
+			writer.finish();
+			log_buffer_.consume(count);
+#else
+			// The store writes one slot at a time, so we hand it slot-sized chunks
+			char chunk[EEPROMLogStore<ArduinoEEPROMDevice>::payload_size];
+
 			while(!log_buffer_.empty())
 			{
-				EEPROMWriteAndIncrement(log_buffer_.get());
+				size_t count = log_buffer_.size();
+				count = (count > sizeof(chunk)) ? sizeof(chunk) : count;
+				copy_from_buffer(log_buffer_, chunk, count);
+				log_buffer_.consume(count);
+				eeprom_.write(chunk, count);
 			}
-			// End with a NULL terminator to ensure we clear out any OLD log data
-			// stored in the EEPROM
-			EEPROMWriteAndIncrement(0x0);
-
-			log_buffer_.reset();
+#endif
 		}
 		else
 		{
 			// Circular buffer just prints out the log
-			while(!log_buffer_.empty())
-			{
-				_putchar(log_buffer_.get());
-			}
+			putchar_log_sink sink;
+			drain_to_sink(sink, log_buffer_);
 		}
 	}
 
@@ -342,175 +734,144 @@ class TeensyRobustModuleLogger final : public LoggerBase
 	}
 
   private:
-	void EEPROMWriteAndIncrement(char c)
+	/// Selects whether a compile-time filtered module statement is compiled in
+	template<bool TEnabled>
+	struct module_level_tag
 	{
-		EEPROM.write(eeprom_log_address_ + eeprom_write_pos_, c);
-		eeprom_write_pos_++;
-		if(eeprom_write_pos_ == eeprom_log_size_)
-		{
-			// Once we've wrapped around, we're *always* full.
-			eeprom_full_ = true;
-			eeprom_write_pos_ = 0;
-		}
-	}
+	};
 
-	void errorHalt(const char* msg)
+	/// Log a statement for a module, if the module's runtime level allows it.
+	/// TFormat is `const char*` or a log_format.
+	template<class TFormat, typename... Args>
+	void log_module(unsigned module_id, log_level_e l, const TFormat& fmt, const Args&... args)
 	{
-		printf("Error: %s\n", msg);
-		if(fs_->sdErrorCode())
-		{
-			if(fs_->sdErrorCode() == SD_CARD_ERROR_ACMD41)
-			{
-				printf("Try power cycling the SD card.\n");
-			}
-			printSdErrorSymbol(&Serial, fs_->sdErrorCode());
-			printf(", ErrorData: 0x%x\n", fs_->sdErrorData());
-		}
-		while(true)
+		if(module_levels_[module_id] >= l)
 		{
+			uint64_t start = this->stats_bytes();
+			this->log(l, fmt, std::forward<const Args>(args)...);
+			module_logged(module_id, start);
 		}
 	}
 
-	void writeBufferToSDFile()
+	/// @see log_module()
+	template<class TFormat, typename... Args>
+	void log_module_interrupt(unsigned module_id, log_level_e l, const TFormat& fmt,
+							  const Args&... args)
 	{
-		if(!file_.open(filename_, O_WRITE | O_APPEND))
-		{
-			errorHalt("Failed to open file");
-		}
-
-		int bytes_written = 0;
-
-		// We need to get the front, the rear, and potentially write the files in two steps
-		// to prevent ordering problems
-		size_t head = log_buffer_.head();
-		size_t tail = log_buffer_.tail();
-		const char* buffer = log_buffer_.storage();
-
-		if((head < tail) || ((tail > 0) && (log_buffer_.size() == log_buffer_.capacity())))
+		if(module_levels_[module_id] >= l)
 		{
-			// we have a wraparound case
-			// We will write from buffer[tail] to buffer[size] in one go
-			// Then we'll reset head to 0 so that we can write 0 to tail next
-			bytes_written = file_.write(&buffer[tail], log_buffer_.capacity() - tail);
-			bytes_written += file_.write(buffer, head);
-		}
-		else
-		{
-			// Write from tail position and send the specified number of bytes
-			bytes_written = file_.write(&buffer[tail], log_buffer_.size());
+			uint64_t start = this->stats_bytes();
+			this->log_interrupt(l, fmt, std::forward<const Args>(args)...);
+			module_logged(module_id, start);
 		}
+	}
 
-		if(static_cast<size_t>(bytes_written) != log_buffer_.size())
+	/// Record a module statement in module_stats(). `start` is stats_bytes() from before it.
+	void module_logged(unsigned module_id, uint64_t start) noexcept
+	{
+#if LOG_STATS_EN
+		// Nothing is written if the global level filtered out the statement
+		if(this->stats_bytes() != start)
 		{
-			errorHalt("Failed to write to log file");
+			module_stats_[module_id].add(static_cast<size_t>(this->stats_bytes() - start));
 		}
-
-		log_buffer_.reset();
-
-		file_.close();
+#else
+		static_cast<void>(module_id);
+		static_cast<void>(start);
+#endif
 	}
 
-	/// Checks the kinetis SoC's reset reason registers and logs them
-	/// This should only be called during begin().
-	void log_reset_reason()
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log(module_level_tag<true>, log_level_e l, const TFormat& fmt,
+					const Args&... args)
 	{
-		auto srs0 = RCM_SRS0;
-		auto srs1 = RCM_SRS1;
-
-		// Clear the values
-		RCM_SRS0 = 0;
-		RCM_SRS1 = 0;
-
-		if(srs0 & RCM_SRS0_LVD)
-		{
-			LoggerBase::info("Low-voltage Detect Reset\n");
-		}
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
 
-		if(srs0 & RCM_SRS0_LOL)
-		{
-			LoggerBase::info("Loss of Lock in PLL Reset\n");
-		}
+		log_module(TModule, l, fmt, args...);
+	}
 
-		if(srs0 & RCM_SRS0_LOC)
-		{
-			LoggerBase::info("Loss of External Clock Reset\n");
-		}
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log(module_level_tag<false>, log_level_e /*l*/, const TFormat& /*fmt*/,
+					const Args&... /*args*/) noexcept
+	{
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
+	}
 
-		if(srs0 & RCM_SRS0_WDOG)
-		{
-			LoggerBase::info("Watchdog Reset\n");
-		}
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log_interrupt(module_level_tag<true>, log_level_e l, const TFormat& fmt,
+							  const Args&... args)
+	{
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
 
-		if(srs0 & RCM_SRS0_PIN)
-		{
-			LoggerBase::info("External Pin Reset\n");
-		}
+		log_module_interrupt(TModule, l, fmt, args...);
+	}
 
-		if(srs0 & RCM_SRS0_POR)
-		{
-			LoggerBase::info("Power-on Reset\n");
-		}
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log_interrupt(module_level_tag<false>, log_level_e /*l*/, const TFormat& /*fmt*/,
+							  const Args&... /*args*/) noexcept
+	{
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
+	}
 
-		if(srs1 & RCM_SRS1_SACKERR)
+	void writeBufferToSDFile()
+	{
+		if(storage_.take_deferred_open())
 		{
-			LoggerBase::info("Stop Mode Acknowledge Error Reset\n");
+			// See begin_deferred()
+			open_next_file();
+			this->flush_pending(false);
 		}
 
-		if(srs1 & RCM_SRS1_MDM_AP)
-		{
-			LoggerBase::info("MDM-AP Reset\n");
-		}
+		uint32_t start = this->stats_clock();
+		size_t count = storage_.write(log_buffer_);
+		this->stats_stored(start);
 
-		if(srs1 & RCM_SRS1_SW)
+		// log() never starts the next file: that waits for an explicit flush() or poll()
+		if(storage_.rotation_due(count, millis()) && !this->flushing_from_log())
 		{
-			LoggerBase::info("Software Reset\n");
+			open_next_file();
 		}
 
-		if(srs1 & RCM_SRS1_LOCKUP)
-		{
-			LoggerBase::info("Core Lockup Event Reset\n");
-		}
+		storage_.finish(count, log_buffer_, millis());
 	}
 
-	void set_filename()
+	/// Close the current file, and start the next one. This is called by begin(), and by the
+	/// flush path when the rotation policy requires a new file.
+	void open_next_file()
 	{
-		uint8_t value = EEPROM.read(EEPROM_LOG_STORAGE_ADDR);
-
-		// 0xFF indicates a byte that's been reset, or value 255. Either way, reset to 0.
-		if(value == 0xFF)
-		{
-			value = 1;
-		}
-
-		snprintf(filename_, FILENAME_SIZE, "log_%d.txt", value);
+		storage_.open_next(".txt", log_buffer_, millis());
+	}
 
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, value + 1);
+	/// Logs the reset reason. This should only be called during begin() or begin_deferred().
+	void log_reset_reason()
+	{
+		report_kinetis_reset_reason([this](const char* reason) {
+			this->LoggerBase::info("%s", reason);
+		});
 	}
 
   private:
 	/// SD Card Storage
-	SdFs* fs_ = nullptr;
-	char filename_[FILENAME_SIZE];
-	mutable FsFile file_;
+	SDRotatingStorage storage_;
 
 	/// EEPROM Log Storage
 	/// This variable indicates whether the class is configured
 	/// to fall back to the EEPROM for critical logging
 	bool fallback_to_eeprom_ = false;
-	/// Start address for writing the log to EEPROM
-	unsigned eeprom_log_address_ = 0;
-	/// Size of the log storage in EEPROM
-	unsigned eeprom_log_size_ = 0;
-	// Current write position into the EEPROM memory range
-	unsigned eeprom_write_pos_ = 0;
-	// Indicates whether we've filled up the EEPROM
-	bool eeprom_full_ = false;
+	ArduinoEEPROMDevice eeprom_device_;
+	/// Wear-leveled record storage in the EEPROM log region
+	EEPROMLogStore<ArduinoEEPROMDevice> eeprom_;
 
 	/// Log Levle Module Storage
-	log_level_e module_levels_[TModuleCount] = {log_level_e(LOG_LEVEL)};
+	log_level_e module_levels_[TModuleCount];
+
+#if LOG_STATS_EN
+	/// Statements logged by each module, see module_stats()
+	log_record_stats module_stats_[TModuleCount];
+#endif
 
 	/// Internal RAM log buffer
-	CircularBuffer<char, BUFFER_SIZE> log_buffer_;
+	TBuffer log_buffer_;
 };
 
-#endif // SD_FILE_LOGGER_H_
+#endif // TEENSY_ROBUST_MODULE_LOGGER_H_
@@ -1,11 +1,15 @@
-#ifndef SD_FILE_LOGGER_H_
-#define SD_FILE_LOGGER_H_
+#ifndef TEENSY_SD_LOGGER_H_
+#define TEENSY_SD_LOGGER_H_
 
 #include "Arduino.h"
 #include "ArduinoLogger.h"
 #include "SdFat.h"
 #include "internal/circular_buffer.hpp"
-#include <kinetis.h>
+#include "internal/external_buffer.hpp"
+#include "internal/kinetis_reset_reason.hpp"
+#include "internal/sdfat_storage.hpp"
+#include "internal/spsc_circular_buffer.hpp"
+#include "internal/timestamp_clock.hpp"
 
 /** SD File Buffer
  *
@@ -18,207 +22,191 @@
  *		PlatformLogger_t<TeensySDLogger>;
  *  @endcode
  *
+ * To log from an interrupt while loop() flushes, select the lock-free buffer:
+ *
+ *	@code
+ *	using PlatformLogger =
+ *		PlatformLogger_t<TeensySDLogger_t<SPSCCircularBuffer<char, 512>>>;
+ *  @endcode
+ *
+ * @tparam TBuffer The type of the internal RAM staging buffer. Any type with the
+ *	CircularBuffer interface can be used (e.g., SPSCCircularBuffer, or ExternalBuffer to place
+ *	the buffer in another memory region).
+ *
  * @ingroup LoggingSubsystem
  */
-class TeensySDLogger final : public LoggerBase
+template<class TBuffer = CircularBuffer<char, 512>>
+class TeensySDLogger_t final : public LoggerBaseT<TeensySDLogger_t<TBuffer>>
 {
-  private:
-	static constexpr size_t BUFFER_SIZE = 512;
+	friend class LoggerBaseT<TeensySDLogger_t>;
 
   public:
 	/// Default constructor
-	TeensySDLogger() : LoggerBase() {}
+	TeensySDLogger_t() : LoggerBaseT<TeensySDLogger_t>() {}
 
 	/// Default destructor
-	~TeensySDLogger() noexcept = default;
+	~TeensySDLogger_t() noexcept = default;
 
 	size_t size() const noexcept final
 	{
-		return file_.size();
+		return storage_.size();
 	}
 
 	size_t capacity() const noexcept final
 	{
-		// size in blocks * bytes per block (512 Bytes = 2^9)
-		return fs_ ? fs_->card()->sectorCount() << 9 : 0;
+		return storage_.capacity();
 	}
 
-	void log_customprefix() noexcept final
+	size_t format_customprefix(char* dst) noexcept final
 	{
-		print("[%d ms] ", millis());
+		return this->format_timestamp_prefix(dst, log_timestamp_now(this->timestamp_source()));
 	}
 
-	void begin(SdFs& sd_inst)
+	/** Open the log file on the SD card
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size If non-zero, a contiguous file of this many bytes is allocated,
+	 *	and the file is kept open. Data is then written in whole sectors, which avoids
+	 *	read-modify-write cycles and cluster allocation during logging. The file is truncated
+	 *	to the length of the data by close(), or when a new file is started.
+	 */
+	void begin(SdFs& sd_inst, uint64_t preallocate_size = 0)
 	{
-		fs_ = &sd_inst;
+		storage_.attach(sd_inst, preallocate_size);
+		storage_.open(storage_.filename(), log_buffer_, millis());
+
+		log_reset_reason();
 
-		if(!file_.open(filename_, O_WRITE | O_CREAT))
+		// Manually flush, since the file is open
+		this->flush();
+
+		if(storage_.keep_open())
 		{
-			errorHalt("Failed to open file");
+			sync();
 		}
+		else
+		{
+			storage_.release();
+		}
+	}
 
-		// Clear current file contents
-		file_.truncate(0);
+	/** Attach the SD card, and open the log file at the first flush
+	 *
+	 * begin() opens the log file, logs the reset reason, and flushes before it returns, which
+	 * can take hundreds of milliseconds on a slow card. This version only attaches the card and
+	 * logs the reset reason. Statements are kept in the RAM buffer, and the file is opened by
+	 * the first flush: the next poll() or flush(), or an auto-flush when the buffer fills.
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size @see begin()
+	 */
+	void begin_deferred(SdFs& sd_inst, uint64_t preallocate_size = 0)
+	{
+		storage_.attach(sd_inst, preallocate_size);
+		storage_.defer_open();
 
 		log_reset_reason();
 
-		// Manually flush, since the file is open
-		flush();
-
-		file_.close();
+		// The first poll() opens the file, even if no flush is due
+		this->flush_pending(true);
 	}
 
-  protected:
-	void log_putc(char c) noexcept final
+	/** Keep the log file open between flushes
+	 *
+	 * By default, the log file is opened and closed on every flush. When the file is kept
+	 * open, flush() only writes the data, and the file is synced according to the sync
+	 * budget (see sync_budget()). Data which has not been synced is lost if power is removed.
+	 *
+	 * @param enable If true, keep the file open. If false, the file is closed.
+	 */
+	void keep_file_open(bool enable)
 	{
-		log_buffer_.put(c);
+		storage_.keep_open(enable, log_buffer_, millis());
 	}
 
-	size_t internal_size() const noexcept override
+	/** Set the sync budget used when the log file is kept open
+	 *
+	 * @param bytes Sync once this many bytes have been written since the last sync.
+	 * @param ms Sync during flush() if this many milliseconds have passed since the last sync.
+	 */
+	void sync_budget(size_t bytes, uint32_t ms) noexcept
 	{
-		return log_buffer_.size();
+		storage_.sync_policy().budget(bytes, ms);
 	}
 
-	size_t internal_capacity() const noexcept override
+	/// Commit the data written to the log file to the SD card.
+	/// For a pre-allocated file, this includes the partial sector held in the buffer.
+	void sync()
 	{
-		return log_buffer_.capacity();
+		storage_.sync(log_buffer_, millis());
 	}
 
-	void flush_() noexcept final
+	/** Write the buffered data and close the log file
+	 *
+	 * A pre-allocated file is truncated to the length of the data. Logging can continue
+	 * after close(): the file is reopened (in append mode) by the next flush.
+	 */
+	void close()
 	{
-		writeBufferToSDFile();
+		this->flush();
+		storage_.close(log_buffer_, millis());
 	}
 
-	void clear_() noexcept final
+  protected:
+	void log_putc(char c) noexcept final
 	{
-		log_buffer_.reset();
+		log_buffer_.put(c);
 	}
 
-  private:
-	void errorHalt(const char* msg)
+	void log_write(const char* str, size_t len) noexcept final
 	{
-		printf("Error: %s\n", msg);
-		if(fs_->sdErrorCode())
-		{
-			if(fs_->sdErrorCode() == SD_CARD_ERROR_ACMD41)
-			{
-				printf("Try power cycling the SD card.\n");
-			}
-			printSdErrorSymbol(&Serial, fs_->sdErrorCode());
-			printf(", ErrorData: 0x%x\n", fs_->sdErrorData());
-		}
-		while(true)
-		{
-		}
+		this->log_write_to_buffer(log_buffer_, str, len);
 	}
 
-	void writeBufferToSDFile()
+	size_t internal_size() const noexcept override
 	{
-		if(!file_.open(filename_, O_WRITE | O_APPEND))
-		{
-			errorHalt("Failed to open file");
-		}
-
-		int bytes_written = 0;
+		return log_buffer_.size();
+	}
 
-		// We need to get the front, the rear, and potentially write the files in two steps
-		// to prevent ordering problems
-		size_t head = log_buffer_.head();
-		size_t tail = log_buffer_.tail();
-		const char* buffer = log_buffer_.storage();
+	size_t internal_capacity() const noexcept override
+	{
+		return log_buffer_.capacity();
+	}
 
-		if((head < tail) || ((tail > 0) && (log_buffer_.size() == log_buffer_.capacity())))
-		{
-			// we have a wraparound case
-			// We will write from buffer[tail] to buffer[size] in one go
-			// Then we'll reset head to 0 so that we can write 0 to tail next
-			bytes_written = file_.write(&buffer[tail], log_buffer_.capacity() - tail);
-			bytes_written += file_.write(buffer, head);
-		}
-		else
+	void flush_() noexcept final
+	{
+		if(storage_.take_deferred_open())
 		{
-			// Write from tail position and send the specified number of bytes
-			bytes_written = file_.write(&buffer[tail], log_buffer_.size());
+			// See begin_deferred()
+			storage_.open(storage_.filename(), log_buffer_, millis());
+			this->flush_pending(false);
 		}
 
-		if(static_cast<size_t>(bytes_written) != log_buffer_.size())
-		{
-			errorHalt("Failed to write to log file");
-		}
+		uint32_t start = this->stats_clock();
+		size_t count = storage_.write(log_buffer_);
+		this->stats_stored(start);
 
-		log_buffer_.reset();
+		storage_.finish(count, log_buffer_, millis());
+	}
 
-		file_.close();
+	void clear_() noexcept final
+	{
+		log_buffer_.reset();
 	}
 
-	/// Checks the kinetis SoC's reset reason registers and logs them
-	/// This should only be called during begin().
+  private:
+	/// Logs the reset reason. This should only be called during begin() or begin_deferred().
 	void log_reset_reason()
 	{
-		auto srs0 = RCM_SRS0;
-		auto srs1 = RCM_SRS1;
-
-		// Clear the values
-		RCM_SRS0 = 0;
-		RCM_SRS1 = 0;
-
-		if(srs0 & RCM_SRS0_LVD)
-		{
-			info("Low-voltage Detect Reset\n");
-		}
-
-		if(srs0 & RCM_SRS0_LOL)
-		{
-			info("Loss of Lock in PLL Reset\n");
-		}
-
-		if(srs0 & RCM_SRS0_LOC)
-		{
-			info("Loss of External Clock Reset\n");
-		}
-
-		if(srs0 & RCM_SRS0_WDOG)
-		{
-			info("Watchdog Reset\n");
-		}
-
-		if(srs0 & RCM_SRS0_PIN)
-		{
-			info("External Pin Reset\n");
-		}
-
-		if(srs0 & RCM_SRS0_POR)
-		{
-			info("Power-on Reset\n");
-		}
-
-		if(srs1 & RCM_SRS1_SACKERR)
-		{
-			info("Stop Mode Acknowledge Error Reset\n");
-		}
-
-		if(srs1 & RCM_SRS1_MDM_AP)
-		{
-			info("MDM-AP Reset\n");
-		}
-
-		if(srs1 & RCM_SRS1_SW)
-		{
-			info("Software Reset\n");
-		}
-
-		if(srs1 & RCM_SRS1_LOCKUP)
-		{
-			info("Core Lockup Event Reset\n");
-		}
+		report_kinetis_reset_reason([this](const char* reason) { this->info("%s", reason); });
 	}
 
   private:
-	SdFs* fs_;
-	const char* filename_ = "log.txt";
-	mutable FsFile file_;
-
-	CircularBuffer<char, BUFFER_SIZE> log_buffer_;
+	SDStorage storage_;
+	TBuffer log_buffer_;
 };
 
-#endif // SD_FILE_LOGGER_H_
+/// The default TeensySDLogger configuration
+using TeensySDLogger = TeensySDLogger_t<>;
+
+#endif // TEENSY_SD_LOGGER_H_
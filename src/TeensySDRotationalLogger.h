@@ -1,12 +1,15 @@
-#ifndef SD_FILE_LOGGER_H_
-#define SD_FILE_LOGGER_H_
+#ifndef TEENSY_SD_ROTATIONAL_LOGGER_H_
+#define TEENSY_SD_ROTATIONAL_LOGGER_H_
 
 #include "Arduino.h"
 #include "ArduinoLogger.h"
 #include "SdFat.h"
+#include "internal/binary_log_encoder.hpp"
 #include "internal/circular_buffer.hpp"
-#include <EEPROM.h>
-#include <kinetis.h>
+#include "internal/external_buffer.hpp"
+#include "internal/kinetis_reset_reason.hpp"
+#include "internal/sdfat_storage.hpp"
+#include "internal/timestamp_clock.hpp"
 
 /** SD File Buffer
  *
@@ -14,237 +17,670 @@
  *
  * This class uses the SdFat Arduino Library.
  *
+ * The file format is selected with a template parameter:
+ * - log_file_format_e::text writes the formatted log to `log_N.txt`.
+ * - log_file_format_e::binary writes compact binary records to `log_N.bin`. Formatting is
+ *	skipped on the device, and the file is turned back into text on the host with
+ *	tools/binary_log_decoder. The format is described in internal/binary_log_format.hpp.
+ *
+ * Binary mode has the same restrictions as the deferred logger: format strings are identified
+ * by pointer (use string literals), string arguments are truncated to
+ * LOG_BINARY_MAX_STRING_LENGTH, and the custom prefix is replaced by a timestamp field.
+ * A record that does not fit in the buffer is dropped as a whole and reported as an overrun.
+ *
  *	@code
  *	using PlatformLogger =
  *		PlatformLogger_t<TeensySDRotationalLogger>;
+ *	using BinaryPlatformLogger =
+ *		PlatformLogger_t<TeensySDRotationalLogger_t<log_file_format_e::binary>>;
  *  @endcode
  *
+ * @tparam TFormat The log file format.
+ * @tparam TBuffer The type of the internal RAM staging buffer. Any type with the
+ *	CircularBuffer interface can be used (e.g., SPSCCircularBuffer, or ExternalBuffer to place
+ *	the buffer in another memory region).
+ *
  * @ingroup LoggingSubsystem
  */
-class TeensySDRotationalLogger final : public LoggerBase
+template<log_file_format_e TFormat = log_file_format_e::text,
+		 class TBuffer = CircularBuffer<char, 512>>
+class TeensySDRotationalLogger_t final
+	: public LoggerBaseT<TeensySDRotationalLogger_t<TFormat, TBuffer>>
 {
-  private:
-	static constexpr size_t BUFFER_SIZE = 512;
-	static constexpr size_t FILENAME_SIZE = 32;
-	static constexpr unsigned EEPROM_LOG_STORAGE_ADDR = 4095;
+	friend class LoggerBaseT<TeensySDRotationalLogger_t>;
 
   public:
 	/// Default constructor
-	TeensySDRotationalLogger() : LoggerBase() {}
+	TeensySDRotationalLogger_t() : LoggerBaseT<TeensySDRotationalLogger_t>() {}
 
 	/// Default destructor
-	~TeensySDRotationalLogger() noexcept = default;
+	~TeensySDRotationalLogger_t() noexcept = default;
 
 	size_t size() const noexcept final
 	{
-		return file_.size();
+		return storage_.size();
 	}
 
 	size_t capacity() const noexcept final
 	{
-		// size in blocks * bytes per block (512 Bytes = 2^9)
-		return fs_ ? fs_->card()->sectorCount() << 9 : 0;
+		return storage_.capacity();
 	}
 
-	void log_customprefix() noexcept final
+	size_t format_customprefix(char* dst) noexcept final
 	{
-		print("[%d ms] ", millis());
+		return this->format_timestamp_prefix(dst, log_timestamp_now(this->timestamp_source()));
 	}
 
-	void begin(SdFs& sd_inst)
+	/** Start a new log file
+	 *
+	 * If a file was already in use, the buffered log data is written to it first.
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size If non-zero, a contiguous file of this many bytes is allocated,
+	 *	and the file is kept open. Data is then written in whole sectors, which avoids
+	 *	read-modify-write cycles and cluster allocation during logging. The file is truncated
+	 *	to the length of the data by close(), or when a new file is started.
+	 */
+	void begin(SdFs& sd_inst, uint64_t preallocate_size = 0)
 	{
-		fs_ = &sd_inst;
+		if(storage_.attached())
+		{
+			flush();
+		}
+
+		storage_.attach(sd_inst, preallocate_size);
+
+		open_next_file();
+
+		log_reset_reason();
+
+		// Manually flush, since the file is open
+		flush();
 
-		set_filename();
+		if(storage_.keep_open())
+		{
+			sync();
+		}
+		else
+		{
+			storage_.release();
+		}
+	}
 
-		if(!file_.open(filename_, O_WRITE | O_CREAT))
+	/** Attach the SD card, and start a new log file at the first flush
+	 *
+	 * begin() starts a new log file, logs the reset reason, and flushes before it returns,
+	 * which can take hundreds of milliseconds on a slow card. This version only attaches the
+	 * card and logs the reset reason. Statements are kept in the RAM buffer, and the new file
+	 * is started by the first flush: the next poll() or flush(), or an auto-flush when the
+	 * buffer fills.
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size @see begin()
+	 */
+	void begin_deferred(SdFs& sd_inst, uint64_t preallocate_size = 0)
+	{
+		if(storage_.attached())
 		{
-			errorHalt("Failed to open file");
+			flush();
 		}
 
-		// Clear current file contents
-		file_.truncate(0);
+		storage_.attach(sd_inst, preallocate_size);
+		storage_.defer_open();
 
 		log_reset_reason();
 
-		// Manually flush, since the file is open
+		// The first poll() starts the file, even if no flush is due
+		this->flush_pending(true);
+	}
+
+	/** Keep the log file open between flushes
+	 *
+	 * By default, the log file is opened and closed on every flush. When the file is kept
+	 * open, flush() only writes the data, and the file is synced according to the sync
+	 * budget (see sync_budget()). Data which has not been synced is lost if power is removed.
+	 *
+	 * @param enable If true, keep the file open. If false, the file is closed.
+	 */
+	void keep_file_open(bool enable)
+	{
+		storage_.keep_open(enable, log_buffer_, millis());
+	}
+
+	/** Set the sync budget used when the log file is kept open
+	 *
+	 * @param bytes Sync once this many bytes have been written since the last sync.
+	 * @param ms Sync during flush() if this many milliseconds have passed since the last sync.
+	 */
+	void sync_budget(size_t bytes, uint32_t ms) noexcept
+	{
+		storage_.sync_policy().budget(bytes, ms);
+	}
+
+	/// Commit the data written to the log file to the SD card.
+	/// For a pre-allocated file, this includes the partial sector held in the buffer.
+	void sync()
+	{
+		storage_.sync(log_buffer_, millis());
+	}
+
+	/** Write the buffered data and close the log file
+	 *
+	 * A pre-allocated file is truncated to the length of the data. Logging can continue
+	 * after close(): the file is reopened (in append mode) by the next flush.
+	 */
+	void close()
+	{
 		flush();
+		storage_.close(log_buffer_, millis());
+	}
+
+	/** Access the rotation policy
+	 *
+	 * By default, a new file is only started by begin(). The policy can also start a new file
+	 * once the current one reaches a size, or has been in use for an interval. With a
+	 * retention budget, the oldest log files are deleted when a new file is started:
+	 *
+	 *	@code
+	 *	logger.rotation_policy().max_size(16 * 1024 * 1024);
+	 *	logger.rotation_policy().interval(24 * 60 * 60 * 1000UL);
+	 *	logger.rotation_policy().retention(1024 * 1024 * 1024ULL);
+	 *	@endcode
+	 */
+	LogRotationPolicy& rotation_policy() noexcept
+	{
+		return storage_.rotation_policy();
+	}
+
+	/// The index of the current log file, log_<index>.txt (or .bin)
+	uint32_t file_index() const noexcept
+	{
+		return storage_.file_index();
+	}
+
+	/// Write the buffered data to the current file, and start the next file
+	void rotate()
+	{
+		if(storage_.attached())
+		{
+			this->flush();
+			open_next_file();
 
-		file_.close();
+			storage_.release();
+		}
 	}
 
-	// Resets the log file counter back to 1
+	/// Resets the log file counter back to 1. The SD card must be initialized.
 	void resetFileCounter()
 	{
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, 1);
+		sd_store_log_index<FsFile>(1);
 	}
 
-  protected:
-	void log_putc(char c) noexcept final
+	template<typename... Args>
+	void critical(const char* fmt, const Args&... args)
 	{
-		log_buffer_.put(c);
+		log(log_level_e::critical, fmt, args...);
 	}
 
-	size_t internal_size() const noexcept override
+	template<typename... Args>
+	void critical_interrupt(const char* fmt, const Args&... args)
 	{
-		return log_buffer_.size();
+		log_interrupt(log_level_e::critical, fmt, args...);
 	}
 
-	size_t internal_capacity() const noexcept override
+	template<typename... Args>
+	void error(const char* fmt, const Args&... args)
 	{
-		return log_buffer_.capacity();
+		log(log_level_e::error, fmt, args...);
 	}
 
-	void flush_() noexcept final
+	template<typename... Args>
+	void error_interrupt(const char* fmt, const Args&... args)
 	{
-		writeBufferToSDFile();
+		log_interrupt(log_level_e::error, fmt, args...);
 	}
 
-	void clear_() noexcept final
+	template<typename... Args>
+	void warning(const char* fmt, const Args&... args)
 	{
-		log_buffer_.reset();
+		log(log_level_e::warning, fmt, args...);
 	}
 
-  private:
-	void errorHalt(const char* msg)
+	template<typename... Args>
+	void warning_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::warning, fmt, args...);
+	}
+
+	template<typename... Args>
+	void info(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::info, fmt, args...);
+	}
+
+	template<typename... Args>
+	void info_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::info, fmt, args...);
+	}
+
+	template<typename... Args>
+	void debug(const char* fmt, const Args&... args)
+	{
+		log(log_level_e::debug, fmt, args...);
+	}
+
+	template<typename... Args>
+	void debug_interrupt(const char* fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::debug, fmt, args...);
+	}
+
+	/// @see LoggerBase::print()
+	template<typename... Args>
+	void print(const char* fmt, const Args&... args) noexcept
+	{
+		print_(format_tag<TFormat>(), fmt, args...);
+	}
+
+	/// @see LoggerBase::log_interrupt()
+	template<typename... Args>
+	void log_interrupt(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		log_interrupt_(format_tag<TFormat>(), l, fmt, args...);
+	}
+
+	/// @see LoggerBase::log()
+	template<typename... Args>
+	void log(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		log_(format_tag<TFormat>(), l, fmt, args...);
+	}
+
+	/** @name LOG_FMT() overloads
+	 *
+	 * @see LoggerBase LOG_FMT() overloads. The arguments are checked against the format at
+	 * compile time. Text files are written by the generated emitter, and binary records store
+	 * the checked format string like a plain one.
+	 */
+	///@{
+	template<class TString, typename... Args>
+	void critical(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void critical_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info(const log_format<TString>& fmt, const Args&... args)
+	{
+		log(log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug(const log_format<TString>& fmt, const Args&... args)
 	{
-		printf("Error: %s\n", msg);
-		if(fs_->sdErrorCode())
+		log(log_level_e::debug, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_interrupt(log_level_e::debug, fmt, args...);
+	}
+
+	/// @see print()
+	template<class TString, typename... Args>
+	void print(const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		print_(format_tag<TFormat>(), fmt, args...);
+	}
+
+	/// @see log_interrupt()
+	template<class TString, typename... Args>
+	void log_interrupt(log_level_e l, const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		log_interrupt_(format_tag<TFormat>(), l, fmt, args...);
+	}
+
+	/// @see log()
+	template<class TString, typename... Args>
+	void log(log_level_e l, const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_format_check<TString, Args...>();
+		log_(format_tag<TFormat>(), l, fmt, args...);
+	}
+	///@}
+
+	/// Write the buffer to the log file, then report any overrun in the current file format
+	void flush() noexcept final
+	{
+		this->write_rate_limit_summary(*this);
+
+		if(internal_size() > 0)
 		{
-			if(fs_->sdErrorCode() == SD_CARD_ERROR_ACMD41)
+			uint32_t start = this->stats_flush_started();
+			flush_();
+
+			if(this->has_overrun())
 			{
-				printf("Try power cycling the SD card.\n");
+				this->write_overrun_marker(*this);
+				flush_();
 			}
-			printSdErrorSymbol(&Serial, fs_->sdErrorCode());
-			printf(", ErrorData: 0x%x\n", fs_->sdErrorData());
-		}
-		while(true)
-		{
+
+			this->overrun_occurred(false);
+			this->stats_flushed(start);
 		}
 	}
 
-	void writeBufferToSDFile()
+  protected:
+	void log_putc(char c) noexcept final
 	{
-		if(!file_.open(filename_, O_WRITE | O_APPEND))
+		if(TFormat == log_file_format_e::binary)
 		{
-			errorHalt("Failed to open file");
+			log_write(&c, 1);
 		}
+		else
+		{
+			log_buffer_.put(c);
+		}
+	}
 
-		int bytes_written = 0;
-
-		// We need to get the front, the rear, and potentially write the files in two steps
-		// to prevent ordering problems
-		size_t head = log_buffer_.head();
-		size_t tail = log_buffer_.tail();
-		const char* buffer = log_buffer_.storage();
-
-		if((head < tail) || ((tail > 0) && (log_buffer_.size() == log_buffer_.capacity())))
+	/// In binary mode, data which bypasses the formatter (e.g., write()) is stored as a text record
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		if(TFormat == log_file_format_e::binary)
 		{
-			// we have a wraparound case
-			// We will write from buffer[tail] to buffer[size] in one go
-			// Then we'll reset head to 0 so that we can write 0 to tail next
-			bytes_written = file_.write(&buffer[tail], log_buffer_.capacity() - tail);
-			bytes_written += file_.write(buffer, head);
+			add_whole_record([this, str, len](record_writer& writer) {
+				return encoder_.text(writer, str, len);
+			});
 		}
 		else
 		{
-			// Write from tail position and send the specified number of bytes
-			bytes_written = file_.write(&buffer[tail], log_buffer_.size());
+			this->log_write_to_buffer(log_buffer_, str, len);
 		}
+	}
 
-		if(static_cast<size_t>(bytes_written) != log_buffer_.size())
-		{
-			errorHalt("Failed to write to log file");
-		}
+	size_t internal_size() const noexcept override
+	{
+		return log_buffer_.size();
+	}
 
-		log_buffer_.reset();
+	size_t internal_capacity() const noexcept override
+	{
+		return log_buffer_.capacity();
+	}
+
+	void flush_() noexcept final
+	{
+		writeBufferToSDFile();
+	}
 
-		file_.close();
+	void clear_() noexcept final
+	{
+		log_buffer_.reset();
 	}
 
-	/// Checks the kinetis SoC's reset reason registers and logs them
-	/// This should only be called during begin().
-	void log_reset_reason()
+  private:
+	/// Selects the text or binary implementation of the logging functions
+	template<log_file_format_e F>
+	struct format_tag
 	{
-		auto srs0 = RCM_SRS0;
-		auto srs1 = RCM_SRS1;
+	};
 
-		// Clear the values
-		RCM_SRS0 = 0;
-		RCM_SRS1 = 0;
+	/// Adapts the log buffer to the writer interface required by BinaryLogEncoder
+	class record_writer
+	{
+	  public:
+		explicit record_writer(TeensySDRotationalLogger_t& logger) noexcept : logger_(logger) {}
 
-		if(srs0 & RCM_SRS0_LVD)
+		/// Records are only added if they fit, so the buffer is never flushed part-way through a
+		/// record (see add_record())
+		size_t available() const noexcept
 		{
-			info("Low-voltage Detect Reset\n");
+			return logger_.internal_capacity() - logger_.internal_size();
 		}
 
-		if(srs0 & RCM_SRS0_LOL)
+		void write(const char* data, size_t len) noexcept
 		{
-			info("Loss of Lock in PLL Reset\n");
+			logger_.log_write_to_buffer(logger_.log_buffer_, data, len);
+			written_ += len;
 		}
 
-		if(srs0 & RCM_SRS0_LOC)
+		/// The number of bytes written through this writer
+		size_t written() const noexcept
 		{
-			info("Loss of External Clock Reset\n");
+			return written_;
 		}
 
-		if(srs0 & RCM_SRS0_WDOG)
+	  private:
+		TeensySDRotationalLogger_t& logger_;
+		size_t written_ = 0;
+	};
+
+	/// The text variants take a `const char*` or a LOG_FMT() format, which LoggerBase handles
+	template<class TFmt, typename... Args>
+	void print_(format_tag<log_file_format_e::text>, const TFmt& fmt, const Args&... args) noexcept
+	{
+		LoggerBase::print(fmt, args...);
+	}
+
+	template<typename... Args>
+	void print_(format_tag<log_file_format_e::binary>, const char* fmt,
+				const Args&... args) noexcept
+	{
+		add_record(log_level_e::off, fmt, args...);
+
+		if(this->echo())
 		{
-			info("Watchdog Reset\n");
+			// cppcheck-suppress wrongPrintfScanfArgNum
+			printf(fmt, args...);
 		}
+	}
+
+	template<class TFmt, typename... Args>
+	void log_interrupt_(format_tag<log_file_format_e::text>, log_level_e l, const TFmt& fmt,
+						const Args&... args) noexcept
+	{
+		LoggerBase::log_interrupt(l, fmt, args...);
+	}
 
-		if(srs0 & RCM_SRS0_PIN)
+	template<typename... Args>
+	void log_interrupt_(format_tag<log_file_format_e::binary>, log_level_e l, const char* fmt,
+						const Args&... args) noexcept
+	{
+		if(this->enabled() && l <= this->level())
 		{
-			info("External Pin Reset\n");
+			bool flush_setting = this->auto_flush(false);
+			uint64_t start = this->stats_bytes();
+			add_record(l, fmt, args...);
+			this->stats_logged(l, start);
+			this->auto_flush(flush_setting);
 		}
+	}
+
+	template<class TFmt, typename... Args>
+	void log_(format_tag<log_file_format_e::text>, log_level_e l, const TFmt& fmt,
+			  const Args&... args) noexcept
+	{
+		LoggerBase::log(l, fmt, args...);
+	}
 
-		if(srs0 & RCM_SRS0_POR)
+	template<typename... Args>
+	void log_(format_tag<log_file_format_e::binary>, log_level_e l, const char* fmt,
+			  const Args&... args) noexcept
+	{
+		if(this->enabled() && l <= this->level() && this->rate_limit_admit(*this, l, fmt, args...))
 		{
-			info("Power-on Reset\n");
+			uint64_t start = this->stats_bytes();
+			add_record(l, fmt, args...);
+			this->stats_logged(l, start);
+
+			if(this->echo())
+			{
+				log_echo_level_prefix(l);
+				// cppcheck-suppress wrongPrintfScanfArgNum
+				printf(fmt, args...);
+			}
+
+			this->flush_on_level(l);
 		}
+	}
+
+	/// Binary records store the format string, so the binary variants store a checked LOG_FMT()
+	/// format like a plain one
+	template<class TString, typename... Args>
+	void print_(format_tag<log_file_format_e::binary> tag, const log_format<TString>& fmt,
+				const Args&... args) noexcept
+	{
+		print_(tag, fmt.c_str(), args...);
+	}
 
-		if(srs1 & RCM_SRS1_SACKERR)
+	template<class TString, typename... Args>
+	void log_interrupt_(format_tag<log_file_format_e::binary> tag, log_level_e l,
+						const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_interrupt_(tag, l, fmt.c_str(), args...);
+	}
+
+	template<class TString, typename... Args>
+	void log_(format_tag<log_file_format_e::binary> tag, log_level_e l,
+			  const log_format<TString>& fmt, const Args&... args) noexcept
+	{
+		log_(tag, l, fmt.c_str(), args...);
+	}
+
+	template<typename... Args>
+	void add_record(log_level_e l, const char* fmt, const Args&... args) noexcept
+	{
+		size_t written = add_whole_record([&](record_writer& writer) {
+			return encoder_.record(writer, static_cast<uint8_t>(l), 0, millis(), fmt, args...);
+		});
+
+		this->stats_wrote(written);
+	}
+
+	/** Add a binary record, which is written by add(record_writer&)
+	 *
+	 * If the record does not fit and auto-flush is enabled, the buffer is flushed, and the
+	 * record is added again. The buffer is therefore only flushed between records: a flush may
+	 * start the next file, which resets the encoder and begins with a new header.
+	 *
+	 * @returns The number of bytes added.
+	 */
+	template<class TAdd>
+	size_t add_whole_record(TAdd add) noexcept
+	{
+		record_writer writer(*this);
+		bool added = add(writer);
+
+		if(!added && this->auto_flush() && log_buffer_.size() > 0)
 		{
-			info("Stop Mode Acknowledge Error Reset\n");
+			this->flush_from_log();
+			added = add(writer);
 		}
 
-		if(srs1 & RCM_SRS1_MDM_AP)
+		if(!added)
 		{
-			info("MDM-AP Reset\n");
+			this->overrun_occurred(true);
 		}
 
-		if(srs1 & RCM_SRS1_SW)
+		return writer.written();
+	}
+
+  private:
+	void writeBufferToSDFile()
+	{
+		if(storage_.take_deferred_open())
 		{
-			info("Software Reset\n");
+			// See begin_deferred()
+			open_next_file();
+			this->flush_pending(false);
 		}
 
-		if(srs1 & RCM_SRS1_LOCKUP)
+		uint32_t start = this->stats_clock();
+		size_t count = storage_.write(log_buffer_);
+		this->stats_stored(start);
+
+		// log() never starts the next file: that waits for an explicit flush() or poll()
+		if(storage_.rotation_due(count, millis()) && !this->flushing_from_log())
 		{
-			info("Core Lockup Event Reset\n");
+			open_next_file();
 		}
+
+		storage_.finish(count, log_buffer_, millis());
 	}
 
-	void set_filename()
+	/// Close the current file, and start the next one. This is called by begin(), and by the
+	/// flush path when the rotation policy requires a new file.
+	void open_next_file()
 	{
-		uint8_t value = EEPROM.read(EEPROM_LOG_STORAGE_ADDR);
+		storage_.open_next(log_extension(), log_buffer_, millis());
 
-		// 0xFF indicates a byte that's been reset, or value 255. Either way, reset to 0.
-		if(value == 0xFF)
+		if(TFormat == log_file_format_e::binary)
 		{
-			value = 1;
+			// Each file must decode on its own, so the format definitions are written again
+			encoder_.reset();
+			char header[binary_log_header_size];
+			storage_.write(header, BinaryLogEncoder::write_header(header), millis());
 		}
+	}
 
-		snprintf(filename_, FILENAME_SIZE, "log_%d.txt", value);
+	/// Logs the reset reason. This should only be called during begin() or begin_deferred().
+	void log_reset_reason()
+	{
+		report_kinetis_reset_reason([this](const char* reason) { this->info("%s", reason); });
+	}
 
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, value + 1);
+	static constexpr const char* log_extension() noexcept
+	{
+		return (TFormat == log_file_format_e::binary) ? ".bin" : ".txt";
 	}
 
   private:
-	SdFs* fs_;
-	char filename_[FILENAME_SIZE];
-	mutable FsFile file_;
+	SDRotatingStorage storage_;
 
-	CircularBuffer<char, BUFFER_SIZE> log_buffer_;
+	TBuffer log_buffer_;
+	BinaryLogEncoder encoder_;
 };
 
-#endif // SD_FILE_LOGGER_H_
+using TeensySDRotationalLogger = TeensySDRotationalLogger_t<>;
+
+#endif // TEENSY_SD_ROTATIONAL_LOGGER_H_
@@ -1,12 +1,14 @@
-#ifndef SD_FILE_LOGGER_H_
-#define SD_FILE_LOGGER_H_
+#ifndef TEENSY_SD_ROTATIONAL_MODULE_LOGGER_H_
+#define TEENSY_SD_ROTATIONAL_MODULE_LOGGER_H_
 
 #include "Arduino.h"
 #include "ArduinoLogger.h"
 #include "SdFat.h"
 #include "internal/circular_buffer.hpp"
-#include <EEPROM.h>
-#include <kinetis.h>
+#include "internal/external_buffer.hpp"
+#include "internal/kinetis_reset_reason.hpp"
+#include "internal/sdfat_storage.hpp"
+#include "internal/timestamp_clock.hpp"
 
 /** Rotational SD File Buffer with per-Module Log Levels
  *
@@ -27,66 +29,178 @@
  *
  * @tparam TModuleCount The maximum number of modules you want to support
  * 	with this logging strategy.
+ * @tparam TBuffer The type of the internal RAM staging buffer. Any type with the
+ *	CircularBuffer interface can be used (e.g., SPSCCircularBuffer, or ExternalBuffer to place
+ *	the buffer in another memory region).
  *
  * @ingroup LoggingSubsystem
  */
-template<size_t TModuleCount = 1>
-class TeensySDRotationalModuleLogger final : public LoggerBase
+template<size_t TModuleCount = 1, class TBuffer = CircularBuffer<char, 512>>
+class TeensySDRotationalModuleLogger final
+	: public LoggerBaseT<TeensySDRotationalModuleLogger<TModuleCount, TBuffer>>
 {
-  private:
-	static constexpr size_t BUFFER_SIZE = 512;
-	static constexpr size_t FILENAME_SIZE = 32;
-	static constexpr unsigned EEPROM_LOG_STORAGE_ADDR = 4095;
+	friend class LoggerBaseT<TeensySDRotationalModuleLogger>;
 
   public:
 	/// Default constructor
-	TeensySDRotationalModuleLogger() : LoggerBase() {}
+	/// Module 0 starts at LOG_LEVEL, clamped to LOG_MODULE_LEVEL_LIMIT(0); other modules start off
+	TeensySDRotationalModuleLogger() : LoggerBaseT<TeensySDRotationalModuleLogger>()
+	{
+		for(unsigned i = 0; i < TModuleCount; i++)
+		{
+			module_levels_[i] = (i == 0) ? LOG_MODULE_LEVEL_LIMIT(0) : log_level_e::off;
+		}
+	}
 
 	/// Default destructor
 	~TeensySDRotationalModuleLogger() noexcept = default;
 
 	size_t size() const noexcept final
 	{
-		return file_.size();
+		return storage_.size();
 	}
 
 	size_t capacity() const noexcept final
 	{
-		// size in blocks * bytes per block (512 Bytes = 2^9)
-		return fs_ ? fs_->card()->sectorCount() << 9 : 0;
+		return storage_.capacity();
 	}
 
-	void log_customprefix() noexcept final
+	size_t format_customprefix(char* dst) noexcept final
 	{
-		print("[%d ms] ", millis());
+		return this->format_timestamp_prefix(dst, log_timestamp_now(this->timestamp_source()));
 	}
 
-	void begin(SdFs& sd_inst)
+	/** Open the log file on the SD card
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size If non-zero, a contiguous file of this many bytes is allocated,
+	 *	and the file is kept open. Data is then written in whole sectors, which avoids
+	 *	read-modify-write cycles and cluster allocation during logging. The file is truncated
+	 *	to the length of the data by close(), or when a new file is started.
+	 */
+	void begin(SdFs& sd_inst, uint64_t preallocate_size = 0)
 	{
-		fs_ = &sd_inst;
+		storage_.attach(sd_inst, preallocate_size);
 
-		set_filename();
+		open_next_file();
 
-		if(!file_.open(filename_, O_WRITE | O_CREAT))
+		log_reset_reason();
+
+		// Manually flush, since the file is open
+		this->flush();
+
+		if(storage_.keep_open())
 		{
-			errorHalt("Failed to open file");
+			sync();
 		}
+		else
+		{
+			storage_.release();
+		}
+	}
 
-		// Clear current file contents
-		file_.truncate(0);
+	/** Attach the SD card, and start a new log file at the first flush
+	 *
+	 * begin() starts a new log file, logs the reset reason, and flushes before it returns,
+	 * which can take hundreds of milliseconds on a slow card. This version only attaches the
+	 * card and logs the reset reason. Statements are kept in the RAM buffer, and the new file
+	 * is started by the first flush: the next poll() or flush(), or an auto-flush when the
+	 * buffer fills.
+	 *
+	 * @param sd_inst The SD card instance.
+	 * @param preallocate_size @see begin()
+	 */
+	void begin_deferred(SdFs& sd_inst, uint64_t preallocate_size = 0)
+	{
+		storage_.attach(sd_inst, preallocate_size);
+		storage_.defer_open();
 
 		log_reset_reason();
 
-		// Manually flush, since the file is open
-		flush();
+		// The first poll() starts the file, even if no flush is due
+		this->flush_pending(true);
+	}
 
-		file_.close();
+	/** Keep the log file open between flushes
+	 *
+	 * By default, the log file is opened and closed on every flush. When the file is kept
+	 * open, flush() only writes the data, and the file is synced according to the sync
+	 * budget (see sync_budget()). Data which has not been synced is lost if power is removed.
+	 *
+	 * @param enable If true, keep the file open. If false, the file is closed.
+	 */
+	void keep_file_open(bool enable)
+	{
+		storage_.keep_open(enable, log_buffer_, millis());
+	}
+
+	/** Set the sync budget used when the log file is kept open
+	 *
+	 * @param bytes Sync once this many bytes have been written since the last sync.
+	 * @param ms Sync during flush() if this many milliseconds have passed since the last sync.
+	 */
+	void sync_budget(size_t bytes, uint32_t ms) noexcept
+	{
+		storage_.sync_policy().budget(bytes, ms);
 	}
 
-	// Resets the log file counter back to 1
+	/// Commit the data written to the log file to the SD card.
+	/// For a pre-allocated file, this includes the partial sector held in the buffer.
+	void sync()
+	{
+		storage_.sync(log_buffer_, millis());
+	}
+
+	/** Write the buffered data and close the log file
+	 *
+	 * A pre-allocated file is truncated to the length of the data. Logging can continue
+	 * after close(): the file is reopened (in append mode) by the next flush.
+	 */
+	void close()
+	{
+		this->flush();
+		storage_.close(log_buffer_, millis());
+	}
+
+	/** Access the rotation policy
+	 *
+	 * By default, a new file is only started by begin(). The policy can also start a new file
+	 * once the current one reaches a size, or has been in use for an interval. With a
+	 * retention budget, the oldest log files are deleted when a new file is started:
+	 *
+	 *	@code
+	 *	logger.rotation_policy().max_size(16 * 1024 * 1024);
+	 *	logger.rotation_policy().interval(24 * 60 * 60 * 1000UL);
+	 *	logger.rotation_policy().retention(1024 * 1024 * 1024ULL);
+	 *	@endcode
+	 */
+	LogRotationPolicy& rotation_policy() noexcept
+	{
+		return storage_.rotation_policy();
+	}
+
+	/// The index of the current log file, log_<index>.txt
+	uint32_t file_index() const noexcept
+	{
+		return storage_.file_index();
+	}
+
+	/// Write the buffered data to the current file, and start the next file
+	void rotate()
+	{
+		if(storage_.attached())
+		{
+			this->flush();
+			open_next_file();
+
+			storage_.release();
+		}
+	}
+
+	/// Resets the log file counter back to 1. The SD card must be initialized.
 	void resetFileCounter()
 	{
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, 1);
+		sd_store_log_index<FsFile>(1);
 	}
 
 	/** Get the maximum log level (filtering) for the specified module
@@ -103,11 +217,12 @@ class TeensySDRotationalModuleLogger final : public LoggerBase
 	 *
 	 * @param module_id The ID for the corresponding module
 	 * @param l The maximum log level. Levels greater than `l` will not be added to the log buffer.
+	 *	Levels greater than LOG_MODULE_LEVEL_LIMIT(module_id) are ignored.
 	 * @returns the current log level maximum.
 	 */
 	log_level_e level(unsigned module_id, log_level_e l) noexcept
 	{
-		if(l <= LOG_LEVEL_LIMIT())
+		if(l <= LOG_MODULE_LEVEL_LIMIT(module_id))
 		{
 			module_levels_[module_id] = l;
 		}
@@ -115,6 +230,20 @@ class TeensySDRotationalModuleLogger final : public LoggerBase
 		return module_levels_[module_id];
 	}
 
+#if LOG_STATS_EN
+	/** The statements logged by a module
+	 *
+	 * Only available when LOG_STATS_EN is set. Statements filtered out by the module or global
+	 * level are not counted.
+	 *
+	 * @param module_id The ID for the corresponding module
+	 */
+	const log_record_stats& module_stats(unsigned module_id) const noexcept
+	{
+		return module_stats_[module_id];
+	}
+#endif
+
 	/// Set the log level for ALL modules
 	/// We need to forward this version to the base class version
 	/// to prevent us from calling level(module_id) when we try to set
@@ -136,99 +265,338 @@ class TeensySDRotationalModuleLogger final : public LoggerBase
 	template<typename... Args>
 	void critical(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::critical)
-		{
-			log(log_level_e::critical, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::critical, fmt, args...);
 	}
 
 	template<typename... Args>
 	void critical_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::critical)
-		{
-			log_interrupt(log_level_e::critical, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::critical, fmt, args...);
 	}
 
 	template<typename... Args>
 	void error(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::error)
-		{
-			log(log_level_e::error, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::error, fmt, args...);
 	}
 
 	template<typename... Args>
 	void error_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::error)
-		{
-			log_interrupt(log_level_e::error, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::error, fmt, args...);
 	}
 
 	template<typename... Args>
 	void warning(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::warning)
-		{
-			log(log_level_e::warning, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::warning, fmt, args...);
 	}
 
 	template<typename... Args>
 	void warning_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::warning)
-		{
-			log_interrupt(log_level_e::warning, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::warning, fmt, args...);
 	}
 
 	template<typename... Args>
 	void info(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::info)
-		{
-			log(log_level_e::info, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::info, fmt, args...);
 	}
 
 	template<typename... Args>
 	void info_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::info)
-		{
-			log_interrupt(log_level_e::info, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::info, fmt, args...);
 	}
 
 	template<typename... Args>
 	void debug(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::debug)
-		{
-			log(log_level_e::debug, fmt, std::forward<const Args>(args)...);
-		}
+		log_module(module_id, log_level_e::debug, fmt, args...);
 	}
 
 	template<typename... Args>
 	void debug_interrupt(unsigned module_id, const char* fmt, const Args&... args)
 	{
-		if(module_levels_[module_id] >= log_level_e::debug)
-		{
-			log_interrupt(log_level_e::debug, fmt, std::forward<const Args>(args)...);
-		}
+		log_module_interrupt(module_id, log_level_e::debug, fmt, args...);
+	}
+
+	/** Compile-time filtered module logging
+	 *
+	 * These overloads take the module ID as a template argument:
+	 * @code
+	 * logger.debug<MODULE_SENSOR>("Reading: %d\n", value);
+	 * @endcode
+	 *
+	 * Statements above LOG_MODULE_LEVEL_LIMIT(TModule) compile away entirely, including the
+	 * format string and argument handling. Statements which are compiled in are still
+	 * filtered by the module's runtime level.
+	 */
+
+	template<unsigned TModule, typename... Args>
+	void critical(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void critical_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void error(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void error_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void warning(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void warning_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void info(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void info_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void debug(const char* fmt, const Args&... args)
+	{
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
+	}
+
+	template<unsigned TModule, typename... Args>
+	void debug_interrupt(const char* fmt, const Args&... args)
+	{
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
+	}
+
+	/** @name LOG_FMT() overloads
+	 *
+	 * The module versions of the LoggerBase LOG_FMT() overloads. The arguments are checked
+	 * against the format at compile time, even if the statement is compiled out:
+	 *
+	 *	@code
+	 *	logger.info(MODULE_SENSOR, LOG_FMT("Reading: %d\n"), value);
+	 *	logger.debug<MODULE_SENSOR>(LOG_FMT("Reading: %d\n"), value);
+	 *	@endcode
+	 */
+	///@{
+	template<class TString, typename... Args>
+	void critical(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void critical_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::critical, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void error_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::error, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void warning_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::warning, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void info_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::info, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module(module_id, log_level_e::debug, fmt, args...);
+	}
+
+	template<class TString, typename... Args>
+	void debug_interrupt(unsigned module_id, const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		log_module_interrupt(module_id, log_level_e::debug, fmt, args...);
 	}
 
+	template<unsigned TModule, class TString, typename... Args>
+	void critical(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void critical_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::critical)>(),
+			log_level_e::critical, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void error(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void error_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::error)>(),
+			log_level_e::error, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void warning(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void warning_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::warning)>(),
+			log_level_e::warning, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void info(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void info_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::info)>(),
+			log_level_e::info, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void debug(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
+	}
+
+	template<unsigned TModule, class TString, typename... Args>
+	void debug_interrupt(const log_format<TString>& fmt, const Args&... args)
+	{
+		log_format_check<TString, Args...>();
+		module_log_interrupt<TModule>(
+			module_level_tag<(LOG_MODULE_LEVEL_LIMIT(TModule) >= log_level_e::debug)>(),
+			log_level_e::debug, fmt, args...);
+	}
+	///@}
+
   protected:
 	void log_putc(char c) noexcept final
 	{
 		log_buffer_.put(c);
 	}
 
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
 	size_t internal_size() const noexcept override
 	{
 		return log_buffer_.size();
@@ -250,147 +618,133 @@ class TeensySDRotationalModuleLogger final : public LoggerBase
 	}
 
   private:
-	void errorHalt(const char* msg)
+	/// Selects whether a compile-time filtered module statement is compiled in
+	template<bool TEnabled>
+	struct module_level_tag
 	{
-		printf("Error: %s\n", msg);
-		if(fs_->sdErrorCode())
-		{
-			if(fs_->sdErrorCode() == SD_CARD_ERROR_ACMD41)
-			{
-				printf("Try power cycling the SD card.\n");
-			}
-			printSdErrorSymbol(&Serial, fs_->sdErrorCode());
-			printf(", ErrorData: 0x%x\n", fs_->sdErrorData());
-		}
-		while(true)
-		{
-		}
-	}
+	};
 
-	void writeBufferToSDFile()
+	/// Log a statement for a module, if the module's runtime level allows it.
+	/// TFormat is `const char*` or a log_format.
+	template<class TFormat, typename... Args>
+	void log_module(unsigned module_id, log_level_e l, const TFormat& fmt, const Args&... args)
 	{
-		if(!file_.open(filename_, O_WRITE | O_APPEND))
+		if(module_levels_[module_id] >= l)
 		{
-			errorHalt("Failed to open file");
+			uint64_t start = this->stats_bytes();
+			this->log(l, fmt, std::forward<const Args>(args)...);
+			module_logged(module_id, start);
 		}
+	}
 
-		int bytes_written = 0;
-
-		// We need to get the front, the rear, and potentially write the files in two steps
-		// to prevent ordering problems
-		size_t head = log_buffer_.head();
-		size_t tail = log_buffer_.tail();
-		const char* buffer = log_buffer_.storage();
-
-		if((head < tail) || ((tail > 0) && (log_buffer_.size() == log_buffer_.capacity())))
-		{
-			// we have a wraparound case
-			// We will write from buffer[tail] to buffer[size] in one go
-			// Then we'll reset head to 0 so that we can write 0 to tail next
-			bytes_written = file_.write(&buffer[tail], log_buffer_.capacity() - tail);
-			bytes_written += file_.write(buffer, head);
-		}
-		else
+	/// @see log_module()
+	template<class TFormat, typename... Args>
+	void log_module_interrupt(unsigned module_id, log_level_e l, const TFormat& fmt,
+							  const Args&... args)
+	{
+		if(module_levels_[module_id] >= l)
 		{
-			// Write from tail position and send the specified number of bytes
-			bytes_written = file_.write(&buffer[tail], log_buffer_.size());
+			uint64_t start = this->stats_bytes();
+			this->log_interrupt(l, fmt, std::forward<const Args>(args)...);
+			module_logged(module_id, start);
 		}
+	}
 
-		if(static_cast<size_t>(bytes_written) != log_buffer_.size())
+	/// Record a module statement in module_stats(). `start` is stats_bytes() from before it.
+	void module_logged(unsigned module_id, uint64_t start) noexcept
+	{
+#if LOG_STATS_EN
+		// Nothing is written if the global level filtered out the statement
+		if(this->stats_bytes() != start)
 		{
-			errorHalt("Failed to write to log file");
+			module_stats_[module_id].add(static_cast<size_t>(this->stats_bytes() - start));
 		}
-
-		log_buffer_.reset();
-
-		file_.close();
+#else
+		static_cast<void>(module_id);
+		static_cast<void>(start);
+#endif
 	}
 
-	/// Checks the kinetis SoC's reset reason registers and logs them
-	/// This should only be called during begin().
-	void log_reset_reason()
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log(module_level_tag<true>, log_level_e l, const TFormat& fmt,
+					const Args&... args)
 	{
-		auto srs0 = RCM_SRS0;
-		auto srs1 = RCM_SRS1;
-
-		// Clear the values
-		RCM_SRS0 = 0;
-		RCM_SRS1 = 0;
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
 
-		if(srs0 & RCM_SRS0_LVD)
-		{
-			LoggerBase::info("Low-voltage Detect Reset\n");
-		}
-
-		if(srs0 & RCM_SRS0_LOL)
-		{
-			LoggerBase::info("Loss of Lock in PLL Reset\n");
-		}
+		log_module(TModule, l, fmt, args...);
+	}
 
-		if(srs0 & RCM_SRS0_LOC)
-		{
-			LoggerBase::info("Loss of External Clock Reset\n");
-		}
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log(module_level_tag<false>, log_level_e /*l*/, const TFormat& /*fmt*/,
+					const Args&... /*args*/) noexcept
+	{
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
+	}
 
-		if(srs0 & RCM_SRS0_WDOG)
-		{
-			LoggerBase::info("Watchdog Reset\n");
-		}
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log_interrupt(module_level_tag<true>, log_level_e l, const TFormat& fmt,
+							  const Args&... args)
+	{
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
 
-		if(srs0 & RCM_SRS0_PIN)
-		{
-			LoggerBase::info("External Pin Reset\n");
-		}
+		log_module_interrupt(TModule, l, fmt, args...);
+	}
 
-		if(srs0 & RCM_SRS0_POR)
-		{
-			LoggerBase::info("Power-on Reset\n");
-		}
+	template<unsigned TModule, class TFormat, typename... Args>
+	void module_log_interrupt(module_level_tag<false>, log_level_e /*l*/, const TFormat& /*fmt*/,
+							  const Args&... /*args*/) noexcept
+	{
+		static_assert(TModule < TModuleCount, "Module ID exceeds the module count");
+	}
 
-		if(srs1 & RCM_SRS1_SACKERR)
+	void writeBufferToSDFile()
+	{
+		if(storage_.take_deferred_open())
 		{
-			LoggerBase::info("Stop Mode Acknowledge Error Reset\n");
+			// See begin_deferred()
+			open_next_file();
+			this->flush_pending(false);
 		}
 
-		if(srs1 & RCM_SRS1_MDM_AP)
-		{
-			LoggerBase::info("MDM-AP Reset\n");
-		}
+		uint32_t start = this->stats_clock();
+		size_t count = storage_.write(log_buffer_);
+		this->stats_stored(start);
 
-		if(srs1 & RCM_SRS1_SW)
+		// log() never starts the next file: that waits for an explicit flush() or poll()
+		if(storage_.rotation_due(count, millis()) && !this->flushing_from_log())
 		{
-			LoggerBase::info("Software Reset\n");
+			open_next_file();
 		}
 
-		if(srs1 & RCM_SRS1_LOCKUP)
-		{
-			LoggerBase::info("Core Lockup Event Reset\n");
-		}
+		storage_.finish(count, log_buffer_, millis());
 	}
 
-	void set_filename()
+	/// Close the current file, and start the next one. This is called by begin(), and by the
+	/// flush path when the rotation policy requires a new file.
+	void open_next_file()
 	{
-		uint8_t value = EEPROM.read(EEPROM_LOG_STORAGE_ADDR);
-
-		// 0xFF indicates a byte that's been reset, or value 255. Either way, reset to 0.
-		if(value == 0xFF)
-		{
-			value = 1;
-		}
-
-		snprintf(filename_, FILENAME_SIZE, "log_%d.txt", value);
+		storage_.open_next(".txt", log_buffer_, millis());
+	}
 
-		EEPROM.write(EEPROM_LOG_STORAGE_ADDR, value + 1);
+	/// Logs the reset reason. This should only be called during begin() or begin_deferred().
+	void log_reset_reason()
+	{
+		report_kinetis_reset_reason([this](const char* reason) {
+			this->LoggerBase::info("%s", reason);
+		});
 	}
 
   private:
-	SdFs* fs_;
-	char filename_[FILENAME_SIZE];
-	mutable FsFile file_;
+	SDRotatingStorage storage_;
+
+	log_level_e module_levels_[TModuleCount];
 
-	log_level_e module_levels_[TModuleCount] = {log_level_e(LOG_LEVEL)};
+#if LOG_STATS_EN
+	/// Statements logged by each module, see module_stats()
+	log_record_stats module_stats_[TModuleCount];
+#endif
 
-	CircularBuffer<char, BUFFER_SIZE> log_buffer_;
+	TBuffer log_buffer_;
 };
 
-#endif // SD_FILE_LOGGER_H_
+#endif // TEENSY_SD_ROTATIONAL_MODULE_LOGGER_H_
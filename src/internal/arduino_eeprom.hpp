@@ -0,0 +1,34 @@
+#ifndef ARDUINO_EEPROM_HPP_
+#define ARDUINO_EEPROM_HPP_
+
+#include <EEPROM.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** EEPROMLogStore device for the Arduino EEPROM library
+ *
+ * update() only writes the bytes which differ from the current contents. On AVR and Teensy,
+ * the whole block is handed to eeprom_update_block(), which lets the Teensy EEPROM emulation
+ * batch the write.
+ */
+struct ArduinoEEPROMDevice
+{
+	uint8_t read(unsigned address) noexcept
+	{
+		return EEPROM.read(static_cast<int>(address));
+	}
+
+	void update(unsigned address, const uint8_t* data, size_t size) noexcept
+	{
+#if defined(__AVR__) || defined(TEENSYDUINO)
+		eeprom_update_block(data, reinterpret_cast<void*>(address), size);
+#else
+		for(size_t i = 0; i < size; i++)
+		{
+			EEPROM.update(static_cast<int>(address + i), data[i]);
+		}
+#endif
+	}
+};
+
+#endif // ARDUINO_EEPROM_HPP_
@@ -0,0 +1,40 @@
+#ifndef AVR_RESET_REASON_HPP_
+#define AVR_RESET_REASON_HPP_
+
+#include <avr/wdt.h>
+
+/** Report the reset reasons recorded in the AVR MCU status register (MCUSR)
+ *
+ * The register is not cleared.
+ *
+ * @param report Called with a description of each reason. The descriptions are string
+ *	literals ending in a newline. Log them as an argument, e.g. info("%s", reason), rather than
+ *	as the format string.
+ */
+template<class TFunction>
+void report_avr_reset_reason(TFunction report)
+{
+	auto reg = MCUSR;
+
+	if(reg & (1 << WDRF))
+	{
+		report("Watchdog reset\n");
+	}
+
+	if(reg & (1 << BORF))
+	{
+		report("Brown-out reset\n");
+	}
+
+	if(reg & (1 << EXTRF))
+	{
+		report("External reset\n");
+	}
+
+	if(reg & (1 << PORF))
+	{
+		report("Power-on reset\n");
+	}
+}
+
+#endif // AVR_RESET_REASON_HPP_
@@ -0,0 +1,459 @@
+#ifndef BINARY_LOG_ENCODER_HPP_
+#define BINARY_LOG_ENCODER_HPP_
+
+#include "binary_log_format.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @file binary_log_encoder.hpp
+ *
+ * On-device encoder for the binary log format described in binary_log_format.hpp.
+ *
+ * Log statements are stored as a format id plus varint-encoded arguments. The format string
+ * itself is written to the log once, in a format definition record, the first time it is used.
+ * Formatting happens on the host with the decoder in tools/binary_log_decoder.
+ */
+
+#ifndef LOG_BINARY_MAX_STRING_LENGTH
+/// The maximum number of characters stored for a string argument in a binary log record.
+/// Longer strings are truncated.
+#define LOG_BINARY_MAX_STRING_LENGTH 32
+#endif
+
+#ifndef LOG_BINARY_FORMAT_SLOTS
+/// The number of format strings the encoder remembers. Must be a power of two.
+/// A format string that maps to an occupied slot replaces the previous definition, which is
+/// written to the log again the next time it is used.
+#define LOG_BINARY_FORMAT_SLOTS 32
+#endif
+
+#ifndef LOG_BINARY_BUILD_ID
+/// Value stored in the build_id field of the binary log header
+#define LOG_BINARY_BUILD_ID 0
+#endif
+
+/// Selects the file format used by loggers which support binary output
+enum class log_file_format_e
+{
+	/// Formatted text, identical to the console output
+	text = 0,
+	/// Binary records, decoded on the host with tools/binary_log_decoder
+	binary,
+};
+
+/// Returns the signature code for an integer with the specified size and signedness
+constexpr char binary_integer_code(size_t size, bool is_signed)
+{
+	return (size == 1) ? (is_signed ? 'b' : 'B')
+		   : (size == 2) ? (is_signed ? 'h' : 'H')
+		   : (size == 4) ? (is_signed ? 'i' : 'I')
+						 : (is_signed ? 'q' : 'Q');
+}
+
+/// Selects the working type used to zigzag-encode a signed integer
+template<bool TWide>
+struct binary_signed_word
+{
+	using type = int32_t;
+};
+
+template<>
+struct binary_signed_word<true>
+{
+	using type = int64_t;
+};
+
+/** Encoding rules for a single binary log argument
+ *
+ * Only the specializations below are defined, so an unsupported argument type fails to compile
+ * instead of producing a record that cannot be decoded.
+ *
+ * Each specialization provides:
+ *	- code: the signature code for the type (see binary_log_format.hpp)
+ *	- max_size: the maximum number of bytes used to store a value
+ *	- encode(): stores a value and returns the number of bytes written
+ *
+ * @tparam T The argument type, as deduced by the `const Args&...` logging templates.
+ */
+template<typename T>
+struct binary_arg;
+
+/// Encoding rule for integer arguments
+template<typename T, bool TSigned = (T(-1) < T(0))>
+struct binary_integer_arg
+{
+	static constexpr char code = binary_integer_code(sizeof(T), false);
+	static constexpr size_t max_size = binary_varint_max_size(sizeof(T));
+
+	static size_t encode(char* dst, const T& value) noexcept
+	{
+		return binary_write_varint(dst, value);
+	}
+};
+
+template<typename T>
+struct binary_integer_arg<T, true>
+{
+	static constexpr char code = binary_integer_code(sizeof(T), true);
+	static constexpr size_t max_size = binary_varint_max_size(sizeof(T));
+
+	static size_t encode(char* dst, const T& value) noexcept
+	{
+		using word = typename binary_signed_word<(sizeof(T) > 4)>::type;
+		return binary_write_varint(dst, binary_zigzag_encode(static_cast<word>(value)));
+	}
+};
+
+template<>
+struct binary_arg<char> : binary_integer_arg<char>
+{
+};
+
+template<>
+struct binary_arg<signed char> : binary_integer_arg<signed char>
+{
+};
+
+template<>
+struct binary_arg<unsigned char> : binary_integer_arg<unsigned char>
+{
+};
+
+template<>
+struct binary_arg<short> : binary_integer_arg<short>
+{
+};
+
+template<>
+struct binary_arg<unsigned short> : binary_integer_arg<unsigned short>
+{
+};
+
+template<>
+struct binary_arg<int> : binary_integer_arg<int>
+{
+};
+
+template<>
+struct binary_arg<unsigned> : binary_integer_arg<unsigned>
+{
+};
+
+template<>
+struct binary_arg<long> : binary_integer_arg<long>
+{
+};
+
+template<>
+struct binary_arg<unsigned long> : binary_integer_arg<unsigned long>
+{
+};
+
+template<>
+struct binary_arg<long long> : binary_integer_arg<long long>
+{
+};
+
+template<>
+struct binary_arg<unsigned long long> : binary_integer_arg<unsigned long long>
+{
+};
+
+template<>
+struct binary_arg<bool>
+{
+	static constexpr char code = 'B';
+	static constexpr size_t max_size = 1;
+
+	static size_t encode(char* dst, const bool& value) noexcept
+	{
+		dst[0] = value ? 1 : 0;
+		return 1;
+	}
+};
+
+/// Encoding rule for floating point arguments: the raw bytes are stored
+template<typename T>
+struct binary_float_arg
+{
+	static constexpr char code = (sizeof(T) == 4) ? 'f' : 'd';
+	static constexpr size_t max_size = sizeof(T);
+
+	static size_t encode(char* dst, const T& value) noexcept
+	{
+		memcpy(dst, &value, sizeof(T));
+		return sizeof(T);
+	}
+};
+
+template<>
+struct binary_arg<float> : binary_float_arg<float>
+{
+};
+
+// double is 4 bytes on AVR, so it is stored as 'f' there
+template<>
+struct binary_arg<double> : binary_float_arg<double>
+{
+};
+
+/// Pointers are stored as their address, for use with %p
+template<typename T>
+struct binary_arg<T*>
+{
+	static constexpr char code = (sizeof(T*) > 4) ? 'P' : 'p';
+	static constexpr size_t max_size = binary_varint_max_size(sizeof(T*));
+
+	static size_t encode(char* dst, const T* value) noexcept
+	{
+		return binary_write_varint(dst, reinterpret_cast<uintptr_t>(value));
+	}
+};
+
+/// Encoding rule for string arguments: the characters are copied into the record
+struct binary_string_arg
+{
+	static constexpr char code = 's';
+	static constexpr size_t max_size =
+		binary_varint_max_size(sizeof(size_t)) + LOG_BINARY_MAX_STRING_LENGTH;
+
+	static size_t encode(char* dst, const char* value) noexcept
+	{
+		size_t len = 0;
+
+		while(value != nullptr && len < LOG_BINARY_MAX_STRING_LENGTH && value[len] != '\0')
+		{
+			len++;
+		}
+
+		size_t size = binary_write_varint(dst, len);
+		memcpy(dst + size, value, len);
+
+		return size + len;
+	}
+};
+
+template<>
+struct binary_arg<const char*> : binary_string_arg
+{
+};
+
+template<>
+struct binary_arg<char*> : binary_string_arg
+{
+};
+
+template<size_t N>
+struct binary_arg<char[N]> : binary_string_arg
+{
+};
+
+/// Signature string for a set of argument types. The address of value identifies the
+/// signature, so it is also used as part of the format dictionary key.
+template<typename... Args>
+struct binary_signature
+{
+	static constexpr char value[sizeof...(Args) + 1] = {binary_arg<Args>::code..., '\0'};
+};
+
+template<typename... Args>
+constexpr char binary_signature<Args...>::value[sizeof...(Args) + 1];
+
+/// Computes the maximum number of bytes needed to store a set of arguments
+template<typename... Args>
+struct binary_args_max_size;
+
+template<>
+struct binary_args_max_size<>
+{
+	static constexpr size_t value = 0;
+};
+
+template<typename T, typename... Rest>
+struct binary_args_max_size<T, Rest...>
+{
+	static constexpr size_t value = binary_arg<T>::max_size + binary_args_max_size<Rest...>::value;
+};
+
+/// Stores the supplied arguments in dst, returning the number of bytes written
+inline size_t binary_args_encode(char* /*dst*/) noexcept
+{
+	return 0;
+}
+
+template<typename T, typename... Rest>
+size_t binary_args_encode(char* dst, const T& value, const Rest&... rest) noexcept
+{
+	size_t size = binary_arg<T>::encode(dst, value);
+	return size + binary_args_encode(dst + size, rest...);
+}
+
+/** Encodes log statements as binary log records
+ *
+ * The encoder keeps track of which format strings have been written to the log, and of the
+ * previous timestamp. It does not own any storage: records are handed to a writer, which
+ * must provide:
+ *	- `size_t available() const`: the number of bytes that can be written without losing data
+ *	- `void write(const char* data, size_t len)`
+ *
+ * A record is written completely or not at all. If it does not fit in available(), the call
+ * returns false and the encoder state is unchanged.
+ *
+ * Format strings are identified by pointer, so they must be string literals (or otherwise
+ * remain valid and unchanged) for as long as the encoder is in use.
+ */
+class BinaryLogEncoder
+{
+	static_assert((LOG_BINARY_FORMAT_SLOTS & (LOG_BINARY_FORMAT_SLOTS - 1)) == 0,
+				  "LOG_BINARY_FORMAT_SLOTS must be a power of two");
+
+  public:
+	BinaryLogEncoder() = default;
+
+	/// Forget all format definitions and the previous timestamp.
+	/// Call this when a new log file is started.
+	void reset() noexcept
+	{
+		for(auto& slot : slots_)
+		{
+			slot.fmt = nullptr;
+			slot.signature = nullptr;
+		}
+
+		last_timestamp_ = 0;
+	}
+
+	/** Write a file header
+	 *
+	 * @param dst The destination, which must hold binary_log_header_size bytes.
+	 * @param build_id The value of the header's build_id field.
+	 * @returns The number of bytes written.
+	 */
+	static size_t write_header(char* dst, uint32_t build_id = LOG_BINARY_BUILD_ID) noexcept
+	{
+		memcpy(dst, binary_log_magic, sizeof(binary_log_magic));
+		dst[4] = static_cast<char>(binary_log_version);
+		dst[5] = 0;
+
+		for(size_t i = 0; i < 4; i++)
+		{
+			dst[6 + i] = static_cast<char>(build_id >> (8 * i));
+		}
+
+		return binary_log_header_size;
+	}
+
+	/** Encode a log statement
+	 *
+	 * @param writer The record destination.
+	 * @param level The log level. Level 0 indicates a print() statement with no prefix.
+	 * @param module The module id. 0 is not stored.
+	 * @param timestamp The statement timestamp, in milliseconds.
+	 * @param fmt The format string.
+	 * @param args The arguments that are associated with the format string.
+	 * @returns true if the record was written, false if it did not fit.
+	 */
+	template<class TWriter, typename... Args>
+	bool record(TWriter& writer, uint8_t level, unsigned module, uint32_t timestamp,
+				const char* fmt, const Args&... args) noexcept
+	{
+		const char* signature = binary_signature<Args...>::value;
+		size_t id = slot_index(fmt);
+		bool defined = slots_[id].fmt == fmt && slots_[id].signature == signature;
+
+		char record[1 + binary_varint_max_size(sizeof(unsigned)) +
+					binary_varint_max_size(sizeof(uint32_t)) +
+					binary_varint_max_size(sizeof(size_t)) + binary_args_max_size<Args...>::value];
+		size_t size = 0;
+
+		record[size++] =
+			static_cast<char>(binary_log_tag_record | (level & binary_log_tag_level_mask) |
+							  (module ? binary_log_tag_module : 0));
+
+		if(module)
+		{
+			size += binary_write_varint(&record[size], module);
+		}
+
+		size +=
+			binary_write_varint(&record[size], static_cast<uint32_t>(timestamp - last_timestamp_));
+		size += binary_write_varint(&record[size], id);
+		size += binary_args_encode(&record[size], args...);
+
+		size_t signature_len = sizeof...(Args) + 1;
+		size_t fmt_len = strlen(fmt) + 1;
+		size_t definition_size = defined ? 0 : 1 + binary_varint_size(id) + signature_len + fmt_len;
+
+		if(writer.available() < definition_size + size)
+		{
+			return false;
+		}
+
+		if(!defined)
+		{
+			char definition[1 + binary_varint_max_size(sizeof(size_t))];
+			size_t definition_header_size = 1;
+
+			definition[0] = static_cast<char>(binary_log_tag_format);
+			definition_header_size += binary_write_varint(&definition[1], id);
+
+			writer.write(definition, definition_header_size);
+			writer.write(signature, signature_len);
+			writer.write(fmt, fmt_len);
+
+			slots_[id].fmt = fmt;
+			slots_[id].signature = signature;
+		}
+
+		writer.write(record, size);
+		last_timestamp_ = timestamp;
+
+		return true;
+	}
+
+	/** Encode data which bypasses the formatter
+	 *
+	 * @param writer The record destination.
+	 * @param str The characters to store.
+	 * @param len The number of characters to store.
+	 * @returns true if the record was written, false if it did not fit.
+	 */
+	template<class TWriter>
+	bool text(TWriter& writer, const char* str, size_t len) noexcept
+	{
+		char header[1 + binary_varint_max_size(sizeof(size_t))];
+		size_t size = 1;
+
+		header[0] = static_cast<char>(binary_log_tag_text);
+		size += binary_write_varint(&header[1], len);
+
+		if(writer.available() < size + len)
+		{
+			return false;
+		}
+
+		writer.write(header, size);
+		writer.write(str, len);
+
+		return true;
+	}
+
+  private:
+	struct format_slot
+	{
+		const char* fmt;
+		const char* signature;
+	};
+
+	static size_t slot_index(const char* fmt) noexcept
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(fmt);
+		return (address ^ (address >> 5)) & (LOG_BINARY_FORMAT_SLOTS - 1);
+	}
+
+	format_slot slots_[LOG_BINARY_FORMAT_SLOTS] = {};
+	uint32_t last_timestamp_ = 0;
+};
+
+#endif // BINARY_LOG_ENCODER_HPP_
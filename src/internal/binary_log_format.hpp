@@ -0,0 +1,144 @@
+#ifndef BINARY_LOG_FORMAT_HPP_
+#define BINARY_LOG_FORMAT_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file binary_log_format.hpp
+ *
+ * Definitions for the binary log file format. This header is shared by the on-device encoder
+ * (binary_log_encoder.hpp) and the host decoder (tools/binary_log_decoder), so it must not
+ * depend on the Arduino SDK.
+ *
+ * All multi-byte values are little-endian. "varint" values are unsigned LEB128: seven bits
+ * per byte, least significant group first, with the high bit set on every byte but the last.
+ *
+ * File header (binary_log_header_size bytes):
+ *	- magic: "ALOG"
+ *	- version: uint8_t (binary_log_version)
+ *	- flags: uint8_t (reserved, 0)
+ *	- build_id: uint32_t. Identifies the firmware build that wrote the file
+ *		(LOG_BINARY_BUILD_ID). The decoder does not need it: format strings are embedded in
+ *		the file, so a file can be decoded without the firmware image.
+ *
+ * The header is followed by a stream of records. The first byte of a record is its tag.
+ *
+ * Format definition record (tag == binary_log_tag_format):
+ *	- id: varint. Redefining an id replaces the previous definition.
+ *	- signature: NUL-terminated string with one type code per argument (see below)
+ *	- format string: NUL-terminated
+ *
+ * Text record (tag == binary_log_tag_text): data that bypassed the formatter, such as write().
+ *	- length: varint
+ *	- data: length bytes
+ *
+ * Log record (tag & binary_log_tag_record):
+ *	- tag bits 0-2: log level. Level 0 (off) is used for print(), which has no prefix.
+ *	- tag bit 3: a module id follows
+ *	- module id: varint (only if tag bit 3 is set)
+ *	- timestamp delta: varint, milliseconds since the previous log record in the file
+ *	- format id: varint
+ *	- arguments, as described by the format's signature:
+ *		- 'b', 'h', 'i', 'q': signed 1/2/4/8 byte integer, zigzag-encoded varint
+ *		- 'B', 'H', 'I', 'Q': unsigned 1/2/4/8 byte integer, varint
+ *		- 'f': float, 4 bytes
+ *		- 'd': double, 8 bytes
+ *		- 's': string, varint length followed by the characters
+ *		- 'p': pointer of up to 4 bytes, varint
+ *		- 'P': 8 byte pointer, varint
+ */
+
+static constexpr char binary_log_magic[4] = {'A', 'L', 'O', 'G'};
+static constexpr uint8_t binary_log_version = 1;
+static constexpr size_t binary_log_header_size = 10;
+
+static constexpr uint8_t binary_log_tag_format = 0x01;
+static constexpr uint8_t binary_log_tag_text = 0x02;
+static constexpr uint8_t binary_log_tag_record = 0x80;
+static constexpr uint8_t binary_log_tag_module = 0x08;
+static constexpr uint8_t binary_log_tag_level_mask = 0x07;
+
+/// The maximum number of bytes needed to store a varint of the specified width
+constexpr size_t binary_varint_max_size(size_t bytes)
+{
+	return ((bytes * 8) + 6) / 7;
+}
+
+/// Returns the number of bytes needed to store value as a varint
+template<typename TUnsigned>
+size_t binary_varint_size(TUnsigned value) noexcept
+{
+	size_t size = 1;
+
+	while(value >= 0x80)
+	{
+		value >>= 7;
+		size++;
+	}
+
+	return size;
+}
+
+/// Writes value to dst as a varint, returning the number of bytes written
+template<typename TUnsigned>
+size_t binary_write_varint(char* dst, TUnsigned value) noexcept
+{
+	size_t size = 0;
+
+	while(value >= 0x80)
+	{
+		dst[size++] = static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	dst[size++] = static_cast<char>(value);
+
+	return size;
+}
+
+/** Reads a varint from [src, end)
+ *
+ * @param src The read position, which is advanced past the varint.
+ * @param end The end of the valid data.
+ * @param value Receives the decoded value.
+ * @returns false if the data ends before the varint does, or if it is too long.
+ */
+inline bool binary_read_varint(const uint8_t*& src, const uint8_t* end, uint64_t& value) noexcept
+{
+	value = 0;
+
+	for(unsigned shift = 0; shift < 64; shift += 7)
+	{
+		if(src == end)
+		{
+			return false;
+		}
+
+		uint8_t byte = *src++;
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+		if((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+inline uint64_t binary_zigzag_encode(int64_t value) noexcept
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline uint32_t binary_zigzag_encode(int32_t value) noexcept
+{
+	return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int64_t binary_zigzag_decode(uint64_t value) noexcept
+{
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+#endif // BINARY_LOG_FORMAT_HPP_
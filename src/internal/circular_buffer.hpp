@@ -1,4 +1,109 @@
-template<class T, size_t TCount>
+#ifndef CIRCULAR_BUFFER_HPP_
+#define CIRCULAR_BUFFER_HPP_
+
+#include <stddef.h>
+#include <string.h>
+
+/// Returns true if value is a non-zero power of two
+constexpr bool is_power_of_2(size_t value)
+{
+	return (value != 0) && ((value & (value - 1)) == 0);
+}
+
+/// A contiguous run of elements in a circular buffer
+template<class T>
+struct buffer_span
+{
+	const T* data;
+	size_t size;
+};
+
+/** The data stored in a circular buffer, as at most two contiguous spans
+ *
+ * first holds the oldest data. second is empty unless the data wraps around the end of the
+ * storage, in which case it starts at the beginning of the storage.
+ */
+template<class T>
+struct buffer_spans
+{
+	buffer_span<T> first;
+	buffer_span<T> second;
+
+	size_t size() const
+	{
+		return first.size + second.size;
+	}
+};
+
+/** Describe count elements starting at storage[tail] as at most two spans
+ *
+ * @param storage The buffer storage.
+ * @param capacity The number of elements in the storage.
+ * @param tail The storage index of the oldest element.
+ * @param count The number of elements. Must be <= capacity.
+ */
+template<class T>
+buffer_spans<T> make_buffer_spans(const T* storage, size_t capacity, size_t tail, size_t count)
+{
+	size_t first_chunk = capacity - tail;
+
+	if(first_chunk > count)
+	{
+		first_chunk = count;
+	}
+
+	buffer_spans<T> spans = {{&storage[tail], first_chunk}, {storage, count - first_chunk}};
+	return spans;
+}
+
+/// buffer_try_put() for buffers which provide try_put()
+template<class TBuffer, class T>
+auto buffer_try_put_(TBuffer& buffer, const T* data, size_t count, int)
+	-> decltype(buffer.try_put(data, count))
+{
+	return buffer.try_put(data, count);
+}
+
+/// buffer_try_put() for the other buffers, which are not shared between producers
+template<class TBuffer, class T>
+bool buffer_try_put_(TBuffer& buffer, const T* data, size_t count, long)
+{
+	if(count > buffer.capacity() - buffer.size())
+	{
+		return false;
+	}
+
+	buffer.put(data, count);
+	return true;
+}
+
+/** Add a block of items to a buffer as a unit
+ *
+ * Uses the buffer's try_put() if it has one (e.g., MPSCCircularBuffer), so the check for free
+ * space and the insertion are a single step.
+ *
+ * @returns true if the items were added. If there is not enough free space for all of the
+ *	items, none are added.
+ */
+template<class TBuffer, class T>
+bool buffer_try_put(TBuffer& buffer, const T* data, size_t count)
+{
+	return buffer_try_put_(buffer, data, count, 0);
+}
+
+/** Fixed-capacity circular buffer
+ *
+ * When the buffer is full, new data overwrites the oldest data.
+ *
+ * Capacities that are a power of two select a specialization which replaces the
+ * modulo operations with a mask (see below).
+ *
+ * @tparam T The element type. Must be trivially copyable, since block operations use memcpy().
+ * @tparam TCount The capacity of the buffer, in elements.
+ * @tparam TPowerOf2 Selects the implementation. Deduced from TCount; you should not need to
+ *	supply this argument.
+ */
+template<class T, size_t TCount, bool TPowerOf2 = is_power_of_2(TCount)>
 class CircularBuffer
 {
   public:
@@ -18,6 +123,52 @@ class CircularBuffer
 		full_ = head_ == tail_;
 	}
 
+	/** Add a block of items to the buffer
+	 *
+	 * This is equivalent to calling put() for each item, but the data is copied with
+	 * at most two memcpy() calls (split around the wrap point). As with put(), the oldest
+	 * data is overwritten if there is not enough free space.
+	 *
+	 * @param data Pointer to the items to add.
+	 * @param count The number of items to add.
+	 */
+	void put(const T* data, size_t count)
+	{
+		if(count >= max_size_)
+		{
+			// Only the newest max_size_ items survive, so we can start over
+			memcpy(buf_, data + (count - max_size_), max_size_ * sizeof(T));
+			head_ = 0;
+			tail_ = 0;
+			full_ = true;
+			return;
+		}
+
+		size_t free_space = max_size_ - size();
+		size_t first_chunk = max_size_ - head_;
+
+		if(first_chunk > count)
+		{
+			first_chunk = count;
+		}
+
+		memcpy(&buf_[head_], data, first_chunk * sizeof(T));
+		memcpy(&buf_[0], data + first_chunk, (count - first_chunk) * sizeof(T));
+
+		head_ += count;
+		if(head_ >= max_size_)
+		{
+			head_ -= max_size_;
+		}
+
+		if(count >= free_space)
+		{
+			// We've filled (or overwritten) the oldest data
+			tail_ = head_;
+			full_ = true;
+		}
+	}
+
 	T get()
 	{
 		if(empty())
@@ -33,6 +184,27 @@ class CircularBuffer
 		return val;
 	}
 
+	/** Remove items from the front of the buffer without reading them
+	 *
+	 * @param count The number of items to remove. Clamped to size().
+	 */
+	void consume(size_t count)
+	{
+		if(count >= size())
+		{
+			reset();
+			return;
+		}
+
+		tail_ += count;
+		if(tail_ >= max_size_)
+		{
+			tail_ -= max_size_;
+		}
+
+		full_ = false;
+	}
+
 	void reset()
 	{
 		head_ = tail_;
@@ -75,17 +247,28 @@ class CircularBuffer
 		return size;
 	}
 
-	size_t head()
+	/** Access the stored data in place
+	 *
+	 * This lets a consumer pass the data straight to a file, UART, or network write, with no
+	 * copy and no per-element call. The spans remain valid until the data is consumed or
+	 * overwritten. Call consume() once the data has been written.
+	 */
+	buffer_spans<T> peek_contiguous() const
+	{
+		return make_buffer_spans<T>(buf_, max_size_, tail_, size());
+	}
+
+	size_t head() const
 	{
 		return head_;
 	}
 
-	size_t tail()
+	size_t tail() const
 	{
 		return tail_;
 	}
 
-	const T* storage()
+	const T* storage() const
 	{
 		return &buf_[0];
 	}
@@ -93,7 +276,164 @@ class CircularBuffer
   private:
 	size_t head_ = 0;
 	size_t tail_ = 0;
-	const size_t max_size_ = TCount;
+	static constexpr size_t max_size_ = TCount;
 	bool full_ = 0;
 	T buf_[TCount];
 };
+
+template<class T, size_t TCount, bool TPowerOf2>
+constexpr size_t CircularBuffer<T, TCount, TPowerOf2>::max_size_;
+
+/** Power-of-two circular buffer
+ *
+ * head_ and tail_ are free-running counters which are only reduced to storage indices
+ * with a mask when the storage is accessed. Because the capacity divides the counter range,
+ * head_ - tail_ is always the number of stored elements, so no full_ flag is needed and
+ * no division is required (important on parts without a hardware divider, such as AVR).
+ */
+template<class T, size_t TCount>
+class CircularBuffer<T, TCount, true>
+{
+  public:
+	CircularBuffer() = default;
+
+	void put(T item)
+	{
+		buf_[head_ & mask_] = item;
+
+		if(full())
+		{
+			tail_++;
+		}
+
+		head_++;
+	}
+
+	/** Add a block of items to the buffer
+	 *
+	 * This is equivalent to calling put() for each item, but the data is copied with
+	 * at most two memcpy() calls (split around the wrap point). As with put(), the oldest
+	 * data is overwritten if there is not enough free space.
+	 *
+	 * @param data Pointer to the items to add.
+	 * @param count The number of items to add.
+	 */
+	void put(const T* data, size_t count)
+	{
+		if(count >= max_size_)
+		{
+			// Only the newest max_size_ items survive, so we can start over
+			memcpy(buf_, data + (count - max_size_), max_size_ * sizeof(T));
+			tail_ = 0;
+			head_ = max_size_;
+			return;
+		}
+
+		size_t index = head_ & mask_;
+		size_t first_chunk = max_size_ - index;
+
+		if(first_chunk > count)
+		{
+			first_chunk = count;
+		}
+
+		memcpy(&buf_[index], data, first_chunk * sizeof(T));
+		memcpy(&buf_[0], data + first_chunk, (count - first_chunk) * sizeof(T));
+
+		head_ += count;
+
+		if(size() > max_size_)
+		{
+			// We've overwritten the oldest data
+			tail_ = head_ - max_size_;
+		}
+	}
+
+	T get()
+	{
+		if(empty())
+		{
+			return T();
+		}
+
+		// Read data and advance the tail (we now have a free space)
+		return buf_[tail_++ & mask_];
+	}
+
+	/** Remove items from the front of the buffer without reading them
+	 *
+	 * @param count The number of items to remove. Clamped to size().
+	 */
+	void consume(size_t count)
+	{
+		tail_ += (count < size()) ? count : size();
+	}
+
+	void reset()
+	{
+		head_ = tail_;
+	}
+
+	bool empty() const
+	{
+		return head_ == tail_;
+	}
+
+	bool full() const
+	{
+		return size() == max_size_;
+	}
+
+	size_t capacity() const
+	{
+		return max_size_;
+	}
+
+	size_t size() const
+	{
+		return head_ - tail_;
+	}
+
+	/** Access the stored data in place
+	 *
+	 * This lets a consumer pass the data straight to a file, UART, or network write, with no
+	 * copy and no per-element call. The spans remain valid until the data is consumed or
+	 * overwritten. Call consume() once the data has been written.
+	 */
+	buffer_spans<T> peek_contiguous() const
+	{
+		return make_buffer_spans<T>(buf_, max_size_, tail_ & mask_, size());
+	}
+
+	/// Returns the storage index that the next element will be written to
+	size_t head() const
+	{
+		return head_ & mask_;
+	}
+
+	/// Returns the storage index of the oldest element
+	size_t tail() const
+	{
+		return tail_ & mask_;
+	}
+
+	const T* storage() const
+	{
+		return &buf_[0];
+	}
+
+  private:
+	static constexpr size_t max_size_ = TCount;
+	static constexpr size_t mask_ = TCount - 1;
+	size_t head_ = 0;
+	size_t tail_ = 0;
+	T buf_[TCount];
+};
+
+template<class T, size_t TCount>
+constexpr size_t CircularBuffer<T, TCount, true>::max_size_;
+
+template<class T, size_t TCount>
+constexpr size_t CircularBuffer<T, TCount, true>::mask_;
+
+#endif // CIRCULAR_BUFFER_HPP_
@@ -0,0 +1,203 @@
+#ifndef DEFERRED_ARGS_HPP_
+#define DEFERRED_ARGS_HPP_
+
+#include <LibPrintf.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @file deferred_args.hpp
+ *
+ * Support for deferred formatting: log arguments are copied into a byte buffer when the log
+ * statement executes, and they are decoded and passed to fctprintf() at a later time.
+ *
+ * Arithmetic types and pointers are stored as their raw bytes. Strings are copied into the
+ * record (up to LOG_DEFERRED_MAX_STRING_LENGTH characters), since the original string is
+ * likely to have changed, or gone out of scope, by the time the record is formatted.
+ */
+
+#ifndef LOG_DEFERRED_MAX_STRING_LENGTH
+/// The maximum number of characters stored for a string argument in a deferred log record.
+/// Longer strings are truncated.
+#define LOG_DEFERRED_MAX_STRING_LENGTH 32
+#endif
+
+/// Output function used with fctprintf()
+using deferred_out_fn = void (*)(char c, void* arg);
+
+/// Decodes the arguments in data and formats them with fmt
+using deferred_format_fn = void (*)(deferred_out_fn out, void* arg, const char* fmt,
+									const char* data);
+
+/** Storage rules for a single deferred log argument
+ *
+ * The default rule stores the raw bytes of the argument.
+ *
+ * @tparam T The argument type, as deduced by the `const Args&...` logging templates.
+ */
+template<typename T>
+struct deferred_arg
+{
+	using decoded_type = T;
+
+	/// The maximum number of bytes used to store an argument of this type
+	static constexpr size_t max_size = sizeof(T);
+
+	static size_t size(const T& /*value*/) noexcept
+	{
+		return sizeof(T);
+	}
+
+	static size_t encode(char* dst, const T& value) noexcept
+	{
+		memcpy(dst, &value, sizeof(T));
+		return sizeof(T);
+	}
+
+	static T decode(const char*& src) noexcept
+	{
+		T value;
+		memcpy(&value, src, sizeof(T));
+		src += sizeof(T);
+		return value;
+	}
+};
+
+/// Storage rule for string arguments: the characters are copied into the record
+struct deferred_string_arg
+{
+	using decoded_type = const char*;
+
+	static constexpr size_t max_size = LOG_DEFERRED_MAX_STRING_LENGTH + 1;
+
+	static size_t length(const char* value) noexcept
+	{
+		if(value == nullptr)
+		{
+			return 0;
+		}
+
+		size_t len = 0;
+
+		while(len < LOG_DEFERRED_MAX_STRING_LENGTH && value[len] != '\0')
+		{
+			len++;
+		}
+
+		return len;
+	}
+
+	static size_t size(const char* value) noexcept
+	{
+		return length(value) + 1;
+	}
+
+	static size_t encode(char* dst, const char* value) noexcept
+	{
+		size_t len = length(value);
+		memcpy(dst, value, len);
+		dst[len] = '\0';
+		return len + 1;
+	}
+
+	static const char* decode(const char*& src) noexcept
+	{
+		const char* value = src;
+		src += strlen(src) + 1;
+		return value;
+	}
+};
+
+template<>
+struct deferred_arg<const char*> : deferred_string_arg
+{
+};
+
+template<>
+struct deferred_arg<char*> : deferred_string_arg
+{
+};
+
+template<size_t N>
+struct deferred_arg<char[N]> : deferred_string_arg
+{
+};
+
+/// Computes the maximum number of bytes needed to store a set of arguments
+template<typename... Args>
+struct deferred_args_max_size;
+
+template<>
+struct deferred_args_max_size<>
+{
+	static constexpr size_t value = 0;
+};
+
+template<typename T, typename... Rest>
+struct deferred_args_max_size<T, Rest...>
+{
+	static constexpr size_t value =
+		deferred_arg<T>::max_size + deferred_args_max_size<Rest...>::value;
+};
+
+/// Returns the number of bytes needed to store the supplied arguments
+inline size_t deferred_args_size() noexcept
+{
+	return 0;
+}
+
+template<typename T, typename... Rest>
+size_t deferred_args_size(const T& value, const Rest&... rest) noexcept
+{
+	return deferred_arg<T>::size(value) + deferred_args_size(rest...);
+}
+
+/// Stores the supplied arguments in dst, which must hold deferred_args_size(args...) bytes
+inline void deferred_args_encode(char* /*dst*/) noexcept {}
+
+template<typename T, typename... Rest>
+void deferred_args_encode(char* dst, const T& value, const Rest&... rest) noexcept
+{
+	dst += deferred_arg<T>::encode(dst, value);
+	deferred_args_encode(dst, rest...);
+}
+
+/** Decodes stored arguments one at a time, then formats them
+ *
+ * Each step decodes the next argument and appends it to the `decoded` pack. Once all
+ * arguments have been decoded, they are passed to fctprintf() along with the format string.
+ */
+template<typename... Remaining>
+struct deferred_formatter;
+
+template<>
+struct deferred_formatter<>
+{
+	template<typename... Decoded>
+	static void format(deferred_out_fn out, void* arg, const char* fmt, const char* /*data*/,
+					   const Decoded&... decoded) noexcept
+	{
+		fctprintf(out, arg, fmt, decoded...);
+	}
+};
+
+template<typename Next, typename... Remaining>
+struct deferred_formatter<Next, Remaining...>
+{
+	template<typename... Decoded>
+	static void format(deferred_out_fn out, void* arg, const char* fmt, const char* data,
+					   const Decoded&... decoded) noexcept
+	{
+		typename deferred_arg<Next>::decoded_type value = deferred_arg<Next>::decode(data);
+		deferred_formatter<Remaining...>::format(out, arg, fmt, data, decoded..., value);
+	}
+};
+
+/// A deferred_format_fn for the given argument types
+template<typename... Args>
+void deferred_format(deferred_out_fn out, void* arg, const char* fmt, const char* data) noexcept
+{
+	deferred_formatter<Args...>::format(out, arg, fmt, data);
+}
+
+#endif // DEFERRED_ARGS_HPP_
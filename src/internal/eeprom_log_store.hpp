@@ -0,0 +1,396 @@
+#ifndef EEPROM_LOG_STORE_HPP_
+#define EEPROM_LOG_STORE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LOG_EEPROM_SLOT_SIZE
+/// The size of a record slot in the EEPROM log, in bytes. Each flush writes whole slots, so
+/// match this to the page size of the storage if it has one.
+#define LOG_EEPROM_SLOT_SIZE 32
+#endif
+
+/// The number of bytes at the end of each slot used by the record header
+static constexpr size_t eeprom_log_header_size = 6;
+
+/// Set in the length byte of a record which starts a block (see EEPROMLogStore::block_writer)
+static constexpr uint8_t eeprom_log_block_start = 0x80;
+
+/// CRC-8 (polynomial 0x07) used to validate EEPROM log records
+inline uint8_t eeprom_log_crc8(uint8_t crc, const uint8_t* data, size_t size) noexcept
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+
+		for(int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07)
+							   : static_cast<uint8_t>(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+/** Wear-leveled log storage for EEPROM and emulated EEPROM
+ *
+ * The storage region is divided into fixed-size slots, which are used as a ring. Each flush
+ * appends records to the ring, and every record carries a sequence number, so there is no
+ * terminator cell which is rewritten on every flush. Every cell is written once per pass
+ * around the ring.
+ *
+ * Slot layout: payload[TSlotSize - 6], length (1 byte), CRC-8 (1 byte), sequence (4 bytes, LE).
+ * The header is at the end of the slot, so it is written after the payload. A record which
+ * was interrupted by a reset fails the CRC check and is ignored. The top bit of the length is
+ * set on the first record of a block (see block_writer).
+ *
+ * Slots are written with a single device.update() call, which must only write the bytes that
+ * have changed. On boot, begin() finds the newest record with a binary search over the
+ * sequence numbers.
+ *
+ * This class does not depend on the Arduino SDK. The device type provides the storage access:
+ *
+ *	@code
+ *	struct device
+ *	{
+ *		uint8_t read(unsigned address);
+ *		void update(unsigned address, const uint8_t* data, size_t size);
+ *	};
+ *	@endcode
+ *
+ * @tparam TDevice The storage device type.
+ * @tparam TSlotSize The size of a slot, in bytes.
+ */
+template<class TDevice, size_t TSlotSize = LOG_EEPROM_SLOT_SIZE>
+class EEPROMLogStore
+{
+	static_assert(TSlotSize > eeprom_log_header_size && TSlotSize - eeprom_log_header_size < 128,
+				  "Slot size must leave room for 1-127 payload bytes");
+
+  public:
+	/// The number of log bytes stored in each slot
+	static constexpr size_t payload_size = TSlotSize - eeprom_log_header_size;
+
+	EEPROMLogStore() = default;
+
+	/** Use a region of the device for log storage, and recover the existing log
+	 *
+	 * @param device The storage device. Must remain valid while this object is used.
+	 * @param address The start address of the region.
+	 * @param size The size of the region, in bytes. Any space past the last whole slot is
+	 *	unused.
+	 */
+	void begin(TDevice& device, unsigned address, unsigned size) noexcept
+	{
+		device_ = &device;
+		address_ = address;
+		slot_count_ = size / TSlotSize;
+		recover();
+	}
+
+	/// The number of slots in the storage region
+	size_t slot_count() const noexcept
+	{
+		return slot_count_;
+	}
+
+	/// The number of slots which hold records
+	size_t used_slots() const noexcept
+	{
+		return full_ ? slot_count_ : next_slot_;
+	}
+
+	/// The number of bytes of the storage region which are in use
+	size_t size() const noexcept
+	{
+		return used_slots() * TSlotSize;
+	}
+
+	/// The size of the storage region, in bytes
+	size_t capacity() const noexcept
+	{
+		return slot_count_ * TSlotSize;
+	}
+
+	/// The sequence number that the next record will be written with
+	uint32_t next_sequence() const noexcept
+	{
+		return next_sequence_;
+	}
+
+	/** Append data to the log
+	 *
+	 * The data is split into records of up to payload_size bytes. When the ring is full,
+	 * the oldest records are overwritten.
+	 *
+	 * @param data The data to append.
+	 * @param size The number of bytes to append.
+	 */
+	void write(const char* data, size_t size) noexcept
+	{
+		if(slot_count_ == 0)
+		{
+			return;
+		}
+
+		while(size > 0)
+		{
+			size_t chunk = (size > payload_size) ? payload_size : size;
+			write_slot(data, chunk);
+			data += chunk;
+			size -= chunk;
+		}
+	}
+
+	/** Log sink which stores one block of data, such as a compressed flush
+	 *
+	 * The data is packed into whole records, and the first record is marked as the start of
+	 * the block. Once the ring wraps, the oldest block may have lost its first records, so a
+	 * reader which needs whole blocks starts at first_block().
+	 *
+	 *	@code
+	 *	EEPROMLogStore<device>::block_writer writer(store);
+	 *	encoder.compress(writer, buffer, buffer.size());
+	 *	writer.finish();
+	 *	@endcode
+	 */
+	class block_writer
+	{
+	  public:
+		explicit block_writer(EEPROMLogStore& store) noexcept : store_(store) {}
+
+		size_t write(const char* data, size_t size) noexcept
+		{
+			for(size_t i = 0; i < size; i++)
+			{
+				chunk_[fill_++] = data[i];
+
+				if(fill_ == payload_size)
+				{
+					store_chunk();
+				}
+			}
+
+			return size;
+		}
+
+		/// Store the last, partial record of the block
+		void finish() noexcept
+		{
+			if(fill_ > 0)
+			{
+				store_chunk();
+			}
+		}
+
+	  private:
+		void store_chunk() noexcept
+		{
+			if(store_.slot_count_ > 0)
+			{
+				store_.write_slot(chunk_, fill_, first_);
+			}
+
+			first_ = false;
+			fill_ = 0;
+		}
+
+		EEPROMLogStore& store_;
+		char chunk_[payload_size];
+		size_t fill_ = 0;
+		bool first_ = true;
+	};
+
+	/// The index of the oldest record which starts a block, or used_slots() if there is none
+	size_t first_block() const noexcept
+	{
+		uint8_t data[TSlotSize];
+		uint32_t sequence;
+
+		for(size_t index = 0; index < used_slots(); index++)
+		{
+			if(read_slot(slot_of(index), data, sequence) &&
+			   (data[payload_size] & eeprom_log_block_start))
+			{
+				return index;
+			}
+		}
+
+		return used_slots();
+	}
+
+	/** Read a record
+	 *
+	 * @param index The record to read. 0 is the oldest record, and used_slots() - 1 the newest.
+	 * @param dst The destination. Must have space for payload_size bytes.
+	 * @returns The number of bytes copied to dst. Records which fail validation return 0.
+	 */
+	size_t read(size_t index, char* dst) const noexcept
+	{
+		if(index >= used_slots())
+		{
+			return 0;
+		}
+
+		uint8_t data[TSlotSize];
+		uint32_t sequence;
+
+		if(!read_slot(slot_of(index), data, sequence))
+		{
+			return 0;
+		}
+
+		size_t length = data[payload_size] & ~eeprom_log_block_start;
+		memcpy(dst, data, length);
+		return length;
+	}
+
+  private:
+	/// The slot which holds a record. 0 is the oldest record.
+	size_t slot_of(size_t index) const noexcept
+	{
+		return ((full_ ? next_slot_ : 0) + index) % slot_count_;
+	}
+
+	/// Read a slot and check its header
+	bool read_slot(size_t slot, uint8_t* data, uint32_t& sequence) const noexcept
+	{
+		unsigned address = address_ + static_cast<unsigned>(slot * TSlotSize);
+
+		for(size_t i = 0; i < TSlotSize; i++)
+		{
+			data[i] = device_->read(address + static_cast<unsigned>(i));
+		}
+
+		const uint8_t* header = &data[payload_size];
+		sequence = static_cast<uint32_t>(header[2]) | (static_cast<uint32_t>(header[3]) << 8) |
+				   (static_cast<uint32_t>(header[4]) << 16) |
+				   (static_cast<uint32_t>(header[5]) << 24);
+
+		return (header[0] & ~eeprom_log_block_start) <= payload_size &&
+			   header[1] == record_crc(data);
+	}
+
+	/// The CRC covers the payload, the length, and the sequence number
+	static uint8_t record_crc(const uint8_t* data) noexcept
+	{
+		uint8_t crc = eeprom_log_crc8(0xFF, data, payload_size + 1);
+		return eeprom_log_crc8(crc, &data[payload_size + 2], 4);
+	}
+
+	/// Whether the slot holds a record written at or after the record in slot 0
+	bool not_older_than_first(size_t slot, uint32_t first_sequence) const noexcept
+	{
+		uint8_t data[TSlotSize];
+		uint32_t sequence;
+
+		return read_slot(slot, data, sequence) &&
+			   static_cast<int32_t>(sequence - first_sequence) >= 0;
+	}
+
+	/** Find the newest record
+	 *
+	 * Starting from slot 0, the sequence numbers increase up to the newest record. Any slots
+	 * after it are either empty, or hold older records from the previous pass around the ring.
+	 * That makes "slot i is no older than slot 0" true for a prefix of the slots, so the end of
+	 * the prefix is found with a binary search.
+	 */
+	void recover() noexcept
+	{
+		next_slot_ = 0;
+		next_sequence_ = 0;
+		full_ = false;
+
+		if(slot_count_ == 0)
+		{
+			return;
+		}
+
+		uint8_t data[TSlotSize];
+		uint32_t first_sequence;
+		uint32_t last_sequence;
+		bool last_valid = read_slot(slot_count_ - 1, data, last_sequence);
+
+		if(!read_slot(0, data, first_sequence))
+		{
+			// Either the log is empty, or a reset interrupted the write to slot 0 after the
+			// ring wrapped, in which case the last slot holds the newest record
+			if(last_valid)
+			{
+				next_sequence_ = last_sequence + 1;
+				full_ = true;
+			}
+
+			return;
+		}
+
+		// Invariant: slot low is no older than slot 0, and slot high (if < slot_count_) is older
+		size_t low = 0;
+		size_t high = slot_count_;
+
+		while(high - low > 1)
+		{
+			size_t mid = low + (high - low) / 2;
+
+			if(not_older_than_first(mid, first_sequence))
+			{
+				low = mid;
+			}
+			else
+			{
+				high = mid;
+			}
+		}
+
+		uint32_t newest_sequence;
+		read_slot(low, data, newest_sequence);
+		next_slot_ = (low + 1) % slot_count_;
+		next_sequence_ = newest_sequence + 1;
+		full_ = last_valid;
+	}
+
+	void write_slot(const char* data, size_t size, bool block_start = false) noexcept
+	{
+		uint8_t slot[TSlotSize];
+
+		memcpy(slot, data, size);
+		// Unused payload bytes keep their current value, so they are not rewritten
+		for(size_t i = size; i < payload_size; i++)
+		{
+			slot[i] =
+				device_->read(address_ + static_cast<unsigned>(next_slot_ * TSlotSize + i));
+		}
+
+		slot[payload_size] =
+			static_cast<uint8_t>(size | (block_start ? eeprom_log_block_start : 0));
+		slot[payload_size + 2] = static_cast<uint8_t>(next_sequence_);
+		slot[payload_size + 3] = static_cast<uint8_t>(next_sequence_ >> 8);
+		slot[payload_size + 4] = static_cast<uint8_t>(next_sequence_ >> 16);
+		slot[payload_size + 5] = static_cast<uint8_t>(next_sequence_ >> 24);
+		slot[payload_size + 1] = record_crc(slot);
+
+		device_->update(address_ + static_cast<unsigned>(next_slot_ * TSlotSize), slot, TSlotSize);
+
+		next_sequence_++;
+		next_slot_++;
+
+		if(next_slot_ == slot_count_)
+		{
+			next_slot_ = 0;
+			full_ = true;
+		}
+	}
+
+	TDevice* device_ = nullptr;
+	unsigned address_ = 0;
+	size_t slot_count_ = 0;
+	/// The slot the next record is written to
+	size_t next_slot_ = 0;
+	uint32_t next_sequence_ = 0;
+	/// True once every slot has been written
+	bool full_ = false;
+};
+
+#endif // EEPROM_LOG_STORE_HPP_
@@ -0,0 +1,107 @@
+#ifndef EXTERNAL_BUFFER_HPP_
+#define EXTERNAL_BUFFER_HPP_
+
+#include "circular_buffer.hpp"
+#include "record_circular_buffer.hpp"
+#include <stddef.h>
+#if defined(__AVR__)
+#include <new.h>
+#else
+#include <new>
+#endif
+
+/** Log buffer which lives outside the logger
+ *
+ * Strategies keep their staging buffer as a member, so the buffer is placed wherever the logger
+ * is. Large buffers can instead be declared separately, in a memory region of your choice
+ * (e.g., Teensy 4 DMAMEM or EXTMEM), so they do not take up tightly-coupled RAM. Select
+ * ExternalBuffer as the strategy's buffer type, naming the buffer as a template argument:
+ *
+ *	@code
+ *	DMAMEM CircularBuffer<char, 64 * 1024> sd_log_buffer;
+ *	TeensySDLogger_t<ExternalBuffer<CircularBuffer<char, 64 * 1024>, sd_log_buffer>> logger;
+ *	@endcode
+ *
+ * The buffer's address is a compile-time constant, so its accesses cost the same as those of a
+ * member buffer. The startup code does not initialize DMAMEM or EXTMEM, so the buffer is
+ * initialized when the ExternalBuffer is constructed. The buffer contents are not touched.
+ * Only one logger may use each buffer.
+ *
+ * This class does not depend on the Arduino SDK.
+ *
+ * @tparam TBuffer The buffer type. Any type with the CircularBuffer interface can be used
+ *	(e.g., SPSCCircularBuffer).
+ * @tparam TStorage The buffer instance. It must have static storage duration.
+ */
+template<class TBuffer, TBuffer& TStorage>
+class ExternalBuffer
+{
+  public:
+	ExternalBuffer() noexcept
+	{
+		// Default-initialization sets the buffer's indices, and leaves its storage alone
+		new(&TStorage) TBuffer;
+	}
+
+	void put(char c)
+	{
+		TStorage.put(c);
+	}
+
+	void put(const char* data, size_t count)
+	{
+		TStorage.put(data, count);
+	}
+
+	bool try_put(const char* data, size_t count)
+	{
+		return buffer_try_put(TStorage, data, count);
+	}
+
+	record_drop_count put_record(const char* data, size_t count)
+	{
+		return buffer_put_record(TStorage, data, count);
+	}
+
+	char get()
+	{
+		return TStorage.get();
+	}
+
+	void consume(size_t count)
+	{
+		TStorage.consume(count);
+	}
+
+	void reset()
+	{
+		TStorage.reset();
+	}
+
+	bool empty() const
+	{
+		return TStorage.empty();
+	}
+
+	bool full() const
+	{
+		return TStorage.full();
+	}
+
+	size_t capacity() const
+	{
+		return TStorage.capacity();
+	}
+
+	size_t size() const
+	{
+		return TStorage.size();
+	}
+
+	buffer_spans<char> peek_contiguous() const
+	{
+		return TStorage.peek_contiguous();
+	}
+};
+
+#endif // EXTERNAL_BUFFER_HPP_
@@ -0,0 +1,131 @@
+#ifndef FLUSH_POLICY_HPP_
+#define FLUSH_POLICY_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOG_FLUSH_WATERMARK_DEFAULT
+/// LoggerBase::poll() flushes once the log buffer is this many percent full.
+/// 0 disables the watermark trigger.
+#define LOG_FLUSH_WATERMARK_DEFAULT 50
+#endif
+
+#ifndef LOG_FLUSH_MAX_AGE_MS_DEFAULT
+/// LoggerBase::poll() flushes once data has been buffered for this many milliseconds.
+/// 0 disables the age trigger.
+#define LOG_FLUSH_MAX_AGE_MS_DEFAULT 1000
+#endif
+
+#ifndef LOG_FLUSH_ON_CRITICAL_DEFAULT
+/// Whether critical log statements are written out immediately by default
+#define LOG_FLUSH_ON_CRITICAL_DEFAULT false
+#endif
+
+/** Decides when a logger flushes its buffer
+ *
+ * Without a policy, a flush happens when the user calls flush(), or when a log statement finds
+ * the buffer full. The second case occurs in the middle of a log statement, at a time the
+ * application cannot choose. With a policy, the application calls LoggerBase::poll() from
+ * loop(), and the buffer is flushed there once it passes a high watermark or once the oldest
+ * buffered data reaches a maximum age. Critical statements can also be written out immediately.
+ *
+ * The age of the buffered data is measured from the first poll() that finds the buffer
+ * non-empty, so no clock is read in the logging path. The age is accurate to the poll interval.
+ *
+ * The current time is supplied by the caller, so this class does not depend on the Arduino SDK.
+ */
+class FlushPolicy
+{
+  public:
+	FlushPolicy() = default;
+
+	/// The buffer fill level, in percent, at which poll() flushes
+	uint8_t watermark() const noexcept
+	{
+		return watermark_;
+	}
+
+	/** Set the buffer fill level at which poll() flushes
+	 *
+	 * @param percent The fill level, in percent of the buffer capacity. 0 disables the
+	 *	watermark trigger.
+	 */
+	void watermark(uint8_t percent) noexcept
+	{
+		watermark_ = (percent > 100) ? 100 : percent;
+	}
+
+	/// The maximum age of buffered data, in milliseconds
+	uint32_t max_age() const noexcept
+	{
+		return max_age_;
+	}
+
+	/** Set the maximum age of buffered data
+	 *
+	 * @param ms poll() flushes once data has been buffered for this many milliseconds.
+	 *	0 disables the age trigger.
+	 */
+	void max_age(uint32_t ms) noexcept
+	{
+		max_age_ = ms;
+	}
+
+	/// Returns true if critical statements are written out immediately
+	bool flush_on_critical() const noexcept
+	{
+		return flush_on_critical_;
+	}
+
+	/// Set whether critical statements are written out immediately
+	void flush_on_critical(bool enable) noexcept
+	{
+		flush_on_critical_ = enable;
+	}
+
+	/** Check whether the buffer should be flushed
+	 *
+	 * @param size The number of bytes in the buffer.
+	 * @param capacity The capacity of the buffer, in bytes.
+	 * @param now The current time, in milliseconds.
+	 * @returns true if the buffer should be flushed now.
+	 */
+	bool due(size_t size, size_t capacity, uint32_t now) noexcept
+	{
+		if(size == 0)
+		{
+			pending_ = false;
+			return false;
+		}
+
+		if(!pending_)
+		{
+			pending_ = true;
+			oldest_ = now;
+		}
+
+		return (watermark_ > 0 && size >= watermark_size(capacity)) ||
+			   (max_age_ > 0 && static_cast<uint32_t>(now - oldest_) >= max_age_);
+	}
+
+	/// Record that the buffer was flushed. Data that remains is aged from the next due() call.
+	void flushed() noexcept
+	{
+		pending_ = false;
+	}
+
+  private:
+	/// The watermark in bytes, computed without overflowing size_t
+	size_t watermark_size(size_t capacity) const noexcept
+	{
+		return (capacity / 100) * watermark_ + (capacity % 100) * watermark_ / 100;
+	}
+
+	uint8_t watermark_ = LOG_FLUSH_WATERMARK_DEFAULT;
+	bool flush_on_critical_ = LOG_FLUSH_ON_CRITICAL_DEFAULT;
+	bool pending_ = false;
+	uint32_t max_age_ = LOG_FLUSH_MAX_AGE_MS_DEFAULT;
+	uint32_t oldest_ = 0;
+};
+
+#endif // FLUSH_POLICY_HPP_
@@ -0,0 +1,76 @@
+#ifndef KINETIS_RESET_REASON_HPP_
+#define KINETIS_RESET_REASON_HPP_
+
+#include <kinetis.h>
+
+/** Report the reset reasons recorded by the Kinetis reset control module
+ *
+ * The RCM_SRS0 and RCM_SRS1 registers are cleared, so this should only be called once, while the
+ * logger is started.
+ *
+ * @param report Called with a description of each reason. The descriptions are string
+ *	literals ending in a newline. Log them as an argument, e.g. info("%s", reason), rather than
+ *	as the format string.
+ */
+template<class TFunction>
+void report_kinetis_reset_reason(TFunction report)
+{
+	auto srs0 = RCM_SRS0;
+	auto srs1 = RCM_SRS1;
+
+	// Clear the values
+	RCM_SRS0 = 0;
+	RCM_SRS1 = 0;
+
+	if(srs0 & RCM_SRS0_LVD)
+	{
+		report("Low-voltage Detect Reset\n");
+	}
+
+	if(srs0 & RCM_SRS0_LOL)
+	{
+		report("Loss of Lock in PLL Reset\n");
+	}
+
+	if(srs0 & RCM_SRS0_LOC)
+	{
+		report("Loss of External Clock Reset\n");
+	}
+
+	if(srs0 & RCM_SRS0_WDOG)
+	{
+		report("Watchdog Reset\n");
+	}
+
+	if(srs0 & RCM_SRS0_PIN)
+	{
+		report("External Pin Reset\n");
+	}
+
+	if(srs0 & RCM_SRS0_POR)
+	{
+		report("Power-on Reset\n");
+	}
+
+	if(srs1 & RCM_SRS1_SACKERR)
+	{
+		report("Stop Mode Acknowledge Error Reset\n");
+	}
+
+	if(srs1 & RCM_SRS1_MDM_AP)
+	{
+		report("MDM-AP Reset\n");
+	}
+
+	if(srs1 & RCM_SRS1_SW)
+	{
+		report("Software Reset\n");
+	}
+
+	if(srs1 & RCM_SRS1_LOCKUP)
+	{
+		report("Core Lockup Event Reset\n");
+	}
+}
+
+#endif // KINETIS_RESET_REASON_HPP_
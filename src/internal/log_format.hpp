@@ -0,0 +1,805 @@
+#ifndef LOG_FORMAT_HPP_
+#define LOG_FORMAT_HPP_
+
+#include <LibPrintf.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @file log_format.hpp
+ *
+ * Compile-time format strings. LOG_FMT("...") wraps a string literal in a unique type, so the
+ * logging templates can parse it at compile time:
+ *
+ *	@code
+ *	logger.info(LOG_FMT("Sensor %u: %ld mV\n"), id, reading);
+ *	@endcode
+ *
+ * - The conversions are checked against the argument types. A mismatch, such as "%d" with a
+ *	long (which is int32_t on ARM and AVR), or a missing argument, fails to compile.
+ * - If every conversion is one of %d, %i, %u, %x, %X, %c, %s, or %%, without flags, width, or
+ *	precision, or is %f or %.Nf (with N from 0 to 9), the statement is written by an emitter
+ *	which is generated for the format, with no format parsing at run time. Other formats are
+ *	checked, and then formatted by fctprintf() as usual.
+ * - The emitter writes %f and %.Nf with integer arithmetic (see log_fmt_put_fixed), which is
+ *	much faster than the floating-point formatting of fctprintf().
+ *
+ * The checks follow the printf() rules, with two exceptions: the signedness of an integer may
+ * differ from its conversion, and an enum is accepted where an int is expected. Plain
+ * `const char*` formats are not affected, and are still formatted at run time.
+ */
+
+/** A format string which is known at compile time (see LOG_FMT())
+ *
+ * @tparam TString A type with a `static constexpr const char* data()` function which returns
+ *	the format string.
+ */
+template<class TString>
+struct log_format
+{
+	/// The format string
+	static constexpr const char* c_str() noexcept
+	{
+		return TString::data();
+	}
+
+	/// Allows a LOG_FMT() string to be used wherever a `const char*` format is expected
+	constexpr operator const char*() const noexcept
+	{
+		return TString::data();
+	}
+};
+
+/// Declare a compile-time format string. `str` must be a string literal.
+#define LOG_FMT(str)                                     \
+	([]() {                                              \
+		struct log_format_string_                        \
+		{                                                \
+			static constexpr const char* data() noexcept \
+			{                                            \
+				return str;                              \
+			}                                            \
+		};                                               \
+		return log_format<log_format_string_>();         \
+	}())
+
+/** @name Format string parser
+ *
+ * C++11 constexpr functions, which are evaluated when a LOG_FMT() string is used.
+ * A conversion is described by `(length << 8) | conversion`, where length is one of the
+ * log_fmt_length_* values below.
+ * @{
+ */
+
+static constexpr unsigned log_fmt_length_none = 0;
+static constexpr unsigned log_fmt_length_hh = 1;
+static constexpr unsigned log_fmt_length_h = 2;
+static constexpr unsigned log_fmt_length_l = 3;
+static constexpr unsigned log_fmt_length_ll = 4;
+static constexpr unsigned log_fmt_length_j = 5;
+static constexpr unsigned log_fmt_length_z = 6;
+static constexpr unsigned log_fmt_length_t = 7;
+static constexpr unsigned log_fmt_length_L = 8;
+
+/// Returned when there is no conversion with the requested index
+static constexpr unsigned log_fmt_end = 0;
+/// The conversion of a specification which ends with the string
+static constexpr char log_fmt_truncated = '!';
+
+constexpr bool log_fmt_is_flag(char c) noexcept
+{
+	return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0';
+}
+
+constexpr bool log_fmt_is_digit(char c) noexcept
+{
+	return c >= '0' && c <= '9';
+}
+
+constexpr size_t log_fmt_skip_flags(const char* f, size_t i) noexcept
+{
+	return log_fmt_is_flag(f[i]) ? log_fmt_skip_flags(f, i + 1) : i;
+}
+
+constexpr size_t log_fmt_skip_digits(const char* f, size_t i) noexcept
+{
+	return log_fmt_is_digit(f[i]) ? log_fmt_skip_digits(f, i + 1) : i;
+}
+
+/// The length modifier at f[i]
+constexpr unsigned log_fmt_length(const char* f, size_t i) noexcept
+{
+	return (f[i] == 'h')   ? ((f[i + 1] == 'h') ? log_fmt_length_hh : log_fmt_length_h)
+		   : (f[i] == 'l') ? ((f[i + 1] == 'l') ? log_fmt_length_ll : log_fmt_length_l)
+		   : (f[i] == 'j') ? log_fmt_length_j
+		   : (f[i] == 'z') ? log_fmt_length_z
+		   : (f[i] == 't') ? log_fmt_length_t
+		   : (f[i] == 'L') ? log_fmt_length_L
+						   : log_fmt_length_none;
+}
+
+/// The number of characters used by a length modifier
+constexpr size_t log_fmt_length_size(unsigned length) noexcept
+{
+	return (length == log_fmt_length_none)								  ? 0
+		   : (length == log_fmt_length_hh || length == log_fmt_length_ll) ? 2
+																		  : 1;
+}
+
+/// The index of the next '%' at or after i, or of the terminating NUL
+constexpr size_t log_fmt_next_spec(const char* f, size_t i) noexcept
+{
+	return (f[i] == '\0' || f[i] == '%') ? i : log_fmt_next_spec(f, i + 1);
+}
+
+constexpr unsigned log_fmt_slot(const char* f, size_t i, size_t n) noexcept;
+
+/// The conversion at f[c], where c is the position after the length modifier
+constexpr unsigned log_fmt_slot_conversion(const char* f, size_t c, size_t n,
+										   unsigned length) noexcept
+{
+	return (f[c] == '\0')  ? static_cast<unsigned>(log_fmt_truncated)
+		   : (f[c] == '%') ? log_fmt_slot(f, c + 1, n)
+		   : (n == 0)	   ? ((length << 8) | static_cast<unsigned char>(f[c]))
+					   : log_fmt_slot(f, c + 1, n - 1);
+}
+
+/// The length modifier at f[i], followed by the conversion
+constexpr unsigned log_fmt_slot_length(const char* f, size_t i, size_t n) noexcept
+{
+	return log_fmt_slot_conversion(f, i + log_fmt_length_size(log_fmt_length(f, i)), n,
+								   log_fmt_length(f, i));
+}
+
+/// The precision at f[i]. A '*' precision consumes an int argument.
+constexpr unsigned log_fmt_slot_precision(const char* f, size_t i, size_t n) noexcept
+{
+	return (f[i] != '.')		  ? log_fmt_slot_length(f, i, n)
+		   : (f[i + 1] != '*') ? log_fmt_slot_length(f, log_fmt_skip_digits(f, i + 1), n)
+		   : (n == 0)		   ? static_cast<unsigned>('*')
+							   : log_fmt_slot_length(f, i + 2, n - 1);
+}
+
+/// The width at f[i]. A '*' width consumes an int argument.
+constexpr unsigned log_fmt_slot_width(const char* f, size_t i, size_t n) noexcept
+{
+	return (f[i] != '*') ? log_fmt_slot_precision(f, log_fmt_skip_digits(f, i), n)
+		   : (n == 0)	 ? static_cast<unsigned>('*')
+						 : log_fmt_slot_precision(f, i + 1, n - 1);
+}
+
+/** The conversion which consumes argument n, scanning from f[i]
+ *
+ * @returns The conversion, log_fmt_end if the format has no argument n, or log_fmt_truncated
+ *	if a specification is incomplete.
+ */
+constexpr unsigned log_fmt_slot(const char* f, size_t i, size_t n) noexcept
+{
+	return (f[i] == '\0')  ? log_fmt_end
+		   : (f[i] != '%') ? log_fmt_slot(f, i + 1, n)
+						   : log_fmt_slot_width(f, log_fmt_skip_flags(f, i + 1), n);
+}
+
+constexpr char log_fmt_conversion(unsigned slot) noexcept
+{
+	return static_cast<char>(slot & 0xFF);
+}
+
+constexpr unsigned log_fmt_length_of(unsigned slot) noexcept
+{
+	return slot >> 8;
+}
+
+constexpr bool log_fmt_is_integer_conversion(char c) noexcept
+{
+	return c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' || c == 'b';
+}
+
+constexpr bool log_fmt_is_float_conversion(char c) noexcept
+{
+	return c == 'f' || c == 'F' || c == 'e' || c == 'E' || c == 'g' || c == 'G' || c == 'a' ||
+		   c == 'A';
+}
+
+constexpr bool log_fmt_is_known_conversion(char c) noexcept
+{
+	return log_fmt_is_integer_conversion(c) || log_fmt_is_float_conversion(c) || c == 'c' ||
+		   c == 's' || c == 'p' || c == '*';
+}
+
+/// The number of arguments consumed by the format, counting from argument n
+constexpr size_t log_fmt_count(const char* f, size_t n) noexcept
+{
+	return (log_fmt_slot(f, 0, n) == log_fmt_end) ? n
+		   : (log_fmt_conversion(log_fmt_slot(f, 0, n)) == log_fmt_truncated)
+			   ? n + 1
+			   : log_fmt_count(f, n + 1);
+}
+
+/// Returns true if every conversion, from argument n on, is supported
+constexpr bool log_fmt_valid(const char* f, size_t n) noexcept
+{
+	return (log_fmt_slot(f, 0, n) == log_fmt_end) ||
+		   (log_fmt_is_known_conversion(log_fmt_conversion(log_fmt_slot(f, 0, n))) &&
+			log_fmt_valid(f, n + 1));
+}
+
+/// The position of the conversion of the specification whose '%' is at f[spec]
+constexpr size_t log_fmt_conversion_pos(const char* f, size_t spec) noexcept
+{
+	return spec + 1 + log_fmt_length_size(log_fmt_length(f, spec + 1));
+}
+
+/// Returns true if the specification whose '%' is at f[spec] is %f, or %.Nf with a single digit N
+constexpr bool log_fmt_fixed_spec(const char* f, size_t spec) noexcept
+{
+	return f[spec + 1] == 'f' ||
+		   (f[spec + 1] == '.' && log_fmt_is_digit(f[spec + 2]) && f[spec + 3] == 'f');
+}
+
+/// The number of decimals of a log_fmt_fixed_spec() specification. printf() defaults to 6.
+constexpr unsigned log_fmt_fixed_decimals(const char* f, size_t spec) noexcept
+{
+	return (f[spec + 1] == '.') ? static_cast<unsigned>(f[spec + 2] - '0') : 6;
+}
+
+/// log_fmt_conversion_pos() for a specification accepted by log_fmt_simple()
+constexpr size_t log_fmt_simple_conversion_pos(const char* f, size_t spec) noexcept
+{
+	return (f[spec + 1] == '.') ? spec + 3 : log_fmt_conversion_pos(f, spec);
+}
+
+constexpr bool log_fmt_simple_conversion(char c) noexcept
+{
+	return c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'c' || c == 's' ||
+		   c == '%';
+}
+
+constexpr bool log_fmt_simple(const char* f, size_t i) noexcept;
+
+/// log_fmt_simple() for the specification whose '%' is at f[spec]
+constexpr bool log_fmt_simple_spec(const char* f, size_t spec) noexcept
+{
+	return (f[spec] == '\0') ||
+		   (log_fmt_fixed_spec(f, spec) &&
+			log_fmt_simple(f, log_fmt_simple_conversion_pos(f, spec) + 1)) ||
+		   (log_fmt_length(f, spec + 1) != log_fmt_length_hh &&
+			log_fmt_length(f, spec + 1) != log_fmt_length_h &&
+			log_fmt_length(f, spec + 1) != log_fmt_length_L &&
+			log_fmt_simple_conversion(f[log_fmt_conversion_pos(f, spec)]) &&
+			log_fmt_simple(f, log_fmt_conversion_pos(f, spec) + 1));
+}
+
+/** Returns true if the format can be written by log_fmt_emitter, scanning from f[i]
+ *
+ * That is, every specification is %d, %i, %u, %x, %X, %c, %s, or %%, with no flags, width,
+ * or precision, and an optional l, ll, j, z, or t length modifier, or is %f or %.Nf, with a
+ * precision N from 0 to 9.
+ */
+constexpr bool log_fmt_simple(const char* f, size_t i) noexcept
+{
+	return log_fmt_simple_spec(f, log_fmt_next_spec(f, i));
+}
+
+/// Returns true if an integer of the given rank and size matches a length modifier
+constexpr bool log_fmt_integer_length_matches(unsigned length, unsigned rank,
+											  size_t size) noexcept
+{
+	return (length == log_fmt_length_none || length == log_fmt_length_hh ||
+			length == log_fmt_length_h)
+			   ? (rank == log_fmt_length_none)
+		   : (length == log_fmt_length_l || length == log_fmt_length_ll) ? (rank == length)
+		   : (length == log_fmt_length_j) ? (size == sizeof(intmax_t))
+		   : (length == log_fmt_length_z) ? (size == sizeof(size_t))
+		   : (length == log_fmt_length_t) ? (size == sizeof(ptrdiff_t))
+										  : false;
+}
+
+/// log_fmt_accepts() for conversion c with a length modifier
+constexpr bool log_fmt_accepts_conversion(char c, unsigned length, char kind, unsigned rank,
+										  size_t size) noexcept
+{
+	return (c == '*' || c == 'c') ? (kind == 'i' && rank == log_fmt_length_none)
+		   : log_fmt_is_integer_conversion(c)
+			   ? (kind == 'i' && log_fmt_integer_length_matches(length, rank, size))
+		   : log_fmt_is_float_conversion(c)
+			   ? (kind == 'f' && (length == log_fmt_length_L) == (rank == log_fmt_length_L))
+		   : (c == 's') ? (kind == 's')
+		   : (c == 'p') ? (kind == 'p' || kind == 's')
+						// Unknown conversions are reported by log_fmt_valid()
+						: true;
+}
+
+/** Returns true if an argument can be passed to a conversion
+ *
+ * @param slot The conversion (see log_fmt_slot()).
+ * @param kind The kind of the argument (see log_fmt_arg).
+ * @param rank The rank of the argument (see log_fmt_arg).
+ * @param size The size of the argument, after promotion.
+ */
+constexpr bool log_fmt_accepts(unsigned slot, char kind, unsigned rank, size_t size) noexcept
+{
+	return (slot == log_fmt_end) ||
+		   log_fmt_accepts_conversion(log_fmt_conversion(slot), log_fmt_length_of(slot), kind,
+									  rank, size);
+}
+
+///@}
+
+/** Describes a log argument to the format checks
+ *
+ * - kind: 'i' for integers (and enums), 'f' for floating-point values, 's' for strings, 'p' for
+ *	other pointers, and '?' for types which printf() cannot format
+ * - rank: for integers, the length modifier that matches the promoted type
+ *	(log_fmt_length_none, log_fmt_length_l, or log_fmt_length_ll); for floating-point values,
+ *	log_fmt_length_L for long double
+ * - signed_type, unsigned_type: the promoted integer type, as signed and unsigned
+ *
+ * @tparam T The argument type, as deduced by the `const Args&...` logging templates.
+ */
+template<typename T>
+struct log_fmt_arg
+{
+	static constexpr char kind = __is_enum(T) ? 'i' : '?';
+	static constexpr unsigned rank = log_fmt_length_none;
+	static constexpr size_t size = sizeof(int);
+	using signed_type = int;
+	using unsigned_type = unsigned;
+};
+
+template<unsigned TRank, typename TSigned, typename TUnsigned>
+struct log_fmt_integer_arg
+{
+	static constexpr char kind = 'i';
+	static constexpr unsigned rank = TRank;
+	static constexpr size_t size = sizeof(TSigned);
+	using signed_type = TSigned;
+	using unsigned_type = TUnsigned;
+};
+
+/// Integers narrower than int are promoted to int
+using log_fmt_int_arg = log_fmt_integer_arg<log_fmt_length_none, int, unsigned>;
+
+template<>
+struct log_fmt_arg<bool> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<char> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<signed char> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<unsigned char> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<short> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<unsigned short> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<int> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<unsigned> : log_fmt_int_arg
+{
+};
+
+template<>
+struct log_fmt_arg<long> : log_fmt_integer_arg<log_fmt_length_l, long, unsigned long>
+{
+};
+
+template<>
+struct log_fmt_arg<unsigned long> : log_fmt_integer_arg<log_fmt_length_l, long, unsigned long>
+{
+};
+
+template<>
+struct log_fmt_arg<long long>
+	: log_fmt_integer_arg<log_fmt_length_ll, long long, unsigned long long>
+{
+};
+
+template<>
+struct log_fmt_arg<unsigned long long>
+	: log_fmt_integer_arg<log_fmt_length_ll, long long, unsigned long long>
+{
+};
+
+template<unsigned TRank>
+struct log_fmt_float_arg
+{
+	static constexpr char kind = 'f';
+	static constexpr unsigned rank = TRank;
+	static constexpr size_t size = 0;
+};
+
+/// float is promoted to double
+template<>
+struct log_fmt_arg<float> : log_fmt_float_arg<log_fmt_length_none>
+{
+};
+
+template<>
+struct log_fmt_arg<double> : log_fmt_float_arg<log_fmt_length_none>
+{
+};
+
+template<>
+struct log_fmt_arg<long double> : log_fmt_float_arg<log_fmt_length_L>
+{
+};
+
+struct log_fmt_string_arg
+{
+	static constexpr char kind = 's';
+	static constexpr unsigned rank = log_fmt_length_none;
+	static constexpr size_t size = 0;
+};
+
+template<>
+struct log_fmt_arg<const char*> : log_fmt_string_arg
+{
+};
+
+template<>
+struct log_fmt_arg<char*> : log_fmt_string_arg
+{
+};
+
+template<size_t N>
+struct log_fmt_arg<char[N]> : log_fmt_string_arg
+{
+};
+
+template<typename T>
+struct log_fmt_arg<T*>
+{
+	static constexpr char kind = 'p';
+	static constexpr unsigned rank = log_fmt_length_none;
+	static constexpr size_t size = 0;
+};
+
+/// Checks each argument against the conversion which consumes it
+template<typename... Args>
+struct log_fmt_args;
+
+template<>
+struct log_fmt_args<>
+{
+	static constexpr bool match(const char* /*f*/, size_t /*n*/) noexcept
+	{
+		return true;
+	}
+};
+
+template<typename T, typename... Rest>
+struct log_fmt_args<T, Rest...>
+{
+	static constexpr bool match(const char* f, size_t n) noexcept
+	{
+		return log_fmt_accepts(log_fmt_slot(f, 0, n), log_fmt_arg<T>::kind, log_fmt_arg<T>::rank,
+							   log_fmt_arg<T>::size) &&
+			   log_fmt_args<Rest...>::match(f, n + 1);
+	}
+};
+
+/// Check the arguments of a LOG_FMT() statement. Fails to compile if they do not match.
+template<class TString, typename... Args>
+inline void log_format_check() noexcept
+{
+	static_assert(log_fmt_valid(TString::data(), 0),
+				  "LOG_FMT: the format string has an unsupported or incomplete conversion");
+	static_assert(log_fmt_count(TString::data(), 0) == sizeof...(Args),
+				  "LOG_FMT: the number of arguments does not match the format string");
+	static_assert(log_fmt_args<Args...>::match(TString::data(), 0),
+				  "LOG_FMT: an argument type does not match its conversion");
+}
+
+/** @name Emitter
+ *
+ * The output type must provide `put(char)` and `put(const char*, size_t)`, like
+ * LogRecordBuilder, and a static `putc_bounce(char, void*)` function for fctprintf().
+ * @{
+ */
+
+template<unsigned TBase, class TOut, typename TUnsigned>
+inline void log_fmt_put_unsigned(TOut& out, TUnsigned value, const char* digits) noexcept
+{
+	// Enough for the decimal or hexadecimal digits of the value
+	char buffer[sizeof(TUnsigned) * 3];
+	size_t i = sizeof(buffer);
+
+	do
+	{
+		buffer[--i] = digits[value % TBase];
+		value /= TBase;
+	} while(value != 0);
+
+	out.put(&buffer[i], sizeof(buffer) - i);
+}
+
+template<char TConversion>
+struct log_fmt_put_arg;
+
+template<>
+struct log_fmt_put_arg<'d'>
+{
+	template<class TOut, typename T>
+	static void put(TOut& out, const T& value) noexcept
+	{
+		using unsigned_type = typename log_fmt_arg<T>::unsigned_type;
+		auto number = static_cast<typename log_fmt_arg<T>::signed_type>(value);
+		auto magnitude = static_cast<unsigned_type>(number);
+
+		if(number < 0)
+		{
+			out.put('-');
+			magnitude = static_cast<unsigned_type>(0U - magnitude);
+		}
+
+		log_fmt_put_unsigned<10>(out, magnitude, "0123456789");
+	}
+};
+
+template<>
+struct log_fmt_put_arg<'i'> : log_fmt_put_arg<'d'>
+{
+};
+
+template<>
+struct log_fmt_put_arg<'u'>
+{
+	template<class TOut, typename T>
+	static void put(TOut& out, const T& value) noexcept
+	{
+		log_fmt_put_unsigned<10>(out, static_cast<typename log_fmt_arg<T>::unsigned_type>(value),
+								 "0123456789");
+	}
+};
+
+template<>
+struct log_fmt_put_arg<'x'>
+{
+	template<class TOut, typename T>
+	static void put(TOut& out, const T& value) noexcept
+	{
+		log_fmt_put_unsigned<16>(out, static_cast<typename log_fmt_arg<T>::unsigned_type>(value),
+								 "0123456789abcdef");
+	}
+};
+
+template<>
+struct log_fmt_put_arg<'X'>
+{
+	template<class TOut, typename T>
+	static void put(TOut& out, const T& value) noexcept
+	{
+		log_fmt_put_unsigned<16>(out, static_cast<typename log_fmt_arg<T>::unsigned_type>(value),
+								 "0123456789ABCDEF");
+	}
+};
+
+template<>
+struct log_fmt_put_arg<'c'>
+{
+	template<class TOut, typename T>
+	static void put(TOut& out, const T& value) noexcept
+	{
+		out.put(static_cast<char>(value));
+	}
+};
+
+template<>
+struct log_fmt_put_arg<'s'>
+{
+	template<class TOut>
+	static void put(TOut& out, const char* str) noexcept
+	{
+		if(str == nullptr)
+		{
+			str = "(null)";
+		}
+
+		out.put(str, strlen(str));
+	}
+};
+
+/// Values with a larger magnitude are written by printf() with an exponent, so
+/// log_fmt_put_fixed leaves them to fctprintf()
+static constexpr double log_fmt_fixed_max = 1e9;
+
+/** Writes a floating-point value with TDecimals decimals, like "%.Nf"
+ *
+ * The integer and fractional parts are written as 32-bit integers, so no 64-bit or
+ * floating-point division is needed. The value is rounded to the nearest decimal, and a value
+ * which is exactly halfway is rounded to even, like printf(). NaN, infinities, and values
+ * beyond log_fmt_fixed_max are passed to fctprintf().
+ */
+template<unsigned TDecimals>
+struct log_fmt_put_fixed
+{
+	static_assert(TDecimals <= 9, "The fractional part must fit in 32 bits");
+
+	template<class TOut>
+	static void put(TOut& out, double value) noexcept
+	{
+		if(!(value >= -log_fmt_fixed_max && value <= log_fmt_fixed_max))
+		{
+			fctprintf(&TOut::putc_bounce, &out, "%.*f", static_cast<int>(TDecimals), value);
+			return;
+		}
+
+		if(value < 0)
+		{
+			out.put('-');
+			value = -value;
+		}
+
+		uint32_t scale = 1;
+		for(unsigned i = 0; i < TDecimals; i++)
+		{
+			scale *= 10;
+		}
+
+		auto whole = static_cast<uint32_t>(value);
+		double scaled = (value - whole) * scale;
+		auto fraction = static_cast<uint32_t>(scaled);
+		double remainder = scaled - fraction;
+		uint32_t last = (TDecimals > 0) ? fraction : whole;
+
+		if(remainder > 0.5 || (remainder == 0.5 && (last & 1U) != 0))
+		{
+			if(++fraction == scale)
+			{
+				fraction = 0;
+				whole++;
+			}
+		}
+
+		log_fmt_put_unsigned<10>(out, whole, "0123456789");
+
+		if(TDecimals > 0)
+		{
+			char buffer[TDecimals + 1];
+			buffer[0] = '.';
+
+			for(unsigned i = TDecimals; i > 0; i--)
+			{
+				buffer[i] = static_cast<char>('0' + fraction % 10);
+				fraction /= 10;
+			}
+
+			out.put(buffer, sizeof(buffer));
+		}
+	}
+};
+
+/// Write a conversion, then the rest of the format (TNext). TDecimals is used by %f.
+template<char TConversion, unsigned TDecimals>
+struct log_fmt_step
+{
+	template<class TNext, class TOut, typename T, typename... Rest>
+	static void emit(TOut& out, const T& value, const Rest&... rest) noexcept
+	{
+		log_fmt_put_arg<TConversion>::put(out, value);
+		TNext::emit(out, rest...);
+	}
+};
+
+template<unsigned TDecimals>
+struct log_fmt_step<'f', TDecimals>
+{
+	template<class TNext, class TOut, typename T, typename... Rest>
+	static void emit(TOut& out, const T& value, const Rest&... rest) noexcept
+	{
+		log_fmt_put_fixed<TDecimals>::put(out, static_cast<double>(value));
+		TNext::emit(out, rest...);
+	}
+};
+
+template<unsigned TDecimals>
+struct log_fmt_step<'%', TDecimals>
+{
+	template<class TNext, class TOut, typename... Args>
+	static void emit(TOut& out, const Args&... args) noexcept
+	{
+		out.put('%');
+		TNext::emit(out, args...);
+	}
+};
+
+/** Writes the format from TPos on, with the text and conversions resolved at compile time
+ *
+ * Each specialization writes the text up to the next specification as a single block, then
+ * the conversion, and then continues with the specialization for the rest of the format.
+ */
+template<class TString, size_t TPos,
+		 bool TDone = (TString::data()[log_fmt_next_spec(TString::data(), TPos)] == '\0')>
+struct log_fmt_emitter
+{
+	template<class TOut>
+	static void emit(TOut& out) noexcept
+	{
+		constexpr size_t length = log_fmt_next_spec(TString::data(), TPos) - TPos;
+
+		if(length > 0)
+		{
+			out.put(TString::data() + TPos, length);
+		}
+	}
+};
+
+template<class TString, size_t TPos>
+struct log_fmt_emitter<TString, TPos, false>
+{
+	template<class TOut, typename... Args>
+	static void emit(TOut& out, const Args&... args) noexcept
+	{
+		constexpr size_t spec = log_fmt_next_spec(TString::data(), TPos);
+		constexpr size_t conversion = log_fmt_simple_conversion_pos(TString::data(), spec);
+		constexpr unsigned decimals = log_fmt_fixed_decimals(TString::data(), spec);
+		using next = log_fmt_emitter<TString, conversion + 1>;
+
+		if(spec > TPos)
+		{
+			out.put(TString::data() + TPos, spec - TPos);
+		}
+
+		log_fmt_step<TString::data()[conversion], decimals>::template emit<next>(out, args...);
+	}
+};
+
+template<bool TSimple>
+struct log_fmt_writer
+{
+	template<class TString, class TOut, typename... Args>
+	static void write(TOut& out, const Args&... args) noexcept
+	{
+		// cppcheck-suppress wrongPrintfScanfArgNum
+		fctprintf(&TOut::putc_bounce, &out, TString::data(), args...);
+	}
+};
+
+template<>
+struct log_fmt_writer<true>
+{
+	template<class TString, class TOut, typename... Args>
+	static void write(TOut& out, const Args&... args) noexcept
+	{
+		log_fmt_emitter<TString, 0>::emit(out, args...);
+	}
+};
+
+/** Format a LOG_FMT() statement into out
+ *
+ * The arguments are checked with log_format_check(). A simple format (see log_fmt_simple())
+ * is written by the generated emitter, and any other format by fctprintf().
+ */
+template<class TString, class TOut, typename... Args>
+inline void log_format_write(TOut& out, const log_format<TString>& /*fmt*/,
+							 const Args&... args) noexcept
+{
+	log_format_check<TString, Args...>();
+	log_fmt_writer<log_fmt_simple(TString::data(), 0)>::template write<TString>(out, args...);
+}
+
+///@}
+
+#endif // LOG_FORMAT_HPP_
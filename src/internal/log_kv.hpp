@@ -0,0 +1,184 @@
+#ifndef LOG_KV_HPP_
+#define LOG_KV_HPP_
+
+#include "log_format.hpp"
+#include "log_rate_limiter.hpp"
+#include <LibPrintf.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @file log_kv.hpp
+ *
+ * Structured log records. LoggerBase::log_kv() writes a named record with key/value fields:
+ *
+ *	@code
+ *	logger.log_kv(log_level_e::info, "motor", kv("rpm", rpm), kv("amps", amps));
+ *	@endcode
+ *
+ * The record replaces the message of a log statement, after the level and custom prefixes:
+ *
+ *	<I> [1200 ms] @motor rpm=3000,amps=1.25
+ *
+ * - The record starts with '@', so it can be told apart from other statements, followed by the
+ *	record name and a space.
+ * - Fields are separated by ','. The key and value are separated by '='.
+ * - Integers and enums are written in decimal. bool is written as true or false.
+ * - Floating-point values are written by printf() with "%g".
+ * - Strings are written in double quotes. '"' and '\' are escaped with a '\'. A null string is
+ *	written as "".
+ *
+ * Names and keys are written as they are, so they should not contain spaces, ',', or '='.
+ */
+
+/// A key/value field of a structured log record. Create fields with kv().
+template<typename T>
+struct log_kv_field
+{
+	const char* key;
+	T value;
+};
+
+/** Create a field for LoggerBase::log_kv()
+ *
+ * @param key The field name. The string must stay valid until the statement is logged.
+ * @param value An integer, enum, bool, floating-point value, or string. Arrays are passed as
+ *	pointers, so a string literal is not copied.
+ */
+template<typename T>
+constexpr log_kv_field<T> kv(const char* key, T value) noexcept
+{
+	return log_kv_field<T>{key, value};
+}
+
+/// The name of a structured record, passed to the logger in place of a format string
+struct log_kv_record
+{
+	const char* name;
+
+	/// The name identifies the call site, e.g. for LOG_RATE_LIMIT_EN
+	constexpr operator const char*() const noexcept
+	{
+		return name;
+	}
+};
+
+/// Fields are hashed by their values (see log_hash_args()), so padding is not hashed
+template<typename T>
+inline uint32_t log_hash_arg(uint32_t hash, const log_kv_field<T>& field) noexcept
+{
+	return log_hash_arg(hash, field.value);
+}
+
+/// Writes a field value. Specialized on the value kind, as described by log_fmt_arg.
+template<char TKind>
+struct log_kv_put_value
+{
+	static_assert(TKind != 'p', "log_kv: pointers are not supported, use the pointed-to value");
+	static_assert(TKind != '?', "log_kv: unsupported field type");
+};
+
+template<>
+struct log_kv_put_value<'i'>
+{
+	template<class TOut, typename T>
+	static void put(TOut& out, const T& value) noexcept
+	{
+		if(static_cast<T>(-1) < static_cast<T>(0))
+		{
+			log_fmt_put_arg<'d'>::put(out, value);
+		}
+		else
+		{
+			log_fmt_put_arg<'u'>::put(out, value);
+		}
+	}
+
+	template<class TOut>
+	static void put(TOut& out, bool value) noexcept
+	{
+		if(value)
+		{
+			out.put("true", 4);
+		}
+		else
+		{
+			out.put("false", 5);
+		}
+	}
+};
+
+template<>
+struct log_kv_put_value<'f'>
+{
+	template<class TOut, typename T>
+	static void put(TOut& out, const T& value) noexcept
+	{
+		fctprintf(&TOut::putc_bounce, &out, "%g", static_cast<double>(value));
+	}
+};
+
+template<>
+struct log_kv_put_value<'s'>
+{
+	template<class TOut>
+	static void put(TOut& out, const char* str) noexcept
+	{
+		out.put('"');
+
+		if(str != nullptr)
+		{
+			const char* run = str;
+
+			for(; *str != '\0'; str++)
+			{
+				if(*str == '"' || *str == '\\')
+				{
+					out.put(run, static_cast<size_t>(str - run));
+					out.put('\\');
+					run = str;
+				}
+			}
+
+			out.put(run, static_cast<size_t>(str - run));
+		}
+
+		out.put('"');
+	}
+};
+
+template<class TOut>
+inline void log_kv_write_fields(TOut& out, char separator) noexcept
+{
+	static_cast<void>(separator);
+	out.put('\n');
+}
+
+template<class TOut, typename T, typename... Rest>
+inline void log_kv_write_fields(TOut& out, char separator, const log_kv_field<T>& field,
+								const log_kv_field<Rest>&... rest) noexcept
+{
+	out.put(separator);
+	out.put(field.key, strlen(field.key));
+	out.put('=');
+	log_kv_put_value<log_fmt_arg<T>::kind>::put(out, field.value);
+	log_kv_write_fields(out, ',', rest...);
+}
+
+/** Write a structured record (see log_kv.hpp)
+ *
+ * @param out The output. Must provide put(char), put(const char*, size_t), and a static
+ *	putc_bounce(char, void*) function, like LogRecordBuilder.
+ * @param record The record name.
+ * @param fields The fields, created with kv().
+ */
+template<class TOut, typename... Fields>
+inline void log_kv_write(TOut& out, log_kv_record record,
+						 const log_kv_field<Fields>&... fields) noexcept
+{
+	out.put('@');
+	out.put(record.name, strlen(record.name));
+	log_kv_write_fields(out, ' ', fields...);
+}
+
+#endif // LOG_KV_HPP_
@@ -0,0 +1,345 @@
+#ifndef LOG_QUERY_HPP_
+#define LOG_QUERY_HPP_
+
+#include "circular_buffer.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** @file log_query.hpp
+ *
+ * Read-only queries over the statements in a RecordCircularBuffer. The buffer keeps the length
+ * of each statement, so a query steps over whole statements instead of scanning the text, and
+ * nothing is removed from the buffer:
+ *
+ *	@code
+ *	// Send the last 5 errors (and critical statements) to the console
+ *	logger.query().tail(5, log_query_filter(log_level_e::error),
+ *						[](const log_record_view& record) { record.write_to(Serial); });
+ *	@endcode
+ *
+ * Each statement must be added as a single record, so set LOG_RECORD_FRAMING_EN when using a
+ * RecordCircularBuffer (see record_circular_buffer.hpp).
+ *
+ * This file does not depend on the Arduino SDK.
+ */
+
+/// A record in a circular buffer. The text may wrap around the end of the storage.
+struct log_record_view
+{
+	/// The text of the record. second is empty unless the record wraps around.
+	buffer_spans<char> text;
+
+	size_t size() const noexcept
+	{
+		return text.size();
+	}
+
+	/// The character at index i, which must be < size()
+	char operator[](size_t i) const noexcept
+	{
+		return (i < text.first.size) ? text.first.data[i] : text.second.data[i - text.first.size];
+	}
+
+	/** Copy the text of the record
+	 *
+	 * @param dst The destination. No NUL is written.
+	 * @param count The size of the destination.
+	 * @returns The number of characters copied: the smaller of size() and count.
+	 */
+	size_t copy(char* dst, size_t count) const noexcept
+	{
+		size_t first = (count < text.first.size) ? count : text.first.size;
+		size_t second = (count - first < text.second.size) ? count - first : text.second.size;
+
+		memcpy(dst, text.first.data, first);
+		memcpy(dst + first, text.second.data, second);
+
+		return first + second;
+	}
+
+	/// Returns true if the text at offset starts with str
+	bool matches_at(size_t offset, const char* str) const noexcept
+	{
+		for(; *str != '\0'; str++, offset++)
+		{
+			if(offset >= size() || (*this)[offset] != *str)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// Returns true if the text contains str
+	bool contains(const char* str) const noexcept
+	{
+		size_t length = strlen(str);
+
+		for(size_t offset = 0; offset + length <= size(); offset++)
+		{
+			if(matches_at(offset, str))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/** Write the record to a sink (see log_sink.hpp), with at most two write() calls
+	 *
+	 * @returns The number of bytes written.
+	 */
+	template<class TSink>
+	size_t write_to(TSink& sink) const
+	{
+		size_t written = 0;
+
+		if(text.first.size > 0)
+		{
+			written = sink.write(text.first.data, text.first.size);
+		}
+
+		if(written == text.first.size && text.second.size > 0)
+		{
+			written += sink.write(text.second.data, text.second.size);
+		}
+
+		return written;
+	}
+};
+
+/// Selects the records visited by LogQuery::tail()
+struct log_query_filter
+{
+	/** Create a filter
+	 *
+	 * @param level Records with a higher (less severe) level are skipped. Records without a
+	 *	level prefix, such as print() output, have level 0 and are never skipped by level.
+	 * @param str Records which do not contain this text are skipped, e.g. a module tag, or a
+	 *	file name from TRACE_FMT(). nullptr matches every record.
+	 */
+	constexpr log_query_filter(unsigned level = UINT8_MAX, const char* str = nullptr) noexcept
+		: max_level(level), text(str)
+	{
+	}
+
+	unsigned max_level;
+	const char* text;
+};
+
+/** Read-only queries over the records in a buffer
+ *
+ * Records are numbered from the oldest (0) to the newest (count() - 1). Finding a record walks
+ * the record lengths, without reading the text.
+ *
+ * The query refers to the buffer, and must not be used after records are added or removed.
+ *
+ * @tparam TBuffer The buffer type. Must provide records(), record_size(), size(), and
+ *	peek_contiguous(), like RecordCircularBuffer.
+ */
+template<class TBuffer>
+class LogQuery
+{
+  public:
+	/** Create a query
+	 *
+	 * @param buffer The buffer to query.
+	 * @param level_prefixes The level prefix of each level, indexed by level, such as the
+	 *	LOG_LEVEL_SHORT_NAMES. The prefix of level 0 (off) is not used.
+	 * @param level_count The number of entries in level_prefixes.
+	 */
+	LogQuery(const TBuffer& buffer, const char* const* level_prefixes,
+			 size_t level_count) noexcept
+		: buffer_(buffer), level_prefixes_(level_prefixes), level_count_(level_count)
+	{
+	}
+
+	/// The number of records in the buffer. The oldest may have been written out in part.
+	size_t count() const noexcept
+	{
+		return buffer_.records();
+	}
+
+	/// The record with index i, which must be < count()
+	log_record_view record(size_t i) const noexcept
+	{
+		size_t offset = 0;
+
+		for(size_t n = 0; n < i; n++)
+		{
+			offset += buffer_.record_size(n);
+		}
+
+		return view(offset, buffer_.record_size(i));
+	}
+
+	/// The level of a record, from its level prefix, or 0 if it has none
+	unsigned level(const log_record_view& record) const noexcept
+	{
+		for(unsigned l = 1; l < level_count_; l++)
+		{
+			if(record.matches_at(0, level_prefixes_[l]))
+			{
+				return l;
+			}
+		}
+
+		return 0;
+	}
+
+	/** Read the timestamp of a record
+	 *
+	 * The timestamp is read from a prefix such as "[123 ms] " after the level prefix, as
+	 * written by the timestamp prefix of the strategies.
+	 *
+	 * @param record The record.
+	 * @param value Set to the timestamp, in the units of the prefix.
+	 * @returns false if the record has no timestamp, or has a delta timestamp ("[+250 us] ").
+	 */
+	bool timestamp(const log_record_view& record, uint32_t& value) const noexcept
+	{
+		unsigned l = level(record);
+		size_t i = (l > 0) ? strlen(level_prefixes_[l]) : 0;
+
+		if(i >= record.size() || record[i] != '[')
+		{
+			return false;
+		}
+
+		uint32_t number = 0;
+		size_t digits = 0;
+
+		for(i++; i < record.size() && record[i] >= '0' && record[i] <= '9'; i++, digits++)
+		{
+			number = number * 10 + static_cast<uint32_t>(record[i] - '0');
+		}
+
+		if(digits == 0 || i >= record.size() || record[i] != ' ')
+		{
+			return false;
+		}
+
+		value = number;
+		return true;
+	}
+
+	/// Returns true if the record is selected by the filter
+	bool matches(const log_record_view& record, const log_query_filter& filter) const noexcept
+	{
+		return level(record) <= filter.max_level &&
+			   (filter.text == nullptr || record.contains(filter.text));
+	}
+
+	/** Visit the newest records which match a filter, oldest first
+	 *
+	 *	@code
+	 *	query.tail(10, log_query_filter(log_level_e::warning, "[imu]"),
+	 *			   [](const log_record_view& record) { record.write_to(Serial); });
+	 *	@endcode
+	 *
+	 * @param n The maximum number of records to visit.
+	 * @param filter Selects the records.
+	 * @param fn Called as fn(const log_record_view&) for each record.
+	 * @returns The number of records visited.
+	 */
+	template<class TFn>
+	size_t tail(size_t n, const log_query_filter& filter, TFn fn) const
+	{
+		// Walk back from the newest record to find the first one to visit
+		size_t first = count();
+		size_t first_offset = buffer_.size();
+		size_t offset = buffer_.size();
+		size_t found = 0;
+
+		for(size_t i = count(); i > 0 && found < n; i--)
+		{
+			size_t length = buffer_.record_size(i - 1);
+			offset -= length;
+
+			if(matches(view(offset, length), filter))
+			{
+				found++;
+				first = i - 1;
+				first_offset = offset;
+			}
+		}
+
+		offset = first_offset;
+
+		for(size_t i = first, visited = 0; i < count() && visited < found; i++)
+		{
+			size_t length = buffer_.record_size(i);
+			log_record_view record = view(offset, length);
+
+			if(matches(record, filter))
+			{
+				fn(record);
+				visited++;
+			}
+
+			offset += length;
+		}
+
+		return found;
+	}
+
+	/** Find the first record which is newer than a time
+	 *
+	 * Records without a timestamp (see timestamp()) are skipped.
+	 *
+	 * @param time The time, in the units of the timestamp prefix.
+	 * @returns The index of the first record with a timestamp greater than time, or count() if
+	 *	there is none.
+	 */
+	size_t find_newer(uint32_t time) const noexcept
+	{
+		size_t offset = 0;
+
+		for(size_t i = 0; i < count(); i++)
+		{
+			size_t length = buffer_.record_size(i);
+			uint32_t value;
+
+			if(timestamp(view(offset, length), value) && value > time)
+			{
+				return i;
+			}
+
+			offset += length;
+		}
+
+		return count();
+	}
+
+  private:
+	/// The record of the given length, offset elements after the front of the buffer
+	log_record_view view(size_t offset, size_t length) const noexcept
+	{
+		buffer_spans<char> data = buffer_.peek_contiguous();
+		log_record_view record;
+
+		if(offset < data.first.size)
+		{
+			size_t first = data.first.size - offset;
+			first = (first < length) ? first : length;
+			record.text.first = {data.first.data + offset, first};
+			record.text.second = {data.second.data, length - first};
+		}
+		else
+		{
+			record.text.first = {data.second.data + (offset - data.first.size), length};
+			record.text.second = {data.second.data, 0};
+		}
+
+		return record;
+	}
+
+	const TBuffer& buffer_;
+	const char* const* level_prefixes_;
+	size_t level_count_;
+};
+
+#endif // LOG_QUERY_HPP_
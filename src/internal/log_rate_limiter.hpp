@@ -0,0 +1,326 @@
+#ifndef LOG_RATE_LIMITER_HPP_
+#define LOG_RATE_LIMITER_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOG_RATE_LIMIT_BURST
+/// The number of statements a call site may log at once before the rate limit applies
+#define LOG_RATE_LIMIT_BURST 10
+#endif
+
+#ifndef LOG_RATE_LIMIT_INTERVAL
+/// Once a call site has used its burst, it may log one statement per interval, in milliseconds
+#define LOG_RATE_LIMIT_INTERVAL 100
+#endif
+
+/// A count of statements which were not logged, and the call site they came from
+struct log_suppressed_site
+{
+	/// The format string of the call site
+	const char* key;
+	/// The level of the last statement which was not logged
+	uint8_t level;
+	/// The number of statements which were not logged
+	uint32_t count;
+};
+
+/** Hash a log argument for LogRateLimiter::admit()
+ *
+ * Values are hashed by their bytes (FNV-1a). Strings are hashed by their contents, so the same
+ * buffer with different text is a different statement.
+ */
+template<class T>
+inline uint32_t log_hash_arg(uint32_t hash, const T& value) noexcept
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+
+	for(size_t i = 0; i < sizeof(T); i++)
+	{
+		hash = (hash ^ bytes[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+inline uint32_t log_hash_arg(uint32_t hash, const char* str) noexcept
+{
+	for(; str && *str; str++)
+	{
+		hash = (hash ^ static_cast<unsigned char>(*str)) * 16777619U;
+	}
+
+	return hash;
+}
+
+inline uint32_t log_hash_arg(uint32_t hash, char* str) noexcept
+{
+	return log_hash_arg(hash, static_cast<const char*>(str));
+}
+
+inline uint32_t log_hash_args_(uint32_t hash) noexcept
+{
+	return hash;
+}
+
+template<class T, class... Rest>
+inline uint32_t log_hash_args_(uint32_t hash, const T& first, const Rest&... rest) noexcept
+{
+	return log_hash_args_(log_hash_arg(hash, first), rest...);
+}
+
+/// Hash the arguments of a log statement, so repeats can be detected without formatting them
+template<class... Args>
+inline uint32_t log_hash_args(const Args&... args) noexcept
+{
+	return log_hash_args_(2166136261U, args...);
+}
+
+/** Rate limiting and duplicate suppression for log call sites
+ *
+ * A single failing sensor can make one call site log thousands of times a second, which fills
+ * the log buffer, forces back-to-back flushes, and evicts everything useful. admit() decides
+ * whether a statement is logged, before it is formatted:
+ *
+ * - A statement with the same call site and arguments as the previous admitted statement is a
+ *	repeat. Repeats are counted instead of logged, and the count is reported as
+ *	"last message repeated N times" when a different statement is logged, or at the next flush.
+ * - Each call site has a token bucket. A site may log `burst` statements at once, and then one
+ *	statement per `interval`. Statements beyond that are counted, and reported at the next
+ *	flush.
+ *
+ * Call sites are identified by their format string pointer, and are kept in a table of TSites
+ * entries, indexed by the pointer. Sites which share an entry evict each other, so a busy site
+ * may see a fresh bucket. An entry with an unreported count is not evicted: the other site is
+ * not limited until the count is reported.
+ *
+ * When the limit is not hit, admit() costs a table lookup, a subtraction, and a compare, plus
+ * hashing the arguments.
+ *
+ * This class is not safe to use from more than one context. It does not depend on the Arduino
+ * SDK.
+ *
+ * @tparam TSites The number of call sites which are limited independently. Must be a power of
+ *	two.
+ */
+template<size_t TSites>
+class LogRateLimiter
+{
+	static_assert(TSites > 0 && (TSites & (TSites - 1)) == 0,
+				  "LogRateLimiter site count must be a power of two");
+
+  public:
+	LogRateLimiter() = default;
+
+	/** Set the rate limit
+	 *
+	 * @param burst The number of statements a call site may log at once. 0 disables the rate
+	 *	limit.
+	 * @param interval Once a site has used its burst, it may log one statement per interval.
+	 *	The unit is that of the clock passed to admit(). 0 disables the rate limit.
+	 */
+	void limit(uint16_t burst, uint32_t interval) noexcept
+	{
+		burst_ = burst;
+		interval_ = interval;
+
+		for(size_t i = 0; i < TSites; i++)
+		{
+			sites_[i].tokens = burst;
+		}
+	}
+
+	uint16_t burst() const noexcept
+	{
+		return burst_;
+	}
+
+	uint32_t interval() const noexcept
+	{
+		return interval_;
+	}
+
+	/// Enable or disable duplicate suppression
+	void collapse_repeats(bool enabled) noexcept
+	{
+		collapse_ = enabled;
+	}
+
+	bool collapse_repeats() const noexcept
+	{
+		return collapse_;
+	}
+
+	/** Decide whether a statement is logged
+	 *
+	 * When this returns true, call take_repeats() before logging the statement, to report the
+	 * repeats of the previous statement.
+	 *
+	 * @param key The call site (its format string).
+	 * @param level The level of the statement.
+	 * @param args_hash The hash of the statement's arguments (see log_hash_args()).
+	 * @param now The current time. Only used by the rate limit.
+	 * @returns true if the statement should be logged.
+	 */
+	bool admit(const char* key, uint8_t level, uint32_t args_hash, uint32_t now) noexcept
+	{
+		if(collapse_ && key == last_.key && args_hash == last_hash_)
+		{
+			last_.level = level;
+			last_.count++;
+			return false;
+		}
+
+		if(burst_ > 0 && interval_ > 0 && !take_token(key, level, now))
+		{
+			return false;
+		}
+
+		if(collapse_)
+		{
+			if(last_.count > 0)
+			{
+				previous_ = last_;
+			}
+
+			last_.key = key;
+			last_.level = level;
+			last_.count = 0;
+			last_hash_ = args_hash;
+		}
+
+		return true;
+	}
+
+	/** Take the unreported count of repeated statements
+	 *
+	 * @param[out] site The repeated statement, and the number of repeats.
+	 * @returns true if there were repeats to report. The count is cleared.
+	 */
+	bool take_repeats(log_suppressed_site& site) noexcept
+	{
+		log_suppressed_site& source = (previous_.count > 0) ? previous_ : last_;
+
+		if(source.count == 0)
+		{
+			return false;
+		}
+
+		site = source;
+		source.count = 0;
+		return true;
+	}
+
+	/** Take the unreported count of a call site which hit the rate limit
+	 *
+	 * Call this until it returns false to report every site.
+	 *
+	 * @param[out] site The call site, and the number of statements which were not logged.
+	 * @returns true if there was a count to report. The count is cleared.
+	 */
+	bool take_suppressed(log_suppressed_site& site) noexcept
+	{
+		for(size_t i = 0; i < TSites; i++)
+		{
+			if(sites_[i].suppressed > 0)
+			{
+				site.key = sites_[i].key;
+				site.level = sites_[i].level;
+				site.count = sites_[i].suppressed;
+				sites_[i].suppressed = 0;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// Forget every call site and unreported count. The settings are kept.
+	void reset() noexcept
+	{
+		for(size_t i = 0; i < TSites; i++)
+		{
+			sites_[i] = site_state();
+		}
+
+		last_ = log_suppressed_site();
+		previous_ = log_suppressed_site();
+		last_hash_ = 0;
+	}
+
+  private:
+	struct site_state
+	{
+		const char* key = nullptr;
+		uint32_t refilled = 0;
+		uint32_t suppressed = 0;
+		uint16_t tokens = 0;
+		uint8_t level = 0;
+	};
+
+	static size_t slot(const char* key) noexcept
+	{
+		uintptr_t value = reinterpret_cast<uintptr_t>(key);
+		return static_cast<size_t>(value ^ (value >> 7)) & (TSites - 1);
+	}
+
+	/// Take a token from the call site's bucket, after refilling it for the time elapsed
+	bool take_token(const char* key, uint8_t level, uint32_t now) noexcept
+	{
+		site_state& site = sites_[slot(key)];
+
+		if(site.key != key)
+		{
+			if(site.suppressed > 0)
+			{
+				return true;
+			}
+
+			site.key = key;
+			site.tokens = burst_;
+			site.refilled = now;
+		}
+
+		uint32_t elapsed = now - site.refilled;
+
+		if(elapsed >= interval_)
+		{
+			uint32_t credits = elapsed / interval_;
+
+			if(credits >= static_cast<uint32_t>(burst_ - site.tokens))
+			{
+				site.tokens = burst_;
+				site.refilled = now;
+			}
+			else
+			{
+				site.tokens = static_cast<uint16_t>(site.tokens + credits);
+				site.refilled += credits * interval_;
+			}
+		}
+
+		if(site.tokens > 0)
+		{
+			site.tokens--;
+			return true;
+		}
+
+		site.level = level;
+		site.suppressed++;
+		return false;
+	}
+
+	uint16_t burst_ = LOG_RATE_LIMIT_BURST;
+	uint32_t interval_ = LOG_RATE_LIMIT_INTERVAL;
+	bool collapse_ = true;
+
+	site_state sites_[TSites];
+
+	/// The last admitted statement, and the number of times it was repeated
+	log_suppressed_site last_ = {nullptr, 0, 0};
+	uint32_t last_hash_ = 0;
+	/// The repeats of the statement before last_, which were not yet reported
+	log_suppressed_site previous_ = {nullptr, 0, 0};
+};
+
+#endif // LOG_RATE_LIMITER_HPP_
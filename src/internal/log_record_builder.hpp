@@ -0,0 +1,94 @@
+#ifndef LOG_RECORD_BUILDER_HPP_
+#define LOG_RECORD_BUILDER_HPP_
+
+#include <stddef.h>
+#include <string.h>
+
+/** Assembles a log statement before it is added to the log
+ *
+ * The logger writes the level prefix, custom prefix, and formatted message into the record,
+ * and then hands the record to the strategy in a single call. The record lives on the stack of
+ * the logging thread, so threads do not share it.
+ *
+ * A statement which is longer than the record is truncated. The last character is then replaced
+ * with a newline, so the next statement still starts on its own line.
+ *
+ * This class does not depend on the Arduino SDK.
+ *
+ * @tparam TSize The maximum record length, in characters.
+ */
+template<size_t TSize>
+class LogRecordBuilder
+{
+	static_assert(TSize > 0, "LogRecordBuilder size must be non-zero");
+
+  public:
+	LogRecordBuilder() = default;
+
+	/// Append a character. Characters which do not fit are dropped.
+	void put(char c) noexcept
+	{
+		if(size_ < TSize)
+		{
+			data_[size_++] = c;
+		}
+		else
+		{
+			truncated_ = true;
+		}
+	}
+
+	/// Append a block of characters. Characters which do not fit are dropped.
+	void put(const char* str, size_t len) noexcept
+	{
+		size_t space = TSize - size_;
+
+		if(len > space)
+		{
+			len = space;
+			truncated_ = true;
+		}
+
+		memcpy(&data_[size_], str, len);
+		size_ += len;
+	}
+
+	/** The assembled record
+	 *
+	 * @post If the record was truncated, its last character is a newline.
+	 */
+	const char* data() noexcept
+	{
+		if(truncated_)
+		{
+			data_[TSize - 1] = '\n';
+		}
+
+		return data_;
+	}
+
+	/// The length of the record, in characters
+	size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	/// Returns true if characters were dropped because the record was full
+	bool truncated() const noexcept
+	{
+		return truncated_;
+	}
+
+	/// The per-character output function for fctprintf(). `record` is the LogRecordBuilder.
+	static void putc_bounce(char c, void* record) noexcept
+	{
+		static_cast<LogRecordBuilder*>(record)->put(c);
+	}
+
+  private:
+	char data_[TSize];
+	size_t size_ = 0;
+	bool truncated_ = false;
+};
+
+#endif // LOG_RECORD_BUILDER_HPP_
@@ -0,0 +1,194 @@
+#ifndef LOG_ROTATION_HPP_
+#define LOG_ROTATION_HPP_
+
+#include "timestamp_prefix.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LOG_ROTATE_SIZE_DEFAULT
+/// The rotational loggers start a new file once the current file reaches this many bytes.
+/// 0 disables size-based rotation.
+#define LOG_ROTATE_SIZE_DEFAULT 0
+#endif
+
+#ifndef LOG_ROTATE_INTERVAL_MS_DEFAULT
+/// The rotational loggers start a new file once the current file has been in use for this
+/// many milliseconds. 0 disables time-based rotation.
+#define LOG_ROTATE_INTERVAL_MS_DEFAULT 0
+#endif
+
+#ifndef LOG_RETENTION_SIZE_DEFAULT
+/// The rotational loggers delete the oldest log files once the log files on the SD card take
+/// up more than this many bytes. 0 keeps all files.
+#define LOG_RETENTION_SIZE_DEFAULT 0
+#endif
+
+/// The prefix of rotational log file names, which are `log_<index><extension>`
+static constexpr const char* log_filename_prefix = "log_";
+
+/// The size of a buffer which can hold any log file name with an extension of up to 4
+/// characters (e.g., "log_4294967295.txt"), including the NUL terminator
+static constexpr size_t log_filename_max_size = 19;
+
+/** Format a rotational log file name
+ *
+ * @param dst The destination. Must hold log_filename_max_size characters.
+ * @param index The file index.
+ * @param extension The file extension, including the '.', of up to 4 characters.
+ * @returns The length of the name, excluding the NUL terminator.
+ */
+inline size_t format_log_filename(char* dst, uint32_t index, const char* extension) noexcept
+{
+	size_t len = strlen(log_filename_prefix);
+	memcpy(dst, log_filename_prefix, len);
+	len += log_u32_to_dec(&dst[len], index);
+
+	size_t extension_len = strlen(extension);
+	memcpy(&dst[len], extension, extension_len + 1);
+
+	return len + extension_len;
+}
+
+/** Parse the index from a rotational log file name
+ *
+ * @param name The file name.
+ * @param extension The expected file extension, including the '.'.
+ * @param index Receives the index if the name matches.
+ * @returns true if name is `log_<index><extension>`, and the index fits in 32 bits.
+ */
+inline bool parse_log_filename(const char* name, const char* extension, uint32_t& index) noexcept
+{
+	size_t prefix_len = strlen(log_filename_prefix);
+
+	if(strncmp(name, log_filename_prefix, prefix_len) != 0)
+	{
+		return false;
+	}
+
+	const char* digits = &name[prefix_len];
+	uint64_t value = 0;
+	size_t count = 0;
+
+	for(; digits[count] >= '0' && digits[count] <= '9'; count++)
+	{
+		value = value * 10 + static_cast<uint64_t>(digits[count] - '0');
+
+		if(value > UINT32_MAX)
+		{
+			return false;
+		}
+	}
+
+	if(count == 0 || strcmp(&digits[count], extension) != 0)
+	{
+		return false;
+	}
+
+	index = static_cast<uint32_t>(value);
+	return true;
+}
+
+/** Decides when a rotational logger starts a new log file
+ *
+ * Without rotation, each boot writes a single file, which grows for as long as the device
+ * runs. Appends get slower as the cluster chain grows, and a single large file is awkward to
+ * retrieve. With a size or interval limit, the logger closes the file and starts the next one
+ * during an explicit flush() or poll(). When log() flushes the buffer (an auto-flush, or the
+ * flush of a critical statement), the rotation is deferred to the next explicit flush, so it
+ * adds no latency to log(). A file may therefore grow past max_size() until then.
+ *
+ * The current time is supplied by the caller, so this class does not depend on the Arduino SDK.
+ */
+class LogRotationPolicy
+{
+  public:
+	LogRotationPolicy() = default;
+
+	/// The file size at which a new file is started, in bytes
+	uint64_t max_size() const noexcept
+	{
+		return max_size_;
+	}
+
+	/** Set the file size at which a new file is started
+	 *
+	 * @param bytes Rotate once the current file holds at least this many bytes.
+	 *	0 disables size-based rotation.
+	 */
+	void max_size(uint64_t bytes) noexcept
+	{
+		max_size_ = bytes;
+	}
+
+	/// The time after which a new file is started, in milliseconds
+	uint32_t interval() const noexcept
+	{
+		return interval_;
+	}
+
+	/** Set the time after which a new file is started
+	 *
+	 * @param ms Rotate once the current file has been in use for this many milliseconds.
+	 *	0 disables time-based rotation.
+	 */
+	void interval(uint32_t ms) noexcept
+	{
+		interval_ = ms;
+	}
+
+	/// The total size of the log files to keep, in bytes
+	uint64_t retention() const noexcept
+	{
+		return retention_;
+	}
+
+	/** Set the total size of the log files to keep
+	 *
+	 * When a new file is started, the oldest log files are deleted until the log files
+	 * (including the new file) take up no more than this many bytes.
+	 *
+	 * @param bytes The storage budget for the log files. 0 keeps all files.
+	 */
+	void retention(uint64_t bytes) noexcept
+	{
+		retention_ = bytes;
+	}
+
+	/// The number of bytes written to the current file
+	uint64_t file_size() const noexcept
+	{
+		return file_size_;
+	}
+
+	/** Record data written to the current file
+	 *
+	 * @param bytes The number of bytes written.
+	 * @param now The current time, in milliseconds.
+	 * @returns true if a new file should be started now.
+	 */
+	bool wrote(size_t bytes, uint32_t now) noexcept
+	{
+		file_size_ += bytes;
+
+		return file_size_ > 0 &&
+			   ((max_size_ > 0 && file_size_ >= max_size_) ||
+				(interval_ > 0 && static_cast<uint32_t>(now - started_) >= interval_));
+	}
+
+	/// Record that a new file was started at time now
+	void rotated(uint32_t now) noexcept
+	{
+		file_size_ = 0;
+		started_ = now;
+	}
+
+  private:
+	uint64_t max_size_ = LOG_ROTATE_SIZE_DEFAULT;
+	uint64_t retention_ = LOG_RETENTION_SIZE_DEFAULT;
+	uint64_t file_size_ = 0;
+	uint32_t interval_ = LOG_ROTATE_INTERVAL_MS_DEFAULT;
+	uint32_t started_ = 0;
+};
+
+#endif // LOG_ROTATION_HPP_
@@ -0,0 +1,143 @@
+#ifndef LOG_SINK_HPP_
+#define LOG_SINK_HPP_
+
+#include "circular_buffer.hpp"
+#include <stddef.h>
+
+/** @file log_sink.hpp
+ *
+ * A log sink is any type which provides:
+ *
+ *	@code
+ *	size_t write(const char* data, size_t size);
+ *	@endcode
+ *
+ * write() returns the number of bytes accepted, which may be less than size if the sink is
+ * busy. Arduino Print objects (e.g., Serial) and SdFat files are sinks, and so is a wrapper
+ * around a UART DMA or USB bulk transfer.
+ *
+ * The helpers below pass the contents of a circular buffer to a sink straight from the buffer
+ * storage (see CircularBuffer::peek_contiguous()), with at most two write() calls.
+ */
+
+/** Write data from the front of a circular buffer to a sink
+ *
+ * The data is not removed from the buffer. If the sink accepts less than the first span, the
+ * second span is not written.
+ *
+ * @param sink The destination.
+ * @param buffer The source buffer.
+ * @param count The number of bytes to write. Must be <= buffer.size().
+ * @returns The number of bytes written.
+ */
+template<class TSink, class TBuffer>
+size_t write_to_sink(TSink& sink, const TBuffer& buffer, size_t count)
+{
+	buffer_spans<char> spans = buffer.peek_contiguous();
+	size_t written = 0;
+
+	if(spans.first.size > count)
+	{
+		spans.first.size = count;
+	}
+
+	if(spans.first.size > 0)
+	{
+		written = sink.write(spans.first.data, spans.first.size);
+	}
+
+	if(written == spans.first.size && count > written)
+	{
+		written += sink.write(spans.second.data, count - written);
+	}
+
+	return written;
+}
+
+/** Write the contents of a circular buffer to a sink, and remove the data that was written
+ *
+ * @param sink The destination.
+ * @param buffer The source buffer.
+ * @returns The number of bytes written. Data which the sink did not accept stays in the buffer.
+ */
+template<class TSink, class TBuffer>
+size_t drain_to_sink(TSink& sink, TBuffer& buffer)
+{
+	size_t written = write_to_sink(sink, buffer, buffer.size());
+	buffer.consume(written);
+
+	return written;
+}
+
+/** A reference to a sink, selected at run time
+ *
+ * Strategies which let the user choose their output store one of these, so the strategy type
+ * does not depend on the sink type. The referenced sink must outlive the log_sink_ref.
+ */
+class log_sink_ref
+{
+  public:
+	/// An empty reference, which does not refer to a sink
+	log_sink_ref() = default;
+
+	/// Refer to a sink. write() is passed through unchanged.
+	template<class TSink>
+	explicit log_sink_ref(TSink& sink) noexcept : context_(&sink), write_(&sink_write<TSink>)
+	{
+	}
+
+	/** Refer to a serial port, and only write what it can accept without blocking
+	 *
+	 * Each write() is limited to serial.availableForWrite() bytes, so a write never waits for
+	 * the port to transmit. The serial type must also provide write(const char*, size_t), as
+	 * Arduino Print objects do.
+	 */
+	template<class TSerial>
+	static log_sink_ref nonblocking(TSerial& serial) noexcept
+	{
+		log_sink_ref ref;
+		ref.context_ = &serial;
+		ref.write_ = &nonblocking_write<TSerial>;
+		return ref;
+	}
+
+	/// Returns true if this refers to a sink
+	bool valid() const noexcept
+	{
+		return write_ != nullptr;
+	}
+
+	size_t write(const char* data, size_t size) noexcept
+	{
+		return write_(context_, data, size);
+	}
+
+  private:
+	using write_fn = size_t (*)(void* context, const char* data, size_t size);
+
+	template<class TSink>
+	static size_t sink_write(void* context, const char* data, size_t size) noexcept
+	{
+		return static_cast<TSink*>(context)->write(data, size);
+	}
+
+	template<class TSerial>
+	static size_t nonblocking_write(void* context, const char* data, size_t size) noexcept
+	{
+		TSerial* serial = static_cast<TSerial*>(context);
+		int available = serial->availableForWrite();
+
+		if(available <= 0)
+		{
+			return 0;
+		}
+
+		size = (size > static_cast<size_t>(available)) ? static_cast<size_t>(available) : size;
+		return serial->write(data, size);
+	}
+
+	void* context_ = nullptr;
+	write_fn write_ = nullptr;
+};
+
+#endif // LOG_SINK_HPP_
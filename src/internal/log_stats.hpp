@@ -0,0 +1,194 @@
+#ifndef LOG_STATS_HPP_
+#define LOG_STATS_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The number of statements and bytes logged at one level, or by one module
+struct log_record_stats
+{
+	/// The number of log statements
+	uint32_t records = 0;
+	/// The number of bytes logged by those statements, including the prefixes
+	uint32_t bytes = 0;
+
+	/// Record a statement of `size` bytes
+	void add(size_t size) noexcept
+	{
+		records++;
+		bytes += static_cast<uint32_t>(size);
+	}
+};
+
+/// The minimum, average, and maximum of a series of durations, in microseconds
+class log_duration_stats
+{
+  public:
+	/// The number of durations recorded
+	uint32_t count() const noexcept
+	{
+		return count_;
+	}
+
+	/// The shortest duration, or 0 if none has been recorded
+	uint32_t min() const noexcept
+	{
+		return count_ ? min_ : 0;
+	}
+
+	/// The longest duration
+	uint32_t max() const noexcept
+	{
+		return max_;
+	}
+
+	/// The average duration, or 0 if none has been recorded
+	uint32_t average() const noexcept
+	{
+		return count_ ? static_cast<uint32_t>(total_ / count_) : 0;
+	}
+
+	/// Record a duration
+	void add(uint32_t us) noexcept
+	{
+		count_++;
+		total_ += us;
+		min_ = (us < min_) ? us : min_;
+		max_ = (us > max_) ? us : max_;
+	}
+
+  private:
+	uint64_t total_ = 0;
+	uint32_t count_ = 0;
+	uint32_t min_ = UINT32_MAX;
+	uint32_t max_ = 0;
+};
+
+/** Counters which describe how a logger is used
+ *
+ * The counters are meant for sizing the log buffer and tuning the flush policy from real
+ * data: how much each level logs, how full the buffer gets between flushes, how much data is
+ * lost to overruns, and how long flushes and storage writes take.
+ *
+ * The logger updates the counters when LOG_STATS_EN is set (see LoggerBase::stats()).
+ * Durations are measured by the caller, so this class does not depend on the Arduino SDK.
+ *
+ * @tparam TLevelCount The number of log levels.
+ */
+template<size_t TLevelCount>
+class LogStats
+{
+  public:
+	LogStats() = default;
+
+	/// The statements logged at level `l`
+	const log_record_stats& level(size_t l) const noexcept
+	{
+		return levels_[l];
+	}
+
+	/// The number of statements logged at all levels
+	uint32_t records() const noexcept
+	{
+		uint32_t total = 0;
+
+		for(size_t i = 0; i < TLevelCount; i++)
+		{
+			total += levels_[i].records;
+		}
+
+		return total;
+	}
+
+	/// The number of bytes written to the log, including data written with print() and write()
+	uint64_t bytes() const noexcept
+	{
+		return bytes_;
+	}
+
+	/// The number of bytes which were overwritten or discarded because the buffer was full
+	uint64_t dropped() const noexcept
+	{
+		return dropped_;
+	}
+
+	/// The largest amount of data held in the internal buffer, in bytes
+	size_t high_water() const noexcept
+	{
+		return high_water_;
+	}
+
+	/// The number of flushes
+	uint32_t flushes() const noexcept
+	{
+		return flush_time_.count();
+	}
+
+	/// The time taken by each flush, in microseconds
+	const log_duration_stats& flush_time() const noexcept
+	{
+		return flush_time_;
+	}
+
+	/// The time taken by each write to the storage (e.g., the SD card), in microseconds
+	const log_duration_stats& write_time() const noexcept
+	{
+		return write_time_;
+	}
+
+	/// Clear all counters
+	void reset() noexcept
+	{
+		*this = LogStats();
+	}
+
+	/// Record data written to the log
+	void wrote(size_t size) noexcept
+	{
+		bytes_ += size;
+	}
+
+	/** Record a completed log statement
+	 *
+	 * @param l The level of the statement.
+	 * @param start The value of bytes() before the statement was written.
+	 */
+	void logged(size_t l, uint64_t start) noexcept
+	{
+		levels_[l].add(static_cast<size_t>(bytes_ - start));
+	}
+
+	/// Record data lost to an overrun
+	void dropped(size_t size) noexcept
+	{
+		dropped_ += size;
+	}
+
+	/// Record the current size of the internal buffer
+	void buffered(size_t size) noexcept
+	{
+		high_water_ = (size > high_water_) ? size : high_water_;
+	}
+
+	/// Record a flush which took `us` microseconds
+	void flushed(uint32_t us) noexcept
+	{
+		flush_time_.add(us);
+	}
+
+	/// Record a storage write which took `us` microseconds
+	void stored(uint32_t us) noexcept
+	{
+		write_time_.add(us);
+	}
+
+  private:
+	log_record_stats levels_[TLevelCount];
+	uint64_t bytes_ = 0;
+	uint64_t dropped_ = 0;
+	size_t high_water_ = 0;
+	log_duration_stats flush_time_;
+	log_duration_stats write_time_;
+};
+
+#endif // LOG_STATS_HPP_
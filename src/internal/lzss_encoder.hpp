@@ -0,0 +1,274 @@
+#ifndef LZSS_ENCODER_HPP_
+#define LZSS_ENCODER_HPP_
+
+#include "circular_buffer.hpp"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOG_COMPRESSION_EN
+/** Whether log data is compressed before it is stored
+ *
+ * If true, the SD card strategies and the EEPROM fallback of TeensyRobustModuleLogger compress
+ * each flush with LZSSEncoder. Use tools/lzss_decoder to restore the text. Define the same value
+ * in every translation unit.
+ */
+#define LOG_COMPRESSION_EN false
+#endif
+
+#ifndef LOG_LZSS_WINDOW_BITS
+/// The size of the compression window, as a power of two (8 = 256 bytes). Larger windows find
+/// more matches, but use more RAM, and the search time grows with the window size.
+#define LOG_LZSS_WINDOW_BITS 8
+#endif
+
+/** @file lzss_encoder.hpp
+ *
+ * Compressed log data is a sequence of blocks. Each block is a sequence of groups:
+ *
+ * - A flag byte, followed by up to eight tokens. Bit n (LSB first) describes token n:
+ *	1 is a literal byte, and 0 is a match.
+ * - A literal token is the byte itself.
+ * - A match token is two bytes, which copy `length` bytes starting `distance` bytes back in the
+ *	block's output: `distance & 0xFF`, `(distance >> 8) | ((length - lzss_min_match) << 4)`.
+ *	Distances are 1 to 4095, and lengths are lzss_min_match to lzss_max_match.
+ *
+ * A block ends with a match token of distance 0 (two zero bytes), after which the group ends
+ * too. Matches never refer to an earlier block, so decoding can start at any block.
+ */
+
+/// The shortest match, in bytes. Shorter runs are cheaper as literals.
+static constexpr size_t lzss_min_match = 3;
+/// The longest match, in bytes
+static constexpr size_t lzss_max_match = lzss_min_match + 15;
+
+/** Streaming LZSS compressor for log data
+ *
+ * Log text is repetitive (the same prefixes, format strings, and module names), and even a
+ * small window finds plenty of matches. The compressor needs no heap and keeps only the window,
+ * so it suits MCUs. The format is described above.
+ *
+ * Input is passed to write() in pieces of any size (e.g., the two spans of a circular buffer),
+ * and end_block() completes the block. Each flush is compressed as one block, so the output of
+ * a flush never depends on data lost before it.
+ *
+ * Output bytes are passed to a log sink (see internal/log_sink.hpp), one group at a time.
+ *
+ * This class does not depend on the Arduino SDK.
+ *
+ * @tparam TWindowBits The size of the window, as a power of two. 5 to 12.
+ */
+template<unsigned TWindowBits = LOG_LZSS_WINDOW_BITS>
+class LZSSEncoder
+{
+	static_assert(TWindowBits >= 5 && TWindowBits <= 12, "LZSS window must be 32 B to 4 KiB");
+
+  public:
+	LZSSEncoder() = default;
+
+	/** Compress data into the current block
+	 *
+	 * Up to lzss_max_match bytes are held back, so they can be matched against the next piece.
+	 *
+	 * @param sink The destination for completed groups.
+	 * @param data The data to compress.
+	 * @param size The number of bytes to compress.
+	 */
+	template<class TSink>
+	void write(TSink& sink, const char* data, size_t size)
+	{
+		for(size_t i = 0; i < size; i++)
+		{
+			window_[end_ & mask_] = static_cast<uint8_t>(data[i]);
+			end_++;
+
+			if(end_ - pos_ == lzss_max_match)
+			{
+				encode_token(sink);
+			}
+		}
+	}
+
+	/** Compress the data held back by write(), and end the block
+	 *
+	 * @param sink The destination.
+	 * @returns The number of bytes the sink accepted for the block. Compare this with
+	 *	block_size() to detect a sink which did not accept all of the data.
+	 */
+	template<class TSink>
+	size_t end_block(TSink& sink)
+	{
+		while(pos_ != end_)
+		{
+			encode_token(sink);
+		}
+
+		// The block end marker is a match with a distance of 0
+		add_token(sink, false, 0, 0);
+		flush_group(sink);
+
+		history_ = 0;
+		size_t written = written_;
+		written_ = 0;
+		block_size_ = produced_;
+		produced_ = 0;
+
+		return written;
+	}
+
+	/// The number of bytes produced for the last completed block
+	size_t block_size() const noexcept
+	{
+		return block_size_;
+	}
+
+	/** Compress count bytes from the front of a circular buffer as one block
+	 *
+	 * The data is not removed from the buffer.
+	 *
+	 * @returns true if the sink accepted the whole block.
+	 */
+	template<class TSink, class TBuffer>
+	bool compress(TSink& sink, const TBuffer& buffer, size_t count)
+	{
+		buffer_spans<char> spans = buffer.peek_contiguous();
+		size_t first_chunk = (spans.first.size > count) ? count : spans.first.size;
+
+		write(sink, spans.first.data, first_chunk);
+		write(sink, spans.second.data, count - first_chunk);
+
+		return end_block(sink) == block_size_;
+	}
+
+  private:
+	static constexpr size_t window_size_ = static_cast<size_t>(1) << TWindowBits;
+	static constexpr size_t mask_ = window_size_ - 1;
+	static constexpr size_t max_distance_ =
+		(window_size_ - lzss_max_match < 4095) ? window_size_ - lzss_max_match : 4095;
+
+	/// Encode the longest match at the front of the lookahead, or a literal
+	template<class TSink>
+	void encode_token(TSink& sink)
+	{
+		size_t lookahead = end_ - pos_;
+		size_t max_distance = (history_ < max_distance_) ? history_ : max_distance_;
+		size_t best_length = 0;
+		size_t best_distance = 0;
+
+		for(size_t distance = 1; distance <= max_distance; distance++)
+		{
+			size_t start = pos_ - distance;
+
+			// Quick reject on the first byte, which fails for most candidates
+			if(window_[start & mask_] != window_[pos_ & mask_])
+			{
+				continue;
+			}
+
+			size_t length = 1;
+			while(length < lookahead &&
+				  window_[(start + length) & mask_] == window_[(pos_ + length) & mask_])
+			{
+				length++;
+			}
+
+			if(length > best_length)
+			{
+				best_length = length;
+				best_distance = distance;
+
+				if(length == lookahead)
+				{
+					break;
+				}
+			}
+		}
+
+		if(best_length >= lzss_min_match)
+		{
+			add_token(sink, false, static_cast<uint8_t>(best_distance & 0xFF),
+					  static_cast<uint8_t>((best_distance >> 8) |
+										   ((best_length - lzss_min_match) << 4)));
+			advance(best_length);
+		}
+		else
+		{
+			add_token(sink, true, window_[pos_ & mask_], 0);
+			advance(1);
+		}
+	}
+
+	void advance(size_t count) noexcept
+	{
+		pos_ += count;
+		history_ = (history_ + count < window_size_) ? history_ + count : window_size_;
+	}
+
+	template<class TSink>
+	void add_token(TSink& sink, bool literal, uint8_t first, uint8_t second)
+	{
+		if(tokens_ == 0)
+		{
+			group_[0] = 0;
+			group_size_ = 1;
+		}
+
+		if(literal)
+		{
+			group_[0] |= static_cast<uint8_t>(1U << tokens_);
+			group_[group_size_++] = first;
+		}
+		else
+		{
+			group_[group_size_++] = first;
+			group_[group_size_++] = second;
+		}
+
+		if(++tokens_ == 8)
+		{
+			flush_group(sink);
+		}
+	}
+
+	template<class TSink>
+	void flush_group(TSink& sink)
+	{
+		if(tokens_ == 0)
+		{
+			return;
+		}
+
+		written_ += sink.write(reinterpret_cast<const char*>(group_), group_size_);
+		produced_ += group_size_;
+		tokens_ = 0;
+	}
+
+	/// The window holds the history followed by the lookahead. The counters are free-running.
+	uint8_t window_[window_size_];
+	/// The start of the lookahead
+	size_t pos_ = 0;
+	/// The end of the lookahead
+	size_t end_ = 0;
+	/// The number of bytes before pos_ which matches may refer to
+	size_t history_ = 0;
+
+	/// The group being assembled: the flag byte and up to eight tokens
+	uint8_t group_[1 + (8 * 2)];
+	size_t group_size_ = 0;
+	unsigned tokens_ = 0;
+
+	/// Bytes produced and accepted for the current block
+	size_t produced_ = 0;
+	size_t written_ = 0;
+	size_t block_size_ = 0;
+};
+
+template<unsigned TWindowBits>
+constexpr size_t LZSSEncoder<TWindowBits>::window_size_;
+
+template<unsigned TWindowBits>
+constexpr size_t LZSSEncoder<TWindowBits>::mask_;
+
+template<unsigned TWindowBits>
+constexpr size_t LZSSEncoder<TWindowBits>::max_distance_;
+
+#endif // LZSS_ENCODER_HPP_
@@ -0,0 +1,205 @@
+#ifndef MPSC_CIRCULAR_BUFFER_HPP_
+#define MPSC_CIRCULAR_BUFFER_HPP_
+
+#include "circular_buffer.hpp"
+#include <atomic>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef LOG_MPSC_WAIT
+/** Called while a producer waits for an earlier producer to publish its data
+ *
+ * The wait is normally over once the earlier producer has copied its data. With a preemptive
+ * scheduler, the earlier producer may have been preempted, so define this to yield to it:
+ *
+ *	@code
+ *	#define LOG_MPSC_WAIT() taskYIELD()       // FreeRTOS
+ *	#define LOG_MPSC_WAIT() threads.yield()   // TeensyThreads
+ *	@endcode
+ */
+#define LOG_MPSC_WAIT()
+#endif
+
+/** Lock-free multi-producer/single-consumer circular buffer
+ *
+ * This buffer has the same interface as CircularBuffer, so it can be supplied to the logging
+ * strategies that take a buffer type as a template parameter. Several threads or tasks can add
+ * data at the same time, while one consumer removes it (see LOG_CONCURRENT_EN).
+ *
+ * try_put() adds a block of items as a unit:
+ * 1. The producer reserves space by advancing the reservation counter with a compare-exchange.
+ *	This is the only atomic read-modify-write on the uncontended path, and producers never wait
+ *	for each other to reserve.
+ * 2. The producer copies its data into the reserved space, in parallel with other producers.
+ * 3. The producer publishes its data by advancing the head. Blocks are published in the order
+ *	they were reserved, so a producer waits (see LOG_MPSC_WAIT()) until the producers which
+ *	reserved earlier space have published theirs.
+ *
+ * The consumer only sees published data, so blocks from different producers never interleave.
+ *
+ * Rules for safe use:
+ * - Only one context may remove data (get(), consume(), reset()).
+ * - A producer must not interrupt another producer. Because of the publication order, an ISR
+ *	which logs while the interrupted task is between steps 1 and 3 never finishes. Log from
+ *	tasks or threads only.
+ * - A full buffer drops *new* data instead of overwriting the oldest data. try_put() drops the
+ *	whole block.
+ *
+ * The counters are free-running and are reduced with a mask, which is why the capacity must be
+ * a power of two.
+ *
+ * @tparam T The element type. Must be trivially copyable.
+ * @tparam TCount The capacity of the buffer. Must be a power of two.
+ */
+template<class T, size_t TCount>
+class MPSCCircularBuffer
+{
+	static_assert(is_power_of_2(TCount), "MPSCCircularBuffer capacity must be a power of two");
+
+  public:
+	MPSCCircularBuffer() = default;
+
+	/// Producer: add an item. The item is dropped if the buffer is full.
+	void put(T item)
+	{
+		try_put(&item, 1);
+	}
+
+	/// Producer: add a block of items as a unit. The block is dropped if it does not fit.
+	void put(const T* data, size_t count)
+	{
+		try_put(data, count);
+	}
+
+	/** Producer: add a block of items as a unit
+	 *
+	 * @param data Pointer to the items to add.
+	 * @param count The number of items to add.
+	 * @returns true if the items were added. If there is not enough free space for all of the
+	 *	items, none are added.
+	 */
+	bool try_put(const T* data, size_t count)
+	{
+		size_t head = reserved_.load(std::memory_order_relaxed);
+
+		do
+		{
+			if(count > max_size_ - (head - tail_.load(std::memory_order_acquire)))
+			{
+				return false;
+			}
+		} while(!reserved_.compare_exchange_weak(head, head + count, std::memory_order_relaxed));
+
+		size_t index = head & mask_;
+		size_t first_chunk = max_size_ - index;
+
+		if(first_chunk > count)
+		{
+			first_chunk = count;
+		}
+
+		memcpy(&buf_[index], data, first_chunk * sizeof(T));
+		memcpy(&buf_[0], data + first_chunk, (count - first_chunk) * sizeof(T));
+
+		// Publish in reservation order
+		while(head_.load(std::memory_order_acquire) != head)
+		{
+			LOG_MPSC_WAIT();
+		}
+
+		head_.store(head + count, std::memory_order_release);
+
+		return true;
+	}
+
+	/// Consumer: remove and return the oldest item, or T() if the buffer is empty.
+	T get()
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+
+		if(head_.load(std::memory_order_acquire) == tail)
+		{
+			return T();
+		}
+
+		T val = buf_[tail & mask_];
+		tail_.store(tail + 1, std::memory_order_release);
+
+		return val;
+	}
+
+	/** Consumer: remove items from the front of the buffer without reading them
+	 *
+	 * @param count The number of items to remove. Clamped to size().
+	 */
+	void consume(size_t count)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		size_t used = head_.load(std::memory_order_acquire) - tail;
+
+		tail_.store(tail + ((count < used) ? count : used), std::memory_order_release);
+	}
+
+	/// Consumer: discard all published data
+	void reset()
+	{
+		tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	bool full() const
+	{
+		return size() == max_size_;
+	}
+
+	size_t capacity() const
+	{
+		return max_size_;
+	}
+
+	/// The number of published items. Space which is reserved but not published is not counted.
+	size_t size() const
+	{
+		// Load the tail first: the head can only move forward in the meantime,
+		// so the result never exceeds the capacity.
+		size_t tail = tail_.load(std::memory_order_acquire);
+		return head_.load(std::memory_order_acquire) - tail;
+	}
+
+	/** Consumer: access the published data in place
+	 *
+	 * The spans cover the data which was published when this was called. Producers do not
+	 * write to that data until it is consumed, so the spans remain valid until consume() is
+	 * called.
+	 */
+	buffer_spans<T> peek_contiguous() const
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		size_t head = head_.load(std::memory_order_acquire);
+		return make_buffer_spans<T>(buf_, max_size_, tail & mask_, head - tail);
+	}
+
+  private:
+	static constexpr size_t max_size_ = TCount;
+	static constexpr size_t mask_ = TCount - 1;
+
+	/// Advanced by producers to reserve space
+	std::atomic<size_t> reserved_{0};
+	/// End of the published data. Advanced by producers, in reservation order.
+	std::atomic<size_t> head_{0};
+	/// Start of the data. Advanced by the consumer.
+	std::atomic<size_t> tail_{0};
+	T buf_[TCount];
+};
+
+template<class T, size_t TCount>
+constexpr size_t MPSCCircularBuffer<T, TCount>::max_size_;
+
+template<class T, size_t TCount>
+constexpr size_t MPSCCircularBuffer<T, TCount>::mask_;
+
+#endif // MPSC_CIRCULAR_BUFFER_HPP_
@@ -0,0 +1,174 @@
+#ifndef NOINIT_LOG_BUFFER_HPP_
+#define NOINIT_LOG_BUFFER_HPP_
+
+#include "circular_buffer.hpp"
+#include <stddef.h>
+#include <stdint.h>
+
+/// Marks a NoInitLogBuffer header as initialized
+static constexpr uint32_t noinit_log_magic = 0x4C4F4721; // "LOG!"
+
+/** Circular log buffer which survives a reset
+ *
+ * The buffer is meant to be placed in a section which the startup code does not clear (see
+ * LOG_NOINIT). It has a trivial default constructor, so a static instance is not initialized
+ * at boot and keeps the data written before a watchdog or software reset.
+ *
+ * After a reset, call recover() before using the buffer. The header holds a magic number, the
+ * capacity, and a check word over the read and write positions. If any of these fail
+ * validation (e.g., after a power-on, which leaves the memory random), the buffer is reset.
+ * Checking the data itself would cost a CRC update per character, so only the header is
+ * checked. A reset in the middle of a write invalidates the header, and the buffer is
+ * discarded.
+ *
+ * When the buffer is full, new data overwrites the oldest data.
+ *
+ * This class does not depend on the Arduino SDK.
+ *
+ * @tparam TSize The capacity of the buffer, in bytes.
+ */
+template<size_t TSize>
+class NoInitLogBuffer
+{
+	static_assert(TSize > 0, "NoInitLogBuffer requires a non-zero size");
+
+  public:
+	// Must stay trivial, or static instances would be initialized at boot
+	NoInitLogBuffer() = default;
+
+	/** Validate the buffer contents after a reset
+	 *
+	 * @returns true if the buffer holds data written before the reset. If false, the buffer
+	 *	has been reset.
+	 */
+	bool recover() noexcept
+	{
+		bool valid = magic_ == noinit_log_magic && capacity_ == TSize && head_ < TSize &&
+					 count_ <= TSize && check_ == header_check();
+
+		if(!valid)
+		{
+			reset();
+		}
+
+		return valid && count_ > 0;
+	}
+
+	void reset() noexcept
+	{
+		magic_ = noinit_log_magic;
+		capacity_ = TSize;
+		head_ = 0;
+		count_ = 0;
+		check_ = header_check();
+	}
+
+	void put(char c) noexcept
+	{
+		data_[head_] = c;
+		head_ = (head_ + 1 == TSize) ? 0 : head_ + 1;
+		count_ = (count_ == TSize) ? count_ : count_ + 1;
+		check_ = header_check();
+	}
+
+	/// Add a block of data. If there is not enough free space, the oldest data is overwritten.
+	void put(const char* data, size_t count) noexcept
+	{
+		if(count > TSize)
+		{
+			// Only the newest TSize bytes survive
+			data += count - TSize;
+			count = TSize;
+		}
+
+		for(size_t i = 0; i < count; i++)
+		{
+			data_[head_] = data[i];
+			head_ = (head_ + 1 == TSize) ? 0 : head_ + 1;
+		}
+
+		count_ = (count_ + count > TSize) ? TSize : count_ + count;
+		check_ = header_check();
+	}
+
+	/** Remove data from the front of the buffer
+	 *
+	 * @param dst The destination.
+	 * @param count The maximum number of bytes to copy.
+	 * @returns The number of bytes copied.
+	 */
+	size_t get(char* dst, size_t count) noexcept
+	{
+		count = (count > count_) ? count_ : count;
+		size_t tail = tail_position();
+
+		for(size_t i = 0; i < count; i++)
+		{
+			dst[i] = data_[tail];
+			tail = (tail + 1 == TSize) ? 0 : tail + 1;
+		}
+
+		count_ -= count;
+		check_ = header_check();
+
+		return count;
+	}
+
+	/// Access the stored data in place (see CircularBuffer::peek_contiguous())
+	buffer_spans<char> peek_contiguous() const noexcept
+	{
+		return make_buffer_spans<char>(data_, TSize, tail_position(), count_);
+	}
+
+	/// Remove data from the front of the buffer without reading it. Clamped to size().
+	void consume(size_t count) noexcept
+	{
+		count_ -= (count > count_) ? count_ : count;
+		check_ = header_check();
+	}
+
+	char get() noexcept
+	{
+		char c = '\0';
+		get(&c, 1);
+		return c;
+	}
+
+	bool empty() const noexcept
+	{
+		return count_ == 0;
+	}
+
+	size_t size() const noexcept
+	{
+		return count_;
+	}
+
+	size_t capacity() const noexcept
+	{
+		return TSize;
+	}
+
+  private:
+	size_t tail_position() const noexcept
+	{
+		return (head_ >= count_) ? head_ - count_ : head_ + TSize - count_;
+	}
+
+	uint32_t header_check() const noexcept
+	{
+		return ~(magic_ ^ static_cast<uint32_t>(capacity_) ^
+				 (static_cast<uint32_t>(head_) * UINT32_C(0x9E3779B1)) ^
+				 (static_cast<uint32_t>(count_) << 16) ^ (static_cast<uint32_t>(count_) >> 16));
+	}
+
+	// No default member initializers: see the constructor
+	uint32_t magic_;
+	uint32_t check_;
+	size_t capacity_;
+	size_t head_;
+	size_t count_;
+	char data_[TSize];
+};
+
+#endif // NOINIT_LOG_BUFFER_HPP_
@@ -0,0 +1,267 @@
+#ifndef RECORD_CIRCULAR_BUFFER_HPP_
+#define RECORD_CIRCULAR_BUFFER_HPP_
+
+#include "circular_buffer.hpp"
+#include <stddef.h>
+
+/// The records and bytes dropped to make room for (or instead of) a new record
+struct record_drop_count
+{
+	size_t records;
+	size_t bytes;
+};
+
+/** Circular buffer which drops whole records when it is full
+ *
+ * CircularBuffer overwrites the oldest bytes, so after an overrun the output starts part-way
+ * through a log statement. This buffer also keeps the length of each record (each block added
+ * with put(const T*, size_t)), and evicts the oldest *records* until a new one fits. The output
+ * therefore always starts at the beginning of a statement.
+ *
+ * The lengths are kept in a separate table rather than in the data, so the data is the log text
+ * itself: the strategies write it out with peek_contiguous() and consume() as usual, and may
+ * consume part of a record. Select this buffer through a strategy's buffer type parameter, and
+ * set LOG_RECORD_FRAMING_EN, so each log statement is added as a single block:
+ *
+ *	@code
+ *	TeensySDLogger_t<RecordCircularBuffer<char, 16 * 1024>> logger;
+ *	@endcode
+ *
+ * This buffer is not safe to use from more than one context, just like CircularBuffer.
+ *
+ * This class does not depend on the Arduino SDK.
+ *
+ * @tparam T The element type. Must be trivially copyable.
+ * @tparam TCount The capacity of the buffer, in elements.
+ * @tparam TMaxRecords The number of records the buffer can hold. When the table is full, the
+ *	oldest record is evicted, even if there is space for the data. The default allows for
+ *	an average record length of 16 elements.
+ */
+template<class T, size_t TCount, size_t TMaxRecords = ((TCount / 16) > 0 ? (TCount / 16) : 1)>
+class RecordCircularBuffer
+{
+	static_assert(TMaxRecords > 0, "RecordCircularBuffer must hold at least one record");
+
+  public:
+	RecordCircularBuffer() = default;
+
+	/** Add an item to the newest record
+	 *
+	 * The oldest records are evicted if the buffer is full. If the newest record fills the
+	 * whole buffer, the item is dropped.
+	 */
+	void put(T item)
+	{
+		if(records_ == 0)
+		{
+			put_record(&item, 1);
+			return;
+		}
+
+		while(data_.full() && records_ > 1)
+		{
+			evict();
+		}
+
+		if(!data_.full())
+		{
+			data_.put(item);
+			lengths_[slot(records_ - 1)]++;
+		}
+	}
+
+	/// Add a block of items as a new record, evicting the oldest records if needed
+	void put(const T* data, size_t count)
+	{
+		put_record(data, count);
+	}
+
+	/** Add a block of items as a new record
+	 *
+	 * The oldest records are evicted until the new record fits. A record which is longer than
+	 * the capacity of the buffer is dropped instead.
+	 *
+	 * @param data Pointer to the items to add.
+	 * @param count The number of items to add.
+	 * @returns The records and elements which were dropped.
+	 */
+	record_drop_count put_record(const T* data, size_t count)
+	{
+		record_drop_count dropped = {0, 0};
+
+		if(count == 0)
+		{
+			return dropped;
+		}
+
+		if(count > TCount)
+		{
+			dropped.records = 1;
+			dropped.bytes = count;
+			return dropped;
+		}
+
+		while(records_ > 0 && (count > TCount - data_.size() || records_ == TMaxRecords))
+		{
+			dropped.bytes += evict();
+			dropped.records++;
+		}
+
+		data_.put(data, count);
+		lengths_[slot(records_)] = count;
+		records_++;
+
+		return dropped;
+	}
+
+	T get()
+	{
+		if(empty())
+		{
+			return T();
+		}
+
+		T item = data_.get();
+		consumed(1);
+		return item;
+	}
+
+	/** Remove items from the front of the buffer without reading them
+	 *
+	 * A record may be consumed in part. The rest of it stays at the front of the buffer.
+	 *
+	 * @param count The number of items to remove. Clamped to size().
+	 */
+	void consume(size_t count)
+	{
+		count = (count < size()) ? count : size();
+		data_.consume(count);
+		consumed(count);
+	}
+
+	void reset()
+	{
+		data_.reset();
+		first_ = 0;
+		records_ = 0;
+	}
+
+	bool empty() const
+	{
+		return data_.empty();
+	}
+
+	bool full() const
+	{
+		return data_.full();
+	}
+
+	size_t capacity() const
+	{
+		return data_.capacity();
+	}
+
+	size_t size() const
+	{
+		return data_.size();
+	}
+
+	/// The number of records in the buffer, including a record which was consumed in part
+	size_t records() const
+	{
+		return records_;
+	}
+
+	/** The length of a record
+	 *
+	 * @param n The record, counting from the oldest (0). Must be < records().
+	 * @returns The remaining length of a record which was consumed in part.
+	 */
+	size_t record_size(size_t n) const
+	{
+		return lengths_[slot(n)];
+	}
+
+	/// @see CircularBuffer::peek_contiguous()
+	buffer_spans<T> peek_contiguous() const
+	{
+		return data_.peek_contiguous();
+	}
+
+  private:
+	/// The table index of the nth oldest record
+	size_t slot(size_t n) const
+	{
+		return (first_ + n) % TMaxRecords;
+	}
+
+	/// Remove the oldest record, and return its length
+	size_t evict()
+	{
+		size_t length = lengths_[first_];
+		data_.consume(length);
+		first_ = slot(1);
+		records_--;
+		return length;
+	}
+
+	/// Update the record table after count items were removed from the front of the data
+	void consumed(size_t count)
+	{
+		while(count > 0 && records_ > 0)
+		{
+			if(count < lengths_[first_])
+			{
+				lengths_[first_] -= count;
+				return;
+			}
+
+			count -= lengths_[first_];
+			first_ = slot(1);
+			records_--;
+		}
+	}
+
+	CircularBuffer<T, TCount> data_;
+	size_t lengths_[TMaxRecords];
+	size_t first_ = 0;
+	size_t records_ = 0;
+};
+
+/// buffer_put_record() for buffers which keep record boundaries
+template<class TBuffer, class T>
+auto buffer_put_record_(TBuffer& buffer, const T* data, size_t count, int)
+	-> decltype(buffer.put_record(data, count))
+{
+	return buffer.put_record(data, count);
+}
+
+/// buffer_put_record() for the other buffers, which reject a record that does not fit
+template<class TBuffer, class T>
+record_drop_count buffer_put_record_(TBuffer& buffer, const T* data, size_t count, long)
+{
+	record_drop_count dropped = {0, 0};
+
+	if(!buffer_try_put(buffer, data, count))
+	{
+		dropped.records = 1;
+		dropped.bytes = count;
+	}
+
+	return dropped;
+}
+
+/** Add a block of items to a buffer as a whole record
+ *
+ * A RecordCircularBuffer evicts its oldest records to make room. With other buffers, the
+ * record is dropped if it does not fit (see buffer_try_put()). Either way, no record is split.
+ *
+ * @returns The records and elements which were dropped.
+ */
+template<class TBuffer, class T>
+record_drop_count buffer_put_record(TBuffer& buffer, const T* data, size_t count)
+{
+	return buffer_put_record_(buffer, data, count, 0);
+}
+
+#endif // RECORD_CIRCULAR_BUFFER_HPP_
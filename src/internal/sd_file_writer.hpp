@@ -0,0 +1,79 @@
+#ifndef SD_FILE_WRITER_HPP_
+#define SD_FILE_WRITER_HPP_
+
+#include "log_sink.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// The SD card sector size, in bytes
+static constexpr size_t sd_sector_size = 512;
+
+/** Returns the number of bytes to write so that a write ends on a sector boundary
+ *
+ * @param position The current file position.
+ * @param size The number of bytes available to write.
+ * @returns The largest count <= size for which position + count is a multiple of
+ *	sd_sector_size. This is 0 if the data does not reach the next sector boundary.
+ */
+inline size_t sector_aligned_size(uint64_t position, size_t size) noexcept
+{
+	uint64_t end = (position + size) & ~static_cast<uint64_t>(sd_sector_size - 1);
+
+	return (end > position) ? static_cast<size_t>(end - position) : 0;
+}
+
+/** Returns the number of bytes a flush writes to a pre-allocated file
+ *
+ * Pre-allocated files are written in whole sectors (see sector_aligned_size()). A buffer
+ * smaller than a sector might never reach the next sector boundary, so it writes all of its
+ * data instead.
+ *
+ * @param position The current file position.
+ * @param size The number of bytes held in the buffer.
+ * @param capacity The capacity of the buffer.
+ */
+inline size_t preallocated_flush_size(uint64_t position, size_t size, size_t capacity) noexcept
+{
+	return (capacity < sd_sector_size) ? size : sector_aligned_size(position, size);
+}
+
+/** Write data from the front of a circular buffer to a file
+ *
+ * The data may wrap around the end of the buffer, in which case we write buffer[tail] to the
+ * end of the buffer, and then the remainder from buffer[0]. The data is not removed from
+ * the buffer.
+ *
+ * @tparam TFile The file type. Must provide write(const void*, size_t).
+ * @tparam TBuffer The buffer type. Must provide peek_contiguous().
+ * @param file The destination file.
+ * @param buffer The source buffer.
+ * @param count The number of bytes to write. Must be <= buffer.size().
+ * @returns The number of bytes written.
+ */
+template<class TFile, class TBuffer>
+size_t write_buffer_to_file(TFile& file, TBuffer& buffer, size_t count)
+{
+	return write_to_sink(file, buffer, count);
+}
+
+/** Copy data from the front of a circular buffer
+ *
+ * The data is copied with at most two memcpy calls, and is not removed from the buffer.
+ *
+ * @tparam TBuffer The buffer type. Must provide peek_contiguous().
+ * @param buffer The source buffer.
+ * @param dst The destination. Must have space for count bytes.
+ * @param count The number of bytes to copy. Must be <= buffer.size().
+ */
+template<class TBuffer>
+void copy_from_buffer(const TBuffer& buffer, char* dst, size_t count)
+{
+	buffer_spans<char> spans = buffer.peek_contiguous();
+	size_t first_chunk = (spans.first.size > count) ? count : spans.first.size;
+
+	memcpy(dst, spans.first.data, first_chunk);
+	memcpy(dst + first_chunk, spans.second.data, count - first_chunk);
+}
+
+#endif // SD_FILE_WRITER_HPP_
@@ -0,0 +1,194 @@
+#ifndef SD_LOG_INDEX_HPP_
+#define SD_LOG_INDEX_HPP_
+
+#include "log_rotation.hpp"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOG_INDEX_FILENAME
+/// The file on the SD card which caches the index of the next rotational log file
+#define LOG_INDEX_FILENAME "log_index.dat"
+#endif
+
+/** @file sd_log_index.hpp
+ *
+ * Tracks the index of the next rotational log file on the SD card itself, so no EEPROM write
+ * is needed when a file is started. The next index is cached in LOG_INDEX_FILENAME. If the
+ * cache is missing (e.g., on a new card), the root directory is scanned once for the highest
+ * existing `log_<index>` file. sd_prune_log_files() deletes the oldest files to keep the logs
+ * within a storage budget.
+ *
+ * @tparam TFile The file type. Must provide the SdFat FsFile interface.
+ */
+
+/// Read the cached next index. Returns false if there is no valid cache.
+template<class TFile>
+bool sd_read_log_index(uint32_t& index)
+{
+	TFile file;
+	uint8_t data[8];
+
+	if(!file.open(LOG_INDEX_FILENAME, O_RDONLY))
+	{
+		return false;
+	}
+
+	bool valid = file.read(data, sizeof(data)) == static_cast<int>(sizeof(data));
+	file.close();
+
+	// The index is stored twice, the second copy inverted, to detect a damaged cache
+	uint32_t value = 0;
+	uint32_t check = 0;
+
+	for(size_t i = 0; i < 4; i++)
+	{
+		value |= static_cast<uint32_t>(data[i]) << (8 * i);
+		check |= static_cast<uint32_t>(data[i + 4]) << (8 * i);
+	}
+
+	valid = valid && value != 0 && value == ~check;
+	index = value;
+
+	return valid;
+}
+
+/// Cache the index of the next log file
+template<class TFile>
+void sd_store_log_index(uint32_t index)
+{
+	TFile file;
+	uint8_t data[8];
+
+	for(size_t i = 0; i < 4; i++)
+	{
+		data[i] = static_cast<uint8_t>(index >> (8 * i));
+		data[i + 4] = static_cast<uint8_t>(~index >> (8 * i));
+	}
+
+	if(file.open(LOG_INDEX_FILENAME, O_WRITE | O_CREAT))
+	{
+		file.seekSet(0);
+		file.write(data, sizeof(data));
+		file.close();
+	}
+}
+
+/** Call a function for each log file with the given extension in the root directory
+ *
+ * @param extension The log file extension, including the '.'.
+ * @param f Called as `f(index, entry)` with the log file index and the open directory entry.
+ */
+template<class TFile, class TFunction>
+void sd_for_each_log_file(const char* extension, TFunction&& f)
+{
+	TFile root;
+	TFile entry;
+
+	if(!root.open("/", O_RDONLY))
+	{
+		return;
+	}
+
+	while(entry.openNext(&root, O_RDONLY))
+	{
+		char name[log_filename_max_size + 1];
+		uint32_t index;
+
+		if(!entry.isDir() && entry.getName(name, sizeof(name)) < sizeof(name) &&
+		   parse_log_filename(name, extension, index))
+		{
+			f(index, entry);
+		}
+
+		entry.close();
+	}
+
+	root.close();
+}
+
+/// Scan the root directory for the highest log file index with the given extension.
+/// Returns 0 if there are no log files.
+template<class TFile>
+uint32_t sd_scan_log_index(const char* extension)
+{
+	uint32_t highest = 0;
+
+	sd_for_each_log_file<TFile>(extension, [&highest](uint32_t index, TFile&) {
+		highest = (index > highest) ? index : highest;
+	});
+
+	return highest;
+}
+
+/** Delete the oldest log files until the log files fit in a storage budget
+ *
+ * The files with the lowest indices are deleted first. Each deletion rescans the directory,
+ * so no list of files is held in RAM. This runs when a new file is started, which is rare.
+ *
+ * @param extension The log file extension, including the '.'.
+ * @param budget The total size of the log files to keep, in bytes.
+ * @param keep The index of the file in use, which is never deleted.
+ * @returns The number of files deleted.
+ */
+template<class TFile>
+size_t sd_prune_log_files(const char* extension, uint64_t budget, uint32_t keep)
+{
+	size_t removed = 0;
+
+	while(true)
+	{
+		uint64_t total = 0;
+		uint32_t oldest = 0;
+		bool found = false;
+
+		sd_for_each_log_file<TFile>(extension, [&](uint32_t index, TFile& entry) {
+			total += entry.fileSize();
+
+			if(index != keep && (!found || index < oldest))
+			{
+				oldest = index;
+				found = true;
+			}
+		});
+
+		if(total <= budget || !found)
+		{
+			return removed;
+		}
+
+		char name[log_filename_max_size];
+		TFile file;
+		format_log_filename(name, oldest, extension);
+
+		if(!file.open(name, O_WRITE) || !file.remove())
+		{
+			return removed;
+		}
+
+		removed++;
+	}
+}
+
+/** Select the index of the next log file, and advance the cached index
+ *
+ * @param extension The log file extension, including the '.'.
+ * @returns The index of the next log file. Indices start at 1.
+ */
+template<class TFile>
+uint32_t sd_next_log_index(const char* extension)
+{
+	uint32_t index;
+
+	if(!sd_read_log_index<TFile>(index))
+	{
+		index = sd_scan_log_index<TFile>(extension) + 1;
+	}
+
+	// Index 0 is not used, so a wrapped counter restarts at 1
+	index = (index == 0) ? 1 : index;
+	sd_store_log_index<TFile>(index + 1);
+
+	return index;
+}
+
+#endif // SD_LOG_INDEX_HPP_
@@ -0,0 +1,464 @@
+#ifndef SD_STORAGE_BACKEND_HPP_
+#define SD_STORAGE_BACKEND_HPP_
+
+#include "log_rotation.hpp"
+#include "lzss_encoder.hpp"
+#include "sd_file_writer.hpp"
+#include "sd_log_index.hpp"
+#include "sd_sync_policy.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/** Log file storage for the SD card strategies
+ *
+ * The strategies stage log data in a RAM buffer (their TBuffer template parameter), and the
+ * backend moves the staged data into the log file. It owns the file handle, applies the sync
+ * budget (SDSyncPolicy), and writes pre-allocated files in whole sectors. Storage features are
+ * implemented here once, and reach every strategy which uses the backend.
+ *
+ * Errors which leave the logger unable to store data (the file cannot be opened, written, or
+ * closed) call `sd_error_halt(fs, message)`, which is found by argument-dependent lookup on the
+ * file system type. internal/sdfat_storage.hpp provides it for SdFat.
+ *
+ * With LOG_COMPRESSION_EN, each write is compressed as one block (see LZSSEncoder) on its way
+ * to the file. A pre-allocated file is then written without sector alignment, since the
+ * compressed size of the data is not known in advance.
+ *
+ * The file system and file types are template parameters, and the current time is supplied by
+ * the caller, so this class does not depend on the Arduino SDK.
+ *
+ * @tparam TFs The file system type. Must provide card()->sectorCount().
+ * @tparam TFile The file type. Must provide the SdFat FsFile interface.
+ */
+template<class TFs, class TFile>
+class SDStorageBackend
+{
+  public:
+	SDStorageBackend() = default;
+
+	/** Select the file system used for the log file
+	 *
+	 * @param fs The file system.
+	 * @param preallocate_size If non-zero, each file opened by open() is pre-allocated to this
+	 *	many bytes, and is kept open.
+	 */
+	void attach(TFs& fs, uint64_t preallocate_size = 0) noexcept
+	{
+		fs_ = &fs;
+		preallocate_size_ = preallocate_size;
+	}
+
+	/// Returns true once a file system has been attached
+	bool attached() const noexcept
+	{
+		return fs_ != nullptr;
+	}
+
+	/// The log file
+	TFile& file() noexcept
+	{
+		return file_;
+	}
+
+	/// The name of the log file
+	const char* filename() const noexcept
+	{
+		return filename_;
+	}
+
+	/// The size of the log file, in bytes
+	size_t size() const
+	{
+		return file_.size();
+	}
+
+	/// The capacity of the card, in bytes
+	size_t capacity() const
+	{
+		return fs_ ? fs_->card()->sectorCount() * sd_sector_size : 0;
+	}
+
+	/// Returns true if the log file is kept open between flushes
+	bool keep_open() const noexcept
+	{
+		return sync_.keep_open();
+	}
+
+	/** Set whether the log file is kept open between flushes
+	 *
+	 * @param enable If false, the file is closed (see close()).
+	 * @param buffer The staging buffer.
+	 * @param now The current time, in milliseconds.
+	 */
+	template<class TBuffer>
+	void keep_open(bool enable, TBuffer& buffer, uint32_t now)
+	{
+		sync_.keep_open(enable);
+
+		if(!enable)
+		{
+			close(buffer, now);
+		}
+	}
+
+	/// The sync budget, see SDSyncPolicy
+	SDSyncPolicy& sync_policy() noexcept
+	{
+		return sync_;
+	}
+
+	/** Start a new log file
+	 *
+	 * The current file is closed, and the new file is created (or truncated). If a
+	 * pre-allocation size was given to attach(), the file is pre-allocated and kept open.
+	 *
+	 * @param filename The file name, of up to log_filename_max_size - 1 characters.
+	 * @param buffer The staging buffer.
+	 * @param now The current time, in milliseconds.
+	 */
+	template<class TBuffer>
+	void open(const char* filename, TBuffer& buffer, uint32_t now)
+	{
+		close(buffer, now);
+
+		if(filename != filename_)
+		{
+			strncpy(filename_, filename, sizeof(filename_) - 1);
+		}
+
+		if(!file_.open(filename_, O_WRITE | O_CREAT))
+		{
+			halt("Failed to open file");
+		}
+
+		// Clear current file contents
+		file_.truncate(0);
+
+		if(preallocate_size_ > 0)
+		{
+			if(!file_.preAllocate(preallocate_size_))
+			{
+				halt("Failed to pre-allocate file");
+			}
+
+			preallocated_ = true;
+			sync_.keep_open(true);
+		}
+	}
+
+	/** Open the log file at the next flush, instead of now
+	 *
+	 * Opening (and truncating or pre-allocating) the file can take hundreds of milliseconds on
+	 * a slow card. The deferred begin() of the strategies calls this, so the boot path only
+	 * stages data in RAM. The strategy calls take_deferred_open() when it flushes, and opens the
+	 * file (with open() or open_next()) if it returns true.
+	 *
+	 * @param filename The name for open(), or nullptr to keep the current name (e.g., when the
+	 *	strategy selects the name with open_next()).
+	 */
+	void defer_open(const char* filename = nullptr) noexcept
+	{
+		if(filename != nullptr)
+		{
+			strncpy(filename_, filename, sizeof(filename_) - 1);
+		}
+
+		open_deferred_ = true;
+	}
+
+	/// Returns true, and clears the request, if defer_open() was called since the last call
+	bool take_deferred_open() noexcept
+	{
+		bool deferred = open_deferred_;
+		open_deferred_ = false;
+		return deferred;
+	}
+
+	/** Write the staged data to the log file
+	 *
+	 * The file is reopened in append mode if it was closed. A pre-allocated file is only
+	 * written in whole sectors: the partial sector at the end stays in the buffer until it is
+	 * complete, or until the file is synced. Call finish() once the write is accounted for.
+	 *
+	 * @param buffer The staging buffer. The written data is removed from it.
+	 * @returns The number of bytes written to the file.
+	 */
+	template<class TBuffer>
+	size_t write(TBuffer& buffer)
+	{
+		if(!file_.isOpen() && !file_.open(filename_, O_WRITE | O_APPEND))
+		{
+			halt("Failed to open file");
+		}
+
+#if LOG_COMPRESSION_EN
+		size_t size = buffer.size();
+
+		if(!encoder_.compress(file_, buffer, size))
+		{
+			halt("Failed to write to log file");
+		}
+
+		buffer.consume(size);
+
+		return encoder_.block_size();
+#else
+		// Snapshot the buffer size. With a lock-free buffer, an interrupt may add data
+		// while we are writing. That data is left in the buffer for the next flush.
+		size_t size = buffer.size();
+		size_t count =
+			preallocated_ ? preallocated_flush_size(file_.curPosition(), size, buffer.capacity())
+						  : size;
+
+		if(write_buffer_to_file(file_, buffer, count) != count)
+		{
+			halt("Failed to write to log file");
+		}
+
+		buffer.consume(count);
+
+		return count;
+#endif
+	}
+
+	/** Write a block of data to the log file, which must be open
+	 *
+	 * The data counts against the sync budget, but the file is not synced.
+	 *
+	 * @param data The data to write.
+	 * @param size The number of bytes to write.
+	 * @param now The current time, in milliseconds.
+	 */
+	void write(const char* data, size_t size, uint32_t now)
+	{
+#if LOG_COMPRESSION_EN
+		encoder_.write(file_, data, size);
+
+		if(encoder_.end_block(file_) != encoder_.block_size())
+		{
+			halt("Failed to write to log file");
+		}
+
+		size = encoder_.block_size();
+#else
+		if(file_.write(data, size) != size)
+		{
+			halt("Failed to write to log file");
+		}
+#endif
+
+		sync_.wrote(size, now);
+	}
+
+	/** Complete a flush which wrote count bytes
+	 *
+	 * The file is closed, unless it is kept open. An open file is synced once the sync budget
+	 * is used.
+	 *
+	 * @param count The number of bytes written by write().
+	 * @param buffer The staging buffer.
+	 * @param now The current time, in milliseconds.
+	 */
+	template<class TBuffer>
+	void finish(size_t count, TBuffer& buffer, uint32_t now)
+	{
+		if(!sync_.keep_open())
+		{
+			file_.close();
+		}
+		else if(sync_.wrote(count, now))
+		{
+			sync(buffer, now);
+		}
+	}
+
+	/// Close the file handle unless the file is kept open. Buffered data is not written.
+	void release()
+	{
+		if(!sync_.keep_open())
+		{
+			file_.close();
+		}
+	}
+
+	/** Commit the data written to the log file to the card
+	 *
+	 * For a pre-allocated file, this includes the partial sector held in the buffer. The data
+	 * stays in the buffer, and the file position is restored, so the sector is rewritten in full
+	 * once it is complete.
+	 *
+	 * @param buffer The staging buffer.
+	 * @param now The current time, in milliseconds.
+	 */
+	template<class TBuffer>
+	void sync(TBuffer& buffer, uint32_t now)
+	{
+		if(!file_.isOpen())
+		{
+			return;
+		}
+
+#if !LOG_COMPRESSION_EN
+		// Compressed data is written in full, so nothing is held back
+		if(preallocated_ && !buffer.empty())
+		{
+			size_t size = buffer.size();
+			uint64_t position = file_.curPosition();
+
+			if(write_buffer_to_file(file_, buffer, size) != size)
+			{
+				halt("Failed to write to log file");
+			}
+
+			file_.seekSet(position);
+		}
+#endif
+
+		file_.sync();
+		sync_.synced(now);
+	}
+
+	/** Close the log file
+	 *
+	 * A pre-allocated file receives the buffered data, since nothing else will be written at
+	 * the current position, and it is truncated to the length of the data.
+	 *
+	 * @param buffer The staging buffer.
+	 * @param now The current time, in milliseconds.
+	 */
+	template<class TBuffer>
+	void close(TBuffer& buffer, uint32_t now)
+	{
+		if(!file_.isOpen())
+		{
+			return;
+		}
+
+		if(preallocated_)
+		{
+#if LOG_COMPRESSION_EN
+			if(!buffer.empty())
+			{
+				write(buffer);
+			}
+#else
+			size_t size = buffer.size();
+
+			if(write_buffer_to_file(file_, buffer, size) != size)
+			{
+				halt("Failed to write to log file");
+			}
+
+			buffer.consume(size);
+#endif
+			file_.truncate(file_.curPosition());
+			preallocated_ = false;
+		}
+
+		if(!file_.close())
+		{
+			halt("Failed to close file");
+		}
+
+		sync_.synced(now);
+	}
+
+	/// Report an unrecoverable error, see sd_error_halt()
+	void halt(const char* msg)
+	{
+		sd_error_halt(fs_, msg);
+	}
+
+#if LOG_COMPRESSION_EN
+	/// The compressor, which strategies may also use for other storage (e.g., EEPROM)
+	LZSSEncoder<>& encoder() noexcept
+	{
+		return encoder_;
+	}
+#endif
+
+  private:
+	TFs* fs_ = nullptr;
+	mutable TFile file_;
+	char filename_[log_filename_max_size] = "log.txt";
+	SDSyncPolicy sync_;
+	uint64_t preallocate_size_ = 0;
+	bool preallocated_ = false;
+	bool open_deferred_ = false;
+#if LOG_COMPRESSION_EN
+	LZSSEncoder<> encoder_;
+#endif
+};
+
+/** Log file storage which starts a new file on rotation
+ *
+ * Files are named `log_<index><extension>`. The next index is selected from the card (see
+ * sd_next_log_index()), and the rotation policy decides when a new file is started and how
+ * many old files are kept (see LogRotationPolicy).
+ *
+ * @tparam TFs The file system type. Must provide card()->sectorCount().
+ * @tparam TFile The file type. Must provide the SdFat FsFile interface.
+ */
+template<class TFs, class TFile>
+class SDRotatingStorageBackend : public SDStorageBackend<TFs, TFile>
+{
+  public:
+	SDRotatingStorageBackend() = default;
+
+	/// The rotation policy
+	LogRotationPolicy& rotation_policy() noexcept
+	{
+		return rotation_;
+	}
+
+	/// The index of the current log file
+	uint32_t file_index() const noexcept
+	{
+		return file_index_;
+	}
+
+	/** Close the current file, and start the next one
+	 *
+	 * Old files are deleted if they exceed the retention budget.
+	 *
+	 * @param extension The file extension, including the '.', of up to 4 characters.
+	 * @param buffer The staging buffer.
+	 * @param now The current time, in milliseconds.
+	 */
+	template<class TBuffer>
+	void open_next(const char* extension, TBuffer& buffer, uint32_t now)
+	{
+		char filename[log_filename_max_size];
+
+		// Close first, so the index scan sees the final size of the current file
+		this->close(buffer, now);
+		file_index_ = sd_next_log_index<TFile>(extension);
+		format_log_filename(filename, file_index_, extension);
+		this->open(filename, buffer, now);
+
+		if(rotation_.retention() > 0)
+		{
+			sd_prune_log_files<TFile>(extension, rotation_.retention(), file_index_);
+		}
+
+		rotation_.rotated(now);
+	}
+
+	/** Record data written to the current file
+	 *
+	 * @param count The number of bytes written.
+	 * @param now The current time, in milliseconds.
+	 * @returns true if the next file should be started.
+	 */
+	bool rotation_due(size_t count, uint32_t now) noexcept
+	{
+		return rotation_.wrote(count, now);
+	}
+
+  private:
+	uint32_t file_index_ = 0;
+	LogRotationPolicy rotation_;
+};
+
+#endif // SD_STORAGE_BACKEND_HPP_
@@ -0,0 +1,97 @@
+#ifndef SD_SYNC_POLICY_HPP_
+#define SD_SYNC_POLICY_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOG_SD_KEEP_FILE_OPEN_DEFAULT
+/// Whether the SD loggers keep the log file open between flushes by default.
+/// If false, the file is opened and closed on every flush.
+#define LOG_SD_KEEP_FILE_OPEN_DEFAULT false
+#endif
+
+#ifndef LOG_SD_SYNC_BYTES_DEFAULT
+/// When the log file is kept open, sync() is called once this many bytes have been written
+#define LOG_SD_SYNC_BYTES_DEFAULT 4096
+#endif
+
+#ifndef LOG_SD_SYNC_MS_DEFAULT
+/// When the log file is kept open, sync() is called if this many milliseconds have passed
+/// since the last sync. The interval is only checked during flush().
+#define LOG_SD_SYNC_MS_DEFAULT 1000
+#endif
+
+/** Tracks when a log file that is kept open must be synced
+ *
+ * Opening and closing the log file on every flush means a directory lookup and a directory
+ * entry update for every buffer written. Keeping the file open avoids that cost, but data is
+ * only committed to the card (and the file size updated) when the file is synced or closed.
+ * This class bounds the amount of unsynced data by size and by age.
+ *
+ * The current time is supplied by the caller, so this class does not depend on the Arduino SDK.
+ */
+class SDSyncPolicy
+{
+  public:
+	SDSyncPolicy() = default;
+
+	/// Returns true if the log file is kept open between flushes
+	bool keep_open() const noexcept
+	{
+		return keep_open_;
+	}
+
+	/// Set whether the log file is kept open between flushes
+	void keep_open(bool enable) noexcept
+	{
+		keep_open_ = enable;
+	}
+
+	/** Set the sync budget
+	 *
+	 * @param bytes Sync once this many bytes have been written since the last sync.
+	 *	0 syncs on every write.
+	 * @param ms Sync if this many milliseconds have passed since the last sync.
+	 */
+	void budget(size_t bytes, uint32_t ms) noexcept
+	{
+		bytes_budget_ = bytes;
+		ms_budget_ = ms;
+	}
+
+	/// The number of bytes written since the last sync
+	size_t pending() const noexcept
+	{
+		return pending_;
+	}
+
+	/** Record data written to the log file
+	 *
+	 * @param bytes The number of bytes written.
+	 * @param now The current time, in milliseconds.
+	 * @returns true if the file should be synced now.
+	 */
+	bool wrote(size_t bytes, uint32_t now) noexcept
+	{
+		pending_ += bytes;
+
+		return pending_ > 0 &&
+			   (pending_ >= bytes_budget_ || static_cast<uint32_t>(now - last_sync_) >= ms_budget_);
+	}
+
+	/// Record that the log file was synced (or closed) at time now
+	void synced(uint32_t now) noexcept
+	{
+		pending_ = 0;
+		last_sync_ = now;
+	}
+
+  private:
+	bool keep_open_ = LOG_SD_KEEP_FILE_OPEN_DEFAULT;
+	size_t bytes_budget_ = LOG_SD_SYNC_BYTES_DEFAULT;
+	uint32_t ms_budget_ = LOG_SD_SYNC_MS_DEFAULT;
+	size_t pending_ = 0;
+	uint32_t last_sync_ = 0;
+};
+
+#endif // SD_SYNC_POLICY_HPP_
@@ -0,0 +1,39 @@
+#ifndef SDFAT_STORAGE_HPP_
+#define SDFAT_STORAGE_HPP_
+
+#include "Arduino.h"
+#include "SdFat.h"
+#include "sd_storage_backend.hpp"
+#include <stdio.h>
+
+/** Report an SD card error, and halt
+ *
+ * The SdFat error code and data are printed, if the card reported an error.
+ *
+ * @param fs The file system, or nullptr if none is attached.
+ * @param msg A description of the failed operation.
+ */
+inline void sd_error_halt(SdFs* fs, const char* msg)
+{
+	printf("Error: %s\n", msg);
+	if(fs && fs->sdErrorCode())
+	{
+		if(fs->sdErrorCode() == SD_CARD_ERROR_ACMD41)
+		{
+			printf("Try power cycling the SD card.\n");
+		}
+		printSdErrorSymbol(&Serial, fs->sdErrorCode());
+		printf(", ErrorData: 0x%x\n", fs->sdErrorData());
+	}
+	while(true)
+	{
+	}
+}
+
+/// Log file storage on an SdFat file system
+using SDStorage = SDStorageBackend<SdFs, FsFile>;
+
+/// Rotating log file storage on an SdFat file system
+using SDRotatingStorage = SDRotatingStorageBackend<SdFs, FsFile>;
+
+#endif // SDFAT_STORAGE_HPP_
@@ -0,0 +1,241 @@
+#ifndef SPSC_CIRCULAR_BUFFER_HPP_
+#define SPSC_CIRCULAR_BUFFER_HPP_
+
+#include "circular_buffer.hpp"
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#else
+#include <atomic>
+#endif
+
+/** Index shared between the producer and consumer of an SPSCCircularBuffer
+ *
+ * load() has acquire semantics and store() has release semantics: the data written before a
+ * store() is visible to the other side once it observes the new index value.
+ */
+#if defined(__AVR__)
+// size_t is 16 bits on AVR, so the access is not atomic. A short critical section makes it
+// atomic, and the memory clobber in ATOMIC_BLOCK keeps the compiler from reordering buffer
+// accesses around it. The core itself does not reorder memory accesses.
+class spsc_index
+{
+  public:
+	size_t load() const
+	{
+		size_t value;
+
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			value = value_;
+		}
+
+		return value;
+	}
+
+	void store(size_t value)
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			value_ = value;
+		}
+	}
+
+  private:
+	volatile size_t value_ = 0;
+};
+#else
+class spsc_index
+{
+  public:
+	size_t load() const
+	{
+		return value_.load(std::memory_order_acquire);
+	}
+
+	void store(size_t value)
+	{
+		value_.store(value, std::memory_order_release);
+	}
+
+  private:
+	std::atomic<size_t> value_{0};
+};
+#endif
+
+/** Lock-free single-producer/single-consumer circular buffer
+ *
+ * This buffer has the same interface as CircularBuffer, so it can be supplied to the logging
+ * strategies that take a buffer type as a template parameter. It allows one context to add data
+ * while another context removes it, without disabling interrupts around every log call.
+ * The typical use is logging from an ISR with log_interrupt() while loop() calls flush().
+ *
+ * Rules for safe use:
+ * - Only one context may add data (put()), and only one context may remove data
+ *	(get(), consume(), reset()). Two producers, such as loop() and an ISR that both log,
+ *	still need external synchronization.
+ * - The producer cannot move the tail, so a full buffer drops *new* data instead of overwriting
+ *	the oldest data. The logger reports this through has_overrun().
+ *
+ * head_ and tail_ are free-running counters that are reduced with a mask, which is why the
+ * capacity must be a power of two.
+ *
+ * @tparam T The element type. Must be trivially copyable.
+ * @tparam TCount The capacity of the buffer. Must be a power of two.
+ */
+template<class T, size_t TCount>
+class SPSCCircularBuffer
+{
+	static_assert(is_power_of_2(TCount), "SPSCCircularBuffer capacity must be a power of two");
+
+  public:
+	SPSCCircularBuffer() = default;
+
+	/// Producer: add an item. The item is dropped if the buffer is full.
+	void put(T item)
+	{
+		size_t head = head_.load();
+
+		if(head - tail_.load() == max_size_)
+		{
+			return;
+		}
+
+		buf_[head & mask_] = item;
+		head_.store(head + 1);
+	}
+
+	/** Producer: add a block of items
+	 *
+	 * Items that do not fit in the free space are dropped.
+	 *
+	 * @param data Pointer to the items to add.
+	 * @param count The number of items to add.
+	 */
+	void put(const T* data, size_t count)
+	{
+		size_t head = head_.load();
+		size_t free_space = max_size_ - (head - tail_.load());
+
+		if(count > free_space)
+		{
+			count = free_space;
+		}
+
+		size_t index = head & mask_;
+		size_t first_chunk = max_size_ - index;
+
+		if(first_chunk > count)
+		{
+			first_chunk = count;
+		}
+
+		memcpy(&buf_[index], data, first_chunk * sizeof(T));
+		memcpy(&buf_[0], data + first_chunk, (count - first_chunk) * sizeof(T));
+
+		head_.store(head + count);
+	}
+
+	/// Consumer: remove and return the oldest item, or T() if the buffer is empty.
+	T get()
+	{
+		size_t tail = tail_.load();
+
+		if(head_.load() == tail)
+		{
+			return T();
+		}
+
+		T val = buf_[tail & mask_];
+		tail_.store(tail + 1);
+
+		return val;
+	}
+
+	/** Consumer: remove items from the front of the buffer without reading them
+	 *
+	 * @param count The number of items to remove. Clamped to size().
+	 */
+	void consume(size_t count)
+	{
+		size_t tail = tail_.load();
+		size_t used = head_.load() - tail;
+
+		tail_.store(tail + ((count < used) ? count : used));
+	}
+
+	/// Consumer: discard all data currently in the buffer
+	void reset()
+	{
+		tail_.store(head_.load());
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	bool full() const
+	{
+		return size() == max_size_;
+	}
+
+	size_t capacity() const
+	{
+		return max_size_;
+	}
+
+	size_t size() const
+	{
+		// Load the tail first: the head can only move forward in the meantime,
+		// so the result never exceeds the capacity.
+		size_t tail = tail_.load();
+		return head_.load() - tail;
+	}
+
+	/** Consumer: access the stored data in place
+	 *
+	 * The spans cover the data which was in the buffer when this was called. The producer
+	 * does not write to that data until it is consumed, so the spans remain valid until
+	 * consume() is called.
+	 */
+	buffer_spans<T> peek_contiguous() const
+	{
+		size_t tail = tail_.load();
+		return make_buffer_spans<T>(buf_, max_size_, tail & mask_, head_.load() - tail);
+	}
+
+	/// Returns the storage index that the next element will be written to
+	size_t head() const
+	{
+		return head_.load() & mask_;
+	}
+
+	/// Returns the storage index of the oldest element
+	size_t tail() const
+	{
+		return tail_.load() & mask_;
+	}
+
+	const T* storage() const
+	{
+		return &buf_[0];
+	}
+
+  private:
+	static constexpr size_t max_size_ = TCount;
+	static constexpr size_t mask_ = TCount - 1;
+	spsc_index head_;
+	spsc_index tail_;
+	T buf_[TCount];
+};
+
+template<class T, size_t TCount>
+constexpr size_t SPSCCircularBuffer<T, TCount>::max_size_;
+
+template<class T, size_t TCount>
+constexpr size_t SPSCCircularBuffer<T, TCount>::mask_;
+
+#endif // SPSC_CIRCULAR_BUFFER_HPP_
@@ -0,0 +1,86 @@
+#ifndef TEE_SINK_LIST_HPP_
+#define TEE_SINK_LIST_HPP_
+
+#include <stddef.h>
+
+/** @file tee_sink_list.hpp
+ *
+ * Storage for the sinks of a TeeLogger. This is a minimal replacement for std::tuple,
+ * which is not available on AVR.
+ */
+
+/// Tag type used to select a sink by index
+template<size_t TIndex>
+struct tee_sink_index
+{
+};
+
+/// Provides the type of the sink at TIndex as `type`
+template<size_t TIndex, class... TSinks>
+struct tee_sink_type;
+
+template<class THead, class... TTail>
+struct tee_sink_type<0, THead, TTail...>
+{
+	using type = THead;
+};
+
+template<size_t TIndex, class THead, class... TTail>
+struct tee_sink_type<TIndex, THead, TTail...> : tee_sink_type<TIndex - 1, TTail...>
+{
+};
+
+/** A list of sink instances
+ *
+ * for_each() calls a function object with each sink, in declaration order. The function object
+ * must provide a templated operator() which accepts a reference to any of the sink types.
+ *
+ * @tparam TSinks The sink types.
+ */
+template<class... TSinks>
+struct tee_sink_list
+{
+	template<class TFunction>
+	void for_each(TFunction& /*function*/) noexcept
+	{
+	}
+
+	template<class TFunction>
+	void for_each(TFunction& /*function*/) const noexcept
+	{
+	}
+};
+
+template<class THead, class... TTail>
+struct tee_sink_list<THead, TTail...>
+{
+	template<class TFunction>
+	void for_each(TFunction& function) noexcept
+	{
+		function(head);
+		tail.for_each(function);
+	}
+
+	template<class TFunction>
+	void for_each(TFunction& function) const noexcept
+	{
+		function(head);
+		tail.for_each(function);
+	}
+
+	THead& get(tee_sink_index<0> /*index*/) noexcept
+	{
+		return head;
+	}
+
+	template<size_t TIndex>
+	typename tee_sink_type<TIndex, THead, TTail...>::type& get(tee_sink_index<TIndex>) noexcept
+	{
+		return tail.get(tee_sink_index<TIndex - 1>());
+	}
+
+	THead head;
+	tee_sink_list<TTail...> tail;
+};
+
+#endif // TEE_SINK_LIST_HPP_
@@ -0,0 +1,40 @@
+#ifndef TIMESTAMP_CLOCK_HPP_
+#define TIMESTAMP_CLOCK_HPP_
+
+#include "Arduino.h"
+#include "timestamp_prefix.hpp"
+
+/** Read the clock used for a timestamp prefix
+ *
+ * The DWT cycle counter is enabled on first use, if the core has not already enabled it.
+ * On targets without a DWT, log_timestamp_e::cycles reads 0.
+ *
+ * @param source The clock to read.
+ * @returns The current reading, in the units of the clock.
+ */
+inline uint32_t log_timestamp_now(log_timestamp_e source) noexcept
+{
+	switch(source)
+	{
+		case log_timestamp_e::millis:
+			return millis();
+		case log_timestamp_e::cycles:
+#if defined(ARM_DWT_CYCCNT)
+			if(!(ARM_DWT_CTRL & ARM_DWT_CTRL_CYCCNTENA))
+			{
+				ARM_DEMCR |= ARM_DEMCR_TRCENA;
+				ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+			}
+
+			return ARM_DWT_CYCCNT;
+#else
+			return 0;
+#endif
+		case log_timestamp_e::micros:
+		case log_timestamp_e::delta:
+		default:
+			return micros();
+	}
+}
+
+#endif // TIMESTAMP_CLOCK_HPP_
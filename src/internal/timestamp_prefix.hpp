@@ -0,0 +1,116 @@
+#ifndef TIMESTAMP_PREFIX_HPP_
+#define TIMESTAMP_PREFIX_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The clock used for the timestamp prefix of the SD card loggers
+enum class log_timestamp_e : uint8_t
+{
+	/// Milliseconds since boot: "[123 ms] "
+	millis = 0,
+	/// Microseconds since boot: "[123456 us] "
+	micros,
+	/// CPU cycles (ARM_DWT_CYCCNT): "[123456789 cyc] ". Reads 0 on targets without a DWT.
+	cycles,
+	/// Microseconds since the previous statement: "[+250 us] "
+	delta,
+};
+
+#ifndef LOG_TIMESTAMP_DEFAULT
+/// The default clock used for the timestamp prefix
+#define LOG_TIMESTAMP_DEFAULT log_timestamp_e::millis
+#endif
+
+/// The maximum length of a timestamp prefix: "[4294967295 cyc] " or "[+4294967295 us] "
+static constexpr size_t log_timestamp_prefix_max_size = 17;
+
+/** Convert an unsigned integer to decimal
+ *
+ * @param buffer The destination. Must have space for 10 characters. No NUL is written.
+ * @param value The value to convert.
+ * @returns The number of characters written.
+ */
+inline size_t log_u32_to_dec(char* buffer, uint32_t value) noexcept
+{
+	char digits[10];
+	size_t count = 0;
+
+	do
+	{
+		digits[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while(value != 0);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		buffer[i] = digits[count - 1 - i];
+	}
+
+	return count;
+}
+
+/** Formats the timestamp prefix of a log statement
+ *
+ * The prefix is built in a stack buffer and written to the log in a single block, which avoids
+ * running a second printf() through the per-character path for every statement.
+ *
+ * The clock is read by the caller, so this class does not depend on the Arduino SDK.
+ */
+class TimestampPrefix
+{
+  public:
+	TimestampPrefix() = default;
+
+	/// The clock used for the prefix
+	log_timestamp_e source() const noexcept
+	{
+		return source_;
+	}
+
+	/// Set the clock used for the prefix
+	void source(log_timestamp_e source) noexcept
+	{
+		source_ = source;
+		last_ = 0;
+	}
+
+	/** Format the prefix
+	 *
+	 * @param buffer The destination. Must have space for log_timestamp_prefix_max_size
+	 *	characters. No NUL is written.
+	 * @param now The current reading of the clock selected by source(). For
+	 *	log_timestamp_e::delta, this is the time in microseconds.
+	 * @returns The number of characters written.
+	 */
+	size_t format(char* buffer, uint32_t now) noexcept
+	{
+		static const char* const units[] = {" ms] ", " us] ", " cyc] ", " us] "};
+		uint32_t value = now;
+		size_t len = 0;
+
+		buffer[len++] = '[';
+
+		if(source_ == log_timestamp_e::delta)
+		{
+			value = now - last_;
+			last_ = now;
+			buffer[len++] = '+';
+		}
+
+		len += log_u32_to_dec(&buffer[len], value);
+
+		for(const char* unit = units[static_cast<uint8_t>(source_)]; *unit; unit++)
+		{
+			buffer[len++] = *unit;
+		}
+
+		return len;
+	}
+
+  private:
+	log_timestamp_e source_ = LOG_TIMESTAMP_DEFAULT;
+	uint32_t last_ = 0;
+};
+
+#endif // TIMESTAMP_PREFIX_HPP_
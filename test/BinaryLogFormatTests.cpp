@@ -0,0 +1,202 @@
+#include <CircularBufferLogger.h>
+#include <binary_log_decoder.hpp>
+#include <catch.hpp>
+#include <internal/binary_log_encoder.hpp>
+#include <string>
+#include <test_helper.hpp>
+#include <vector>
+
+namespace
+{
+/// Writer for BinaryLogEncoder which stores records in a vector, with an optional size limit
+struct test_writer
+{
+	explicit test_writer(size_t limit = SIZE_MAX) : limit(limit)
+	{
+		char header[binary_log_header_size];
+		data.insert(data.end(), header, header + BinaryLogEncoder::write_header(header, 0x1234));
+	}
+
+	size_t available() const
+	{
+		return limit - (data.size() - binary_log_header_size);
+	}
+
+	void write(const char* str, size_t len)
+	{
+		data.insert(data.end(), reinterpret_cast<const uint8_t*>(str),
+					reinterpret_cast<const uint8_t*>(str) + len);
+	}
+
+	std::string decode()
+	{
+		std::string output;
+		BinaryLogDecoder decoder;
+		CHECK(decoder.decode(data.data(), data.size(), output));
+		CHECK(0x1234 == decoder.build_id());
+		return output;
+	}
+
+	size_t limit;
+	std::vector<uint8_t> data;
+};
+} // namespace
+
+TEST_CASE("Binary: Varint and zigzag encoding round-trip", "[BinaryLogFormat]")
+{
+	const uint64_t values[] = {0, 1, 127, 128, 300, 0xFFFFFFFF, UINT64_MAX};
+
+	for(auto value : values)
+	{
+		char buffer[binary_varint_max_size(sizeof(uint64_t))];
+		size_t size = binary_write_varint(buffer, value);
+		CHECK(binary_varint_size(value) == size);
+
+		const uint8_t* src = reinterpret_cast<const uint8_t*>(buffer);
+		uint64_t decoded;
+		CHECK(binary_read_varint(src, src + size, decoded));
+		CHECK(value == decoded);
+	}
+
+	const int64_t signed_values[] = {0, -1, 1, -64, 64, INT64_MIN, INT64_MAX};
+
+	for(auto value : signed_values)
+	{
+		CHECK(value == binary_zigzag_decode(binary_zigzag_encode(value)));
+	}
+
+	CHECK(1 == binary_zigzag_encode(int32_t(-1)));
+	CHECK(2 == binary_zigzag_encode(int32_t(1)));
+}
+
+TEST_CASE("Binary: Decoded output matches the text logger", "[BinaryLogFormat]")
+{
+	test_writer writer;
+	BinaryLogEncoder encoder;
+	CircularLogBufferLogger<1024> immediate;
+
+	encoder.record(writer, 0, 0, 0, "%s: %d of %u, %c %x %5.2f|", "progress", -3, 10u, 'z', 0xbeef,
+				   3.14159);
+	encoder.record(writer, 0, 0, 0, "%hhu %ld %lld %.*s|", 257, -123456L, -1234567890123LL, 3,
+				   "abcdef");
+	encoder.text(writer, "text|", 5);
+	encoder.record(writer, 0, 0, 0, "%%%-4d|%04X\n", 7, 0xab);
+
+	log_buffer_output.clear();
+	immediate.print("%s: %d of %u, %c %x %5.2f|", "progress", -3, 10u, 'z', 0xbeef, 3.14159);
+	immediate.print("%hhu %ld %lld %.*s|", 257, -123456L, -1234567890123LL, 3, "abcdef");
+	immediate.write("text|", 5);
+	immediate.print("%%%-4d|%04X\n", 7, 0xab);
+	immediate.flush();
+
+	CHECK(writer.decode() == log_buffer_output);
+}
+
+TEST_CASE("Binary: Records carry the level prefix and timestamps", "[BinaryLogFormat]")
+{
+	test_writer writer;
+	BinaryLogEncoder encoder;
+
+	encoder.record(writer, static_cast<uint8_t>(log_level_e::info), 0, 100, "start\n");
+	encoder.record(writer, static_cast<uint8_t>(log_level_e::critical), 3, 250, "module %d\n", 3);
+	encoder.record(writer, static_cast<uint8_t>(log_level_e::debug), 0, 1000000, "late\n");
+
+	CHECK(writer.decode() ==
+		  construct_log_string(log_level_e::info, "[100 ms] start\n") +
+			  construct_log_string(log_level_e::critical, "[250 ms] module 3\n") +
+			  construct_log_string(log_level_e::debug, "[1000000 ms] late\n"));
+}
+
+TEST_CASE("Binary: Format strings are only stored once", "[BinaryLogFormat]")
+{
+	test_writer writer;
+	BinaryLogEncoder encoder;
+	const char* fmt = "A fairly long format string with a value: %d\n";
+
+	encoder.record(writer, 0, 0, 0, fmt, 1);
+	size_t first_size = writer.data.size() - binary_log_header_size;
+	encoder.record(writer, 0, 0, 0, fmt, 2);
+	size_t second_size = writer.data.size() - binary_log_header_size - first_size;
+
+	CHECK(second_size < first_size - strlen(fmt));
+	CHECK(second_size <= 5);
+
+	// A change in argument types redefines the format
+	encoder.record(writer, 0, 0, 0, fmt, 3u);
+	encoder.record(writer, 0, 0, 0, fmt, -4);
+
+	CHECK(writer.decode() == "A fairly long format string with a value: 1\n"
+							 "A fairly long format string with a value: 2\n"
+							 "A fairly long format string with a value: 3\n"
+							 "A fairly long format string with a value: -4\n");
+
+	// Starting a new file writes the definitions again
+	test_writer next_file;
+	encoder.reset();
+	encoder.record(next_file, 0, 0, 0, fmt, 5);
+	CHECK(next_file.decode() == "A fairly long format string with a value: 5\n");
+}
+
+TEST_CASE("Binary: Records that do not fit are not written", "[BinaryLogFormat]")
+{
+	test_writer writer(8);
+	BinaryLogEncoder encoder;
+
+	// The definition does not fit, so nothing is written
+	CHECK(false == encoder.record(writer, 0, 0, 0, "Too long to fit %d\n", 1));
+	CHECK(binary_log_header_size == writer.data.size());
+	CHECK(false == encoder.text(writer, "0123456789", 10));
+	CHECK(binary_log_header_size == writer.data.size());
+
+	// Once there is space, the definition is written with the record
+	writer.limit = SIZE_MAX;
+	CHECK(encoder.record(writer, 0, 0, 0, "Too long to fit %d\n", 2));
+	CHECK(writer.decode() == "Too long to fit 2\n");
+}
+
+TEST_CASE("Binary: Binary records are smaller than text", "[BinaryLogFormat]")
+{
+	test_writer writer;
+	BinaryLogEncoder encoder;
+	std::string text;
+	uint32_t timestamp = 0;
+
+	for(int i = 0; i < 100; i++)
+	{
+		timestamp += 12;
+		encoder.record(writer, static_cast<uint8_t>(log_level_e::info), 0, timestamp,
+					   "Sensor reading %d: %d, %d, %d\n", i, 1000 + i, -2000 - i, 30000 + i);
+	}
+
+	text = writer.decode();
+	CHECK(writer.data.size() * 3 < text.size());
+}
+
+TEST_CASE("Binary: The decoder rejects invalid data", "[BinaryLogFormat]")
+{
+	BinaryLogDecoder decoder;
+	std::string output;
+
+	const uint8_t not_a_log[] = "This is a text file";
+	CHECK(false == decoder.decode(not_a_log, sizeof(not_a_log), output));
+	CHECK(false == decoder.error().empty());
+
+	test_writer writer;
+	BinaryLogEncoder encoder;
+	encoder.record(writer, static_cast<uint8_t>(log_level_e::error), 0, 5, "First\n");
+	encoder.record(writer, static_cast<uint8_t>(log_level_e::error), 0, 6, "Second %s\n", "arg");
+
+	// Text that was decoded before the data ends is still returned
+	output.clear();
+	CHECK(false == decoder.decode(writer.data.data(), writer.data.size() - 1, output));
+	CHECK(output == construct_log_string(log_level_e::error, "[5 ms] First\n") +
+						construct_log_string(log_level_e::error, "[6 ms] Second "));
+
+	// Records which refer to an unknown format cannot be decoded
+	test_writer missing_definition;
+	encoder.record(missing_definition, 0, 0, 0, "First\n");
+	output.clear();
+	CHECK(false == decoder.decode(missing_definition.data.data(), missing_definition.data.size(),
+								  output));
+	CHECK(output.empty());
+}
@@ -96,3 +96,196 @@ TEST_CASE("CB: Log level checks", "[CircularBufferLogger]")
 	logger.flush();
 	CHECK(log_buffer_output == construct_log_string(log_level_e::debug, test_string));
 }
+
+TEST_CASE("CB: Write pre-formatted data", "[CircularBufferLogger]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	logger.write("abc%d", 3);
+	CHECK(3 == logger.size());
+
+	logger.flush();
+	CHECK(log_buffer_output == std::string_view("abc"));
+}
+
+TEST_CASE("CB: Overrun with block writes", "[CircularBufferLogger]")
+{
+	CircularLogBufferLogger<16> logger;
+	log_buffer_output.clear();
+
+	logger.write("0123456789", 10);
+	CHECK(false == logger.has_overrun());
+
+	logger.write("abcdefghij", 10);
+	CHECK(true == logger.has_overrun());
+	CHECK(16 == logger.size());
+
+	logger.clear();
+	CHECK(false == logger.has_overrun());
+}
+
+TEST_CASE("CB: Flush to a sink", "[CircularBufferLogger]")
+{
+	struct string_sink
+	{
+		size_t write(const char* data, size_t size)
+		{
+			output.append(data, size);
+			return size;
+		}
+
+		std::string output;
+	};
+
+	CircularLogBufferLogger<16> logger;
+	string_sink sink;
+	log_buffer_output.clear();
+
+	logger.info("0123456789\n");
+	logger.info("abc\n");
+	CHECK(16 == logger.size());
+
+	CHECK(16 == logger.flush_to(sink));
+	CHECK(sink.output == "3456789\n<I> abc\n");
+	CHECK(0 == logger.size());
+	CHECK(log_buffer_output.empty());
+}
+
+TEST_CASE("CB: Non-blocking output drains only what the port accepts", "[CircularBufferLogger]")
+{
+	struct test_serial
+	{
+		int availableForWrite()
+		{
+			return available;
+		}
+
+		size_t write(const char* data, size_t size)
+		{
+			output.append(data, size);
+			available -= static_cast<int>(size);
+			return size;
+		}
+
+		std::string output;
+		int available = 0;
+	};
+
+	CircularLogBufferLogger<64> logger;
+	test_serial serial;
+	logger.output(log_sink_ref::nonblocking(serial));
+	logger.flush_policy().watermark(0);
+	logger.flush_policy().max_age(0);
+	log_buffer_output.clear();
+
+	logger.info("hello world\n");
+
+	// The port is busy: flush() returns without writing
+	logger.flush();
+	CHECK(serial.output.empty());
+	CHECK(16 == logger.size());
+
+	serial.available = 6;
+	logger.flush();
+	CHECK(serial.output == "<I> he");
+	CHECK(10 == logger.size());
+
+	// poll() resumes the flush, even though the policy triggers are disabled
+	serial.available = 4;
+	CHECK(logger.poll(0));
+	CHECK(serial.output == "<I> hello ");
+
+	serial.available = 100;
+	CHECK(logger.poll(0));
+	CHECK(serial.output == "<I> hello world\n");
+	CHECK(0 == logger.size());
+	CHECK(false == logger.poll(0));
+	CHECK(log_buffer_output.empty());
+
+	// An empty reference selects _putchar() again
+	logger.output(log_sink_ref());
+	logger.info("x\n");
+	logger.flush();
+	CHECK(log_buffer_output == "<I> x\n");
+}
+
+TEST_CASE("CB: An auto-flush which frees no space is an overrun", "[CircularBufferLogger]")
+{
+	struct busy_serial
+	{
+		int availableForWrite()
+		{
+			return 0;
+		}
+
+		size_t write(const char* /*data*/, size_t size)
+		{
+			return size;
+		}
+	};
+
+	CircularLogBufferLogger<16> logger;
+	busy_serial serial;
+	logger.output(log_sink_ref::nonblocking(serial));
+	logger.auto_flush(true);
+
+	SECTION("Characters")
+	{
+		logger.print("0123456789abcdef");
+		CHECK_FALSE(logger.has_overrun());
+
+		logger.print("x");
+		CHECK(logger.has_overrun());
+	}
+
+	SECTION("Blocks")
+	{
+		logger.write("0123456789abcdef", 16);
+		CHECK_FALSE(logger.has_overrun());
+
+		logger.write("xyz", 3);
+		CHECK(logger.has_overrun());
+	}
+
+	CHECK(16 == logger.size());
+}
+
+TEST_CASE("CB: Echo prints the same statements that are logged", "[CircularBufferLogger]")
+{
+	CircularLogBufferLogger<1024> logger;
+	std::string long_string(LOG_ECHO_STAGING_SIZE * 2 + 5, 'x');
+	std::string long_line = long_string + "\n";
+	std::string expected = construct_log_string(log_level_e::info, "Value 42 str\n") +
+						   construct_log_string(log_level_e::warning, long_line.c_str()) +
+						   construct_log_string(log_level_e::error, "Fixed 7\n") +
+						   construct_log_string(log_level_e::debug, "@kv a=1\n");
+	logger.echo(true);
+	log_buffer_output.clear();
+
+	logger.info("Value %d %s\n", 42, "str");
+	logger.warning("%s\n", long_string.c_str());
+	logger.error(LOG_FMT("Fixed %u\n"), 7U);
+	logger.log_kv(log_level_e::debug, "kv", kv("a", 1));
+
+	CHECK(log_buffer_output == expected);
+	CHECK(expected.size() == logger.size());
+
+	log_buffer_output.clear();
+	logger.flush();
+	CHECK(log_buffer_output == expected);
+}
+
+TEST_CASE("CB: Timestamp prefix with a clock", "[CircularBufferLogger]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	logger.timestamp_clock([]() -> uint32_t { return 1200; });
+	logger.info("stamped\n");
+	logger.timestamp_clock(nullptr);
+	logger.info("plain\n");
+	logger.flush();
+
+	CHECK("<I> [1200 ms] stamped\n<I> plain\n" == log_buffer_output);
+}
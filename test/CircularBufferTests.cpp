@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <internal/circular_buffer.hpp>
+#include <string>
+
+template<class TBuffer>
+static std::string drain(TBuffer& buffer)
+{
+	std::string output;
+
+	while(!buffer.empty())
+	{
+		output += buffer.get();
+	}
+
+	return output;
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Block put without wraparound", "[CircularBuffer]",
+				   (CircularBuffer<char, 16>), (CircularBuffer<char, 16, false>))
+{
+	TestType buffer;
+
+	buffer.put("hello", 5);
+	CHECK(5 == buffer.size());
+	CHECK(false == buffer.full());
+	CHECK(drain(buffer) == "hello");
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Block put splits around the wrap point", "[CircularBuffer]",
+				   (CircularBuffer<char, 8>), (CircularBuffer<char, 8, false>))
+{
+	TestType buffer;
+
+	buffer.put("abcdef", 6);
+	CHECK(drain(buffer) == "abcdef");
+
+	// head is now at index 6, so this write must wrap
+	buffer.put("0123", 4);
+	CHECK(4 == buffer.size());
+	CHECK(2 == buffer.head());
+	CHECK(drain(buffer) == "0123");
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Block put exactly fills the buffer", "[CircularBuffer]",
+				   (CircularBuffer<char, 8>), (CircularBuffer<char, 8, false>))
+{
+	TestType buffer;
+
+	buffer.put("abc", 3);
+	buffer.put("defgh", 5);
+	CHECK(true == buffer.full());
+	CHECK(8 == buffer.size());
+	CHECK(drain(buffer) == "abcdefgh");
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Block put overwrites the oldest data", "[CircularBuffer]",
+				   (CircularBuffer<char, 8>), (CircularBuffer<char, 8, false>))
+{
+	TestType buffer;
+
+	buffer.put("abcdef", 6);
+	buffer.put("ghij", 4);
+	CHECK(true == buffer.full());
+	CHECK(drain(buffer) == "cdefghij");
+
+	buffer.put("0123456789ab", 12);
+	CHECK(true == buffer.full());
+	CHECK(drain(buffer) == "456789ab");
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Block put matches per-item put", "[CircularBuffer]",
+				   (CircularBuffer<char, 8>), (CircularBuffer<char, 8, false>))
+{
+	TestType block;
+	TestType single;
+	const std::string input = "The quick brown fox";
+
+	for(size_t offset = 0; offset < input.size(); offset += 3)
+	{
+		size_t count = std::min<size_t>(3, input.size() - offset);
+		block.put(&input[offset], count);
+
+		for(size_t i = 0; i < count; i++)
+		{
+			single.put(input[offset + i]);
+		}
+
+		CHECK(block.size() == single.size());
+		CHECK(block.full() == single.full());
+	}
+
+	CHECK(drain(block) == drain(single));
+}
+
+TEST_CASE("Circular Buffer: Implementation selection", "[CircularBuffer]")
+{
+	CHECK(is_power_of_2(1));
+	CHECK(is_power_of_2(512));
+	CHECK_FALSE(is_power_of_2(0));
+	CHECK_FALSE(is_power_of_2(1000));
+
+	// The power-of-two buffer has no full_ flag, so it is only as large as its members
+	CHECK(sizeof(CircularBuffer<char, 512>) == 2 * sizeof(size_t) + 512);
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Fill, drain, and refill", "[CircularBuffer]",
+				   (CircularBuffer<char, 4>), (CircularBuffer<char, 5>))
+{
+	TestType buffer;
+	const size_t capacity = buffer.capacity();
+
+	for(size_t round = 0; round < 3; round++)
+	{
+		for(size_t i = 0; i < capacity; i++)
+		{
+			CHECK_FALSE(buffer.full());
+			buffer.put(static_cast<char>('a' + i));
+		}
+
+		CHECK(buffer.full());
+		CHECK(capacity == buffer.size());
+
+		// Overwrite the oldest element
+		buffer.put('z');
+		CHECK(buffer.full());
+		CHECK('b' == buffer.get());
+		CHECK((capacity - 1) == buffer.size());
+
+		buffer.reset();
+		CHECK(buffer.empty());
+		CHECK(0 == buffer.size());
+	}
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Consume removes data from the front", "[CircularBuffer]",
+				   (CircularBuffer<char, 8>), (CircularBuffer<char, 8, false>))
+{
+	TestType buffer;
+
+	buffer.put("abcdefgh", 8);
+	buffer.consume(3);
+	CHECK(5 == buffer.size());
+	CHECK_FALSE(buffer.full());
+
+	buffer.put("ij", 2);
+	CHECK(drain(buffer) == "defghij");
+
+	buffer.put("xyz", 3);
+	buffer.consume(10);
+	CHECK(buffer.empty());
+}
+
+TEMPLATE_TEST_CASE("Circular Buffer: Peek the data as contiguous spans", "[CircularBuffer]",
+				   (CircularBuffer<char, 8>), (CircularBuffer<char, 8, false>))
+{
+	TestType buffer;
+
+	auto spans = buffer.peek_contiguous();
+	CHECK(0 == spans.size());
+
+	buffer.put("abcde", 5);
+	spans = buffer.peek_contiguous();
+	CHECK(std::string(spans.first.data, spans.first.size) == "abcde");
+	CHECK(0 == spans.second.size);
+
+	// The oldest data is at index 3, and the newest data wraps to the start of the storage
+	buffer.consume(3);
+	buffer.put("fghij", 5);
+	spans = buffer.peek_contiguous();
+	CHECK(std::string(spans.first.data, spans.first.size) == "defgh");
+	CHECK(std::string(spans.second.data, spans.second.size) == "ij");
+	CHECK(spans.second.data == buffer.storage());
+	CHECK(7 == spans.size());
+
+	// A full buffer
+	buffer.put("kl", 2);
+	spans = buffer.peek_contiguous();
+	CHECK(8 == spans.size());
+	CHECK(std::string(spans.first.data, spans.first.size) +
+			  std::string(spans.second.data, spans.second.size) ==
+		  "efghijkl");
+
+	buffer.consume(spans.first.size);
+	spans = buffer.peek_contiguous();
+	CHECK(std::string(spans.first.data, spans.first.size) == "ijkl");
+	CHECK(0 == spans.second.size);
+}
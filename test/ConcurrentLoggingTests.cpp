@@ -0,0 +1,171 @@
+// Built as a separate test executable with LOG_CONCURRENT_EN set
+#include <ArduinoLogger.h>
+#include <catch.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Producers are preempted while they hold a reservation, so they yield while waiting
+#define LOG_MPSC_WAIT() std::this_thread::yield()
+#include <internal/mpsc_circular_buffer.hpp>
+
+static_assert(LOG_CONCURRENT_EN,
+			  "ConcurrentLoggingTests must be compiled with LOG_CONCURRENT_EN set");
+
+namespace
+{
+/// Logs to an MPSCCircularBuffer, and flushes to a string
+template<size_t TBufferSize>
+class ConcurrentTestLogger final : public LoggerBaseT<ConcurrentTestLogger<TBufferSize>>
+{
+	friend class LoggerBaseT<ConcurrentTestLogger>;
+
+  public:
+	ConcurrentTestLogger() : LoggerBaseT<ConcurrentTestLogger>(true, log_level_e::debug, false)
+	{
+	}
+
+	size_t size() const noexcept final
+	{
+		return log_buffer_.size();
+	}
+
+	size_t capacity() const noexcept final
+	{
+		return log_buffer_.capacity();
+	}
+
+	std::string output;
+
+  protected:
+	void log_putc(char c) noexcept final
+	{
+		log_buffer_.put(c);
+	}
+
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
+	size_t format_customprefix(char* dst) noexcept final
+	{
+		memcpy(dst, "[t] ", 4);
+		return 4;
+	}
+
+	void flush_() noexcept final
+	{
+		while(!log_buffer_.empty())
+		{
+			output += log_buffer_.get();
+		}
+	}
+
+	void clear_() noexcept final
+	{
+		log_buffer_.reset();
+	}
+
+  private:
+	MPSCCircularBuffer<char, TBufferSize> log_buffer_;
+};
+} // namespace
+
+TEST_CASE("Concurrent logging: A statement is added as one record", "[ConcurrentLogging]")
+{
+	ConcurrentTestLogger<64> logger;
+
+	logger.info("value %d\n", 42);
+	logger.log_interrupt(log_level_e::warning, "irq\n");
+	logger.flush();
+
+	CHECK("<I> [t] value 42\n<W> [t] irq\n" == logger.output);
+	CHECK_FALSE(logger.has_overrun());
+}
+
+TEST_CASE("Concurrent logging: A statement which does not fit is dropped", "[ConcurrentLogging]")
+{
+	ConcurrentTestLogger<128> logger;
+	std::string message(120, 'x');
+
+	logger.info("first\n");
+	logger.info("%s\n", message.c_str());
+	CHECK(logger.has_overrun());
+
+	logger.flush();
+	CHECK("<I> [t] first\n<!> [t] ---Log buffer overrun: 1 records (128 bytes) dropped---\n" ==
+		  logger.output);
+}
+
+TEST_CASE("Concurrent logging: A long statement is truncated", "[ConcurrentLogging]")
+{
+	ConcurrentTestLogger<512> logger;
+	std::string message(LOG_RECORD_MAX_SIZE, 'x');
+
+	logger.info("%s\n", message.c_str());
+	logger.flush();
+
+	CHECK(LOG_RECORD_MAX_SIZE == logger.output.size());
+	CHECK('\n' == logger.output.back());
+}
+
+TEST_CASE("Concurrent logging: Statements from several threads do not interleave",
+		  "[ConcurrentLogging]")
+{
+	ConcurrentTestLogger<256> logger;
+	constexpr unsigned thread_count = 4;
+	constexpr unsigned statements_per_thread = 5000;
+	bool done = false;
+
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < thread_count; t++)
+	{
+		threads.emplace_back([&logger, t]() {
+			for(unsigned i = 0; i < statements_per_thread; i++)
+			{
+				logger.info("thread %u statement %u\n", t, i);
+				std::this_thread::yield();
+			}
+		});
+	}
+
+	std::thread consumer([&logger, &done]() {
+		while(!__atomic_load_n(&done, __ATOMIC_ACQUIRE))
+		{
+			logger.flush();
+			std::this_thread::yield();
+		}
+
+		logger.flush();
+	});
+
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	__atomic_store_n(&done, true, __ATOMIC_RELEASE);
+	consumer.join();
+
+	// Statements may be dropped while the buffer is full, but each one is intact
+	std::istringstream lines(logger.output);
+	std::string line;
+	unsigned next[thread_count] = {};
+	bool intact = true;
+	while(std::getline(lines, line))
+	{
+		unsigned t = 0;
+		unsigned i = 0;
+		intact = intact &&
+				 (2 == sscanf(line.c_str(), "<I> [t] thread %u statement %u", &t, &i)) &&
+				 (t < thread_count) && (i >= next[t]);
+		if(intact)
+		{
+			next[t] = i + 1;
+		}
+	}
+
+	CHECK(intact);
+}
@@ -19,6 +19,86 @@ class test
 	}
 };
 
+namespace
+{
+/// Strategy which stores output in a string with a capacity of 8, derived from LoggerBase
+class string_logger final : public LoggerBase
+{
+  public:
+	size_t size() const noexcept final
+	{
+		return buffer.size();
+	}
+
+	size_t capacity() const noexcept final
+	{
+		return 8;
+	}
+
+	std::string buffer;
+	std::string flushed;
+
+  protected:
+	void log_putc(char c) noexcept final
+	{
+		buffer.push_back(c);
+	}
+
+	void flush_() noexcept final
+	{
+		flushed += buffer;
+		buffer.clear();
+	}
+};
+
+/// The same strategy, derived from LoggerBaseT
+class crtp_string_logger final : public LoggerBaseT<crtp_string_logger>
+{
+	friend class LoggerBaseT<crtp_string_logger>;
+
+  public:
+	size_t size() const noexcept final
+	{
+		return buffer.size();
+	}
+
+	size_t capacity() const noexcept final
+	{
+		return 8;
+	}
+
+	std::string buffer;
+	std::string flushed;
+
+  protected:
+	void log_putc(char c) noexcept final
+	{
+		buffer.push_back(c);
+	}
+
+	void flush_() noexcept final
+	{
+		flushed += buffer;
+		buffer.clear();
+	}
+};
+
+template<class TLogger>
+void check_string_logger(TLogger& logger)
+{
+	logger.auto_flush(true);
+	logger.print("%s %d", "abcdef", 12345);
+	CHECK("abcdef 1" == logger.flushed);
+	CHECK("2345" == logger.buffer);
+
+	// The strategy still works through a LoggerBase reference
+	LoggerBase& base = logger;
+	base.flush();
+	CHECK("abcdef 12345" == logger.flushed);
+	CHECK(0 == base.size());
+}
+} // namespace
+
 TEST_CASE("TRACE Macro", "[CoreLogger]")
 {
 	std::string_view trace_string{TRACE()};
@@ -26,6 +106,27 @@ TEST_CASE("TRACE Macro", "[CoreLogger]")
 	CHECK(trace_string == compare_string);
 }
 
+TEST_CASE("TRACE_FMT Macro", "[CoreLogger]")
+{
+	std::string_view trace_string{TRACE_FMT("%d/%d\n")};
+	std::string compare_string =
+		std::string(__SHORT_FILE__) + ":" + std::to_string(__LINE__ - 2) + " %d/%d\n";
+	CHECK(trace_string == compare_string);
+}
+
+TEST_CASE("Log level prefix lengths", "[CoreLogger]")
+{
+	static_assert(LOG_LEVEL_SHORT_C_STRING_LENGTH(log_level_e::info) ==
+					  sizeof(LOG_LEVEL_INFO_PREFIX) - 1,
+				  "Prefix length must be known at compile time");
+
+	for(int i = 0; i < LOG_LEVEL_COUNT; i++)
+	{
+		auto l = static_cast<log_level_e>(i);
+		CHECK(strlen(LOG_LEVEL_TO_SHORT_C_STRING(l)) == LOG_LEVEL_SHORT_C_STRING_LENGTH(l));
+	}
+}
+
 TEST_CASE("Func Macro", "[CoreLogger]")
 {
 	CHECK(std::string_view("check_func_name") == std::string_view(test::check_func_name()));
@@ -87,3 +188,19 @@ TEST_CASE("Log Level to Short String", "[CoreLogger]")
 	auto off = LOG_LEVEL_TO_SHORT_C_STRING(log_level_e::off);
 	CHECK(0 == strcmp("O", off));
 }
+
+TEST_CASE("Module Level Limit", "[CoreLogger]")
+{
+	// By default, every module uses the global limit
+	static_assert(LOG_MODULE_LEVEL_LIMIT(0) == LOG_LEVEL_LIMIT(), "Module limit must be constexpr");
+	CHECK(LOG_LEVEL_LIMIT() == LOG_MODULE_LEVEL_LIMIT(7));
+}
+
+TEST_CASE("LoggerBaseT and LoggerBase strategies behave the same", "[CoreLogger]")
+{
+	string_logger direct;
+	crtp_string_logger crtp;
+
+	check_string_logger(direct);
+	check_string_logger(crtp);
+}
@@ -0,0 +1,156 @@
+#include <CircularBufferLogger.h>
+#include <DeferredCircularBufferLogger.h>
+#include <catch.hpp>
+#include <string>
+#include <test_helper.hpp>
+
+static uint32_t test_timestamp()
+{
+	return 42;
+}
+
+TEST_CASE("Deferred: Create a logger", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> logger;
+
+	CHECK(0 == logger.size());
+	CHECK(1024 == logger.capacity());
+	CHECK(true == logger.enabled());
+	CHECK(false == logger.echo());
+	CHECK(LOG_LEVEL_LIMIT() == logger.level());
+}
+
+TEST_CASE("Deferred: Formatting happens during flush", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	logger.info("Value %d, %u, %c, %x\n", -5, 7u, 'z', 0xbeef);
+	logger.debug("Long %ld, double %.2f\n", 1234567L, 3.14159);
+	CHECK(logger.size() > 0);
+	CHECK(log_buffer_output.empty());
+
+	logger.flush();
+	CHECK(log_buffer_output == "<I> Value -5, 7, z, beef\n<D> Long 1234567, double 3.14\n");
+	CHECK(0 == logger.size());
+}
+
+TEST_CASE("Deferred: Output matches the immediate logger", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> deferred;
+	CircularLogBufferLogger<1024> immediate;
+
+	log_buffer_output.clear();
+	deferred.warning("%s: %d of %d\n", "progress", 3, 10);
+	deferred.print("raw %d|", 1);
+	deferred.write("text|", 5);
+	deferred.flush();
+	std::string deferred_output = log_buffer_output;
+
+	log_buffer_output.clear();
+	immediate.warning("%s: %d of %d\n", "progress", 3, 10);
+	immediate.print("raw %d|", 1);
+	immediate.write("text|", 5);
+	immediate.flush();
+
+	CHECK(deferred_output == log_buffer_output);
+}
+
+TEST_CASE("Deferred: String arguments are copied", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	char name[16] = "sensor";
+	const char* ptr = name;
+	logger.info("%s %s\n", name, ptr);
+	strcpy(name, "changed");
+
+	logger.flush();
+	CHECK(log_buffer_output == "<I> sensor sensor\n");
+}
+
+TEST_CASE("Deferred: Long strings are truncated", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	std::string long_string(LOG_DEFERRED_MAX_STRING_LENGTH + 10, 'a');
+	logger.info("%s", long_string.c_str());
+	logger.flush();
+
+	CHECK(log_buffer_output == "<I> " + std::string(LOG_DEFERRED_MAX_STRING_LENGTH, 'a'));
+}
+
+TEST_CASE("Deferred: Timestamps are recorded", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> logger;
+	logger.timestamp_clock(&test_timestamp);
+	log_buffer_output.clear();
+
+	logger.error("failed\n");
+	logger.flush();
+
+	CHECK(log_buffer_output == "<E> [42 ms] failed\n");
+}
+
+TEST_CASE("Deferred: Timestamps can be disabled", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> logger;
+	logger.timestamp_clock(nullptr);
+	log_buffer_output.clear();
+
+	logger.error("failed\n");
+	logger.flush();
+
+	CHECK(log_buffer_output == "<E> failed\n");
+}
+
+TEST_CASE("Deferred: Run-time filtering", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<1024> logger;
+	logger.level(log_level_e::warning);
+
+	logger.debug("This should not be added %d", 1);
+	CHECK(0 == logger.size());
+}
+
+TEST_CASE("Deferred: Overrun drops whole records", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<256> logger;
+	log_buffer_output.clear();
+
+	for(int i = 0; i < 100; i++)
+	{
+		logger.info("Record %d\n", i);
+	}
+
+	CHECK(logger.has_overrun());
+	logger.flush();
+	CHECK_FALSE(logger.has_overrun());
+
+	// The oldest records are dropped, and every surviving record is intact
+	CHECK(log_buffer_output.find("<I> Record 99\n") != std::string::npos);
+	CHECK(log_buffer_output.find("<I> Record 0\n") == std::string::npos);
+	CHECK(log_buffer_output.rfind("<!> ---Log buffer overrun detected---\n") !=
+		  std::string::npos);
+	CHECK(log_buffer_output.compare(0, 11, "<I> Record ") == 0);
+}
+
+TEST_CASE("Deferred: Auto-flush keeps all records", "[DeferredCircularBufferLogger]")
+{
+	DeferredCircularLogBufferLogger<256> logger;
+	logger.auto_flush(true);
+	log_buffer_output.clear();
+
+	std::string expected;
+	for(int i = 0; i < 100; i++)
+	{
+		logger.info("Record %d\n", i);
+		expected += "<I> Record " + std::to_string(i) + "\n";
+	}
+
+	logger.flush();
+	CHECK_FALSE(logger.has_overrun());
+	CHECK(log_buffer_output == expected);
+}
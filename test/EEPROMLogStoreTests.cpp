@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <internal/eeprom_log_store.hpp>
+#include <string>
+#include <vector>
+
+namespace
+{
+/// Erased EEPROM which counts writes to each cell and read() calls
+struct test_eeprom
+{
+	explicit test_eeprom(size_t size = 1024) : data(size, 0xFF), writes(size, 0) {}
+
+	uint8_t read(unsigned address)
+	{
+		reads++;
+		return data[address];
+	}
+
+	void update(unsigned address, const uint8_t* src, size_t size)
+	{
+		for(size_t i = 0; i < size; i++)
+		{
+			if(data[address + i] != src[i])
+			{
+				data[address + i] = src[i];
+				writes[address + i]++;
+			}
+		}
+	}
+
+	std::vector<uint8_t> data;
+	std::vector<unsigned> writes;
+	unsigned reads = 0;
+};
+
+using test_store = EEPROMLogStore<test_eeprom, 16>;
+
+template<class TStore>
+std::string read_all(const TStore& store)
+{
+	std::string text;
+	char payload[TStore::payload_size];
+
+	for(size_t i = 0; i < store.used_slots(); i++)
+	{
+		text.append(payload, store.read(i, payload));
+	}
+
+	return text;
+}
+} // namespace
+
+TEST_CASE("EEPROMLogStore: An erased region is empty", "[EEPROMLogStore]")
+{
+	test_eeprom eeprom;
+	test_store store;
+	store.begin(eeprom, 100, 130);
+
+	CHECK(8 == store.slot_count());
+	CHECK(128 == store.capacity());
+	CHECK(0 == store.size());
+	CHECK(0 == store.next_sequence());
+	CHECK(read_all(store).empty());
+}
+
+TEST_CASE("EEPROMLogStore: Data is split into records and recovered", "[EEPROMLogStore]")
+{
+	test_eeprom eeprom;
+	test_store store;
+	store.begin(eeprom, 0, 256);
+
+	store.write("Hello world\n", 12);
+	store.write("Second flush\n", 13);
+	// 10 payload bytes per slot, and each write starts a new record
+	CHECK(4 == store.used_slots());
+	CHECK(read_all(store) == "Hello world\nSecond flush\n");
+
+	test_store recovered;
+	recovered.begin(eeprom, 0, 256);
+	CHECK(4 == recovered.used_slots());
+	CHECK(4 == recovered.next_sequence());
+	CHECK(read_all(recovered) == "Hello world\nSecond flush\n");
+
+	recovered.write("Third\n", 6);
+	CHECK(read_all(recovered) == "Hello world\nSecond flush\nThird\n");
+}
+
+TEST_CASE("EEPROMLogStore: The oldest records are overwritten", "[EEPROMLogStore]")
+{
+	test_eeprom eeprom;
+	std::string expected;
+
+	for(int boot = 0; boot < 20; boot++)
+	{
+		test_store store;
+		store.begin(eeprom, 0, 16 * 5);
+		std::string line = "boot " + std::to_string(boot) + "\n";
+		store.write(line.c_str(), line.size());
+		expected += line;
+	}
+
+	test_store store;
+	store.begin(eeprom, 0, 16 * 5);
+	CHECK(5 == store.used_slots());
+	CHECK(20 == store.next_sequence());
+	CHECK(read_all(store) == expected.substr(expected.find("boot 15")));
+}
+
+TEST_CASE("EEPROMLogStore: Writes are spread across the region", "[EEPROMLogStore]")
+{
+	test_eeprom eeprom(16 * 64);
+	test_store store;
+	store.begin(eeprom, 0, 16 * 64);
+
+	for(int i = 0; i < 64 * 10; i++)
+	{
+		store.write("x\n", 2);
+	}
+
+	// Every cell has been written at most once per pass around the ring
+	CHECK(*std::max_element(eeprom.writes.begin(), eeprom.writes.end()) <= 10);
+	// Payload bytes past the end of the data are never written
+	CHECK(0 == eeprom.writes[15 - 6]);
+}
+
+TEST_CASE("EEPROMLogStore: Recovery uses a binary search", "[EEPROMLogStore]")
+{
+	test_eeprom eeprom(16 * 64);
+	test_store store;
+	store.begin(eeprom, 0, 16 * 64);
+
+	for(int i = 0; i < 37; i++)
+	{
+		store.write("abc", 3);
+	}
+
+	eeprom.reads = 0;
+	test_store recovered;
+	recovered.begin(eeprom, 0, 16 * 64);
+	CHECK(37 == recovered.used_slots());
+	// Slot 0, the last slot, about log2(64) probes, and the newest slot
+	CHECK(eeprom.reads <= 16 * 10);
+}
+
+TEST_CASE("EEPROMLogStore: An interrupted write is ignored", "[EEPROMLogStore]")
+{
+	test_eeprom eeprom;
+	test_store store;
+	store.begin(eeprom, 0, 16 * 4);
+
+	for(int i = 0; i < 5; i++)
+	{
+		std::string line = std::to_string(i);
+		store.write(line.c_str(), line.size());
+	}
+
+	// Corrupt the newest record (slot 0 after wrapping), as if a reset interrupted the write
+	eeprom.data[2] ^= 0xFF;
+
+	test_store recovered;
+	recovered.begin(eeprom, 0, 16 * 4);
+	CHECK(4 == recovered.next_sequence());
+	CHECK(read_all(recovered) == "123");
+
+	recovered.write("5", 1);
+	CHECK(read_all(recovered) == "1235");
+}
+
+TEST_CASE("EEPROMLogStore: Blocks are packed into records, and the first is marked",
+		  "[EEPROMLogStore]")
+{
+	test_eeprom eeprom;
+	test_store store;
+	store.begin(eeprom, 0, 128);
+
+	{
+		test_store::block_writer writer(store);
+		writer.write("0123456", 7);
+		writer.write("789abcdef", 9);
+		writer.finish();
+	}
+
+	{
+		test_store::block_writer writer(store);
+		writer.write("block 2", 7);
+		writer.finish();
+	}
+
+	// 10 payload bytes per slot
+	CHECK(3 == store.used_slots());
+	CHECK(0 == store.first_block());
+	CHECK(read_all(store) == "0123456789abcdefblock 2");
+
+	// Blocks of three records. Once the ring wraps, the oldest record is the second record of
+	// a block, so the oldest whole block starts two records later.
+	for(int i = 0; i < 3; i++)
+	{
+		test_store::block_writer writer(store);
+		writer.write("0123456789abcdefghij-----", 25);
+		writer.finish();
+	}
+
+	test_store recovered;
+	recovered.begin(eeprom, 0, 128);
+	CHECK(8 == recovered.used_slots());
+	CHECK(2 == recovered.first_block());
+}
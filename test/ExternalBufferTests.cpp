@@ -0,0 +1,72 @@
+#include <catch.hpp>
+#include <internal/external_buffer.hpp>
+#include <internal/log_sink.hpp>
+#include <internal/spsc_circular_buffer.hpp>
+#include <string>
+
+namespace
+{
+CircularBuffer<char, 16> test_storage;
+SPSCCircularBuffer<char, 8> test_spsc_storage;
+
+struct string_sink
+{
+	size_t write(const char* data, size_t size)
+	{
+		contents.append(data, size);
+		return size;
+	}
+
+	std::string contents;
+};
+} // namespace
+
+TEST_CASE("ExternalBuffer: Initializes the buffer it names", "[ExternalBuffer]")
+{
+	// Simulate memory which the startup code did not clear
+	memset(static_cast<void*>(&test_storage), 0x5a, sizeof(test_storage));
+
+	ExternalBuffer<CircularBuffer<char, 16>, test_storage> buffer;
+
+	CHECK(buffer.empty());
+	CHECK(0 == buffer.size());
+	CHECK(16 == buffer.capacity());
+	CHECK(test_storage.empty());
+}
+
+TEST_CASE("ExternalBuffer: Forwards to the buffer", "[ExternalBuffer]")
+{
+	ExternalBuffer<CircularBuffer<char, 16>, test_storage> buffer;
+
+	buffer.put('a');
+	buffer.put("bcdef", 5);
+	CHECK(6 == buffer.size());
+	CHECK(6 == test_storage.size());
+
+	CHECK('a' == buffer.get());
+	buffer.consume(1);
+
+	string_sink sink;
+	CHECK(4 == drain_to_sink(sink, buffer));
+	CHECK("cdef" == sink.contents);
+	CHECK(buffer.empty());
+
+	buffer.put("0123456789abcdefXY", 18);
+	CHECK(buffer.full());
+
+	buffer.reset();
+	CHECK(buffer.empty());
+}
+
+TEST_CASE("ExternalBuffer: Works with the lock-free buffer", "[ExternalBuffer]")
+{
+	ExternalBuffer<SPSCCircularBuffer<char, 8>, test_spsc_storage> buffer;
+
+	buffer.put("abcdef", 6);
+	buffer.consume(4);
+	buffer.put("ghij", 4);
+
+	string_sink sink;
+	CHECK(6 == drain_to_sink(sink, buffer));
+	CHECK("efghij" == sink.contents);
+}
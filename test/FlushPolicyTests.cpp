@@ -0,0 +1,105 @@
+#include <CircularBufferLogger.h>
+#include <catch.hpp>
+#include <internal/flush_policy.hpp>
+#include <test_helper.hpp>
+
+TEST_CASE("FlushPolicy: Defaults", "[FlushPolicy]")
+{
+	FlushPolicy policy;
+
+	CHECK(LOG_FLUSH_WATERMARK_DEFAULT == policy.watermark());
+	CHECK(LOG_FLUSH_MAX_AGE_MS_DEFAULT == policy.max_age());
+	CHECK(LOG_FLUSH_ON_CRITICAL_DEFAULT == policy.flush_on_critical());
+	CHECK(false == policy.due(0, 100, 0));
+
+	policy.watermark(150);
+	CHECK(100 == policy.watermark());
+}
+
+TEST_CASE("FlushPolicy: Flush at the watermark", "[FlushPolicy]")
+{
+	FlushPolicy policy;
+	policy.watermark(75);
+	policy.max_age(0);
+
+	CHECK(false == policy.due(767, 1024, 0));
+	CHECK(true == policy.due(768, 1024, 0));
+
+	// The watermark does not overflow for large capacities
+	CHECK(false == policy.due(SIZE_MAX / 2, SIZE_MAX, 0));
+	CHECK(true == policy.due(SIZE_MAX - SIZE_MAX / 4, SIZE_MAX, 0));
+
+	policy.watermark(0);
+	CHECK(false == policy.due(1024, 1024, 0));
+}
+
+TEST_CASE("FlushPolicy: Flush once data reaches the maximum age", "[FlushPolicy]")
+{
+	FlushPolicy policy;
+	policy.watermark(0);
+	policy.max_age(100);
+
+	// Age is measured from the first check that finds data in the buffer
+	CHECK(false == policy.due(0, 1024, 1000));
+	CHECK(false == policy.due(10, 1024, 1050));
+	CHECK(false == policy.due(20, 1024, 1149));
+	CHECK(true == policy.due(20, 1024, 1150));
+
+	// Data left after a flush is aged from the next check
+	policy.flushed();
+	CHECK(false == policy.due(5, 1024, 1200));
+	CHECK(true == policy.due(5, 1024, 1300));
+
+	// The clock may wrap around
+	policy.flushed();
+	CHECK(false == policy.due(5, 1024, UINT32_MAX - 10));
+	CHECK(true == policy.due(5, 1024, 90));
+}
+
+TEST_CASE("FlushPolicy: poll() flushes the logger", "[FlushPolicy]")
+{
+	CircularLogBufferLogger<100> logger;
+	logger.flush_policy().watermark(50);
+	logger.flush_policy().max_age(0);
+
+	log_buffer_output.clear();
+	logger.print("0123456789012345678901234567890123456789");
+	CHECK(false == logger.poll(0));
+	CHECK(log_buffer_output.empty());
+
+	logger.print("0123456789");
+	CHECK(true == logger.poll(0));
+	CHECK(50 == log_buffer_output.size());
+	CHECK(0 == logger.size());
+}
+
+TEST_CASE("FlushPolicy: Critical statements are written immediately", "[FlushPolicy]")
+{
+	CircularLogBufferLogger<1024> logger;
+	logger.flush_policy().flush_on_critical(true);
+
+	log_buffer_output.clear();
+	logger.error("Not yet\n");
+	CHECK(log_buffer_output.empty());
+
+	logger.critical("Now\n");
+	CHECK(log_buffer_output == construct_log_string(log_level_e::error, "Not yet\n") +
+								   construct_log_string(log_level_e::critical, "Now\n"));
+	CHECK(0 == logger.size());
+}
+
+TEST_CASE("FlushPolicy: An overrun is reported once with flush on critical", "[FlushPolicy]")
+{
+	CircularLogBufferLogger<64> logger;
+	logger.flush_policy().flush_on_critical(true);
+	logger.auto_flush(false);
+
+	logger.print("0123456789012345678901234567890123456789012345678901234567890123456789");
+	CHECK(logger.has_overrun());
+
+	log_buffer_output.clear();
+	logger.flush();
+	CHECK(false == logger.has_overrun());
+	CHECK(std::string::npos != log_buffer_output.find("overrun"));
+	CHECK(log_buffer_output.find("overrun") == log_buffer_output.rfind("overrun"));
+}
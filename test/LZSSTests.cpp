@@ -0,0 +1,160 @@
+#include <catch.hpp>
+#include <internal/circular_buffer.hpp>
+#include <internal/lzss_encoder.hpp>
+#include <lzss_decoder.hpp>
+#include <string>
+
+namespace
+{
+/// Sink which appends to a string, and optionally accepts only part of the data
+struct string_sink
+{
+	size_t write(const char* data, size_t size)
+	{
+		size_t count = (size > limit) ? limit : size;
+		output.append(data, count);
+		limit -= count;
+		return count;
+	}
+
+	std::string output;
+	size_t limit = SIZE_MAX;
+};
+
+std::string decode(const std::string& data)
+{
+	LZSSDecoder decoder;
+	std::string output;
+	bool success =
+		decoder.decode(reinterpret_cast<const uint8_t*>(data.data()), data.size(), output);
+	INFO(decoder.error());
+	CHECK(success);
+	return output;
+}
+
+std::string sample_log()
+{
+	std::string text;
+
+	for(int i = 0; i < 40; i++)
+	{
+		text += "<I> [" + std::to_string(1000 + i * 17) + " ms] sensor: sample " +
+				std::to_string(i) + " value " + std::to_string(i * 31 % 97) + "\n";
+	}
+
+	return text;
+}
+} // namespace
+
+TEST_CASE("LZSS: Log text round-trips, and compresses", "[LZSS]")
+{
+	LZSSEncoder<> encoder;
+	string_sink sink;
+	std::string text = sample_log();
+
+	encoder.write(sink, text.data(), text.size());
+	CHECK(sink.output.size() == encoder.end_block(sink));
+	CHECK(sink.output.size() == encoder.block_size());
+
+	CHECK(text == decode(sink.output));
+	CHECK(sink.output.size() < text.size() / 2);
+}
+
+TEST_CASE("LZSS: Input pieces do not change the output", "[LZSS]")
+{
+	std::string text = sample_log();
+	LZSSEncoder<> whole;
+	string_sink whole_sink;
+	whole.write(whole_sink, text.data(), text.size());
+	whole.end_block(whole_sink);
+
+	LZSSEncoder<> pieces;
+	string_sink pieces_sink;
+	for(size_t i = 0; i < text.size(); i += 7)
+	{
+		pieces.write(pieces_sink, &text[i], std::min<size_t>(7, text.size() - i));
+	}
+	pieces.end_block(pieces_sink);
+
+	CHECK(whole_sink.output == pieces_sink.output);
+}
+
+TEST_CASE("LZSS: Runs and data without repeats round-trip", "[LZSS]")
+{
+	LZSSEncoder<5> encoder;
+	string_sink sink;
+	std::string run(100, 'a');
+	std::string mixed;
+
+	for(int i = 0; i < 256; i++)
+	{
+		mixed.push_back(static_cast<char>((i * 73) & 0xFF));
+	}
+
+	encoder.write(sink, run.data(), run.size());
+	encoder.end_block(sink);
+	encoder.write(sink, mixed.data(), mixed.size());
+	encoder.end_block(sink);
+	// An empty block is valid
+	encoder.end_block(sink);
+
+	CHECK(run + mixed == decode(sink.output));
+}
+
+TEST_CASE("LZSS: Blocks decode on their own", "[LZSS]")
+{
+	LZSSEncoder<> encoder;
+	string_sink first;
+	string_sink second;
+	std::string text = "<I> repeated statement\n";
+
+	encoder.write(first, text.data(), text.size());
+	encoder.end_block(first);
+	encoder.write(second, text.data(), text.size());
+	encoder.end_block(second);
+
+	// The second block does not refer to the first
+	CHECK(text == decode(second.output));
+}
+
+TEST_CASE("LZSS: A circular buffer is compressed as one block", "[LZSS]")
+{
+	CircularBuffer<char, 64> buffer;
+	LZSSEncoder<> encoder;
+	string_sink sink;
+
+	buffer.put("0123456789012345678901234567890123456789", 40);
+	buffer.consume(40);
+	buffer.put("<W> wrapped <W> wrapped <W> wrapped\n", 36);
+
+	CHECK(encoder.compress(sink, buffer, buffer.size()));
+	CHECK(36 == buffer.size());
+	CHECK("<W> wrapped <W> wrapped <W> wrapped\n" == decode(sink.output));
+
+	// A sink which does not accept the whole block is reported
+	string_sink short_sink;
+	short_sink.limit = 4;
+	CHECK_FALSE(encoder.compress(short_sink, buffer, buffer.size()));
+}
+
+TEST_CASE("LZSS: The decoder reports damaged data", "[LZSS]")
+{
+	LZSSEncoder<> encoder;
+	string_sink sink;
+	std::string text = sample_log();
+
+	encoder.write(sink, text.data(), text.size());
+	encoder.end_block(sink);
+
+	LZSSDecoder decoder;
+	std::string output;
+	std::string truncated = sink.output.substr(0, sink.output.size() / 2);
+	CHECK_FALSE(decoder.decode(reinterpret_cast<const uint8_t*>(truncated.data()),
+							   truncated.size(), output));
+	CHECK(0 == decoder.blocks());
+
+	// A match which refers to data before the block
+	const uint8_t bad[] = {0x00, 0x05, 0x00};
+	CHECK_FALSE(decoder.decode(bad, sizeof(bad), output));
+	CHECK_FALSE(decoder.error().empty());
+}
@@ -0,0 +1,243 @@
+#include <CircularBufferLogger.h>
+#include <DeferredCircularBufferLogger.h>
+#include <SdFat.h>
+#include <TeeLogger.h>
+#include <TeensySDRotationalLogger.h>
+#include <TeensySDRotationalModuleLogger.h>
+#include <binary_log_decoder.hpp>
+#include <catch.hpp>
+#include <cstdio>
+#include <internal/log_format.hpp>
+#include <internal/log_record_builder.hpp>
+#include <limits>
+#include <string>
+#include <test_helper.hpp>
+
+// The parser is constexpr, so most of it is checked at compile time
+static_assert(log_fmt_count("no conversions\n", 0) == 0, "");
+static_assert(log_fmt_count("%d %s %%\n", 0) == 2, "");
+static_assert(log_fmt_count("%*.*f\n", 0) == 3, "A '*' consumes an argument");
+static_assert(log_fmt_valid("%d %lu %zu %p %5.2f\n", 0), "");
+static_assert(!log_fmt_valid("%n\n", 0), "%n is not supported");
+static_assert(!log_fmt_valid("incomplete %", 0), "");
+static_assert(log_fmt_simple("%d, %u, %x, %X, %c, %s, %ld, %llu %%\n", 0), "");
+static_assert(!log_fmt_simple("%5d\n", 0), "A width is not simple");
+static_assert(!log_fmt_simple("%-d\n", 0), "A flag is not simple");
+static_assert(!log_fmt_simple("%hhd\n", 0), "");
+static_assert(log_fmt_simple("%f %.0f %.3f %.9f\n", 0), "Fixed decimals are simple");
+static_assert(!log_fmt_simple("%5.2f\n", 0), "");
+static_assert(!log_fmt_simple("%.10f\n", 0), "");
+static_assert(!log_fmt_simple("%g %e\n", 0), "");
+static_assert(log_fmt_args<int, const char*>::match("%d %s\n", 0), "");
+static_assert(log_fmt_args<long>::match("%ld\n", 0), "");
+static_assert(!log_fmt_args<long>::match("%d\n", 0), "long needs %ld");
+static_assert(!log_fmt_args<int>::match("%s\n", 0), "");
+static_assert(log_fmt_args<unsigned char, char>::match("%u %c\n", 0), "Promoted to int");
+static_assert(log_fmt_args<size_t>::match("%zu\n", 0), "");
+static_assert(log_fmt_args<double, float>::match("%f %g\n", 0), "");
+static_assert(!log_fmt_args<long double>::match("%f\n", 0), "long double needs %Lf");
+static_assert(log_fmt_args<int*, const char*>::match("%p %p\n", 0), "");
+
+namespace
+{
+template<class TString, typename... Args>
+std::string format(const log_format<TString>& fmt, const Args&... args)
+{
+	LogRecordBuilder<128> record;
+	log_format_write(record, fmt, args...);
+	return std::string(record.data(), record.size());
+}
+
+template<typename... Args>
+std::string format_printf(const char* fmt, const Args&... args)
+{
+	char buffer[128];
+	int size = snprintf(buffer, sizeof(buffer), fmt, args...);
+	return std::string(buffer, static_cast<size_t>(size));
+}
+
+template<typename... Args>
+std::string format_fctprintf(const char* fmt, const Args&... args)
+{
+	LogRecordBuilder<128> record;
+	fctprintf(&LogRecordBuilder<128>::putc_bounce, &record, fmt, args...);
+	return std::string(record.data(), record.size());
+}
+
+/// The contents of the current log file of an SD logger
+template<class TLogger>
+std::string log_file(const TLogger& logger, const char* extension)
+{
+	char name[log_filename_max_size + 1];
+	format_log_filename(name, logger.file_index(), extension);
+	return fake_files[name];
+}
+
+std::string decode(const std::string& file)
+{
+	std::string output;
+	BinaryLogDecoder decoder;
+	CHECK(decoder.decode(reinterpret_cast<const uint8_t*>(file.data()), file.size(), output));
+	return output;
+}
+} // namespace
+
+TEST_CASE("LOG_FMT: Simple formats match printf", "[LogFormat]")
+{
+	CHECK(format(LOG_FMT("Hello world\n")) == "Hello world\n");
+	CHECK(format(LOG_FMT("%d %i %u\n"), -42, 0, 42U) == format_printf("%d %i %u\n", -42, 0, 42U));
+	CHECK(format(LOG_FMT("%x %X\n"), 0xbeefU, 0xbeefU) ==
+		  format_printf("%x %X\n", 0xbeefU, 0xbeefU));
+	CHECK(format(LOG_FMT("%ld %lu\n"), INT32_MIN + 0L, UINT32_MAX + 0UL) ==
+		  format_printf("%ld %lu\n", INT32_MIN + 0L, UINT32_MAX + 0UL));
+	CHECK(format(LOG_FMT("%llx\n"), 0x123456789abcdefULL) ==
+		  format_printf("%llx\n", 0x123456789abcdefULL));
+	CHECK(format(LOG_FMT("%c%s%%\n"), 'a', "bc") == "abc%\n");
+	CHECK(format(LOG_FMT("[%s]\n"), static_cast<const char*>(nullptr)) == "[(null)]\n");
+}
+
+TEST_CASE("LOG_FMT: Fixed decimals match printf", "[LogFormat]")
+{
+	CHECK(format(LOG_FMT("%f %.3f\n"), 1.5, -3.14159f) ==
+		  format_printf("%f %.3f\n", 1.5, -3.14159));
+	CHECK(format(LOG_FMT("%.0f %.0f %.1f\n"), 2.7, 3.5, 0.0) ==
+		  format_printf("%.0f %.0f %.1f\n", 2.7, 3.5, 0.0));
+	CHECK(format(LOG_FMT("%.2f %.2f\n"), 0.125, 0.375) == "0.12 0.38\n");
+	CHECK(format(LOG_FMT("%.2f|%.2f\n"), 999.9999, -0.0001) == "1000.00|-0.00\n");
+	CHECK(format(LOG_FMT("%.9f\n"), 0.000000001) == format_printf("%.9f\n", 0.000000001));
+	CHECK(format(LOG_FMT("%.1f\n"), 123456789.25) == "123456789.2\n");
+}
+
+TEST_CASE("LOG_FMT: Fixed decimals outside the fast range use printf", "[LogFormat]")
+{
+	CHECK(format(LOG_FMT("%.1f\n"), 1e10) == format_fctprintf("%.1f\n", 1e10));
+	CHECK(format(LOG_FMT("%.1f\n"), -1e10) == format_fctprintf("%.1f\n", -1e10));
+	CHECK(format(LOG_FMT("%.2f\n"), std::numeric_limits<double>::infinity()) ==
+		  format_fctprintf("%.2f\n", std::numeric_limits<double>::infinity()));
+}
+
+TEST_CASE("LOG_FMT: Other formats are written by printf", "[LogFormat]")
+{
+	CHECK(format(LOG_FMT("%5.2f|%-4d|%04x\n"), 1.5, 7, 255U) ==
+		  format_printf("%5.2f|%-4d|%04x\n", 1.5, 7, 255U));
+}
+
+TEST_CASE("LOG_FMT: The logger output matches a run-time format", "[LogFormat]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	logger.info("Sensor %s: %d (%lu ms)\n", "imu", -3, 1200UL);
+	logger.flush();
+	std::string expected = log_buffer_output;
+
+	log_buffer_output.clear();
+	logger.info(LOG_FMT("Sensor %s: %d (%lu ms)\n"), "imu", -3, 1200UL);
+	logger.flush();
+
+	CHECK("<I> Sensor imu: -3 (1200 ms)\n" == expected);
+	CHECK(expected == log_buffer_output);
+}
+
+TEST_CASE("LOG_FMT: The level is checked", "[LogFormat]")
+{
+	CircularLogBufferLogger<1024> logger;
+	logger.level(log_level_e::warning);
+	log_buffer_output.clear();
+
+	logger.debug(LOG_FMT("Hidden %d\n"), 1);
+	logger.error(LOG_FMT("Shown %d\n"), 2);
+	logger.flush();
+
+	CHECK("<E> Shown 2\n" == log_buffer_output);
+}
+
+TEST_CASE("LOG_FMT: The SD strategy checks the format", "[LogFormat]")
+{
+	// A mismatch such as info(LOG_FMT("%d\n"), 5L) fails to compile with each of these
+	static SdFs sd;
+	fake_files.clear();
+
+	SECTION("Text files")
+	{
+		static TeensySDRotationalLogger logger;
+		logger.begin(sd);
+
+		logger.info(LOG_FMT("Sensor %s: %d\n"), "imu", -3);
+		logger.print(LOG_FMT("%u%%\n"), 50U);
+		logger.flush();
+
+		CHECK(std::string::npos != log_file(logger, ".txt").find("Sensor imu: -3\n50%\n"));
+	}
+
+	SECTION("Binary files")
+	{
+		static TeensySDRotationalLogger_t<log_file_format_e::binary> logger;
+		logger.begin(sd);
+
+		logger.info(LOG_FMT("Sensor %s: %d\n"), "imu", -3);
+		logger.debug_interrupt(LOG_FMT("Reading %ld\n"), 1200L);
+		logger.flush();
+
+		std::string output = decode(log_file(logger, ".bin"));
+		CHECK(std::string::npos != output.find("Sensor imu: -3\n"));
+		CHECK(std::string::npos != output.find("Reading 1200\n"));
+	}
+
+	SECTION("PlatformLogger_t")
+	{
+		using logger = PlatformLogger_t<TeensySDRotationalLogger>;
+		logger::inst().begin(sd);
+
+		logger::warning(LOG_FMT("Sensor %s: %d\n"), "imu", -3);
+		logger::flush();
+
+		CHECK(std::string::npos != log_file(logger::inst(), ".txt").find("Sensor imu: -3\n"));
+	}
+}
+
+TEST_CASE("LOG_FMT: Strategies with their own log() check the format", "[LogFormat]")
+{
+	log_buffer_output.clear();
+
+	SECTION("DeferredCircularLogBufferLogger")
+	{
+		DeferredCircularLogBufferLogger<1024> logger;
+		logger.timestamp_clock(nullptr);
+
+		logger.info(LOG_FMT("Sensor %s: %d\n"), "imu", -3);
+		logger.flush();
+
+		CHECK("<I> Sensor imu: -3\n" == log_buffer_output);
+	}
+
+	SECTION("TeeLogger")
+	{
+		TeeLogger<CircularLogBufferLogger<512>, CircularLogBufferLogger<512>> tee;
+		tee.echo(false);
+
+		tee.error(LOG_FMT("Sensor %s: %d\n"), "imu", -3);
+		tee.flush();
+
+		CHECK("<E> Sensor imu: -3\n<E> Sensor imu: -3\n" == log_buffer_output);
+	}
+
+	SECTION("TeensySDRotationalModuleLogger")
+	{
+		static SdFs sd;
+		static TeensySDRotationalModuleLogger<2> logger;
+		fake_files.clear();
+		logger.begin(sd);
+		CHECK(LOG_MODULE_LEVEL_LIMIT(0) == logger.level(0));
+		CHECK(log_level_e::off == logger.level(1));
+		logger.level(1, log_level_e::info);
+
+		logger.info(1, LOG_FMT("Sensor %s: %d\n"), "imu", -3);
+		logger.info<1>(LOG_FMT("Reading %ld\n"), 1200L);
+		logger.flush();
+
+		std::string file = log_file(logger, ".txt");
+		CHECK(std::string::npos != file.find("Sensor imu: -3\n"));
+		CHECK(std::string::npos != file.find("Reading 1200\n"));
+	}
+}
@@ -0,0 +1,103 @@
+#include <CircularBufferLogger.h>
+#include <DeferredCircularBufferLogger.h>
+#include <TeeLogger.h>
+#include <catch.hpp>
+#include <internal/log_kv.hpp>
+#include <internal/log_record_builder.hpp>
+#include <string>
+#include <test_helper.hpp>
+
+namespace
+{
+enum class motor_state
+{
+	idle = 0,
+	running = 2,
+};
+
+template<typename... Fields>
+std::string format_kv(const char* name, const log_kv_field<Fields>&... fields)
+{
+	LogRecordBuilder<128> record;
+	log_kv_write(record, log_kv_record{name}, fields...);
+	return std::string(record.data(), record.size());
+}
+} // namespace
+
+TEST_CASE("log_kv: Fields are written as key=value pairs", "[LogKV]")
+{
+	CHECK(format_kv("boot") == "@boot\n");
+	CHECK(format_kv("motor", kv("rpm", 3000), kv("amps", 1.25)) == "@motor rpm=3000,amps=1.25\n");
+}
+
+TEST_CASE("log_kv: Integers are written in decimal", "[LogKV]")
+{
+	CHECK(format_kv("i", kv("a", -42), kv("b", 42U), kv("c", INT32_MIN + 0L)) ==
+		  "@i a=-42,b=42,c=-2147483648\n");
+	CHECK(format_kv("i", kv("max", UINT64_MAX + 0ULL)) == "@i max=18446744073709551615\n");
+	CHECK(format_kv("i", kv("small", static_cast<int8_t>(-5)), kv("byte", uint8_t(200))) ==
+		  "@i small=-5,byte=200\n");
+	CHECK(format_kv("i", kv("size", sizeof(uint32_t))) == "@i size=4\n");
+}
+
+TEST_CASE("log_kv: bool, enum, and float values", "[LogKV]")
+{
+	CHECK(format_kv("v", kv("ok", true), kv("err", false)) == "@v ok=true,err=false\n");
+	CHECK(format_kv("v", kv("state", motor_state::running)) == "@v state=2\n");
+	CHECK(format_kv("v", kv("t", 21.5f), kv("p", -0.001)) == "@v t=21.5,p=-0.001\n");
+}
+
+TEST_CASE("log_kv: Strings are quoted and escaped", "[LogKV]")
+{
+	char buffer[16] = "imu";
+
+	CHECK(format_kv("s", kv("name", "imu"), kv("buf", buffer)) == "@s name=\"imu\",buf=\"imu\"\n");
+	CHECK(format_kv("s", kv("q", "say \"hi\" \\o/")) == "@s q=\"say \\\"hi\\\" \\\\o/\"\n");
+	CHECK(format_kv("s", kv("empty", ""), kv("null", static_cast<const char*>(nullptr))) ==
+		  "@s empty=\"\",null=\"\"\n");
+}
+
+TEST_CASE("log_kv: Records are logged with the level prefix", "[LogKV]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	logger.log_kv(log_level_e::info, "motor", kv("rpm", 3000), kv("dir", "cw"));
+	logger.log_kv(log_level_e::debug, "imu", kv("ax", -12));
+	logger.level(log_level_e::info);
+	logger.log_kv(log_level_e::debug, "hidden", kv("x", 1));
+	logger.flush();
+
+	CHECK(log_buffer_output ==
+		  construct_log_string(log_level_e::info, "@motor rpm=3000,dir=\"cw\"\n") +
+			  construct_log_string(log_level_e::debug, "@imu ax=-12\n"));
+}
+
+TEST_CASE("log_kv: The platform logger forwards records", "[LogKV]")
+{
+	using test_platform_logger = PlatformLogger_t<CircularLogBufferLogger<256>>;
+	log_buffer_output.clear();
+
+	test_platform_logger::log_kv(log_level_e::warning, "battery", kv("mv", 3300U));
+	test_platform_logger::flush();
+
+	CHECK(log_buffer_output == construct_log_string(log_level_e::warning, "@battery mv=3300\n"));
+}
+
+TEST_CASE("log_kv: Strategies with their own log() store records", "[LogKV]")
+{
+	DeferredCircularLogBufferLogger<512> deferred;
+	TeeLogger<CircularLogBufferLogger<512>, CircularLogBufferLogger<512>> tee;
+	tee.sink<1>().level(log_level_e::warning);
+
+	deferred.log_kv(log_level_e::error, "fault", kv("code", 7));
+	log_buffer_output.clear();
+	deferred.flush();
+	CHECK(log_buffer_output == "<E> @fault code=7\n");
+
+	tee.log_kv(log_level_e::info, "motor", kv("rpm", 10));
+	CHECK(0 == tee.sink<1>().size());
+	log_buffer_output.clear();
+	tee.sink<0>().flush();
+	CHECK(log_buffer_output == construct_log_string(log_level_e::info, "@motor rpm=10\n"));
+}
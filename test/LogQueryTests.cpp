@@ -0,0 +1,126 @@
+#include <ArduinoLogger.h>
+#include <catch.hpp>
+#include <internal/log_query.hpp>
+#include <internal/record_circular_buffer.hpp>
+#include <string>
+
+namespace
+{
+using test_buffer = RecordCircularBuffer<char, 64, 8>;
+
+LogQuery<test_buffer> make_query(const test_buffer& buffer)
+{
+	return LogQuery<test_buffer>(buffer, logNames::level_short_names, LOG_LEVEL_COUNT);
+}
+
+void add(test_buffer& buffer, const char* record)
+{
+	buffer.put(record, strlen(record));
+}
+
+std::string text(const log_record_view& record)
+{
+	char copy[64];
+	return std::string(copy, record.copy(copy, sizeof(copy)));
+}
+
+struct string_sink
+{
+	size_t write(const char* data, size_t size)
+	{
+		output.append(data, size);
+		return size;
+	}
+
+	std::string output;
+};
+} // namespace
+
+TEST_CASE("Log query: Records are read without removing them", "[LogQuery]")
+{
+	test_buffer buffer;
+	add(buffer, "<I> one\n");
+	add(buffer, "<E> two\n");
+	add(buffer, "raw\n");
+	auto query = make_query(buffer);
+
+	REQUIRE(3 == query.count());
+	CHECK("<I> one\n" == text(query.record(0)));
+	CHECK("<E> two\n" == text(query.record(1)));
+	CHECK("raw\n" == text(query.record(2)));
+	CHECK(log_level_e::info == query.level(query.record(0)));
+	CHECK(log_level_e::error == query.level(query.record(1)));
+	CHECK(0 == query.level(query.record(2)));
+	CHECK(20 == buffer.size());
+	CHECK(3 == buffer.records());
+}
+
+TEST_CASE("Log query: tail() visits the newest matching records", "[LogQuery]")
+{
+	test_buffer buffer;
+	add(buffer, "<E> [imu] a\n");
+	add(buffer, "<I> [imu] b\n");
+	add(buffer, "<W> [gps] c\n");
+	add(buffer, "<!> [imu] d\n");
+	auto query = make_query(buffer);
+	string_sink sink;
+	auto write = [&sink](const log_record_view& record) { record.write_to(sink); };
+
+	CHECK(2 == query.tail(2, log_query_filter(), write));
+	CHECK("<W> [gps] c\n<!> [imu] d\n" == sink.output);
+
+	sink.output.clear();
+	CHECK(3 == query.tail(5, log_query_filter(log_level_e::warning), write));
+	CHECK("<E> [imu] a\n<W> [gps] c\n<!> [imu] d\n" == sink.output);
+
+	sink.output.clear();
+	CHECK(2 == query.tail(5, log_query_filter(log_level_e::error, "[imu]"), write));
+	CHECK("<E> [imu] a\n<!> [imu] d\n" == sink.output);
+
+	sink.output.clear();
+	CHECK(0 == query.tail(5, log_query_filter(log_level_e::debug, "[adc]"), write));
+	CHECK(0 == query.tail(0, log_query_filter(), write));
+	CHECK(sink.output.empty());
+}
+
+TEST_CASE("Log query: Records which wrap around the storage", "[LogQuery]")
+{
+	RecordCircularBuffer<char, 16, 4> buffer;
+	buffer.put("<I> 0123456\n", 12);
+	buffer.consume(12);
+	buffer.put("<W> wrap\n", 9);
+	auto query = LogQuery<RecordCircularBuffer<char, 16, 4>>(buffer, logNames::level_short_names,
+															   LOG_LEVEL_COUNT);
+	log_record_view record = query.record(0);
+	string_sink sink;
+
+	REQUIRE(1 == query.count());
+	CHECK(0 < record.text.second.size);
+	CHECK("<W> wrap\n" == text(record));
+	CHECK(log_level_e::warning == query.level(record));
+	CHECK(record.contains("p\n"));
+	CHECK(9 == record.write_to(sink));
+	CHECK("<W> wrap\n" == sink.output);
+}
+
+TEST_CASE("Log query: find_newer() uses the timestamp prefix", "[LogQuery]")
+{
+	test_buffer buffer;
+	add(buffer, "<I> [100 ms] a\n");
+	add(buffer, "plain\n");
+	add(buffer, "<W> [250 ms] b\n");
+	add(buffer, "<D> [+5 us] c\n");
+	add(buffer, "[300 ms] d\n");
+	auto query = make_query(buffer);
+	uint32_t value = 0;
+
+	CHECK(query.timestamp(query.record(0), value));
+	CHECK(100 == value);
+	CHECK_FALSE(query.timestamp(query.record(1), value));
+	CHECK_FALSE(query.timestamp(query.record(3), value));
+
+	CHECK(0 == query.find_newer(99));
+	CHECK(2 == query.find_newer(100));
+	CHECK(4 == query.find_newer(250));
+	CHECK(5 == query.find_newer(300));
+}
@@ -0,0 +1,32 @@
+#include <catch.hpp>
+#include <internal/log_record_builder.hpp>
+#include <string>
+
+TEST_CASE("LogRecordBuilder: Characters and blocks are appended", "[LogRecordBuilder]")
+{
+	LogRecordBuilder<16> record;
+
+	CHECK(0 == record.size());
+
+	record.put("<I> ", 4);
+	record.put('h');
+	LogRecordBuilder<16>::putc_bounce('i', &record);
+
+	CHECK(6 == record.size());
+	CHECK_FALSE(record.truncated());
+	CHECK("<I> hi" == std::string(record.data(), record.size()));
+}
+
+TEST_CASE("LogRecordBuilder: A long record is truncated, and ends with a newline",
+		  "[LogRecordBuilder]")
+{
+	LogRecordBuilder<8> record;
+
+	record.put("<I> ", 4);
+	record.put("message\n", 8);
+	record.put('x');
+
+	CHECK(8 == record.size());
+	CHECK(record.truncated());
+	CHECK("<I> mes\n" == std::string(record.data(), record.size()));
+}
@@ -0,0 +1,73 @@
+#include <catch.hpp>
+#include <internal/log_rotation.hpp>
+#include <string>
+
+TEST_CASE("LogRotation: File names round-trip", "[LogRotation]")
+{
+	char name[log_filename_max_size];
+	const uint32_t indices[] = {1, 254, 255, 256, 100000, UINT32_MAX};
+
+	for(auto index : indices)
+	{
+		size_t len = format_log_filename(name, index, ".txt");
+		CHECK(std::string(name) == "log_" + std::to_string(index) + ".txt");
+		CHECK(len == strlen(name));
+
+		uint32_t parsed = 0;
+		CHECK(parse_log_filename(name, ".txt", parsed));
+		CHECK(index == parsed);
+	}
+
+	CHECK(log_filename_max_size == format_log_filename(name, UINT32_MAX, ".bin") + 1);
+}
+
+TEST_CASE("LogRotation: Other file names are not parsed", "[LogRotation]")
+{
+	uint32_t index = 7;
+
+	CHECK(false == parse_log_filename("log_12.bin", ".txt", index));
+	CHECK(false == parse_log_filename("log_.txt", ".txt", index));
+	CHECK(false == parse_log_filename("log_12a.txt", ".txt", index));
+	CHECK(false == parse_log_filename("log_4294967296.txt", ".txt", index));
+	CHECK(false == parse_log_filename("mylog_12.txt", ".txt", index));
+	CHECK(false == parse_log_filename("log_index.dat", ".txt", index));
+	CHECK(7 == index);
+}
+
+TEST_CASE("LogRotation: Rotation is disabled by default", "[LogRotation]")
+{
+	LogRotationPolicy policy;
+
+	CHECK(LOG_ROTATE_SIZE_DEFAULT == policy.max_size());
+	CHECK(LOG_ROTATE_INTERVAL_MS_DEFAULT == policy.interval());
+	CHECK(false == policy.wrote(UINT32_MAX, UINT32_MAX));
+}
+
+TEST_CASE("LogRotation: Rotate once the file reaches the size limit", "[LogRotation]")
+{
+	LogRotationPolicy policy;
+	policy.max_size(1024);
+	policy.rotated(0);
+
+	CHECK(false == policy.wrote(512, 10));
+	CHECK(false == policy.wrote(511, 20));
+	CHECK(true == policy.wrote(1, 30));
+	CHECK(1024 == policy.file_size());
+
+	policy.rotated(30);
+	CHECK(0 == policy.file_size());
+	CHECK(false == policy.wrote(100, 40));
+}
+
+TEST_CASE("LogRotation: Rotate once the interval has passed", "[LogRotation]")
+{
+	LogRotationPolicy policy;
+	policy.interval(1000);
+	policy.rotated(UINT32_MAX - 100);
+
+	CHECK(false == policy.wrote(10, UINT32_MAX));
+	// An empty file is not rotated
+	policy.rotated(0);
+	CHECK(false == policy.wrote(0, 5000));
+	CHECK(true == policy.wrote(10, 5000));
+}
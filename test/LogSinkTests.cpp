@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <internal/circular_buffer.hpp>
+#include <internal/log_sink.hpp>
+#include <internal/spsc_circular_buffer.hpp>
+#include <string>
+
+namespace
+{
+/// Sink which accepts up to limit bytes in total, and records each write
+struct test_sink
+{
+	size_t write(const char* data, size_t size)
+	{
+		size = std::min(size, limit - output.size());
+		output.append(data, size);
+		writes++;
+		return size;
+	}
+
+	std::string output;
+	size_t limit = SIZE_MAX;
+	unsigned writes = 0;
+};
+} // namespace
+
+TEMPLATE_TEST_CASE("LogSink: Write wrapped data with two writes", "[LogSink]",
+				   (CircularBuffer<char, 8>), (CircularBuffer<char, 8, false>),
+				   (SPSCCircularBuffer<char, 8>))
+{
+	TestType buffer;
+	test_sink sink;
+
+	buffer.put("abcdef", 6);
+	buffer.consume(5);
+	buffer.put("ghijk", 5);
+
+	CHECK(4 == write_to_sink(sink, buffer, 4));
+	CHECK("fghi" == sink.output);
+	CHECK(2 == sink.writes);
+	CHECK(6 == buffer.size());
+
+	sink.output.clear();
+	CHECK(6 == drain_to_sink(sink, buffer));
+	CHECK("fghijk" == sink.output);
+	CHECK(buffer.empty());
+
+	// Nothing is written for an empty buffer
+	sink.writes = 0;
+	CHECK(0 == drain_to_sink(sink, buffer));
+	CHECK(0 == sink.writes);
+}
+
+TEST_CASE("LogSink: Data the sink does not accept stays in the buffer", "[LogSink]")
+{
+	CircularBuffer<char, 8> buffer;
+	test_sink sink;
+	sink.limit = 2;
+
+	buffer.put("abcdef", 6);
+	buffer.consume(5);
+	buffer.put("ghijk", 5);
+
+	// The short write of the first span stops the write
+	CHECK(2 == drain_to_sink(sink, buffer));
+	CHECK(1 == sink.writes);
+	CHECK("fg" == sink.output);
+	CHECK(4 == buffer.size());
+
+	sink.limit = 5;
+	CHECK(3 == drain_to_sink(sink, buffer));
+	CHECK("fghij" == sink.output);
+
+	sink.limit = SIZE_MAX;
+	CHECK(1 == drain_to_sink(sink, buffer));
+	CHECK("fghijk" == sink.output);
+	CHECK(buffer.empty());
+}
+
+TEST_CASE("LogSink: A sink reference forwards writes", "[LogSink]")
+{
+	test_sink sink;
+	log_sink_ref ref(sink);
+
+	CHECK(false == log_sink_ref().valid());
+	CHECK(ref.valid());
+	CHECK(3 == ref.write("abc", 3));
+	CHECK("abc" == sink.output);
+}
@@ -0,0 +1,180 @@
+// Built as a separate test executable with LOG_STATS_EN set
+#include <CircularBufferLogger.h>
+#include <DeferredCircularBufferLogger.h>
+#include <catch.hpp>
+#include <internal/log_stats.hpp>
+#include <string>
+#include <test_helper.hpp>
+
+static_assert(LOG_STATS_EN, "LogStatsTests must be compiled with LOG_STATS_EN set");
+
+TEST_CASE("LogStats: Durations", "[LogStats]")
+{
+	log_duration_stats durations;
+
+	CHECK(0 == durations.count());
+	CHECK(0 == durations.min());
+	CHECK(0 == durations.max());
+	CHECK(0 == durations.average());
+
+	durations.add(30);
+	durations.add(10);
+	durations.add(20);
+
+	CHECK(3 == durations.count());
+	CHECK(10 == durations.min());
+	CHECK(30 == durations.max());
+	CHECK(20 == durations.average());
+}
+
+TEST_CASE("LogStats: Counters", "[LogStats]")
+{
+	LogStats<LOG_LEVEL_COUNT> stats;
+
+	stats.wrote(4);
+	stats.logged(log_level_e::info, 0);
+	stats.wrote(6);
+	stats.logged(log_level_e::info, 4);
+	stats.wrote(5);
+	stats.logged(log_level_e::error, 10);
+	stats.dropped(3);
+	stats.buffered(100);
+	stats.buffered(50);
+	stats.flushed(7);
+	stats.stored(5);
+
+	CHECK(2 == stats.level(log_level_e::info).records);
+	CHECK(10 == stats.level(log_level_e::info).bytes);
+	CHECK(1 == stats.level(log_level_e::error).records);
+	CHECK(5 == stats.level(log_level_e::error).bytes);
+	CHECK(3 == stats.records());
+	CHECK(15 == stats.bytes());
+	CHECK(3 == stats.dropped());
+	CHECK(100 == stats.high_water());
+	CHECK(1 == stats.flushes());
+	CHECK(7 == stats.flush_time().max());
+	CHECK(5 == stats.write_time().max());
+
+	stats.reset();
+	CHECK(0 == stats.records());
+	CHECK(0 == stats.bytes());
+	CHECK(0 == stats.high_water());
+	CHECK(0 == stats.flushes());
+}
+
+TEST_CASE("LogStats: Records and bytes per level", "[LogStats]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	logger.info("Hello world\n");
+	logger.info("Value %d\n", 42);
+	logger.error("Oops\n");
+	logger.print("No prefix\n");
+
+	// Filtered out statements are not counted
+	logger.level(log_level_e::info);
+	logger.debug("Filtered\n");
+
+	auto& stats = logger.stats();
+	CHECK(2 == stats.level(log_level_e::info).records);
+	CHECK(strlen("Hello world\n") + strlen("Value 42\n") + 2 * prefix_len ==
+		  stats.level(log_level_e::info).bytes);
+	CHECK(1 == stats.level(log_level_e::error).records);
+	CHECK(strlen("Oops\n") + prefix_len == stats.level(log_level_e::error).bytes);
+	CHECK(0 == stats.level(log_level_e::debug).records);
+	CHECK(3 == stats.records());
+
+	// print() data is counted in the total, but is not a statement
+	CHECK(logger.size() == stats.bytes());
+}
+
+TEST_CASE("LogStats: Overruns and the high-water mark", "[LogStats]")
+{
+	CircularLogBufferLogger<64> logger;
+	logger.auto_flush(false);
+	log_buffer_output.clear();
+
+	std::string data(40, 'x');
+	logger.write(data.c_str(), data.size());
+	CHECK(0 == logger.stats().dropped());
+
+	logger.write(data.c_str(), data.size());
+	CHECK(true == logger.has_overrun());
+	CHECK(16 == logger.stats().dropped());
+
+	logger.print("%s", "xy");
+	CHECK(18 == logger.stats().dropped());
+
+	logger.flush();
+	CHECK(false == logger.has_overrun());
+	CHECK(64 == logger.stats().high_water());
+	CHECK(1 == logger.stats().flushes());
+
+	// Unlike has_overrun(), the counters survive the flush
+	CHECK(18 == logger.stats().dropped());
+
+	logger.reset_stats();
+	CHECK(0 == logger.stats().dropped());
+	CHECK(0 == logger.stats().high_water());
+}
+
+TEST_CASE("LogStats: Flush durations", "[LogStats]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+
+	// Flushing an empty buffer does nothing
+	logger.flush();
+	CHECK(0 == logger.stats().flushes());
+
+	for(int i = 0; i < 3; i++)
+	{
+		logger.info("Statement %d\n", i);
+		logger.flush();
+	}
+
+	auto& flush_time = logger.stats().flush_time();
+	CHECK(3 == logger.stats().flushes());
+	CHECK(flush_time.min() <= flush_time.average());
+	CHECK(flush_time.average() <= flush_time.max());
+	CHECK(strlen("Statement 0\n") + prefix_len == logger.stats().high_water());
+
+	// The circular buffer logger has no storage
+	CHECK(0 == logger.stats().write_time().count());
+}
+
+TEST_CASE("LogStats: Clear samples the high-water mark", "[LogStats]")
+{
+	CircularLogBufferLogger<1024> logger;
+
+	logger.info("Hello world\n");
+	logger.clear();
+
+	CHECK(strlen("Hello world\n") + prefix_len == logger.stats().high_water());
+	CHECK(0 == logger.stats().flushes());
+}
+
+TEST_CASE("LogStats: Deferred records", "[LogStats]")
+{
+	DeferredCircularLogBufferLogger<128> logger;
+	logger.auto_flush(false);
+	log_buffer_output.clear();
+
+	logger.info("Value %d\n", 1);
+	logger.info("Value %d\n", 2);
+	CHECK(2 == logger.stats().level(log_level_e::info).records);
+	CHECK(logger.size() == logger.stats().level(log_level_e::info).bytes);
+
+	// Filling the buffer drops whole records
+	for(int i = 0; i < 8; i++)
+	{
+		logger.warning("Value %d\n", i);
+	}
+
+	CHECK(logger.stats().dropped() > 0);
+	CHECK(logger.stats().bytes() - logger.stats().dropped() == logger.size());
+
+	logger.flush();
+	CHECK(1 == logger.stats().flushes());
+}
@@ -0,0 +1,141 @@
+#include <catch.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Producers are preempted while they hold a reservation, so they yield while waiting
+#define LOG_MPSC_WAIT() std::this_thread::yield()
+#include <internal/mpsc_circular_buffer.hpp>
+
+TEST_CASE("MPSC Buffer: Put and get", "[MPSCCircularBuffer]")
+{
+	MPSCCircularBuffer<char, 8> buffer;
+
+	CHECK(buffer.empty());
+	CHECK(8 == buffer.capacity());
+
+	buffer.put('a');
+	buffer.put("bcd", 3);
+	CHECK(4 == buffer.size());
+
+	CHECK('a' == buffer.get());
+	CHECK('b' == buffer.get());
+	buffer.consume(1);
+	CHECK('d' == buffer.get());
+	CHECK(buffer.empty());
+	CHECK(char() == buffer.get());
+}
+
+TEST_CASE("MPSC Buffer: A block which does not fit is dropped whole", "[MPSCCircularBuffer]")
+{
+	MPSCCircularBuffer<char, 8> buffer;
+
+	CHECK(buffer.try_put("abcdef", 6));
+	CHECK_FALSE(buffer.try_put("ghi", 3));
+	CHECK(6 == buffer.size());
+
+	CHECK(buffer.try_put("gh", 2));
+	CHECK(buffer.full());
+	CHECK_FALSE(buffer.try_put("i", 1));
+
+	std::string output;
+	while(!buffer.empty())
+	{
+		output += buffer.get();
+	}
+
+	CHECK(output == "abcdefgh");
+}
+
+TEST_CASE("MPSC Buffer: Blocks wrap around the storage", "[MPSCCircularBuffer]")
+{
+	MPSCCircularBuffer<char, 8> buffer;
+
+	buffer.put("abcdef", 6);
+	buffer.consume(6);
+	CHECK(buffer.try_put("0123", 4));
+
+	buffer_spans<char> spans = buffer.peek_contiguous();
+	CHECK(2 == spans.first.size);
+	CHECK(0 == memcmp(spans.first.data, "01", 2));
+	CHECK(2 == spans.second.size);
+	CHECK(0 == memcmp(spans.second.data, "23", 2));
+
+	buffer.reset();
+	CHECK(buffer.empty());
+}
+
+TEST_CASE("MPSC Buffer: Blocks from concurrent producers do not interleave",
+		  "[MPSCCircularBuffer]")
+{
+	MPSCCircularBuffer<char, 64> buffer;
+	constexpr unsigned producer_count = 4;
+	constexpr unsigned blocks_per_producer = 20000;
+	constexpr size_t block_size = 8;
+
+	std::vector<std::thread> producers;
+	for(unsigned p = 0; p < producer_count; p++)
+	{
+		producers.emplace_back([&buffer, p]() {
+			char block[block_size];
+			memset(block, 'a' + static_cast<char>(p), block_size);
+
+			for(unsigned i = 0; i < blocks_per_producer;)
+			{
+				if(buffer.try_put(block, block_size))
+				{
+					i++;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	unsigned blocks[producer_count] = {};
+	bool intact = true;
+	size_t received = 0;
+	while(received < producer_count * blocks_per_producer * block_size)
+	{
+		// Blocks are published whole, so the data always holds complete blocks
+		size_t size = buffer.size();
+		if(size % block_size != 0)
+		{
+			intact = false;
+			break;
+		}
+
+		for(size_t i = 0; i < size; i += block_size)
+		{
+			char block[block_size];
+			for(char& c : block)
+			{
+				c = buffer.get();
+			}
+
+			unsigned p = static_cast<unsigned>(block[0] - 'a');
+			intact = intact && (p < producer_count) &&
+					 (std::string(block, block_size) == std::string(block_size, block[0]));
+			if(p < producer_count)
+			{
+				blocks[p]++;
+			}
+		}
+
+		received += size;
+		std::this_thread::yield();
+	}
+
+	for(auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	CHECK(intact);
+	for(unsigned count : blocks)
+	{
+		CHECK(blocks_per_producer == count);
+	}
+}
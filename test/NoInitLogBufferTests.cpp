@@ -0,0 +1,156 @@
+#include <CircularBufferLogger.h>
+#include <NoInitLogBufferLogger.h>
+#include <catch.hpp>
+#include <string>
+#include <test_helper.hpp>
+#include <type_traits>
+
+namespace
+{
+template<size_t TSize>
+std::string drain(NoInitLogBuffer<TSize>& buffer)
+{
+	std::string contents;
+
+	while(!buffer.empty())
+	{
+		contents += buffer.get();
+	}
+
+	return contents;
+}
+} // namespace
+
+TEST_CASE("NoInit: The buffer is not initialized at boot", "[NoInitLogBuffer]")
+{
+	CHECK(std::is_trivially_default_constructible<NoInitLogBuffer<64>>::value);
+}
+
+TEST_CASE("NoInit: Random memory is reset", "[NoInitLogBuffer]")
+{
+	NoInitLogBuffer<64> buffer;
+	memset(static_cast<void*>(&buffer), 0xA5, sizeof(buffer));
+
+	CHECK(false == buffer.recover());
+	CHECK(0 == buffer.size());
+	CHECK(64 == buffer.capacity());
+
+	// An empty but valid buffer has nothing to recover
+	CHECK(false == buffer.recover());
+}
+
+TEST_CASE("NoInit: The oldest data is overwritten", "[NoInitLogBuffer]")
+{
+	NoInitLogBuffer<8> buffer;
+	buffer.reset();
+
+	buffer.put("abcdef", 6);
+	buffer.put('g');
+	buffer.put("hij", 3);
+	CHECK(8 == buffer.size());
+	CHECK("cdefghij" == drain(buffer));
+
+	buffer.put("0123456789", 10);
+	CHECK("23456789" == drain(buffer));
+
+	char dst[8];
+	buffer.put("xyz", 3);
+	CHECK(2 == buffer.get(dst, 2));
+	CHECK(std::string("xy") == std::string(dst, 2));
+	CHECK(1 == buffer.size());
+}
+
+TEST_CASE("NoInit: Data survives a reset", "[NoInitLogBuffer]")
+{
+	NoInitLogBuffer<16> buffer;
+	buffer.reset();
+	buffer.put("0123456789abcdef", 16);
+	buffer.put("xy", 2);
+
+	// A reset leaves the memory as it was
+	NoInitLogBuffer<16> after_reset;
+	memcpy(static_cast<void*>(&after_reset), &buffer, sizeof(buffer));
+
+	CHECK(after_reset.recover());
+	CHECK("23456789abcdefxy" == drain(after_reset));
+}
+
+TEST_CASE("NoInit: A damaged header is detected", "[NoInitLogBuffer]")
+{
+	NoInitLogBuffer<16> buffer;
+	buffer.reset();
+	buffer.put("hello", 5);
+
+	auto bytes = reinterpret_cast<unsigned char*>(&buffer);
+
+	// Every byte before the data belongs to the header
+	for(size_t i = 0; i < sizeof(buffer) - 16; i++)
+	{
+		NoInitLogBuffer<16> damaged;
+		memcpy(static_cast<void*>(&damaged), &buffer, sizeof(buffer));
+		reinterpret_cast<unsigned char*>(&damaged)[i] = static_cast<unsigned char>(~bytes[i]);
+
+		CHECK(false == damaged.recover());
+		CHECK(0 == damaged.size());
+	}
+
+	NoInitLogBuffer<32> other_size;
+	memcpy(static_cast<void*>(&other_size), &buffer, sizeof(buffer));
+	CHECK(false == other_size.recover());
+}
+
+TEST_CASE("NoInit: Write the log from before the reset to another logger", "[NoInitLogBuffer]")
+{
+	static NoInitLogBuffer<64> storage;
+	CircularLogBufferLogger<128> sink;
+
+	{
+		NoInitLogBufferLogger<64> logger(storage);
+		CHECK(false == logger.begin(sink));
+		logger.error("before reset\n");
+	}
+
+	NoInitLogBufferLogger<64> logger(storage);
+	CHECK(strlen("<E> before reset\n") == logger.recovered());
+
+	// Data logged before begin() is kept for the new log
+	logger.info("after\n");
+	log_buffer_output.clear();
+	CHECK(logger.begin(sink));
+	CHECK(0 == logger.recovered());
+	CHECK(log_buffer_output == "<E> before reset\n");
+	CHECK(0 == sink.size());
+
+	log_buffer_output.clear();
+	logger.flush();
+	CHECK(log_buffer_output == "<I> after\n");
+	CHECK(false == logger.begin(sink));
+}
+
+TEST_CASE("NoInit: Recovered data which is overwritten is not written", "[NoInitLogBuffer]")
+{
+	static NoInitLogBuffer<32> storage;
+	CircularLogBufferLogger<128> sink;
+
+	{
+		NoInitLogBufferLogger<32> logger(storage);
+		logger.clear();
+		logger.write("0123456789", 10);
+	}
+
+	NoInitLogBufferLogger<32> logger(storage);
+	CHECK(10 == logger.recovered());
+
+	logger.write("abcdefghijklmnopqrstuv", 22);
+	CHECK(10 == logger.recovered());
+	logger.write("xyz", 3);
+	CHECK(7 == logger.recovered());
+
+	log_buffer_output.clear();
+	CHECK(logger.begin(sink));
+	CHECK(log_buffer_output == "3456789");
+	CHECK(25 == logger.size());
+
+	logger.clear();
+	CHECK(0 == logger.size());
+}
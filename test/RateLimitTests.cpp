@@ -0,0 +1,205 @@
+// Built as a separate test executable with LOG_RATE_LIMIT_EN set
+#include <stdint.h>
+
+namespace
+{
+uint32_t test_clock = 0;
+} // namespace
+
+#define LOG_RATE_LIMIT_CLOCK() test_clock
+
+#include <CircularBufferLogger.h>
+#include <DeferredCircularBufferLogger.h>
+#include <catch.hpp>
+#include <internal/log_rate_limiter.hpp>
+#include <string>
+#include <test_helper.hpp>
+
+static_assert(LOG_RATE_LIMIT_EN, "RateLimitTests must be compiled with LOG_RATE_LIMIT_EN set");
+
+TEST_CASE("LogRateLimiter: A call site may log its burst, then one per interval", "[RateLimit]")
+{
+	LogRateLimiter<4> limiter;
+	limiter.collapse_repeats(false);
+	limiter.limit(3, 100);
+	const char* site = "site %d\n";
+
+	CHECK(limiter.admit(site, 3, 0, 0));
+	CHECK(limiter.admit(site, 3, 0, 0));
+	CHECK(limiter.admit(site, 3, 0, 0));
+	CHECK_FALSE(limiter.admit(site, 3, 0, 50));
+	CHECK_FALSE(limiter.admit(site, 3, 0, 99));
+	CHECK(limiter.admit(site, 3, 0, 100));
+	CHECK_FALSE(limiter.admit(site, 3, 0, 150));
+
+	// Two intervals refill two tokens
+	CHECK(limiter.admit(site, 3, 0, 300));
+	CHECK(limiter.admit(site, 3, 0, 300));
+	CHECK_FALSE(limiter.admit(site, 3, 0, 300));
+
+	log_suppressed_site suppressed;
+	REQUIRE(limiter.take_suppressed(suppressed));
+	CHECK(site == suppressed.key);
+	CHECK(3 == suppressed.level);
+	CHECK(4 == suppressed.count);
+	CHECK_FALSE(limiter.take_suppressed(suppressed));
+}
+
+TEST_CASE("LogRateLimiter: The bucket does not fill beyond the burst", "[RateLimit]")
+{
+	LogRateLimiter<4> limiter;
+	limiter.collapse_repeats(false);
+	limiter.limit(2, 10);
+	const char* site = "site\n";
+
+	CHECK(limiter.admit(site, 3, 0, 0));
+	CHECK(limiter.admit(site, 3, 0, 10000));
+	CHECK(limiter.admit(site, 3, 0, 10000));
+	CHECK_FALSE(limiter.admit(site, 3, 0, 10000));
+}
+
+TEST_CASE("LogRateLimiter: Call sites are limited independently", "[RateLimit]")
+{
+	LogRateLimiter<8> limiter;
+	limiter.collapse_repeats(false);
+	limiter.limit(1, 1000);
+	static const char sites[2][8] = {"first", "second"};
+
+	CHECK(limiter.admit(sites[0], 3, 0, 0));
+	CHECK_FALSE(limiter.admit(sites[0], 3, 0, 0));
+	CHECK(limiter.admit(sites[1], 3, 0, 0));
+}
+
+TEST_CASE("LogRateLimiter: A limit of 0 disables the rate limit", "[RateLimit]")
+{
+	LogRateLimiter<4> limiter;
+	limiter.collapse_repeats(false);
+	limiter.limit(0, 100);
+
+	for(int i = 0; i < 100; i++)
+	{
+		CHECK(limiter.admit("site\n", 3, 0, 0));
+	}
+}
+
+TEST_CASE("LogRateLimiter: Repeats are counted until a different statement", "[RateLimit]")
+{
+	LogRateLimiter<4> limiter;
+	const char* site = "value %d\n";
+	log_suppressed_site repeated;
+
+	CHECK(limiter.admit(site, 4, log_hash_args(1), 0));
+	CHECK_FALSE(limiter.admit(site, 4, log_hash_args(1), 0));
+	CHECK_FALSE(limiter.admit(site, 4, log_hash_args(1), 0));
+	CHECK(limiter.admit(site, 4, log_hash_args(2), 0));
+
+	REQUIRE(limiter.take_repeats(repeated));
+	CHECK(site == repeated.key);
+	CHECK(4 == repeated.level);
+	CHECK(2 == repeated.count);
+	CHECK_FALSE(limiter.take_repeats(repeated));
+}
+
+TEST_CASE("log_hash_args: Strings are hashed by their contents", "[RateLimit]")
+{
+	char buffer[8] = "abc";
+	uint32_t first = log_hash_args(static_cast<char*>(buffer));
+	buffer[0] = 'x';
+
+	CHECK(first != log_hash_args(static_cast<char*>(buffer)));
+	CHECK(log_hash_args("xbc") == log_hash_args(static_cast<const char*>(buffer)));
+	CHECK(log_hash_args(1, 2) != log_hash_args(2, 1));
+}
+
+TEST_CASE("Rate limit: A flooding call site is limited, and reported at flush", "[RateLimit]")
+{
+	CircularLogBufferLogger<1024> logger;
+	logger.rate_limiter().limit(2, 100);
+	log_buffer_output.clear();
+	test_clock = 0;
+
+	for(int i = 0; i < 10; i++)
+	{
+		logger.warning("Sensor read failed: %d\n", i);
+	}
+
+	logger.flush();
+
+	CHECK("<W> Sensor read failed: 0\n<W> Sensor read failed: 1\n"
+		  "<W> ---Rate limited 8 statements--- Sensor read failed: %d\n" == log_buffer_output);
+
+	// The counts were reported, and the interval restores the site
+	log_buffer_output.clear();
+	test_clock = 100;
+	logger.warning("Sensor read failed: %d\n", 10);
+	logger.flush();
+
+	CHECK("<W> Sensor read failed: 10\n" == log_buffer_output);
+}
+
+TEST_CASE("Rate limit: Repeated statements are collapsed", "[RateLimit]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+	test_clock = 0;
+
+	for(int i = 0; i < 5; i++)
+	{
+		logger.error("Sensor %s timed out\n", "imu");
+	}
+
+	logger.info("Recovered\n");
+	logger.error("Sensor %s timed out\n", "imu");
+	logger.error("Sensor %s timed out\n", "imu");
+	logger.flush();
+
+	CHECK("<E> Sensor imu timed out\n<E> ---Last message repeated 4 times---\n<I> Recovered\n"
+		  "<E> Sensor imu timed out\n<E> ---Last message repeated 1 times---\n" ==
+		  log_buffer_output);
+}
+
+TEST_CASE("Rate limit: clear() discards the counts", "[RateLimit]")
+{
+	CircularLogBufferLogger<1024> logger;
+	log_buffer_output.clear();
+	test_clock = 0;
+
+	logger.info("Same\n");
+	logger.info("Same\n");
+	logger.clear();
+	logger.info("Other\n");
+	logger.flush();
+
+	CHECK("<I> Other\n" == log_buffer_output);
+}
+
+TEST_CASE("Rate limit: The deferred logger is limited", "[RateLimit]")
+{
+	DeferredCircularLogBufferLogger<512> logger;
+	log_buffer_output.clear();
+	test_clock = 0;
+
+	logger.info("Reading %d\n", 7);
+	logger.info("Reading %d\n", 7);
+	logger.info("Reading %d\n", 7);
+	logger.flush();
+
+	CHECK("<I> Reading 7\n<I> ---Last message repeated 2 times---\n" == log_buffer_output);
+}
+
+TEST_CASE("Rate limit: Structured records are limited by name", "[RateLimit]")
+{
+	CircularLogBufferLogger<1024> logger;
+	logger.rate_limiter().limit(1, 100);
+	log_buffer_output.clear();
+	test_clock = 0;
+
+	for(int i = 0; i < 3; i++)
+	{
+		logger.log_kv(log_level_e::info, "imu", kv("ax", i));
+	}
+
+	logger.flush();
+
+	CHECK("<I> @imu ax=0\n<I> ---Rate limited 2 statements--- imu\n" == log_buffer_output);
+}
@@ -0,0 +1,114 @@
+#include <catch.hpp>
+#include <internal/record_circular_buffer.hpp>
+#include <internal/spsc_circular_buffer.hpp>
+#include <string>
+
+namespace
+{
+template<class TBuffer>
+std::string contents(TBuffer& buffer)
+{
+	std::string output;
+	while(!buffer.empty())
+	{
+		output += buffer.get();
+	}
+
+	return output;
+}
+} // namespace
+
+TEST_CASE("Record Buffer: Records are added and removed", "[RecordCircularBuffer]")
+{
+	RecordCircularBuffer<char, 16, 4> buffer;
+
+	CHECK(buffer.empty());
+	CHECK(16 == buffer.capacity());
+
+	// A single item extends the newest record
+	buffer.put("abc\n", 4);
+	buffer.put('d');
+	buffer.put("ef\n", 3);
+	CHECK(8 == buffer.size());
+	CHECK(2 == buffer.records());
+	CHECK(5 == buffer.record_size(0));
+	CHECK(3 == buffer.record_size(1));
+
+	buffer.consume(2);
+	CHECK(2 == buffer.records());
+	CHECK(3 == buffer.record_size(0));
+	buffer.consume(3);
+	CHECK(1 == buffer.records());
+
+	CHECK("ef\n" == contents(buffer));
+	CHECK(0 == buffer.records());
+}
+
+TEST_CASE("Record Buffer: Whole records are evicted to make room", "[RecordCircularBuffer]")
+{
+	RecordCircularBuffer<char, 16, 4> buffer;
+
+	buffer.put("first\n", 6);
+	buffer.put("second\n", 7);
+
+	record_drop_count dropped = buffer.put_record("third\n", 6);
+	CHECK(1 == dropped.records);
+	CHECK(6 == dropped.bytes);
+	CHECK("second\nthird\n" == contents(buffer));
+}
+
+TEST_CASE("Record Buffer: A full record table evicts the oldest record", "[RecordCircularBuffer]")
+{
+	RecordCircularBuffer<char, 16, 2> buffer;
+
+	buffer.put("a\n", 2);
+	buffer.put("b\n", 2);
+
+	record_drop_count dropped = buffer.put_record("c\n", 2);
+	CHECK(1 == dropped.records);
+	CHECK(2 == dropped.bytes);
+	CHECK("b\nc\n" == contents(buffer));
+}
+
+TEST_CASE("Record Buffer: A record longer than the buffer is dropped", "[RecordCircularBuffer]")
+{
+	RecordCircularBuffer<char, 8, 4> buffer;
+
+	buffer.put("keep\n", 5);
+
+	record_drop_count dropped = buffer.put_record("much too long\n", 14);
+	CHECK(1 == dropped.records);
+	CHECK(14 == dropped.bytes);
+	CHECK("keep\n" == contents(buffer));
+}
+
+TEST_CASE("Record Buffer: Records wrap around the storage", "[RecordCircularBuffer]")
+{
+	RecordCircularBuffer<char, 8, 4> buffer;
+
+	buffer.put("abcdef", 6);
+	buffer.consume(6);
+	buffer.put("0123", 4);
+
+	buffer_spans<char> spans = buffer.peek_contiguous();
+	CHECK(2 == spans.first.size);
+	CHECK(2 == spans.second.size);
+
+	buffer.reset();
+	CHECK(buffer.empty());
+	CHECK(0 == buffer.records());
+}
+
+TEST_CASE("Record Buffer: Other buffers reject a record which does not fit",
+		  "[RecordCircularBuffer]")
+{
+	SPSCCircularBuffer<char, 8> buffer;
+
+	record_drop_count dropped = buffer_put_record(buffer, "abcdef", 6);
+	CHECK(0 == dropped.records);
+
+	dropped = buffer_put_record(buffer, "ghi", 3);
+	CHECK(1 == dropped.records);
+	CHECK(3 == dropped.bytes);
+	CHECK("abcdef" == contents(buffer));
+}
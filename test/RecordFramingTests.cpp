@@ -0,0 +1,167 @@
+// Built as a separate test executable with LOG_RECORD_FRAMING_EN set
+#include <ArduinoLogger.h>
+#include <CircularBufferLogger.h>
+#include <SdFat.h>
+#include <TeensySDRotationalLogger.h>
+#include <catch.hpp>
+#include <string>
+
+static_assert(LOG_RECORD_FRAMING_EN,
+			  "RecordFramingTests must be compiled with LOG_RECORD_FRAMING_EN set");
+
+namespace
+{
+/// Logs to a RecordCircularBuffer, and flushes to a string
+template<size_t TBufferSize>
+class RecordTestLogger final : public LoggerBaseT<RecordTestLogger<TBufferSize>>
+{
+	friend class LoggerBaseT<RecordTestLogger>;
+
+  public:
+	RecordTestLogger() : LoggerBaseT<RecordTestLogger>(true, log_level_e::debug, false) {}
+
+	size_t size() const noexcept final
+	{
+		return log_buffer_.size();
+	}
+
+	size_t capacity() const noexcept final
+	{
+		return log_buffer_.capacity();
+	}
+
+	std::string output;
+
+  protected:
+	void log_putc(char c) noexcept final
+	{
+		log_buffer_.put(c);
+	}
+
+	void log_write(const char* str, size_t len) noexcept final
+	{
+		this->log_write_to_buffer(log_buffer_, str, len);
+	}
+
+	void flush_() noexcept final
+	{
+		while(!log_buffer_.empty())
+		{
+			output += log_buffer_.get();
+		}
+	}
+
+	void clear_() noexcept final
+	{
+		log_buffer_.reset();
+	}
+
+  private:
+	RecordCircularBuffer<char, TBufferSize> log_buffer_;
+};
+} // namespace
+
+TEST_CASE("Record framing: An overrun drops the oldest whole statements", "[RecordFraming]")
+{
+	RecordTestLogger<64> logger;
+	logger.auto_flush(false);
+
+	logger.info("statement %d\n", 1);
+	logger.info("statement %d\n", 2);
+	logger.info("statement %d\n", 3);
+	logger.info("statement %d\n", 4);
+	logger.info("statement %d\n", 5);
+	CHECK(logger.has_overrun());
+
+	logger.auto_flush(true);
+	logger.flush();
+	// Each statement is 16 bytes, so the oldest one makes room for the fifth
+	CHECK("<I> statement 2\n<I> statement 3\n<I> statement 4\n<I> statement 5\n"
+		  "<!> ---Log buffer overrun: 1 records (16 bytes) dropped---\n" == logger.output);
+	CHECK_FALSE(logger.has_overrun());
+}
+
+TEST_CASE("Record framing: Auto-flush makes room for a statement", "[RecordFraming]")
+{
+	RecordTestLogger<32> logger;
+
+	logger.info("statement %d\n", 1);
+	logger.info("statement %d\n", 2);
+	logger.info("statement %d\n", 3);
+	logger.flush();
+
+	CHECK("<I> statement 1\n<I> statement 2\n<I> statement 3\n" == logger.output);
+	CHECK_FALSE(logger.has_overrun());
+}
+
+TEST_CASE("Record framing: print() adds one record", "[RecordFraming]")
+{
+	RecordTestLogger<64> logger;
+
+	logger.print("%s=%d\n", "value", 7);
+	logger.flush();
+
+	CHECK("value=7\n" == logger.output);
+}
+
+TEST_CASE("Record framing: The circular buffer logger can be queried", "[RecordFraming]")
+{
+	static uint32_t now = 0;
+	CircularLogBufferLogger_t<RecordCircularBuffer<char, 256>> logger;
+	logger.timestamp_clock([]() { return now; });
+
+	now = 10;
+	logger.info("[imu] sample\n");
+	now = 20;
+	logger.error("[gps] no fix\n");
+	now = 30;
+	logger.error("[imu] timeout\n");
+
+	auto query = logger.query();
+	std::string output;
+	size_t visited = query.tail(5, log_query_filter(log_level_e::error, "[imu]"),
+								[&output](const log_record_view& record) {
+									for(size_t i = 0; i < record.size(); i++)
+									{
+										output += record[i];
+									}
+								});
+
+	CHECK(1 == visited);
+	CHECK("<E> [30 ms] [imu] timeout\n" == output);
+	CHECK(3 == query.count());
+	CHECK(1 == query.find_newer(15));
+	CHECK(3 == logger.query().count());
+}
+
+TEST_CASE("Record framing: The SD logger reports the dropped records", "[RecordFraming]")
+{
+	static SdFs sd;
+	static TeensySDRotationalLogger_t<log_file_format_e::text, RecordCircularBuffer<char, 128>>
+		logger;
+	fake_files.clear();
+	logger.begin(sd);
+	logger.auto_flush(false);
+
+	for(int i = 0; i < 10; i++)
+	{
+		logger.info("statement %d\n", i);
+	}
+
+	CHECK(logger.has_overrun());
+	logger.flush();
+	CHECK_FALSE(logger.has_overrun());
+
+	char name[log_filename_max_size + 1];
+	format_log_filename(name, logger.file_index(), ".txt");
+	const std::string& file = fake_files[name];
+	size_t marker = file.find("records (");
+	REQUIRE(std::string::npos != marker);
+	CHECK(std::string::npos != file.find("statement 9\n"));
+
+	// The counts are cleared by the report, so the next flush has no marker
+	logger.info("after\n");
+	logger.flush();
+	CHECK(std::string::npos == file.find("records (", marker + 1));
+	CHECK(std::string::npos == file.find("overrun detected"));
+}
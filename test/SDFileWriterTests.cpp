@@ -0,0 +1,104 @@
+#include <catch.hpp>
+#include <internal/circular_buffer.hpp>
+#include <internal/sd_file_writer.hpp>
+#include <string>
+
+namespace
+{
+/// File which appends written data to a string, and records each write
+struct test_file
+{
+	size_t write(const void* data, size_t size)
+	{
+		contents.append(static_cast<const char*>(data), size);
+		writes++;
+		return size;
+	}
+
+	std::string contents;
+	unsigned writes = 0;
+};
+} // namespace
+
+TEST_CASE("SDFileWriter: Sector-aligned write sizes", "[SDFileWriter]")
+{
+	CHECK(0 == sector_aligned_size(0, 0));
+	CHECK(0 == sector_aligned_size(0, 511));
+	CHECK(512 == sector_aligned_size(0, 512));
+	CHECK(512 == sector_aligned_size(0, 1000));
+	CHECK(1024 == sector_aligned_size(0, 1024));
+
+	// Writes from an unaligned position complete the current sector first
+	CHECK(502 == sector_aligned_size(10, 600));
+	CHECK(0 == sector_aligned_size(10, 501));
+	CHECK(502 == sector_aligned_size(10, 502));
+	CHECK(1014 == sector_aligned_size(10, 1100));
+
+	CHECK(512 == sector_aligned_size(UINT64_C(0x100000000), 600));
+}
+
+TEST_CASE("SDFileWriter: Buffers smaller than a sector write all data", "[SDFileWriter]")
+{
+	CHECK(502 == preallocated_flush_size(10, 600, 1024));
+	CHECK(0 == preallocated_flush_size(10, 501, 512));
+
+	// A 128-byte buffer never reaches the sector boundary at 512
+	CHECK(100 == preallocated_flush_size(10, 100, 128));
+	CHECK(128 == preallocated_flush_size(10, 128, 128));
+}
+
+TEST_CASE("SDFileWriter: Write buffered data to a file", "[SDFileWriter]")
+{
+	CircularBuffer<char, 8> buffer;
+	test_file file;
+
+	for(char c : std::string("abcdef"))
+	{
+		buffer.put(c);
+	}
+
+	// The data is not removed from the buffer
+	CHECK(4 == write_buffer_to_file(file, buffer, 4));
+	CHECK("abcd" == file.contents);
+	CHECK(6 == buffer.size());
+
+	buffer.consume(4);
+
+	for(char c : std::string("ghijk"))
+	{
+		buffer.put(c);
+	}
+
+	// The data wraps around the end of the buffer, so two writes are needed
+	file.writes = 0;
+	CHECK(7 == write_buffer_to_file(file, buffer, 7));
+	CHECK("abcdefghijk" == file.contents);
+	CHECK(2 == file.writes);
+
+	file.writes = 0;
+	CHECK(0 == write_buffer_to_file(file, buffer, 0));
+	CHECK(0 == file.writes);
+}
+
+TEST_CASE("SDFileWriter: Copy buffered data", "[SDFileWriter]")
+{
+	CircularBuffer<char, 8> buffer;
+	char block[8] = {};
+
+	for(char c : std::string("abcdef"))
+	{
+		buffer.put(c);
+	}
+
+	buffer.consume(4);
+
+	for(char c : std::string("ghijk"))
+	{
+		buffer.put(c);
+	}
+
+	// The data wraps around the end of the buffer
+	copy_from_buffer(buffer, block, 6);
+	CHECK(std::string("efghij") == std::string(block, 6));
+	CHECK(7 == buffer.size());
+}
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <iterator>
+#include <map>
+#include <string>
+
+#define O_RDONLY 0x00
+#define O_WRITE 0x01
+#define O_CREAT 0x10
+
+#include <internal/sd_log_index.hpp>
+
+namespace
+{
+std::map<std::string, std::string> test_files;
+
+/// File which keeps its contents in test_files. "/" opens the root directory.
+class test_file
+{
+  public:
+	bool open(const char* name, int flags)
+	{
+		name_ = name;
+		dir_ = name_ == "/";
+		next_ = 0;
+		pos_ = 0;
+		open_ = dir_ || test_files.count(name_) || (flags & O_CREAT);
+
+		if(open_ && !dir_)
+		{
+			test_files[name_];
+		}
+
+		return open_;
+	}
+
+	bool openNext(test_file* dir, int)
+	{
+		auto entry = test_files.begin();
+		std::advance(entry, std::min(dir->next_, test_files.size()));
+
+		if(entry == test_files.end())
+		{
+			return false;
+		}
+
+		dir->next_++;
+		return open(entry->first.c_str(), O_RDONLY);
+	}
+
+	int read(void* data, size_t size)
+	{
+		const std::string& contents = test_files[name_];
+		size = std::min(size, contents.size() - pos_);
+		memcpy(data, &contents[pos_], size);
+		pos_ += size;
+		return static_cast<int>(size);
+	}
+
+	size_t write(const void* data, size_t size)
+	{
+		std::string& contents = test_files[name_];
+		contents.resize(std::max(contents.size(), pos_ + size));
+		memcpy(&contents[pos_], data, size);
+		pos_ += size;
+		return size;
+	}
+
+	bool seekSet(size_t pos)
+	{
+		pos_ = pos;
+		return true;
+	}
+
+	size_t getName(char* name, size_t size)
+	{
+		snprintf(name, size, "%s", name_.c_str());
+		return name_.size();
+	}
+
+	bool isDir() const
+	{
+		return dir_;
+	}
+
+	uint64_t fileSize() const
+	{
+		return test_files[name_].size();
+	}
+
+	bool remove()
+	{
+		open_ = false;
+		return test_files.erase(name_) != 0;
+	}
+
+	void close()
+	{
+		open_ = false;
+	}
+
+  private:
+	std::string name_;
+	size_t pos_ = 0;
+	size_t next_ = 0;
+	bool dir_ = false;
+	bool open_ = false;
+};
+} // namespace
+
+TEST_CASE("SDLogIndex: The index starts at 1 on an empty card", "[SDLogIndex]")
+{
+	test_files.clear();
+
+	CHECK(1 == sd_next_log_index<test_file>(".txt"));
+	CHECK(2 == sd_next_log_index<test_file>(".txt"));
+	CHECK(3 == sd_next_log_index<test_file>(".txt"));
+	CHECK(8 == test_files[LOG_INDEX_FILENAME].size());
+}
+
+TEST_CASE("SDLogIndex: Continue after the highest file without a cache", "[SDLogIndex]")
+{
+	test_files.clear();
+	test_files["log_9.txt"] = "a";
+	test_files["log_300.txt"] = "b";
+	test_files["log_1000.bin"] = "c";
+	test_files["notes.txt"] = "d";
+
+	CHECK(300 == sd_scan_log_index<test_file>(".txt"));
+	CHECK(301 == sd_next_log_index<test_file>(".txt"));
+	CHECK(302 == sd_next_log_index<test_file>(".txt"));
+}
+
+TEST_CASE("SDLogIndex: A damaged cache is replaced by a scan", "[SDLogIndex]")
+{
+	test_files.clear();
+	test_files["log_41.txt"] = "a";
+	sd_store_log_index<test_file>(7);
+
+	uint32_t index = 0;
+	CHECK(sd_read_log_index<test_file>(index));
+	CHECK(7 == index);
+
+	test_files[LOG_INDEX_FILENAME][5] ^= 0x10;
+	CHECK(false == sd_read_log_index<test_file>(index));
+	CHECK(42 == sd_next_log_index<test_file>(".txt"));
+}
+
+TEST_CASE("SDLogIndex: A wrapped index restarts at 1", "[SDLogIndex]")
+{
+	test_files.clear();
+	sd_store_log_index<test_file>(UINT32_MAX);
+
+	CHECK(UINT32_MAX == sd_next_log_index<test_file>(".txt"));
+	// The cache now holds 0, which is not a valid index
+	CHECK(1 == sd_next_log_index<test_file>(".txt"));
+}
+
+TEST_CASE("SDLogIndex: Delete the oldest files over the retention budget", "[SDLogIndex]")
+{
+	test_files.clear();
+	test_files["log_2.txt"] = std::string(100, 'a');
+	test_files["log_10.txt"] = std::string(100, 'b');
+	test_files["log_11.txt"] = std::string(100, 'c');
+	test_files["log_12.txt"] = std::string(100, 'd');
+	test_files["log_1.bin"] = std::string(1000, 'e');
+
+	CHECK(0 == sd_prune_log_files<test_file>(".txt", 400, 12));
+	CHECK(2 == sd_prune_log_files<test_file>(".txt", 250, 12));
+	CHECK(0 == test_files.count("log_2.txt"));
+	CHECK(0 == test_files.count("log_10.txt"));
+	CHECK(1 == test_files.count("log_11.txt"));
+	CHECK(1 == test_files.count("log_1.bin"));
+
+	// The file in use is kept, even if it is over the budget on its own
+	CHECK(1 == sd_prune_log_files<test_file>(".txt", 50, 12));
+	CHECK(1 == test_files.count("log_12.txt"));
+	CHECK(0 == sd_prune_log_files<test_file>(".txt", 50, 12));
+}
@@ -0,0 +1,127 @@
+#include <SdFat.h>
+#include <TeensySDRotationalLogger.h>
+#include <algorithm>
+#include <binary_log_decoder.hpp>
+#include <catch.hpp>
+#include <kinetis.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+/// The contents of each log file with the given extension, oldest first
+std::vector<std::string> log_files(const char* extension)
+{
+	std::map<uint32_t, std::string> files;
+
+	for(const auto& file : fake_files)
+	{
+		uint32_t index;
+
+		if(parse_log_filename(file.first.c_str(), extension, index))
+		{
+			files[index] = file.second;
+		}
+	}
+
+	std::vector<std::string> contents;
+
+	for(const auto& file : files)
+	{
+		contents.push_back(file.second);
+	}
+
+	return contents;
+}
+
+/// Decode every binary log file, and return the number of files
+size_t decode_binary_logs(std::string& output)
+{
+	std::vector<std::string> files = log_files(".bin");
+
+	for(const auto& file : files)
+	{
+		BinaryLogDecoder decoder;
+		bool decoded = decoder.decode(reinterpret_cast<const uint8_t*>(file.data()), file.size(),
+									  output);
+		INFO(decoder.error());
+		CHECK(decoded);
+	}
+
+	return files.size();
+}
+} // namespace
+
+TEST_CASE("Binary log files rotate between records", "[TeensySDRotationalLogger]")
+{
+	fake_files.clear();
+	static SdFs sd;
+	static TeensySDRotationalLogger_t<log_file_format_e::binary> logger;
+
+	logger.begin(sd);
+	logger.rotation_policy().max_size(300);
+
+	// The buffer is auto-flushed while logging, and the next file is started by flush()
+	for(int i = 0; i < 200; i++)
+	{
+		logger.info("rotating statement %d %s\n", i, "abc");
+
+		if(i % 50 == 49)
+		{
+			logger.flush();
+		}
+	}
+
+	std::string output;
+	CHECK(decode_binary_logs(output) == 5);
+	CHECK(200 == std::count(output.begin(), output.end(), '\n'));
+	CHECK(std::string::npos != output.find("rotating statement 0 abc\n"));
+	CHECK(std::string::npos != output.find("rotating statement 199 abc\n"));
+}
+
+TEST_CASE("Text log files only rotate on an explicit flush", "[TeensySDRotationalLogger]")
+{
+	fake_files.clear();
+	static SdFs sd;
+	static TeensySDRotationalLogger logger;
+
+	logger.begin(sd);
+	logger.rotation_policy().max_size(300);
+
+	for(int i = 0; i < 100; i++)
+	{
+		logger.info("rotating statement %d\n", i);
+	}
+
+	// The buffer was auto-flushed, but log() does not start the next file
+	REQUIRE(1 == log_files(".txt").size());
+	CHECK(log_files(".txt")[0].size() > 300);
+
+	logger.flush();
+	REQUIRE(2 == log_files(".txt").size());
+
+	logger.info("after rotation\n");
+	logger.flush();
+
+	std::vector<std::string> files = log_files(".txt");
+	REQUIRE(2 == files.size());
+	CHECK('\n' == files[0].back());
+	CHECK(std::string::npos != files[0].find("rotating statement 99\n"));
+	CHECK(std::string::npos != files[1].find("after rotation\n"));
+}
+
+TEST_CASE("The reset reason is logged by begin()", "[TeensySDRotationalLogger]")
+{
+	fake_files.clear();
+	static SdFs sd;
+	static TeensySDRotationalLogger logger;
+
+	RCM_SRS0 = RCM_SRS0_WDOG;
+	logger.begin(sd);
+
+	std::vector<std::string> files = log_files(".txt");
+	REQUIRE(1 == files.size());
+	CHECK(std::string::npos != files[0].find("Watchdog Reset\n"));
+	CHECK(0 == RCM_SRS0);
+}
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#define O_RDONLY 0x00
+#define O_WRITE 0x01
+#define O_APPEND 0x08
+#define O_CREAT 0x10
+
+#include <internal/circular_buffer.hpp>
+#include <internal/sd_storage_backend.hpp>
+
+namespace
+{
+std::map<std::string, std::string> test_files;
+unsigned test_syncs = 0;
+bool test_write_fails = false;
+
+/// File which keeps its contents in test_files. "/" opens the root directory.
+class test_file
+{
+  public:
+	bool open(const char* name, int flags)
+	{
+		name_ = name;
+		dir_ = name_ == "/";
+		next_ = 0;
+		open_ = dir_ || test_files.count(name_) || (flags & O_CREAT);
+		pos_ = (open_ && (flags & O_APPEND)) ? test_files[name_].size() : 0;
+
+		if(open_ && !dir_)
+		{
+			test_files[name_];
+		}
+
+		return open_;
+	}
+
+	bool openNext(test_file* dir, int)
+	{
+		auto entry = test_files.begin();
+		std::advance(entry, std::min(dir->next_, test_files.size()));
+
+		if(entry == test_files.end())
+		{
+			return false;
+		}
+
+		dir->next_++;
+		return open(entry->first.c_str(), O_RDONLY);
+	}
+
+	bool isOpen() const
+	{
+		return open_;
+	}
+
+	int read(void* data, size_t size)
+	{
+		const std::string& contents = test_files[name_];
+		size = std::min(size, contents.size() - pos_);
+		memcpy(data, &contents[pos_], size);
+		pos_ += size;
+		return static_cast<int>(size);
+	}
+
+	size_t write(const void* data, size_t size)
+	{
+		if(test_write_fails)
+		{
+			return 0;
+		}
+
+		std::string& contents = test_files[name_];
+		contents.resize(std::max(contents.size(), pos_ + size));
+		memcpy(&contents[pos_], data, size);
+		pos_ += size;
+		return size;
+	}
+
+	uint64_t curPosition() const
+	{
+		return pos_;
+	}
+
+	bool seekSet(size_t pos)
+	{
+		pos_ = pos;
+		return true;
+	}
+
+	bool truncate(uint64_t size)
+	{
+		test_files[name_].resize(size);
+		pos_ = std::min<size_t>(pos_, size);
+		return true;
+	}
+
+	bool preAllocate(uint64_t size)
+	{
+		test_files[name_].resize(std::max<size_t>(test_files[name_].size(), size));
+		return true;
+	}
+
+	bool sync()
+	{
+		test_syncs++;
+		return true;
+	}
+
+	size_t getName(char* name, size_t size)
+	{
+		snprintf(name, size, "%s", name_.c_str());
+		return name_.size();
+	}
+
+	bool isDir() const
+	{
+		return dir_;
+	}
+
+	uint64_t size() const
+	{
+		return test_files[name_].size();
+	}
+
+	uint64_t fileSize() const
+	{
+		return size();
+	}
+
+	bool remove()
+	{
+		open_ = false;
+		return test_files.erase(name_) != 0;
+	}
+
+	bool close()
+	{
+		bool was_open = open_;
+		open_ = false;
+		return was_open;
+	}
+
+  private:
+	std::string name_;
+	size_t pos_ = 0;
+	size_t next_ = 0;
+	bool dir_ = false;
+	bool open_ = false;
+};
+
+struct test_card
+{
+	uint32_t sectorCount()
+	{
+		return 8;
+	}
+};
+
+struct test_fs
+{
+	test_card* card()
+	{
+		return &card_;
+	}
+
+	test_card card_;
+};
+
+/// The test version of the error handler, which is found by argument-dependent lookup
+void sd_error_halt(test_fs*, const char* msg)
+{
+	throw std::runtime_error(msg);
+}
+
+void reset_test_files()
+{
+	test_files.clear();
+	test_syncs = 0;
+	test_write_fails = false;
+}
+
+std::string repeat(char c, size_t count)
+{
+	return std::string(count, c);
+}
+} // namespace
+
+TEST_CASE("SDStorageBackend: Each flush appends to the file, and closes it", "[SDStorageBackend]")
+{
+	reset_test_files();
+	test_fs fs;
+	CircularBuffer<char, 64> buffer;
+	SDStorageBackend<test_fs, test_file> storage;
+
+	CHECK_FALSE(storage.attached());
+	CHECK(0 == storage.capacity());
+
+	storage.attach(fs);
+	CHECK(storage.attached());
+	CHECK(8 * 512 == storage.capacity());
+
+	test_files["log.txt"] = "stale";
+	storage.open("log.txt", buffer, 0);
+	CHECK(storage.file().isOpen());
+	CHECK(test_files["log.txt"].empty());
+
+	buffer.put("hello ", 6);
+	size_t count = storage.write(buffer);
+	CHECK(6 == count);
+	CHECK(buffer.empty());
+	storage.finish(count, buffer, 10);
+	CHECK_FALSE(storage.file().isOpen());
+
+	// The file is reopened in append mode
+	buffer.put("world", 5);
+	storage.finish(storage.write(buffer), buffer, 20);
+	CHECK("hello world" == test_files["log.txt"]);
+	CHECK(0 == test_syncs);
+}
+
+TEST_CASE("SDStorageBackend: A deferred open keeps the name until the file is opened",
+		  "[SDStorageBackend]")
+{
+	reset_test_files();
+	test_fs fs;
+	CircularBuffer<char, 64> buffer;
+	SDStorageBackend<test_fs, test_file> storage;
+
+	storage.attach(fs);
+	storage.defer_open("boot.txt");
+	CHECK(0 == test_files.count("boot.txt"));
+	CHECK(std::string("boot.txt") == storage.filename());
+
+	// Data staged during boot is written once the strategy opens the file
+	buffer.put("boot", 4);
+	REQUIRE(storage.take_deferred_open());
+	CHECK_FALSE(storage.take_deferred_open());
+	storage.open(storage.filename(), buffer, 10);
+	storage.finish(storage.write(buffer), buffer, 10);
+	CHECK("boot" == test_files["boot.txt"]);
+}
+
+TEST_CASE("SDStorageBackend: A file kept open is synced by budget", "[SDStorageBackend]")
+{
+	reset_test_files();
+	test_fs fs;
+	CircularBuffer<char, 64> buffer;
+	SDStorageBackend<test_fs, test_file> storage;
+
+	storage.attach(fs);
+	storage.keep_open(true, buffer, 0);
+	storage.sync_policy().budget(10, 1000);
+	storage.open("keep.txt", buffer, 0);
+
+	buffer.put("123456", 6);
+	storage.finish(storage.write(buffer), buffer, 10);
+	CHECK(storage.file().isOpen());
+	CHECK(0 == test_syncs);
+
+	buffer.put("7890", 4);
+	storage.finish(storage.write(buffer), buffer, 20);
+	CHECK(1 == test_syncs);
+	CHECK(0 == storage.sync_policy().pending());
+
+	// Disabling keep-open closes the file
+	storage.keep_open(false, buffer, 30);
+	CHECK_FALSE(storage.file().isOpen());
+	CHECK("1234567890" == test_files["keep.txt"]);
+}
+
+TEST_CASE("SDStorageBackend: Pre-allocated files are written in whole sectors",
+		  "[SDStorageBackend]")
+{
+	reset_test_files();
+	test_fs fs;
+	CircularBuffer<char, 1024> buffer;
+	SDStorageBackend<test_fs, test_file> storage;
+
+	storage.attach(fs, 4096);
+	storage.open("pre.txt", buffer, 0);
+	CHECK(storage.keep_open());
+	CHECK(4096 == test_files["pre.txt"].size());
+
+	std::string data = repeat('a', 512) + repeat('b', 88);
+	buffer.put(data.c_str(), data.size());
+	CHECK(512 == storage.write(buffer));
+	CHECK(88 == buffer.size());
+
+	// A sync writes the partial sector, but keeps it buffered
+	storage.sync(buffer, 10);
+	CHECK(1 == test_syncs);
+	CHECK(88 == buffer.size());
+	CHECK(512 == storage.file().curPosition());
+	CHECK(data == test_files["pre.txt"].substr(0, data.size()));
+
+	// Closing writes the remaining data, and truncates the file
+	storage.close(buffer, 20);
+	CHECK(buffer.empty());
+	CHECK(data == test_files["pre.txt"]);
+}
+
+TEST_CASE("SDStorageBackend: Errors halt", "[SDStorageBackend]")
+{
+	reset_test_files();
+	test_fs fs;
+	CircularBuffer<char, 64> buffer;
+	SDStorageBackend<test_fs, test_file> storage;
+
+	storage.attach(fs);
+	storage.open("log.txt", buffer, 0);
+
+	buffer.put("data", 4);
+	test_write_fails = true;
+	CHECK_THROWS_WITH(storage.write(buffer), "Failed to write to log file");
+
+	// Data which was not written stays in the buffer
+	CHECK(4 == buffer.size());
+}
+
+TEST_CASE("SDRotatingStorageBackend: Each file gets the next index", "[SDStorageBackend]")
+{
+	reset_test_files();
+	test_fs fs;
+	CircularBuffer<char, 64> buffer;
+	SDRotatingStorageBackend<test_fs, test_file> storage;
+
+	storage.attach(fs);
+	storage.rotation_policy().max_size(8);
+
+	storage.open_next(".txt", buffer, 0);
+	CHECK(1 == storage.file_index());
+	CHECK(std::string("log_1.txt") == storage.filename());
+
+	buffer.put("12345678", 8);
+	size_t count = storage.write(buffer);
+	CHECK(storage.rotation_due(count, 10));
+
+	storage.open_next(".txt", buffer, 10);
+	CHECK(2 == storage.file_index());
+	CHECK_FALSE(storage.rotation_due(0, 20));
+
+	buffer.put("next", 4);
+	storage.finish(storage.write(buffer), buffer, 20);
+	CHECK("12345678" == test_files["log_1.txt"]);
+	CHECK("next" == test_files["log_2.txt"]);
+}
@@ -0,0 +1,51 @@
+#include <catch.hpp>
+#include <internal/sd_sync_policy.hpp>
+
+TEST_CASE("SDSyncPolicy: Defaults", "[SDSyncPolicy]")
+{
+	SDSyncPolicy policy;
+
+	CHECK(LOG_SD_KEEP_FILE_OPEN_DEFAULT == policy.keep_open());
+	CHECK(0 == policy.pending());
+
+	policy.keep_open(true);
+	CHECK(true == policy.keep_open());
+}
+
+TEST_CASE("SDSyncPolicy: Sync once the byte budget is used", "[SDSyncPolicy]")
+{
+	SDSyncPolicy policy;
+	policy.budget(1024, 1000);
+
+	CHECK(false == policy.wrote(512, 10));
+	CHECK(512 == policy.pending());
+	CHECK(true == policy.wrote(512, 20));
+
+	policy.synced(20);
+	CHECK(0 == policy.pending());
+	CHECK(false == policy.wrote(100, 30));
+}
+
+TEST_CASE("SDSyncPolicy: Sync once the time budget is used", "[SDSyncPolicy]")
+{
+	SDSyncPolicy policy;
+	policy.budget(4096, 100);
+	policy.synced(1000);
+
+	CHECK(false == policy.wrote(10, 1050));
+	CHECK(true == policy.wrote(10, 1100));
+
+	// Nothing to sync, regardless of the time
+	policy.synced(1100);
+	CHECK(false == policy.wrote(0, 5000));
+}
+
+TEST_CASE("SDSyncPolicy: The time budget handles millis() rollover", "[SDSyncPolicy]")
+{
+	SDSyncPolicy policy;
+	policy.budget(4096, 100);
+	policy.synced(UINT32_MAX - 10);
+
+	CHECK(false == policy.wrote(10, 50));
+	CHECK(true == policy.wrote(10, 90));
+}
@@ -0,0 +1,108 @@
+#include <catch.hpp>
+#include <internal/spsc_circular_buffer.hpp>
+#include <string>
+#include <thread>
+
+TEST_CASE("SPSC Buffer: Put and get", "[SPSCCircularBuffer]")
+{
+	SPSCCircularBuffer<char, 8> buffer;
+
+	CHECK(buffer.empty());
+	CHECK(8 == buffer.capacity());
+
+	buffer.put('a');
+	buffer.put("bcd", 3);
+	CHECK(4 == buffer.size());
+
+	CHECK('a' == buffer.get());
+	CHECK('b' == buffer.get());
+	buffer.consume(1);
+	CHECK('d' == buffer.get());
+	CHECK(buffer.empty());
+	CHECK(char() == buffer.get());
+}
+
+TEST_CASE("SPSC Buffer: Full buffer drops new data", "[SPSCCircularBuffer]")
+{
+	SPSCCircularBuffer<char, 8> buffer;
+
+	buffer.put("abcdef", 6);
+	buffer.put("ghij", 4);
+	CHECK(buffer.full());
+
+	buffer.put('k');
+	CHECK(8 == buffer.size());
+
+	std::string output;
+	while(!buffer.empty())
+	{
+		output += buffer.get();
+	}
+
+	CHECK(output == "abcdefgh");
+}
+
+TEST_CASE("SPSC Buffer: Indices wrap around the storage", "[SPSCCircularBuffer]")
+{
+	SPSCCircularBuffer<char, 8> buffer;
+
+	buffer.put("abcdef", 6);
+	buffer.consume(6);
+	buffer.put("0123", 4);
+
+	CHECK(6 == buffer.tail());
+	CHECK(2 == buffer.head());
+	CHECK(0 == memcmp(&buffer.storage()[6], "01", 2));
+	CHECK(0 == memcmp(buffer.storage(), "23", 2));
+
+	buffer.reset();
+	CHECK(buffer.empty());
+}
+
+TEST_CASE("SPSC Buffer: Concurrent producer and consumer", "[SPSCCircularBuffer]")
+{
+	SPSCCircularBuffer<uint32_t, 64> buffer;
+	constexpr uint32_t count = 100000;
+
+	std::thread producer([&buffer]() {
+		for(uint32_t i = 1; i <= count;)
+		{
+			if(!buffer.full())
+			{
+				buffer.put(i++);
+			}
+		}
+	});
+
+	uint32_t expected = 1;
+	bool in_order = true;
+	while(expected <= count)
+	{
+		if(!buffer.empty())
+		{
+			in_order &= (buffer.get() == expected);
+			expected++;
+		}
+	}
+
+	producer.join();
+	CHECK(in_order);
+	CHECK(buffer.empty());
+}
+
+TEST_CASE("SPSC Buffer: Peek the data as contiguous spans", "[SPSCCircularBuffer]")
+{
+	SPSCCircularBuffer<char, 8> buffer;
+
+	buffer.put("abcdef", 6);
+	buffer.consume(4);
+	buffer.put("ghijkl", 6);
+
+	auto spans = buffer.peek_contiguous();
+	CHECK(std::string(spans.first.data, spans.first.size) == "efgh");
+	CHECK(std::string(spans.second.data, spans.second.size) == "ijkl");
+
+	buffer.consume(spans.size());
+	CHECK(buffer.empty());
+	CHECK(0 == buffer.peek_contiguous().size());
+}
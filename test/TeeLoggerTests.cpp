@@ -0,0 +1,94 @@
+#include <CircularBufferLogger.h>
+#include <TeeLogger.h>
+#include <catch.hpp>
+#include <string>
+#include <test_helper.hpp>
+
+namespace
+{
+using test_tee = TeeLogger<CircularLogBufferLogger<512>, CircularLogBufferLogger<512>>;
+
+template<class TSink>
+std::string flush_sink(TSink& sink)
+{
+	log_buffer_output.clear();
+	sink.flush();
+	return log_buffer_output;
+}
+} // namespace
+
+TEST_CASE("Tee: Statements reach each sink according to its level", "[TeeLogger]")
+{
+	test_tee tee;
+	tee.sink<0>().level(log_level_e::info);
+	tee.sink<1>().level(log_level_e::warning);
+
+	tee.info("Value %d\n", 1);
+	tee.warning("Warning %s\n", "two");
+	tee.debug("Not logged\n");
+	tee.critical("Critical\n");
+
+	CHECK(0 == tee.size());
+	CHECK(flush_sink(tee.sink<0>()) == construct_log_string(log_level_e::info, "Value 1\n") +
+											construct_log_string(log_level_e::warning,
+																 "Warning two\n") +
+											construct_log_string(log_level_e::critical,
+																 "Critical\n"));
+	CHECK(flush_sink(tee.sink<1>()) ==
+		  construct_log_string(log_level_e::warning, "Warning two\n") +
+			  construct_log_string(log_level_e::critical, "Critical\n"));
+}
+
+TEST_CASE("Tee: The tee level filters statements before the sinks", "[TeeLogger]")
+{
+	test_tee tee;
+	tee.sink<1>().level(log_level_e::off);
+	tee.level(log_level_e::warning);
+
+	tee.info("Filtered by the tee\n");
+	tee.error("Error\n");
+
+	CHECK(flush_sink(tee.sink<0>()) == construct_log_string(log_level_e::error, "Error\n"));
+	CHECK(0 == tee.sink<1>().size());
+}
+
+TEST_CASE("Tee: Statements longer than the scratch buffer are not truncated", "[TeeLogger]")
+{
+	test_tee tee;
+	std::string long_string(LOG_TEE_SCRATCH_SIZE * 2 + 10, 'x');
+
+	tee.info("%s\n", long_string.c_str());
+	tee.write("abc", 3);
+	tee.print("%d\n", 42);
+
+	std::string expected =
+		construct_log_string(log_level_e::info, (long_string + "\n").c_str()) + "abc42\n";
+	CHECK(flush_sink(tee.sink<0>()) == expected);
+	CHECK(flush_sink(tee.sink<1>()) == expected);
+}
+
+TEST_CASE("Tee: Flush and clear apply to every sink", "[TeeLogger]")
+{
+	test_tee tee;
+
+	tee.info("First\n");
+	log_buffer_output.clear();
+	tee.flush();
+	CHECK(log_buffer_output == construct_log_string(log_level_e::info, "First\n") +
+								   construct_log_string(log_level_e::info, "First\n"));
+
+	tee.info("Second\n");
+	tee.clear();
+	CHECK(0 == tee.sink<0>().size());
+	CHECK(0 == tee.sink<1>().size());
+}
+
+TEST_CASE("Tee: Echo copies the formatted statement once", "[TeeLogger]")
+{
+	test_tee tee;
+	tee.echo(true);
+
+	log_buffer_output.clear();
+	tee.warning("Echo %d\n", 7);
+	CHECK(log_buffer_output == construct_log_string(log_level_e::warning, "Echo 7\n"));
+}
@@ -0,0 +1,59 @@
+#include <catch.hpp>
+#include <internal/timestamp_prefix.hpp>
+#include <string>
+
+namespace
+{
+std::string format(TimestampPrefix& prefix, uint32_t now)
+{
+	char buffer[log_timestamp_prefix_max_size];
+	return std::string(buffer, prefix.format(buffer, now));
+}
+} // namespace
+
+TEST_CASE("TimestampPrefix: Integer to decimal", "[TimestampPrefix]")
+{
+	char buffer[10];
+
+	CHECK("0" == std::string(buffer, log_u32_to_dec(buffer, 0)));
+	CHECK("7" == std::string(buffer, log_u32_to_dec(buffer, 7)));
+	CHECK("10" == std::string(buffer, log_u32_to_dec(buffer, 10)));
+	CHECK("123456" == std::string(buffer, log_u32_to_dec(buffer, 123456)));
+	CHECK("4294967295" == std::string(buffer, log_u32_to_dec(buffer, UINT32_MAX)));
+}
+
+TEST_CASE("TimestampPrefix: Clock units", "[TimestampPrefix]")
+{
+	TimestampPrefix prefix;
+	CHECK(LOG_TIMESTAMP_DEFAULT == prefix.source());
+
+	prefix.source(log_timestamp_e::millis);
+	CHECK("[0 ms] " == format(prefix, 0));
+	CHECK("[81838 ms] " == format(prefix, 81838));
+
+	prefix.source(log_timestamp_e::micros);
+	CHECK("[81838000 us] " == format(prefix, 81838000));
+
+	prefix.source(log_timestamp_e::cycles);
+	CHECK("[4294967295 cyc] " == format(prefix, UINT32_MAX));
+}
+
+TEST_CASE("TimestampPrefix: Delta since the previous statement", "[TimestampPrefix]")
+{
+	TimestampPrefix prefix;
+	prefix.source(log_timestamp_e::delta);
+
+	CHECK("[+1000 us] " == format(prefix, 1000));
+	CHECK("[+250 us] " == format(prefix, 1250));
+	CHECK("[+0 us] " == format(prefix, 1250));
+
+	// The clock may wrap around
+	format(prefix, UINT32_MAX - 9);
+	CHECK("[+20 us] " == format(prefix, 10));
+
+	// The longest prefixes fit in the buffer
+	prefix.source(log_timestamp_e::delta);
+	CHECK(log_timestamp_prefix_max_size == format(prefix, UINT32_MAX).size());
+	prefix.source(log_timestamp_e::cycles);
+	CHECK(log_timestamp_prefix_max_size == format(prefix, UINT32_MAX).size());
+}
@@ -0,0 +1,15 @@
+#include <logger_bench.hpp>
+#include <stdio.h>
+
+/// printf() and the logger flushes write through _putchar(). The benchmarks flush to their
+/// own sinks, so only the results reach stdout.
+void _putchar(char c)
+{
+	putchar(c);
+}
+
+int main()
+{
+	run_logger_benchmarks();
+	return 0;
+}
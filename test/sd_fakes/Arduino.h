@@ -0,0 +1,41 @@
+#ifndef SD_FAKES_ARDUINO_H_
+#define SD_FAKES_ARDUINO_H_
+
+// Just enough of the Arduino SDK to run the SD card strategies on the host
+#include <LibPrintf.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The value returned by millis() and micros()
+extern uint32_t fake_clock;
+
+inline uint32_t millis()
+{
+	return fake_clock;
+}
+
+inline uint32_t micros()
+{
+	return fake_clock * 1000;
+}
+
+class Print
+{
+  public:
+	virtual ~Print() = default;
+	virtual size_t write(uint8_t c) = 0;
+};
+
+class FakeSerial final : public Print
+{
+  public:
+	size_t write(uint8_t c) override
+	{
+		_putchar(static_cast<char>(c));
+		return 1;
+	}
+};
+
+extern FakeSerial Serial;
+
+#endif // SD_FAKES_ARDUINO_H_
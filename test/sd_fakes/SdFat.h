@@ -0,0 +1,205 @@
+#ifndef SD_FAKES_SDFAT_H_
+#define SD_FAKES_SDFAT_H_
+
+// An in-memory SdFat: files are kept in fake_files, by name
+#include "Arduino.h"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <stdio.h>
+#include <string>
+
+#define O_RDONLY 0x00
+#define O_WRITE 0x01
+#define O_APPEND 0x08
+#define O_CREAT 0x10
+#define SD_CARD_ERROR_ACMD41 0xff
+
+extern std::map<std::string, std::string> fake_files;
+
+inline void printSdErrorSymbol(Print*, int) {}
+
+class FsFile
+{
+  public:
+	bool open(const char* name, int flags)
+	{
+		name_ = name;
+		dir_ = name_ == "/";
+		next_ = 0;
+		open_ = dir_ || fake_files.count(name_) || (flags & O_CREAT);
+		pos_ = (open_ && (flags & O_APPEND)) ? fake_files[name_].size() : 0;
+
+		if(open_ && !dir_)
+		{
+			fake_files[name_];
+		}
+
+		return open_;
+	}
+
+	bool openNext(FsFile* dir, int)
+	{
+		auto entry = fake_files.begin();
+		std::advance(entry, std::min(dir->next_, fake_files.size()));
+
+		if(entry == fake_files.end())
+		{
+			return false;
+		}
+
+		dir->next_++;
+		return open(entry->first.c_str(), O_RDONLY);
+	}
+
+	bool isOpen() const
+	{
+		return open_;
+	}
+
+	bool isBusy() const
+	{
+		return false;
+	}
+
+	size_t write(const void* data, size_t size)
+	{
+		std::string& contents = fake_files[name_];
+
+		if(contents.size() < pos_ + size)
+		{
+			contents.resize(pos_ + size);
+		}
+
+		contents.replace(pos_, size, static_cast<const char*>(data), size);
+		pos_ += size;
+		return size;
+	}
+
+	int read(void* data, size_t size)
+	{
+		const std::string& contents = fake_files[name_];
+		size_t available = (contents.size() > pos_) ? contents.size() - pos_ : 0;
+		size = (size < available) ? size : available;
+		contents.copy(static_cast<char*>(data), size, pos_);
+		pos_ += size;
+		return static_cast<int>(size);
+	}
+
+	uint64_t curPosition() const
+	{
+		return pos_;
+	}
+
+	bool seekSet(uint64_t pos)
+	{
+		pos_ = static_cast<size_t>(pos);
+		return true;
+	}
+
+	bool truncate(uint64_t size)
+	{
+		fake_files[name_].resize(static_cast<size_t>(size));
+		pos_ = (pos_ < size) ? pos_ : static_cast<size_t>(size);
+		return true;
+	}
+
+	bool preAllocate(uint64_t size)
+	{
+		std::string& contents = fake_files[name_];
+
+		if(contents.size() < size)
+		{
+			contents.resize(static_cast<size_t>(size));
+		}
+
+		return true;
+	}
+
+	bool sync()
+	{
+		return true;
+	}
+
+	size_t getName(char* name, size_t size)
+	{
+		snprintf(name, size, "%s", name_.c_str());
+		return name_.size();
+	}
+
+	bool isDir() const
+	{
+		return dir_;
+	}
+
+	uint64_t size() const
+	{
+		return fake_files[name_].size();
+	}
+
+	uint64_t fileSize() const
+	{
+		return size();
+	}
+
+	bool rename(const char* name)
+	{
+		fake_files[name] = fake_files[name_];
+		fake_files.erase(name_);
+		name_ = name;
+		return true;
+	}
+
+	bool remove()
+	{
+		open_ = false;
+		return fake_files.erase(name_) != 0;
+	}
+
+	bool close()
+	{
+		bool was_open = open_;
+		open_ = false;
+		return was_open;
+	}
+
+  private:
+	std::string name_;
+	size_t pos_ = 0;
+	size_t next_ = 0;
+	bool dir_ = false;
+	bool open_ = false;
+};
+
+class Card
+{
+  public:
+	uint32_t sectorCount()
+	{
+		return 1024;
+	}
+};
+
+class SdFs
+{
+  public:
+	int sdErrorCode()
+	{
+		return 0;
+	}
+
+	unsigned sdErrorData()
+	{
+		return 0;
+	}
+
+	Card* card()
+	{
+		return &card_;
+	}
+
+  private:
+	Card card_;
+};
+
+#endif // SD_FAKES_SDFAT_H_
@@ -0,0 +1,21 @@
+#ifndef SD_FAKES_KINETIS_H_
+#define SD_FAKES_KINETIS_H_
+
+#include <stdint.h>
+
+// The reset control registers read by report_kinetis_reset_reason()
+extern volatile uint8_t RCM_SRS0;
+extern volatile uint8_t RCM_SRS1;
+
+#define RCM_SRS0_LVD 0x02
+#define RCM_SRS0_LOC 0x04
+#define RCM_SRS0_LOL 0x08
+#define RCM_SRS0_WDOG 0x20
+#define RCM_SRS0_PIN 0x40
+#define RCM_SRS0_POR 0x80
+#define RCM_SRS1_LOCKUP 0x02
+#define RCM_SRS1_SW 0x04
+#define RCM_SRS1_MDM_AP 0x08
+#define RCM_SRS1_SACKERR 0x20
+
+#endif // SD_FAKES_KINETIS_H_
@@ -0,0 +1,9 @@
+#include "Arduino.h"
+#include "SdFat.h"
+#include "kinetis.h"
+
+uint32_t fake_clock = 0;
+FakeSerial Serial;
+std::map<std::string, std::string> fake_files;
+volatile uint8_t RCM_SRS0 = 0;
+volatile uint8_t RCM_SRS1 = 0;
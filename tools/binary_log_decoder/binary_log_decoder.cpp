@@ -0,0 +1,527 @@
+#include "binary_log_decoder.hpp"
+#include <ArduinoLogger.h>
+#include <LibPrintf.h>
+#include <string.h>
+
+namespace
+{
+/// A decoded log argument
+struct decoded_arg
+{
+	char code;
+	uint64_t bits;
+	double real;
+	std::string str;
+};
+
+void append_char(char c, void* arg)
+{
+	static_cast<std::string*>(arg)->push_back(c);
+}
+
+/// The size in bytes of an integer signature code, or 0 if the code is not an integer
+size_t integer_code_size(char code)
+{
+	switch(code)
+	{
+		case 'b':
+		case 'B':
+			return 1;
+		case 'h':
+		case 'H':
+			return 2;
+		case 'i':
+		case 'I':
+		case 'p':
+			return 4;
+		case 'q':
+		case 'Q':
+		case 'P':
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+bool is_signed_code(char code)
+{
+	return code == 'b' || code == 'h' || code == 'i' || code == 'q';
+}
+
+/// Truncates value to the specified number of bytes
+uint64_t truncate_bits(uint64_t value, size_t bytes)
+{
+	return (bytes >= 8) ? value : (value & ((UINT64_C(1) << (bytes * 8)) - 1));
+}
+
+/// Sign-extends the lowest bytes of value
+int64_t sign_extend(uint64_t value, size_t bytes)
+{
+	if(bytes >= 8)
+	{
+		return static_cast<int64_t>(value);
+	}
+
+	uint64_t sign_bit = UINT64_C(1) << (bytes * 8 - 1);
+	value = truncate_bits(value, bytes);
+	return static_cast<int64_t>((value ^ sign_bit) - sign_bit);
+}
+
+bool read_arg(char code, const uint8_t*& src, const uint8_t* end, decoded_arg& arg)
+{
+	arg.code = code;
+
+	if(code == 'f' || code == 'd')
+	{
+		size_t bytes = (code == 'f') ? sizeof(float) : sizeof(double);
+
+		if(static_cast<size_t>(end - src) < bytes)
+		{
+			return false;
+		}
+
+		if(code == 'f')
+		{
+			float value;
+			memcpy(&value, src, sizeof(value));
+			arg.real = value;
+		}
+		else
+		{
+			memcpy(&arg.real, src, sizeof(arg.real));
+		}
+
+		src += bytes;
+		return true;
+	}
+
+	uint64_t value;
+
+	if(!binary_read_varint(src, end, value))
+	{
+		return false;
+	}
+
+	if(code == 's')
+	{
+		if(static_cast<uint64_t>(end - src) < value)
+		{
+			return false;
+		}
+
+		arg.str.assign(reinterpret_cast<const char*>(src), static_cast<size_t>(value));
+		src += value;
+		return true;
+	}
+
+	if(integer_code_size(code) == 0)
+	{
+		return false;
+	}
+
+	// Store every integer as the two's complement bits of its device width
+	arg.bits = is_signed_code(code) ? static_cast<uint64_t>(binary_zigzag_decode(value)) : value;
+	arg.bits = truncate_bits(arg.bits, integer_code_size(code));
+	return true;
+}
+} // namespace
+
+bool BinaryLogDecoder::decode(const uint8_t* data, size_t size, std::string& output)
+{
+	const uint8_t* src = data;
+	const uint8_t* end = data + size;
+
+	formats_.clear();
+	timestamp_ = 0;
+	error_.clear();
+
+	if(!decode_header(src, end))
+	{
+		return false;
+	}
+
+	while(src != end)
+	{
+		uint8_t tag = *src++;
+		bool success;
+
+		if(tag & binary_log_tag_record)
+		{
+			success = decode_record(tag, src, end, output);
+		}
+		else if(tag == binary_log_tag_format)
+		{
+			success = decode_format(src, end);
+		}
+		else if(tag == binary_log_tag_text)
+		{
+			success = decode_text(src, end, output);
+		}
+		else
+		{
+			success = fail("Unknown record tag");
+		}
+
+		if(!success)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool BinaryLogDecoder::decode_header(const uint8_t*& src, const uint8_t* end)
+{
+	if(static_cast<size_t>(end - src) < binary_log_header_size ||
+	   memcmp(src, binary_log_magic, sizeof(binary_log_magic)) != 0)
+	{
+		return fail("Not a binary log file");
+	}
+
+	if(src[4] != binary_log_version)
+	{
+		return fail("Unsupported binary log version");
+	}
+
+	build_id_ = 0;
+
+	for(size_t i = 0; i < 4; i++)
+	{
+		build_id_ |= static_cast<uint32_t>(src[6 + i]) << (8 * i);
+	}
+
+	src += binary_log_header_size;
+	return true;
+}
+
+bool BinaryLogDecoder::decode_format(const uint8_t*& src, const uint8_t* end)
+{
+	uint64_t id;
+
+	if(!binary_read_varint(src, end, id))
+	{
+		return fail("Truncated format definition");
+	}
+
+	format_definition format;
+	std::string* fields[] = {&format.signature, &format.fmt};
+
+	for(auto field : fields)
+	{
+		auto terminator = static_cast<const uint8_t*>(memchr(src, '\0', end - src));
+
+		if(terminator == nullptr)
+		{
+			return fail("Truncated format definition");
+		}
+
+		field->assign(reinterpret_cast<const char*>(src), terminator - src);
+		src = terminator + 1;
+	}
+
+	formats_[id] = format;
+	return true;
+}
+
+bool BinaryLogDecoder::decode_text(const uint8_t*& src, const uint8_t* end, std::string& output)
+{
+	uint64_t len;
+
+	if(!binary_read_varint(src, end, len) || static_cast<uint64_t>(end - src) < len)
+	{
+		return fail("Truncated text record");
+	}
+
+	output.append(reinterpret_cast<const char*>(src), static_cast<size_t>(len));
+	src += len;
+	return true;
+}
+
+bool BinaryLogDecoder::decode_record(uint8_t tag, const uint8_t*& src, const uint8_t* end,
+									 std::string& output)
+{
+	uint8_t level = tag & binary_log_tag_level_mask;
+	uint64_t module = 0;
+	uint64_t delta;
+	uint64_t id;
+
+	if(level > LOG_LEVEL_MAX)
+	{
+		return fail("Invalid log level");
+	}
+
+	// Module ids are not part of the text output
+	if((tag & binary_log_tag_module) && !binary_read_varint(src, end, module))
+	{
+		return fail("Truncated log record");
+	}
+
+	if(!binary_read_varint(src, end, delta) || !binary_read_varint(src, end, id))
+	{
+		return fail("Truncated log record");
+	}
+
+	auto format = formats_.find(id);
+
+	if(format == formats_.end())
+	{
+		return fail("Log record uses an undefined format id");
+	}
+
+	timestamp_ += static_cast<uint32_t>(delta);
+
+	if(level != LOG_LEVEL_OFF)
+	{
+		output += LOG_LEVEL_TO_SHORT_C_STRING(static_cast<log_level_e>(level));
+		fctprintf(&append_char, &output, "[%u ms] ", static_cast<unsigned>(timestamp_));
+	}
+
+	return format_message(format->second, src, end, output);
+}
+
+bool BinaryLogDecoder::format_message(const format_definition& format, const uint8_t*& src,
+									  const uint8_t* end, std::string& output)
+{
+	const char* p = format.fmt.c_str();
+	size_t next_arg = 0;
+	decoded_arg arg;
+
+	// Reads the next argument described by the signature into arg
+	auto take_arg = [&]() -> bool {
+		if(next_arg == format.signature.size())
+		{
+			return fail("Log record has too few arguments for its format string");
+		}
+
+		if(!read_arg(format.signature[next_arg++], src, end, arg))
+		{
+			return fail("Truncated log record arguments");
+		}
+
+		return true;
+	};
+
+	// Reads an int argument, as used for '*' widths and precisions
+	auto take_int = [&](int& value) -> bool {
+		if(!take_arg())
+		{
+			return false;
+		}
+
+		if(integer_code_size(arg.code) == 0)
+		{
+			return fail("Log record argument does not match its format string");
+		}
+
+		value = static_cast<int>(sign_extend(arg.bits, integer_code_size(arg.code)));
+		return true;
+	};
+
+	while(*p)
+	{
+		if(*p != '%')
+		{
+			output += *p++;
+			continue;
+		}
+
+		p++;
+
+		if(*p == '%')
+		{
+			output += *p++;
+			continue;
+		}
+
+		// Rebuild the conversion specification with the width and precision resolved,
+		// and the length modifier replaced to match the decoded argument
+		std::string spec = "%";
+
+		while(*p && strchr("-+ #0", *p))
+		{
+			spec += *p++;
+		}
+
+		if(*p == '*')
+		{
+			int width;
+
+			if(!take_int(width))
+			{
+				return false;
+			}
+
+			spec += std::to_string(width);
+			p++;
+		}
+		else
+		{
+			while(*p >= '0' && *p <= '9')
+			{
+				spec += *p++;
+			}
+		}
+
+		if(*p == '.')
+		{
+			p++;
+
+			if(*p == '*')
+			{
+				int precision;
+
+				if(!take_int(precision))
+				{
+					return false;
+				}
+
+				// A negative precision is taken as if the precision were omitted
+				if(precision >= 0)
+				{
+					spec += "." + std::to_string(precision);
+				}
+
+				p++;
+			}
+			else
+			{
+				spec += '.';
+
+				while(*p >= '0' && *p <= '9')
+				{
+					spec += *p++;
+				}
+			}
+		}
+
+		// The device promotes char and short arguments to int, so hh and h still truncate
+		size_t length_bytes = 8;
+
+		while(*p && strchr("hljztL", *p))
+		{
+			if(*p == 'h')
+			{
+				length_bytes = (length_bytes == 2) ? 1 : 2;
+			}
+
+			p++;
+		}
+
+		char conversion = *p;
+
+		if(conversion == '\0')
+		{
+			return fail("Incomplete conversion specification in format string");
+		}
+
+		p++;
+
+		if(!take_arg())
+		{
+			return false;
+		}
+
+		size_t arg_bytes = integer_code_size(arg.code);
+
+		if(arg_bytes > length_bytes)
+		{
+			arg_bytes = length_bytes;
+		}
+
+		switch(conversion)
+		{
+			case 'd':
+			case 'i':
+				if(arg_bytes == 0)
+				{
+					return fail("Log record argument does not match its format string");
+				}
+
+				spec += "lld";
+				fctprintf(&append_char, &output, spec.c_str(),
+						  static_cast<long long>(sign_extend(arg.bits, arg_bytes)));
+				break;
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				if(arg_bytes == 0)
+				{
+					return fail("Log record argument does not match its format string");
+				}
+
+				spec += "ll";
+				spec += conversion;
+				fctprintf(&append_char, &output, spec.c_str(),
+						  static_cast<unsigned long long>(truncate_bits(arg.bits, arg_bytes)));
+				break;
+			case 'c':
+				if(arg_bytes == 0)
+				{
+					return fail("Log record argument does not match its format string");
+				}
+
+				spec += 'c';
+				fctprintf(&append_char, &output, spec.c_str(), static_cast<int>(arg.bits));
+				break;
+			case 'p':
+				if(arg_bytes == 0)
+				{
+					return fail("Log record argument does not match its format string");
+				}
+
+				// Matches the library's %p output for the device's pointer size
+				fctprintf(&append_char, &output, "%0*llX",
+						  static_cast<int>(integer_code_size(arg.code) * 2),
+						  static_cast<unsigned long long>(arg.bits));
+				break;
+			case 's':
+				if(arg.code != 's')
+				{
+					return fail("Log record argument does not match its format string");
+				}
+
+				spec += 's';
+				fctprintf(&append_char, &output, spec.c_str(), arg.str.c_str());
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				if(arg.code != 'f' && arg.code != 'd')
+				{
+					return fail("Log record argument does not match its format string");
+				}
+
+				spec += conversion;
+				fctprintf(&append_char, &output, spec.c_str(), arg.real);
+				break;
+			case 'n':
+				break;
+			default:
+				return fail("Unsupported conversion in format string");
+		}
+	}
+
+	// Skip any arguments the format string did not use
+	while(next_arg < format.signature.size())
+	{
+		if(!take_arg())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool BinaryLogDecoder::fail(const char* msg)
+{
+	error_ = msg;
+	return false;
+}
@@ -0,0 +1,64 @@
+#ifndef BINARY_LOG_DECODER_HPP_
+#define BINARY_LOG_DECODER_HPP_
+
+#include <internal/binary_log_format.hpp>
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/** Host-side decoder for binary log files
+ *
+ * Turns the output of a logger in log_file_format_e::binary mode back into the text that the
+ * same log statements produce in text mode: the level prefix, the `[N ms] ` timestamp,
+ * and the message formatted with the library's printf implementation.
+ *
+ * The format is described in internal/binary_log_format.hpp.
+ */
+class BinaryLogDecoder
+{
+  public:
+	/** Decode a complete binary log file
+	 *
+	 * @param data The file contents, starting with the file header.
+	 * @param size The size of the file, in bytes.
+	 * @param output The decoded text is appended to this string. If an error occurs, it holds
+	 *	the text decoded up to that point.
+	 * @returns true if the whole file was decoded. On failure, error() describes the problem.
+	 */
+	bool decode(const uint8_t* data, size_t size, std::string& output);
+
+	/// A description of the last decoding error
+	const std::string& error() const noexcept
+	{
+		return error_;
+	}
+
+	/// The build_id field from the most recently decoded file header
+	uint32_t build_id() const noexcept
+	{
+		return build_id_;
+	}
+
+  private:
+	struct format_definition
+	{
+		std::string signature;
+		std::string fmt;
+	};
+
+	bool decode_header(const uint8_t*& src, const uint8_t* end);
+	bool decode_format(const uint8_t*& src, const uint8_t* end);
+	bool decode_text(const uint8_t*& src, const uint8_t* end, std::string& output);
+	bool decode_record(uint8_t tag, const uint8_t*& src, const uint8_t* end, std::string& output);
+	bool format_message(const format_definition& format, const uint8_t*& src, const uint8_t* end,
+						std::string& output);
+	bool fail(const char* msg);
+
+	std::map<uint64_t, format_definition> formats_;
+	uint32_t timestamp_ = 0;
+	uint32_t build_id_ = 0;
+	std::string error_;
+};
+
+#endif // BINARY_LOG_DECODER_HPP_
@@ -0,0 +1,75 @@
+#include "binary_log_decoder.hpp"
+#include <stdio.h>
+#include <vector>
+
+/** binary_log_decoder
+ *
+ * Converts a binary log file (e.g., log_N.bin written by
+ * TeensySDRotationalLogger_t<log_file_format_e::binary>) to text.
+ *
+ * Usage: binary_log_decoder <log_file.bin> [output.txt]
+ *
+ * The text is written to stdout if no output file is specified.
+ */
+
+// Required by the printf library
+void _putchar(char c)
+{
+	putchar(c);
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "Usage: %s <log_file.bin> [output.txt]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* input = fopen(argv[1], "rb");
+
+	if(input == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<uint8_t> data;
+	uint8_t chunk[4096];
+	size_t count;
+
+	while((count = fread(chunk, 1, sizeof(chunk), input)) > 0)
+	{
+		data.insert(data.end(), chunk, chunk + count);
+	}
+
+	fclose(input);
+
+	BinaryLogDecoder decoder;
+	std::string text;
+	bool success = decoder.decode(data.data(), data.size(), text);
+
+	FILE* output = (argc == 3) ? fopen(argv[2], "w") : stdout;
+
+	if(output == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s\n", argv[2]);
+		return 1;
+	}
+
+	// Text decoded before an error is still written, so a truncated file remains useful
+	fwrite(text.data(), 1, text.size(), output);
+
+	if(output != stdout)
+	{
+		fclose(output);
+	}
+
+	if(!success)
+	{
+		fprintf(stderr, "Error decoding %s: %s\n", argv[1], decoder.error().c_str());
+		return 1;
+	}
+
+	return 0;
+}
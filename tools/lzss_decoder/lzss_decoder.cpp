@@ -0,0 +1,73 @@
+#include "lzss_decoder.hpp"
+#include <internal/lzss_encoder.hpp>
+
+bool LZSSDecoder::decode(const uint8_t* data, size_t size, std::string& output)
+{
+	const uint8_t* src = data;
+	const uint8_t* end = data + size;
+	size_t block_start = output.size();
+
+	blocks_ = 0;
+	error_.clear();
+
+	while(src < end)
+	{
+		uint8_t flags = *src++;
+
+		for(unsigned token = 0; token < 8; token++)
+		{
+			if(src == end)
+			{
+				return fail("Data ends part-way through a block");
+			}
+
+			if(flags & (1U << token))
+			{
+				output.push_back(static_cast<char>(*src++));
+				continue;
+			}
+
+			if(end - src < 2)
+			{
+				return fail("Data ends part-way through a match");
+			}
+
+			size_t distance = src[0] | (static_cast<size_t>(src[1] & 0x0F) << 8);
+			size_t length = (src[1] >> 4) + lzss_min_match;
+			src += 2;
+
+			if(distance == 0)
+			{
+				// End of the block, and of the group
+				blocks_++;
+				block_start = output.size();
+				break;
+			}
+
+			if(distance > output.size() - block_start)
+			{
+				return fail("Match refers to data before the start of the block");
+			}
+
+			// Copy one byte at a time, since the match may overlap the data it produces
+			size_t from = output.size() - distance;
+			for(size_t i = 0; i < length; i++)
+			{
+				output.push_back(output[from + i]);
+			}
+		}
+	}
+
+	if(block_start != output.size())
+	{
+		return fail("Data ends part-way through a block");
+	}
+
+	return true;
+}
+
+bool LZSSDecoder::fail(const char* msg)
+{
+	error_ = msg;
+	return false;
+}
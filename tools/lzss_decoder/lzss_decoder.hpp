@@ -0,0 +1,46 @@
+#ifndef LZSS_DECODER_HPP_
+#define LZSS_DECODER_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/** Host-side decompressor for compressed log data
+ *
+ * Restores the log text written with LOG_COMPRESSION_EN. The format is described in
+ * internal/lzss_encoder.hpp.
+ */
+class LZSSDecoder
+{
+  public:
+	/** Decompress a sequence of blocks
+	 *
+	 * @param data The compressed data, starting at the beginning of a block.
+	 * @param size The size of the data, in bytes.
+	 * @param output The decompressed data is appended to this string. If an error occurs, it
+	 *	holds the data decompressed up to that point.
+	 * @returns true if all of the data was decompressed, and it ended with a complete block.
+	 *	On failure, error() describes the problem.
+	 */
+	bool decode(const uint8_t* data, size_t size, std::string& output);
+
+	/// A description of the last decoding error
+	const std::string& error() const noexcept
+	{
+		return error_;
+	}
+
+	/// The number of complete blocks in the last decoded data
+	size_t blocks() const noexcept
+	{
+		return blocks_;
+	}
+
+  private:
+	bool fail(const char* msg);
+
+	size_t blocks_ = 0;
+	std::string error_;
+};
+
+#endif // LZSS_DECODER_HPP_
@@ -0,0 +1,68 @@
+#include "lzss_decoder.hpp"
+#include <stdio.h>
+#include <vector>
+
+/** lzss_decoder
+ *
+ * Decompresses a log file written with LOG_COMPRESSION_EN, or a dump of a compressed EEPROM
+ * log (see EEPROMLogStore::first_block()).
+ *
+ * Usage: lzss_decoder <log_file> [output.txt]
+ *
+ * The text is written to stdout if no output file is specified.
+ */
+int main(int argc, char* argv[])
+{
+	if(argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "Usage: %s <log_file> [output.txt]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* input = fopen(argv[1], "rb");
+
+	if(input == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<uint8_t> data;
+	uint8_t chunk[4096];
+	size_t count;
+
+	while((count = fread(chunk, 1, sizeof(chunk), input)) > 0)
+	{
+		data.insert(data.end(), chunk, chunk + count);
+	}
+
+	fclose(input);
+
+	LZSSDecoder decoder;
+	std::string text;
+	bool success = decoder.decode(data.data(), data.size(), text);
+
+	FILE* output = (argc == 3) ? fopen(argv[2], "w") : stdout;
+
+	if(output == nullptr)
+	{
+		fprintf(stderr, "Failed to open %s\n", argv[2]);
+		return 1;
+	}
+
+	// Text decoded before an error is still written, so a truncated file remains useful
+	fwrite(text.data(), 1, text.size(), output);
+
+	if(output != stdout)
+	{
+		fclose(output);
+	}
+
+	if(!success)
+	{
+		fprintf(stderr, "Error decoding %s: %s\n", argv[1], decoder.error().c_str());
+		return 1;
+	}
+
+	return 0;
+}